@@ -84,6 +84,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #ifndef M_PIf
 #define M_PIf   ((float) M_PI)
@@ -990,7 +991,9 @@ namespace {
  * function module.
  *
  * It generates IR for every built-in function signature, and organizes them
- * into functions.
+ * into functions.  A function's signatures are only generated the first time
+ * the function is looked up, so a process only pays for the built-ins its
+ * shaders actually use.
  */
 class builtin_builder {
 public:
@@ -1002,18 +1005,37 @@ public:
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
 
+   /**
+    * Return the function called \p name, generating its signatures if this
+    * is the first time it is looked up.  A function without signatures is
+    * returned if \p name isn't a built-in.
+    */
+   ir_function *lookup_function(const char *name);
+
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in that has been looked up so
+    * far, regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature() to
+    * filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /**
+    * The function create_intrinsics() and create_builtins() generate
+    * signatures for; all other functions are skipped.
+    */
+   const char *wanted_name;
+
+   bool wants_function(const char *name) const
+   {
+      return strcmp(name, wanted_name) == 0;
+   }
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
@@ -1398,6 +1420,7 @@ builtin_builder::builtin_builder()
    : shader(NULL)
 {
    mem_ctx = NULL;
+   wanted_name = NULL;
 }
 
 builtin_builder::~builtin_builder()
@@ -1426,7 +1449,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = lookup_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1438,6 +1461,29 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+ir_function *
+builtin_builder::lookup_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL)
+      return f;
+
+   /* Generating a built-in may look up the intrinsic it calls, so keep the
+    * name of the function that is being generated already.
+    */
+   const char *outer_name = wanted_name;
+   wanted_name = name;
+   create_intrinsics();
+   create_builtins();
+   wanted_name = outer_name;
+
+   /* Names that are not built-ins are not added here, as that would grow
+    * the built-in symbol table with every name any shader ever uses.  The
+    * parse state remembers them instead.
+    */
+   return shader->symbols->get_function(name);
+}
+
 void
 builtin_builder::initialize()
 {
@@ -1449,8 +1495,6 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    create_shader();
-   create_intrinsics();
-   create_builtins();
 }
 
 void
@@ -1478,6 +1522,15 @@ builtin_builder::create_shader()
 
 /** @} */
 
+/* Only evaluate the signature arguments of the function that is being looked
+ * up; see builtin_builder::lookup_function().
+ */
+#define add_function(NAME, ...)                    \
+   do {                                            \
+      if (wants_function(NAME))                    \
+         this->add_function(NAME, __VA_ARGS__);    \
+   } while (0)
+
 /**
  * Create ir_function and ir_function_signature objects for each
  * intrinsic.
@@ -5447,6 +5500,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -5517,6 +5572,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!wants_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -7282,7 +7340,7 @@ builtin_builder::_is_sparse_texels_resident(void)
 
    ir_variable *retval = body.make_temp(glsl_type::bool_type, "retval");
    ir_function *f =
-      shader->symbols->get_function("__intrinsic_is_sparse_texels_resident");
+      lookup_function("__intrinsic_is_sparse_texels_resident");
 
    body.emit(call(f, retval, sig->parameters));
    body.emit(ret(retval));
@@ -8139,7 +8197,7 @@ builtin_builder::_atomic_counter_op(const char *intrinsic,
    MAKE_SIG(glsl_type::uint_type, avail, 1, counter);
 
    ir_variable *retval = body.make_temp(glsl_type::uint_type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(lookup_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8170,7 +8228,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
       parameters.push_tail(new(mem_ctx) ir_dereference_variable(neg_data));
 
       ir_function *const func =
-         shader->symbols->get_function("__intrinsic_atomic_add");
+         lookup_function("__intrinsic_atomic_add");
       ir_instruction *const c = call(func, retval, parameters);
 
       assert(c != NULL);
@@ -8178,7 +8236,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
 
       body.emit(c);
    } else {
-      body.emit(call(shader->symbols->get_function(intrinsic), retval,
+      body.emit(call(lookup_function(intrinsic), retval,
                      sig->parameters));
    }
 
@@ -8196,7 +8254,7 @@ builtin_builder::_atomic_counter_op2(const char *intrinsic,
    MAKE_SIG(glsl_type::uint_type, avail, 3, counter, compare, data);
 
    ir_variable *retval = body.make_temp(glsl_type::uint_type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(lookup_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8214,7 +8272,7 @@ builtin_builder::_atomic_op2(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(lookup_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8233,7 +8291,7 @@ builtin_builder::_atomic_op3(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(lookup_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8448,7 +8506,7 @@ builtin_builder::_image(image_prototype_ctr prototype,
 
    if (flags & IMAGE_FUNCTION_EMIT_STUB) {
       ir_factory body(&sig->body, mem_ctx);
-      ir_function *f = shader->symbols->get_function(intrinsic_name);
+      ir_function *f = lookup_function(intrinsic_name);
 
       if (flags & IMAGE_FUNCTION_RETURNS_VOID) {
          body.emit(call(f, NULL, sig->parameters));
@@ -8500,7 +8558,7 @@ builtin_builder::_memory_barrier(const char *intrinsic_name,
                                  builtin_available_predicate avail)
 {
    MAKE_SIG(glsl_type::void_type, avail, 0);
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(lookup_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -8522,7 +8580,7 @@ builtin_builder::_ballot()
    MAKE_SIG(glsl_type::uint64_t_type, shader_ballot, 1, value);
    ir_variable *retval = body.make_temp(glsl_type::uint64_t_type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_ballot"),
+   body.emit(call(lookup_function("__intrinsic_ballot"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8545,7 +8603,7 @@ builtin_builder::_read_first_invocation(const glsl_type *type)
    MAKE_SIG(type, shader_ballot, 1, value);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_read_first_invocation"),
+   body.emit(call(lookup_function("__intrinsic_read_first_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8570,7 +8628,7 @@ builtin_builder::_read_invocation(const glsl_type *type)
    MAKE_SIG(type, shader_ballot, 2, value, invocation);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_read_invocation"),
+   body.emit(call(lookup_function("__intrinsic_read_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8589,7 +8647,7 @@ builtin_builder::_invocation_interlock(const char *intrinsic_name,
                                        builtin_available_predicate avail)
 {
    MAKE_SIG(glsl_type::void_type, avail, 0);
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(lookup_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -8610,7 +8668,7 @@ builtin_builder::_shader_clock(builtin_available_predicate avail,
 
    ir_variable *retval = body.make_temp(glsl_type::uvec2_type, "clock_retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_shader_clock"),
+   body.emit(call(lookup_function("__intrinsic_shader_clock"),
                   retval, sig->parameters));
 
    if (type == glsl_type::uint64_t_type) {
@@ -8641,7 +8699,7 @@ builtin_builder::_vote(const char *intrinsic_name,
 
    ir_variable *retval = body.make_temp(glsl_type::bool_type, "retval");
 
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(lookup_function(intrinsic_name),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8662,7 +8720,7 @@ builtin_builder::_helper_invocation()
 
    ir_variable *retval = body.make_temp(glsl_type::bool_type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_helper_invocation"),
+   body.emit(call(lookup_function("__intrinsic_helper_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
 
@@ -8700,15 +8758,45 @@ _mesa_glsl_builtin_functions_decref()
    mtx_unlock(&builtins_lock);
 }
 
+static bool
+is_known_non_builtin(_mesa_glsl_parse_state *state, const char *name)
+{
+   return state->non_builtin_names &&
+          _mesa_set_search(state->non_builtin_names, name);
+}
+
+static void
+add_known_non_builtin(_mesa_glsl_parse_state *state, const char *name)
+{
+   if (!state->non_builtin_names) {
+      state->non_builtin_names =
+         _mesa_set_create(state, _mesa_hash_string, _mesa_key_string_equal);
+   }
+
+   _mesa_set_add(state->non_builtin_names, ralloc_strdup(state, name));
+}
+
 ir_function_signature *
 _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
                                  const char *name, exec_list *actual_parameters)
 {
    ir_function_signature *s;
+   ir_function *f;
+
+   if (is_known_non_builtin(state, name)) {
+      /* find() would still have flagged the use of built-ins. */
+      state->uses_builtin_functions = true;
+      return NULL;
+   }
+
    mtx_lock(&builtins_lock);
+   f = builtins.lookup_function(name);
    s = builtins.find(state, name, actual_parameters);
    mtx_unlock(&builtins_lock);
 
+   if (f == NULL)
+      add_known_non_builtin(state, name);
+
    return s;
 }
 
@@ -8717,8 +8805,12 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
 {
    ir_function *f;
    bool ret = false;
+
+   if (is_known_non_builtin(state, name))
+      return false;
+
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.lookup_function(name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -8729,13 +8821,21 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    }
    mtx_unlock(&builtins_lock);
 
+   if (f == NULL)
+      add_known_non_builtin(state, name);
+
    return ret;
 }
 
-gl_shader *
-_mesa_glsl_get_builtin_function_shader()
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
 {
-   return builtins.shader;
+   ir_function *f;
+   mtx_lock(&builtins_lock);
+   f = builtins.lookup_function(name);
+   mtx_unlock(&builtins_lock);
+
+   return f;
 }
 
 
@@ -48,8 +48,13 @@ extern bool
 _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state,
                                 const char *name);
 
-extern gl_shader *
-_mesa_glsl_get_builtin_function_shader(void);
+/**
+ * Return the built-in function called \p name, or NULL if there is no such
+ * built-in.  Its signatures don't change once it has been
+ * returned, so they can be inspected without holding the built-in lock.
+ */
+extern ir_function *
+_mesa_glsl_get_builtin_function(const char *name);
 
 extern ir_function_signature *
 _mesa_get_main_function_signature(glsl_symbol_table *symbols);
@@ -79,6 +79,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->loop_nesting_ast = NULL;
 
    this->uses_builtin_functions = false;
+   this->non_builtin_names = NULL;
 
    /* Set default language version and extensions */
    this->language_version = 110;
@@ -2144,8 +2145,28 @@ opt_shader_and_create_symbol_table(const struct gl_constants *consts,
 
    validate_ir_tree(shader->ir);
 
-   /* Retain any live IR, but trash the rest. */
-   reparent_ir(shader->ir, shader->ir);
+   /* Retain any live IR, but trash the rest.  The IR was built in the
+    * compile's arena, so copy it out instead of stealing it, which would
+    * keep the whole arena alive for the lifetime of the shader.
+    */
+   exec_list *ir = new(shader) exec_list;
+   clone_ir_list(ir, ir, shader->ir);
+   ralloc_steal(ir, shader->symbols);
+
+   /* The clones' origin is the signature they were cloned from, in the
+    * arena.  Their bodies, if any, were cloned with them.
+    */
+   foreach_in_list(ir_instruction, node, ir) {
+      ir_function *const f = node->as_function();
+
+      if (f == NULL)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures)
+         sig->clear_origin();
+   }
+   ralloc_free(shader->ir);
+   shader->ir = ir;
 
    /* Destroy the symbol table.  Create a new symbol table that contains only
     * the variables and functions that still exist in the IR.  The symbol
@@ -2241,8 +2262,12 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                         false))
       return;
 
-    struct _mesa_glsl_parse_state *state =
-      new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
+   /* The AST, the unoptimized IR and everything else the compile needs
+    * only until it is done live in an arena that is released at the end.
+    */
+   void *arena = ralloc_arena_context(NULL);
+   struct _mesa_glsl_parse_state *state =
+      new(arena) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
 
    if (ctx->Const.GenerateTemporaryNames)
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
@@ -2259,8 +2284,11 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
     */
    if (source_has_shader_include &&
        can_skip_compile(ctx, shader, source, source_sha1, force_recompile,
-                        true))
+                        true)) {
+      delete state->symbols;
+      ralloc_free(arena);
       return;
+   }
 
    if (!state->error) {
      _mesa_glsl_lexer_ctor(state, source);
@@ -2330,7 +2358,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    }
 
    delete state->symbols;
-   ralloc_free(state);
+   ralloc_free(arena);
 
    if (shader->CompileStatus == COMPILE_SUCCESS)
       memcpy(shader->compiled_source_sha1, source_sha1, SHA1_DIGEST_LENGTH);
@@ -911,6 +911,12 @@ struct _mesa_glsl_parse_state {
    bool uses_builtin_functions;
    bool fs_uses_gl_fragcoord;
 
+   /**
+    * Names this compile has looked up that are not built-in functions, so
+    * each of them is only searched for once.  Created on first use.
+    */
+   struct set *non_builtin_names;
+
    /**
     * For geometry shaders, size of the most recently seen input declaration
     * that was a sized array, or 0 if no sized input array declarations have
@@ -1248,6 +1248,15 @@ public:
     */
    void replace_parameters(exec_list *new_params);
 
+   /**
+    * Forget the signature this one was cloned from, e.g. before that one is
+    * freed.  Only valid if the body, if any, was cloned along.
+    */
+   inline void clear_origin()
+   {
+      this->origin = NULL;
+   }
+
    /**
     * Function return type.
     *
@@ -201,7 +201,10 @@ nir_shader_create(void *mem_ctx,
                   const nir_shader_compiler_options *options,
                   shader_info *si)
 {
-   nir_shader *shader = rzalloc(mem_ctx, nir_shader);
+   /* NIR makes huge numbers of tiny allocations that all go away with the
+    * shader, so give each shader its own arena.
+    */
+   nir_shader *shader = rzalloc_arena(mem_ctx, nir_shader);
    ralloc_set_destructor(shader, nir_shader_destructor);
 
 #ifndef NDEBUG
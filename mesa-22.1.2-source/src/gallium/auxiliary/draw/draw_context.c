@@ -1113,9 +1113,34 @@ draw_set_sampler_views(struct draw_context *draw,
    for (i = num; i < draw->num_sampler_views[shader_stage]; ++i)
       draw->sampler_views[shader_stage][i] = NULL;
 
+   memset(draw->sampler_views_tiled[shader_stage], 0,
+          sizeof draw->sampler_views_tiled[shader_stage]);
+
    draw->num_sampler_views[shader_stage] = num;
 }
 
+/**
+ * Tell which of the sampler views last set with draw_set_sampler_views()
+ * have their texels stored in tiles, see lp_static_texture_state::tiled.
+ * Only drivers that lay textures out that way need to call this.
+ */
+void
+draw_set_sampler_views_tiled(struct draw_context *draw,
+                             enum pipe_shader_type shader_stage,
+                             const boolean *tiled,
+                             unsigned num)
+{
+   unsigned i;
+
+   debug_assert(shader_stage < PIPE_SHADER_TYPES);
+   debug_assert(num <= draw->num_sampler_views[shader_stage]);
+
+   draw_do_flush( draw, DRAW_FLUSH_STATE_CHANGE );
+
+   for (i = 0; i < num; ++i)
+      draw->sampler_views_tiled[shader_stage][i] = tiled[i];
+}
+
 void
 draw_set_samplers(struct draw_context *draw,
                   enum pipe_shader_type shader_stage,
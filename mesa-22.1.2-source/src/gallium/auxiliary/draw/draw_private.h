@@ -260,6 +260,11 @@ struct draw_context
 
       boolean test_fse;         /* enable FSE even though its not correct (eg for softpipe) */
       boolean no_fse;           /* disable FSE even when it is correct */
+      boolean reorder_elts;     /* draw static triangle lists reordered for vertex reuse */
+      boolean vs_stats;         /* print the vertex shader invocations of each draw */
+
+      /** reordered index buffers, see draw_pt_reorder.c */
+      struct draw_pt_reorder_cache *reorder;
    } pt;
 
    struct {
@@ -410,6 +415,8 @@ struct draw_context
     */
    struct pipe_sampler_view *sampler_views[PIPE_SHADER_TYPES][PIPE_MAX_SHADER_SAMPLER_VIEWS];
    unsigned num_sampler_views[PIPE_SHADER_TYPES];
+   /** Views whose texels the driver stores in tiles */
+   boolean sampler_views_tiled[PIPE_SHADER_TYPES][PIPE_MAX_SHADER_SAMPLER_VIEWS];
    const struct pipe_sampler_state *samplers[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
    unsigned num_samplers[PIPE_SHADER_TYPES];
 
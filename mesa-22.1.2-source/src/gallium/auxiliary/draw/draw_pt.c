@@ -30,6 +30,8 @@
   *   Keith Whitwell <keithw@vmware.com>
   */
 
+#include <inttypes.h>
+
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_tess.h"
@@ -38,6 +40,7 @@
 #include "draw/draw_vbuf.h"
 #include "draw/draw_vs.h"
 #include "tgsi/tgsi_dump.h"
+#include "util/log.h"
 #include "util/u_math.h"
 #include "util/u_prim.h"
 #include "util/format/u_format.h"
@@ -46,6 +49,8 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(draw_fse, "DRAW_FSE", FALSE)
 DEBUG_GET_ONCE_BOOL_OPTION(draw_no_fse, "DRAW_NO_FSE", FALSE)
+DEBUG_GET_ONCE_BOOL_OPTION(draw_reorder_indices, "DRAW_REORDER_INDICES", FALSE)
+DEBUG_GET_ONCE_BOOL_OPTION(draw_vs_stats, "DRAW_VS_STATS", FALSE)
 
 /* Overall we split things into:
  *     - frontend -- prepare fetch_elts, draw_elts - eg vsplit
@@ -184,6 +189,8 @@ boolean draw_pt_init( struct draw_context *draw )
 {
    draw->pt.test_fse = debug_get_option_draw_fse();
    draw->pt.no_fse = debug_get_option_draw_no_fse();
+   draw->pt.reorder_elts = debug_get_option_draw_reorder_indices();
+   draw->pt.vs_stats = debug_get_option_draw_vs_stats();
 
    draw->pt.front.vsplit = draw_pt_vsplit(draw);
    if (!draw->pt.front.vsplit)
@@ -227,6 +234,8 @@ void draw_pt_destroy( struct draw_context *draw )
       draw->pt.front.vsplit->destroy( draw->pt.front.vsplit );
       draw->pt.front.vsplit = NULL;
    }
+
+   draw_pt_reorder_destroy(draw);
 }
 
 
@@ -505,6 +514,9 @@ draw_vbo(struct draw_context *draw,
    unsigned fpstate = util_fpstate_get();
    struct pipe_draw_info resolved_info;
    struct pipe_draw_start_count_bias resolved_draw;
+   struct pipe_draw_start_count_bias reordered_draw;
+   const void *elts = draw->pt.user.elts;
+   const unsigned elt_max = draw->pt.user.eltMax;
    struct pipe_draw_info *use_info = (struct pipe_draw_info *)info;
    struct pipe_draw_start_count_bias *use_draws = (struct pipe_draw_start_count_bias *)draws;
 
@@ -589,10 +601,25 @@ draw_vbo(struct draw_context *draw,
    }
 
    /* If we're collecting stats then make sure we start from scratch */
-   if (draw->collect_statistics) {
+   if (draw->collect_statistics || draw->pt.vs_stats) {
       memset(&draw->statistics, 0, sizeof(draw->statistics));
    }
 
+   /* Draw the reordered copy of static triangle lists, if there is one */
+   if (draw->pt.reorder_elts && use_info->index_size && num_draws == 1) {
+      const void *reordered = draw_pt_reorder_elts(draw, use_info, &use_draws[0]);
+
+      if (reordered) {
+         reordered_draw = use_draws[0];
+         reordered_draw.start = 0;
+         reordered_draw.count -= reordered_draw.count % 3;
+         use_draws = &reordered_draw;
+
+         draw->pt.user.elts = reordered;
+         draw->pt.user.eltMax = reordered_draw.count;
+      }
+   }
+
    draw->pt.max_index = index_limit - 1;
    draw->start_index = use_draws[0].start;
 
@@ -609,9 +636,24 @@ draw_vbo(struct draw_context *draw,
    } else
       draw_instances(draw, drawid_offset, use_info, use_draws, num_draws);
 
+   draw->pt.user.elts = elts;
+   draw->pt.user.eltMax = elt_max;
+
    /* If requested emit the pipeline statistics for this run */
    if (draw->collect_statistics) {
       draw->render->pipeline_statistics(draw->render, &draw->statistics);
    }
+
+   if (draw->pt.vs_stats) {
+      const struct pipe_query_data_pipeline_statistics *stats = &draw->statistics;
+
+      mesa_logi("draw: %s, %"PRIu64" vertices, %"PRIu64" primitives, "
+                "%"PRIu64" vs invocations (%.3f per primitive)",
+                u_prim_name(use_info->mode),
+                stats->ia_vertices, stats->ia_primitives,
+                stats->vs_invocations,
+                stats->ia_primitives ?
+                (double) stats->vs_invocations / stats->ia_primitives : 0.0);
+   }
    util_fpstate_set(fpstate);
 }
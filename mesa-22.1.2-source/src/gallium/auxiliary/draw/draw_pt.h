@@ -142,6 +142,18 @@ struct vertex_header;
 struct draw_pt_front_end *draw_pt_vsplit(struct draw_context *draw);
 
 
+/* Vertex cache optimised copies of static triangle list indices.
+ */
+struct pipe_draw_info;
+struct pipe_draw_start_count_bias;
+
+const void *draw_pt_reorder_elts(struct draw_context *draw,
+                                 const struct pipe_draw_info *info,
+                                 const struct pipe_draw_start_count_bias *draw_info);
+
+void draw_pt_reorder_destroy(struct draw_context *draw);
+
+
 /* Middle-ends:
  *
  * Currently one general-purpose case which can do all possibilities,
@@ -261,7 +261,7 @@ fetch_pipeline_generic(struct draw_pt_middle_end *middle,
       assert(0);
       return;
    }
-   if (draw->collect_statistics) {
+   if (draw->collect_statistics || draw->pt.vs_stats) {
       draw->statistics.ia_vertices += prim_info->count;
       draw->statistics.ia_primitives +=
          u_decomposed_prims_for_vertices(prim_info->prim, fetch_info->count);
@@ -607,7 +607,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       return;
    }
 
-   if (draw->collect_statistics) {
+   if (draw->collect_statistics || draw->pt.vs_stats) {
       draw->statistics.ia_vertices += prim_info->count;
       if (prim_info->prim == PIPE_PRIM_PATCHES)
          draw->statistics.ia_primitives += prim_info->count / draw->pt.vertices_per_patch;
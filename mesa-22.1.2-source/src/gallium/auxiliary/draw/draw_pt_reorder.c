@@ -0,0 +1,371 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Vertex cache optimisation of triangle list indices.
+ *
+ * vsplit shades each vertex once per segment it is used in, so triangle
+ * lists whose triangles sharing a vertex lie far apart in the index buffer
+ * shade many vertices several times.  With DRAW_REORDER_INDICES set, the
+ * triangles of indexed triangle lists that are drawn more than once with
+ * the same indices are reordered for locality, with Tom Forsyth's "Linear-
+ * Speed Vertex Cache Optimisation", and later draws use the reordered copy.
+ *
+ * The reordered indices are cached by a hash of their contents, as
+ * index buffers are only seen here as mappings and may be written in many
+ * ways.  Reordering changes the order primitives are rasterized in, and
+ * their primitive ids, so this is only correct for rendering which does
+ * not depend on either, hence opt-in.
+ */
+
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+#include "draw/draw_context.h"
+#include "draw/draw_private.h"
+#include "draw/draw_pt.h"
+
+#define XXH_INLINE_ALL
+#include "util/xxhash.h"
+
+#define REORDER_CACHE_ENTRIES 8
+
+/* Draws fitting in a single vsplit segment can't gain anything */
+#define REORDER_MIN_COUNT 1024
+#define REORDER_MAX_COUNT (1 << 21)
+
+/* Size of the modelled vertex cache */
+#define FORSYTH_CACHE_SIZE 32
+
+
+struct draw_pt_reorder_entry {
+   uint64_t hash;
+   unsigned elt_size;
+   unsigned count;
+   /** reordered indices, only made the second time the indices are seen */
+   void *elts;
+};
+
+struct draw_pt_reorder_cache {
+   struct draw_pt_reorder_entry entries[REORDER_CACHE_ENTRIES];
+   unsigned next;
+};
+
+
+static inline unsigned
+get_elt(const void *elts, unsigned elt_size, unsigned i)
+{
+   switch (elt_size) {
+   case 1:
+      return ((const ubyte *) elts)[i];
+   case 2:
+      return ((const ushort *) elts)[i];
+   default:
+      return ((const uint *) elts)[i];
+   }
+}
+
+
+static inline void
+set_elt(void *elts, unsigned elt_size, unsigned i, unsigned value)
+{
+   switch (elt_size) {
+   case 1:
+      ((ubyte *) elts)[i] = value;
+      break;
+   case 2:
+      ((ushort *) elts)[i] = value;
+      break;
+   default:
+      ((uint *) elts)[i] = value;
+      break;
+   }
+}
+
+
+static float
+forsyth_vertex_score(const float *cache_scores, int cache_pos,
+                     unsigned live)
+{
+   float score;
+
+   /* no triangle left to use the vertex */
+   if (live == 0)
+      return -1.0f;
+
+   score = cache_pos >= 0 ? cache_scores[cache_pos] : 0.0f;
+
+   /* boost vertices with few triangles left, to finish them off */
+   return score + 2.0f / sqrtf((float) live);
+}
+
+
+/**
+ * Reorder the triangles of a list for vertex reuse.
+ * \return a new index buffer, or NULL
+ */
+static void *
+forsyth_reorder(const void *elts, unsigned elt_size, unsigned count)
+{
+   const unsigned num_tris = count / 3;
+   float cache_scores[FORSYTH_CACHE_SIZE];
+   int cache[FORSYTH_CACHE_SIZE + 3];
+   unsigned cache_len = 0;
+   unsigned min_elt = ~0u, max_elt = 0, num_verts;
+   unsigned *tri_verts = NULL, *live = NULL, *adj_start = NULL, *adj = NULL;
+   int *cache_pos = NULL;
+   float *vert_scores = NULL, *tri_scores = NULL;
+   ubyte *emitted = NULL;
+   void *out = NULL;
+   unsigned i, j, k, n, cursor = 0;
+   int best;
+
+   for (i = 0; i < num_tris * 3; i++) {
+      unsigned elt = get_elt(elts, elt_size, i);
+      min_elt = MIN2(min_elt, elt);
+      max_elt = MAX2(max_elt, elt);
+   }
+
+   /* leave sparse indices alone rather than mapping them */
+   num_verts = max_elt - min_elt + 1;
+   if (num_verts == 0 || num_verts > num_tris * 3)
+      return NULL;
+
+   tri_verts = MALLOC(num_tris * 3 * sizeof *tri_verts);
+   adj = MALLOC(num_tris * 3 * sizeof *adj);
+   live = CALLOC(num_verts, sizeof *live);
+   adj_start = CALLOC(num_verts + 1, sizeof *adj_start);
+   cache_pos = MALLOC(num_verts * sizeof *cache_pos);
+   vert_scores = MALLOC(num_verts * sizeof *vert_scores);
+   tri_scores = MALLOC(num_tris * sizeof *tri_scores);
+   emitted = CALLOC(num_tris, sizeof *emitted);
+   out = MALLOC(count * elt_size);
+   if (!tri_verts || !adj || !live || !adj_start || !cache_pos ||
+       !vert_scores || !tri_scores || !emitted || !out) {
+      FREE(out);
+      out = NULL;
+      goto done;
+   }
+
+   /* the last triangle's vertices score the same whatever their order */
+   for (i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+      cache_scores[i] = i < 3 ? 0.75f :
+         powf(1.0f - (float) (i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+   }
+
+   /* triangles using each vertex */
+   for (i = 0; i < num_tris * 3; i++) {
+      tri_verts[i] = get_elt(elts, elt_size, i) - min_elt;
+      live[tri_verts[i]]++;
+   }
+   for (i = 0; i < num_verts; i++)
+      adj_start[i + 1] = adj_start[i] + live[i];
+   for (i = 0; i < num_verts; i++)
+      cache_pos[i] = adj_start[i];
+   for (i = 0; i < num_tris * 3; i++)
+      adj[cache_pos[tri_verts[i]]++] = i / 3;
+
+   for (i = 0; i < num_verts; i++) {
+      cache_pos[i] = -1;
+      vert_scores[i] = forsyth_vertex_score(cache_scores, -1, live[i]);
+   }
+
+   best = 0;
+   for (i = 0; i < num_tris; i++) {
+      tri_scores[i] = vert_scores[tri_verts[i * 3 + 0]] +
+                      vert_scores[tri_verts[i * 3 + 1]] +
+                      vert_scores[tri_verts[i * 3 + 2]];
+      if (tri_scores[i] > tri_scores[best])
+         best = i;
+   }
+
+   for (n = 0; n < num_tris; n++) {
+      unsigned new_len = 0, tri_len;
+      int new_cache[FORSYTH_CACHE_SIZE + 3];
+
+      /* nothing left around the cache, carry on in submission order */
+      if (best < 0) {
+         while (emitted[cursor])
+            cursor++;
+         best = cursor;
+      }
+
+      emitted[best] = 1;
+      for (j = 0; j < 3; j++) {
+         const unsigned v = tri_verts[best * 3 + j];
+         unsigned *first = &adj[adj_start[v]];
+
+         set_elt(out, elt_size, n * 3 + j, v + min_elt);
+
+         /* drop the triangle from the vertex's remaining ones */
+         for (k = 0; k < live[v]; k++) {
+            if (first[k] == (unsigned) best) {
+               first[k] = first[live[v] - 1];
+               live[v]--;
+               break;
+            }
+         }
+
+         /* degenerate triangles name a vertex more than once */
+         for (k = 0; k < new_len; k++) {
+            if (new_cache[k] == (int) v)
+               break;
+         }
+         if (k == new_len)
+            new_cache[new_len++] = v;
+      }
+
+      tri_len = new_len;
+      for (i = 0; i < cache_len; i++) {
+         for (k = 0; k < tri_len; k++) {
+            if (new_cache[k] == cache[i])
+               break;
+         }
+         if (k == tri_len)
+            new_cache[new_len++] = cache[i];
+      }
+
+      /* rescore the vertices of the new cache, and those falling out of it,
+       * along with their remaining triangles
+       */
+      best = -1;
+      for (i = 0; i < new_len; i++) {
+         const unsigned v = new_cache[i];
+         const int pos = i < FORSYTH_CACHE_SIZE ? (int) i : -1;
+         const float score = forsyth_vertex_score(cache_scores, pos, live[v]);
+         const float delta = score - vert_scores[v];
+         const unsigned *first = &adj[adj_start[v]];
+
+         cache_pos[v] = pos;
+         vert_scores[v] = score;
+
+         for (k = 0; k < live[v]; k++) {
+            tri_scores[first[k]] += delta;
+            if (pos >= 0 &&
+                (best < 0 || tri_scores[first[k]] > tri_scores[best]))
+               best = first[k];
+         }
+      }
+
+      cache_len = MIN2(new_len, FORSYTH_CACHE_SIZE);
+      memcpy(cache, new_cache, cache_len * sizeof cache[0]);
+   }
+
+done:
+   FREE(tri_verts);
+   FREE(adj);
+   FREE(live);
+   FREE(adj_start);
+   FREE(cache_pos);
+   FREE(vert_scores);
+   FREE(tri_scores);
+   FREE(emitted);
+   return out;
+}
+
+
+/**
+ * Return the reordered copy of the draw's indices, or NULL to draw them
+ * as they are.  Reordered indices start at zero, and still need the
+ * draw's index bias.
+ */
+const void *
+draw_pt_reorder_elts(struct draw_context *draw,
+                     const struct pipe_draw_info *info,
+                     const struct pipe_draw_start_count_bias *draw_info)
+{
+   struct draw_pt_reorder_cache *cache = draw->pt.reorder;
+   struct draw_pt_reorder_entry *entry;
+   const unsigned elt_size = draw->pt.user.eltSize;
+   const unsigned start = draw_info->start;
+   const unsigned count = draw_info->count - draw_info->count % 3;
+   const ubyte *elts;
+   uint64_t hash;
+   unsigned i;
+
+   if (info->mode != PIPE_PRIM_TRIANGLES ||
+       !elt_size ||
+       info->primitive_restart ||
+       count < REORDER_MIN_COUNT ||
+       count > REORDER_MAX_COUNT ||
+       start + count < start ||
+       start + count > draw->pt.user.eltMax)
+      return NULL;
+
+   /* the primitives reach these in the new order too */
+   if (draw->gs.geometry_shader ||
+       draw->tes.tess_eval_shader ||
+       draw->so.num_targets)
+      return NULL;
+
+   if (!cache) {
+      cache = CALLOC_STRUCT(draw_pt_reorder_cache);
+      if (!cache)
+         return NULL;
+      draw->pt.reorder = cache;
+   }
+
+   elts = (const ubyte *) draw->pt.user.elts + start * elt_size;
+   hash = XXH64(elts, count * elt_size, 0);
+
+   for (i = 0; i < REORDER_CACHE_ENTRIES; i++) {
+      entry = &cache->entries[i];
+      if (entry->hash == hash &&
+          entry->elt_size == elt_size &&
+          entry->count == count) {
+         if (!entry->elts)
+            entry->elts = forsyth_reorder(elts, elt_size, count);
+         return entry->elts;
+      }
+   }
+
+   /* first time around, only remember the indices */
+   entry = &cache->entries[cache->next];
+   cache->next = (cache->next + 1) % REORDER_CACHE_ENTRIES;
+
+   FREE(entry->elts);
+   entry->hash = hash;
+   entry->elt_size = elt_size;
+   entry->count = count;
+   entry->elts = NULL;
+
+   return NULL;
+}
+
+
+void
+draw_pt_reorder_destroy(struct draw_context *draw)
+{
+   struct draw_pt_reorder_cache *cache = draw->pt.reorder;
+   unsigned i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < REORDER_CACHE_ENTRIES; i++)
+      FREE(cache->entries[i].elts);
+
+   FREE(cache);
+   draw->pt.reorder = NULL;
+}
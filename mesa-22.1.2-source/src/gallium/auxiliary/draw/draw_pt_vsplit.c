@@ -29,9 +29,15 @@
 #include "draw/draw_context.h"
 #include "draw/draw_private.h"
 #include "draw/draw_pt.h"
+#include "draw/draw_vbuf.h"
 
 #define SEGMENT_SIZE 1024
-#define MAP_SIZE     256
+#define MAP_BITS     11
+#define MAP_SIZE     (1 << MAP_BITS)
+
+/* List primitives are split by fetched vertices, so a segment may hold
+ * more draw elements than that. */
+#define DRAW_ELTS_SIZE (4 * SEGMENT_SIZE)
 
 /* The largest possible index within an index buffer */
 #define MAX_ELT_IDX 0xffffffff
@@ -46,17 +52,21 @@ struct vsplit_frontend {
 
    unsigned max_vertices;
    ushort segment_size;
+   ushort draw_elts_size;
 
    /* buffers for splitting */
    unsigned fetch_elts[SEGMENT_SIZE];
-   ushort draw_elts[SEGMENT_SIZE];
+   ushort draw_elts[DRAW_ELTS_SIZE];
    ushort identity_draw_elts[SEGMENT_SIZE];
 
    struct {
-      /* map a fetch element to a draw element */
+      /* map a fetch element to a draw element, open addressed with linear
+       * probing;  an entry is only valid when its stamp is the current one
+       */
       unsigned fetches[MAP_SIZE];
       ushort draws[MAP_SIZE];
-      boolean has_max_fetch;
+      ushort stamps[MAP_SIZE];
+      ushort stamp;
 
       ushort num_fetch_elts;
       ushort num_draw_elts;
@@ -67,8 +77,10 @@ struct vsplit_frontend {
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
-   vsplit->cache.has_max_fetch = FALSE;
+   if (++vsplit->cache.stamp == 0) {
+      memset(vsplit->cache.stamps, 0, sizeof(vsplit->cache.stamps));
+      vsplit->cache.stamp = 1;
+   }
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
 }
@@ -83,26 +95,34 @@ vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
 
 /**
  * Add a fetch element and add it to the draw elements.
+ *
+ * A segment never fetches more than SEGMENT_SIZE elements, so the map is
+ * at most half full and every element fetched by the segment is found
+ * again, whatever its distance from its previous use.
  */
 static inline void
 vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch)
 {
    unsigned hash;
 
-   hash = fetch % MAP_SIZE;
+   hash = (fetch * 0x9e3779b1u) >> (32 - MAP_BITS);
 
-   /* If the value isn't in the cache or it's an overflow due to the
-    * element bias */
-   if (vsplit->cache.fetches[hash] != fetch) {
+   while (vsplit->cache.stamps[hash] == vsplit->cache.stamp &&
+          vsplit->cache.fetches[hash] != fetch)
+      hash = (hash + 1) % MAP_SIZE;
+
+   if (vsplit->cache.stamps[hash] != vsplit->cache.stamp) {
       /* update cache */
       vsplit->cache.fetches[hash] = fetch;
       vsplit->cache.draws[hash] = vsplit->cache.num_fetch_elts;
+      vsplit->cache.stamps[hash] = vsplit->cache.stamp;
 
       /* add fetch */
       assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
       vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
    }
 
+   assert(vsplit->cache.num_draw_elts < DRAW_ELTS_SIZE);
    vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[hash];
 }
 
@@ -125,12 +145,6 @@ vsplit_add_cache_ubyte(struct vsplit_frontend *vsplit, const ubyte *elts,
    unsigned elt_idx;
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -142,12 +156,6 @@ vsplit_add_cache_ushort(struct vsplit_frontend *vsplit, const ushort *elts,
    unsigned elt_idx;
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -167,13 +175,6 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
     */
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* Take care for DRAW_MAX_FETCH_IDX (since cache is initialized to -1). */
-   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      /* force update - any value will do except DRAW_MAX_FETCH_IDX */
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -229,6 +230,14 @@ static void vsplit_prepare(struct draw_pt_front_end *frontend,
    middle->prepare(middle, vsplit->prim, opt, &vsplit->max_vertices);
 
    vsplit->segment_size = MIN2(SEGMENT_SIZE, vsplit->max_vertices);
+
+   /* The draw elements of a segment may be handed to the render as is, so
+    * don't go past what it can take at once.
+    */
+   vsplit->draw_elts_size = DRAW_ELTS_SIZE;
+   if (vsplit->draw->render)
+      vsplit->draw_elts_size = MIN2(vsplit->draw_elts_size,
+                                    vsplit->draw->render->max_indices);
 }
 
 
@@ -254,6 +263,8 @@ struct draw_pt_front_end *draw_pt_vsplit(struct draw_context *draw)
    struct vsplit_frontend *vsplit = CALLOC_STRUCT(vsplit_frontend);
    ushort i;
 
+   STATIC_ASSERT(MAP_SIZE >= 2 * SEGMENT_SIZE);
+
    if (!vsplit)
       return NULL;
 
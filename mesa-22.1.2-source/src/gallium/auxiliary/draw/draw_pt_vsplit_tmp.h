@@ -206,6 +206,46 @@ CONCAT(vsplit_segment_fan_, ELT_TYPE)(struct vsplit_frontend *vsplit,
          flags, istart, icount, use_spoken, i0, FALSE, 0);
 }
 
+/**
+ * Split a list of primitives into segments ending when the cache could
+ * overflow, rather than after a fixed number of elements.  The vertices
+ * shared by the primitives of a segment are only shaded once, so the
+ * fewer the segments, the fewer vertices are shaded more than once.
+ */
+static void
+CONCAT(vsplit_segment_list_, ELT_TYPE)(struct vsplit_frontend *vsplit,
+                                       unsigned istart, unsigned icount,
+                                       unsigned incr)
+{
+   struct draw_context *draw = vsplit->draw;
+   const ELT_TYPE *ib = (const ELT_TYPE *) draw->pt.user.elts;
+   const int ibias = draw->pt.user.eltBias;
+   unsigned flags = DRAW_SPLIT_AFTER;
+   unsigned i = 0, j;
+
+   assert(incr <= vsplit->segment_size);
+   assert(incr <= vsplit->draw_elts_size);
+
+   while (i < icount) {
+      vsplit_clear_cache(vsplit);
+
+      do {
+         for (j = 0; j < incr; j++)
+            ADD_CACHE(vsplit, ib, istart, i + j, ibias);
+         i += incr;
+      } while (i < icount &&
+               vsplit->cache.num_fetch_elts + incr <= vsplit->segment_size &&
+               vsplit->cache.num_draw_elts + incr <= vsplit->draw_elts_size);
+
+      if (i >= icount)
+         flags &= ~DRAW_SPLIT_AFTER;
+
+      vsplit_flush_cache(vsplit, flags);
+
+      flags |= DRAW_SPLIT_BEFORE;
+   }
+}
+
 #define LOCAL_VARS                                                         \
    struct vsplit_frontend *vsplit = (struct vsplit_frontend *) frontend;   \
    const unsigned prim = vsplit->prim;                                     \
@@ -216,6 +256,9 @@ CONCAT(vsplit_segment_fan_, ELT_TYPE)(struct vsplit_frontend *vsplit,
 #define PRIMITIVE(istart, icount)   \
    CONCAT(vsplit_primitive_, ELT_TYPE)(vsplit, istart, icount)
 
+#define SEGMENT_LIST(istart, icount, incr)   \
+   CONCAT(vsplit_segment_list_, ELT_TYPE)(vsplit, istart, icount, incr)
+
 #else /* ELT_TYPE */
 
 static void
@@ -91,6 +91,13 @@ FUNC(FUNC_VARS)
       case PIPE_PRIM_LINE_STRIP_ADJACENCY:
       case PIPE_PRIM_TRIANGLES_ADJACENCY:
       case PIPE_PRIM_TRIANGLE_STRIP_ADJACENCY:
+#ifdef SEGMENT_LIST
+         /* lists can be split anywhere between two primitives */
+         if (rollback == 0) {
+            SEGMENT_LIST(start, count, incr);
+            break;
+         }
+#endif
          seg_max =
             draw_pt_trim_count(MIN2(max_count_simple, count), first, incr);
          if (prim == PIPE_PRIM_TRIANGLE_STRIP ||
@@ -178,3 +185,4 @@ FUNC(FUNC_VARS)
 #undef SEGMENT_SIMPLE
 #undef SEGMENT_LOOP
 #undef SEGMENT_FAN
+#undef SEGMENT_LIST
@@ -60,6 +60,7 @@ static const struct debug_named_value lp_bld_perf_flags[] = {
    { "no_quad_lod", GALLIVM_PERF_NO_QUAD_LOD, "disable quad_lod optimization" },
    { "no_aos_sampling", GALLIVM_PERF_NO_AOS_SAMPLING, "disable aos sampling optimization" },
    { "nopt",   GALLIVM_PERF_NO_OPT, "disable optimization passes to speed up shader compilation" },
+   { "avx512", GALLIVM_PERF_AVX512, "use 512 bit vectors on AVX-512 CPUs" },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -445,9 +446,31 @@ lp_build_init(void)
       util_cpu_caps.has_avx2 = 0;
       util_cpu_caps.has_f16c = 0;
       util_cpu_caps.has_fma = 0;
+      util_cpu_caps.has_avx512f = 0;
+      util_cpu_caps.has_avx512bw = 0;
+      util_cpu_caps.has_avx512dq = 0;
+      util_cpu_caps.has_avx512vl = 0;
    }
 #endif
 
+#if LLVM_VERSION_MAJOR >= 4
+   /* 512 bit vectors are opt-in (GALLIVM_PERF=avx512): they speed up ALU
+    * and depth bound shaders, but texturing and blending still work on
+    * 256 bit halves and get slower (see lp_test_vector_width).
+    *
+    * Only use them when the byte/word and dword/qword extensions are there
+    * too (Skylake-X and later); without them much of the 8 and 16 bit
+    * pack/unpack code falls apart into 256 bit halves.  (Older LLVM
+    * versions have AVX-512 code generation disabled anyway.)
+    */
+   if ((gallivm_perf & GALLIVM_PERF_AVX512) &&
+       util_get_cpu_caps()->has_avx512f &&
+       util_get_cpu_caps()->has_avx512bw &&
+       util_get_cpu_caps()->has_avx512dq &&
+       util_get_cpu_caps()->has_avx512vl) {
+      lp_native_vector_width = 512;
+   } else
+#endif
    if (util_get_cpu_caps()->has_avx2 || util_get_cpu_caps()->has_avx) {
       lp_native_vector_width = 256;
    } else {
@@ -498,6 +498,25 @@ lp_build_any_true_range(struct lp_build_context *bld,
 
    assert(real_length <= bld->type.length);
 
+   if (real_length == bld->type.length &&
+       bld->type.width * bld->type.length == 512 &&
+       util_get_cpu_caps()->has_avx512f &&
+       (bld->type.width >= 32 || util_get_cpu_caps()->has_avx512bw)) {
+      /*
+       * There's no ptest for 512 bit vectors, compare into a mask
+       * register instead and test that (kortest).
+       */
+      LLVMTypeRef int_vec_type = lp_build_int_vec_type(bld->gallivm, bld->type);
+      LLVMTypeRef mask_type = LLVMIntTypeInContext(bld->gallivm->context,
+                                                   bld->type.length);
+      val = LLVMBuildBitCast(builder, val, int_vec_type, "");
+      val = LLVMBuildICmp(builder, LLVMIntNE, val,
+                          LLVMConstNull(int_vec_type), "");
+      val = LLVMBuildBitCast(builder, val, mask_type, "");
+      return LLVMBuildICmp(builder, LLVMIntNE,
+                           val, LLVMConstNull(mask_type), "");
+   }
+
    true_type = LLVMIntTypeInContext(bld->gallivm->context,
                                     bld->type.width * real_length);
    scalar_type = LLVMIntTypeInContext(bld->gallivm->context,
@@ -2104,16 +2104,120 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 }
 
 
+/**
+ * Move bit i of each element to bit 2*i, for the Morton order of the
+ * blocks inside a tile.  Only the low nbits bits of v may be set.
+ */
+static LLVMValueRef
+lp_build_spread_bits(struct lp_build_context *bld,
+                     LLVMValueRef v,
+                     unsigned nbits)
+{
+   static const struct {
+      unsigned shift;
+      unsigned mask;
+   } steps[] = {
+      { 8, 0x00ff00ff },
+      { 4, 0x0f0f0f0f },
+      { 2, 0x33333333 },
+      { 1, 0x55555555 },
+   };
+   LLVMBuilderRef builder = bld->gallivm->builder;
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(steps); i++) {
+      if (nbits > steps[i].shift) {
+         LLVMValueRef shift = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                                     steps[i].shift);
+         LLVMValueRef mask = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                                    steps[i].mask);
+         v = LLVMBuildOr(builder, v, LLVMBuildShl(builder, v, shift, ""), "");
+         v = LLVMBuildAnd(builder, v, mask, "");
+      }
+   }
+
+   return v;
+}
+
+
+/**
+ * Compute the offset of a pixel block in a tiled texture (see
+ * lp_static_texture_state::tiled), without the z part.
+ */
+static LLVMValueRef
+lp_build_sample_tiled_offset(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   const unsigned block_bytes = format_desc->block.bits / 8;
+   const unsigned tile_log2 = lp_sampler_tile_log2(block_bytes);
+   LLVMValueRef one = lp_build_const_int_vec(gallivm, bld->type, 1);
+   LLVMValueRef tile_shift = lp_build_const_int_vec(gallivm, bld->type,
+                                                    tile_log2);
+   LLVMValueRef tile_mask = lp_build_const_int_vec(gallivm, bld->type,
+                                                   (1 << tile_log2) - 1);
+   LLVMValueRef tile_bytes =
+      lp_build_const_int_vec(gallivm, bld->type,
+                             block_bytes << (2 * tile_log2));
+   LLVMValueRef block_x, block_y, morton, offset;
+
+   /* With a stride of one these give the block coordinates. */
+   lp_build_sample_partial_offset(bld, format_desc->block.width,
+                                  x, one, &block_x, out_i);
+
+   offset = LLVMBuildLShr(builder, block_x, tile_shift, "");
+   offset = lp_build_mul(bld, offset, tile_bytes);
+   morton = lp_build_spread_bits(bld,
+                                 LLVMBuildAnd(builder, block_x, tile_mask, ""),
+                                 tile_log2);
+
+   if (y && y_stride) {
+      LLVMValueRef y_offset, y_morton;
+
+      lp_build_sample_partial_offset(bld, format_desc->block.height,
+                                     y, one, &block_y, out_j);
+
+      y_offset = LLVMBuildLShr(builder, block_y, tile_shift, "");
+      y_offset = lp_build_mul(bld, y_offset, y_stride);
+      offset = lp_build_add(bld, offset, y_offset);
+
+      y_morton = lp_build_spread_bits(bld,
+                                      LLVMBuildAnd(builder, block_y,
+                                                   tile_mask, ""),
+                                      tile_log2);
+      y_morton = LLVMBuildShl(builder, y_morton, one, "");
+      morton = LLVMBuildOr(builder, morton, y_morton, "");
+   }
+   else {
+      *out_j = bld->zero;
+   }
+
+   morton = lp_build_mul(bld, morton,
+                         lp_build_const_int_vec(gallivm, bld->type,
+                                                block_bytes));
+
+   return lp_build_add(bld, offset, morton);
+}
+
+
 /**
  * Compute the offset of a pixel block.
  *
  * x, y, z, y_stride, z_stride are vectors, and they refer to pixels.
+ * tiled says whether the texture uses the tiled layout.
  *
  * Returns the relative offset and i,j sub-block coordinates
  */
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -2126,24 +2230,31 @@ lp_build_sample_offset(struct lp_build_context *bld,
    LLVMValueRef x_stride;
    LLVMValueRef offset;
 
-   x_stride = lp_build_const_vec(bld->gallivm, bld->type,
-                                 format_desc->block.bits/8);
-
-   lp_build_sample_partial_offset(bld,
-                                  format_desc->block.width,
-                                  x, x_stride,
-                                  &offset, out_i);
-
-   if (y && y_stride) {
-      LLVMValueRef y_offset;
-      lp_build_sample_partial_offset(bld,
-                                     format_desc->block.height,
-                                     y, y_stride,
-                                     &y_offset, out_j);
-      offset = lp_build_add(bld, offset, y_offset);
+   if (tiled) {
+      offset = lp_build_sample_tiled_offset(bld, format_desc,
+                                            x, y, y_stride,
+                                            out_i, out_j);
    }
    else {
-      *out_j = bld->zero;
+      x_stride = lp_build_const_vec(bld->gallivm, bld->type,
+                                    format_desc->block.bits/8);
+
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.width,
+                                     x, x_stride,
+                                     &offset, out_i);
+
+      if (y && y_stride) {
+         LLVMValueRef y_offset;
+         lp_build_sample_partial_offset(bld,
+                                        format_desc->block.height,
+                                        y, y_stride,
+                                        &y_offset, out_j);
+         offset = lp_build_add(bld, offset, y_offset);
+      }
+      else {
+         *out_j = bld->zero;
+      }
    }
 
    if (z && z_stride) {
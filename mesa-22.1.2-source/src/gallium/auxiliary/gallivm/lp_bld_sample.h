@@ -36,8 +36,10 @@
 #define LP_BLD_SAMPLE_H
 
 
+#include "pipe/p_defines.h"
 #include "pipe/p_format.h"
 #include "util/u_debug.h"
+#include "util/u_math.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_type.h"
 #include "gallivm/lp_bld_swizzle.h"
@@ -175,9 +177,36 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+
+   /**
+    * The texels are stored in tiles rather than row by row.
+    *
+    * A tile is a square of 2^n x 2^n pixel blocks holding at most
+    * LP_TILED_TEXTURE_BYTES, see lp_sampler_tile_log2().  The blocks inside
+    * a tile are in Morton (Z) order, the tiles of an image are stored row by
+    * row, and the row stride is the size of a row of tiles.
+    *
+    * This is a property of the driver's resource, so it is never set by
+    * lp_sampler_static_texture_state(), but by the driver itself.
+    */
+   unsigned tiled:1;
 };
 
 
+#define LP_TILED_TEXTURE_BYTES 4096
+
+
+/**
+ * log2 of the width and height in blocks of the tiles of a tiled texture
+ * with the given block size in bytes.
+ */
+static inline unsigned
+lp_sampler_tile_log2(unsigned block_bytes)
+{
+   return util_logbase2(LP_TILED_TEXTURE_BYTES / block_bytes) / 2;
+}
+
+
 /**
  * Sampler static state.
  *
@@ -675,6 +704,7 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -32,6 +32,9 @@
  * Although the SSE intrinsics are support by all modern x86 and x86-64 
  * compilers, there are some intrisincs missing in some implementations 
  * (especially older MSVC versions). This header abstracts that away.
+ *
+ * On AArch64 the helpers are only available through u_sse_neon.h, which
+ * provides the SSE2 integer intrinsics they use on top of NEON.
  */
 
 #ifndef U_SSE_H_
@@ -45,6 +48,11 @@
 
 #include <emmintrin.h>
 
+#endif
+
+
+#if defined(PIPE_ARCH_SSE) || defined(U_SSE_NEON)
+
 
 union m128i {
    __m128i m;
@@ -115,6 +123,7 @@ static inline void u_print_epi32(const char *name, __m128i r)
                 u.ui[0],  u.ui[1],  u.ui[2],  u.ui[3]);
 }
 
+#if defined(PIPE_ARCH_SSE)
 static inline void u_print_ps(const char *name, __m128 r)
 {
    union { __m128 m; float f[4]; } u;
@@ -128,6 +137,7 @@ static inline void u_print_ps(const char *name, __m128 r)
                 name,
                 u.f[0],  u.f[1],  u.f[2],  u.f[3]);
 }
+#endif
 
 
 #define U_DUMP_EPI32(a) u_print_epi32(#a, a)
@@ -667,6 +677,6 @@ util_sse2_stretch_row_8unorm(__m128i * restrict dst,
 
 
 
-#endif /* PIPE_ARCH_SSE */
+#endif /* PIPE_ARCH_SSE || U_SSE_NEON */
 
 #endif /* U_SSE_H_ */
@@ -0,0 +1,378 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * The SSE2 integer intrinsics used by the u_sse.h helpers and by llvmpipe's
+ * linear rasterizer, implemented with NEON on AArch64.
+ *
+ * These are the reserved _mm_* and __m128i names, so only the code that
+ * shares its SSE2 kernels with AArch64 includes this header, instead of
+ * u_sse.h, which it includes itself.  On other architectures it is the same
+ * as u_sse.h.
+ */
+
+#ifndef U_SSE_NEON_H_
+#define U_SSE_NEON_H_
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_AARCH64)
+
+#ifdef U_SSE_H_
+#error "u_sse_neon.h must be included before util/u_sse.h"
+#endif
+
+/*
+ * Each intrinsic is mostly one or two NEON instructions.  Shift counts and
+ * shuffle selectors are meant to be constants, like the SSE2 immediates
+ * they stand for, so that they fold away once inlined.
+ */
+
+#include <arm_neon.h>
+
+typedef int32x4_t __m128i;
+
+#define _MM_SHUFFLE(z, y, x, w) (((z) << 6) | ((y) << 4) | ((x) << 2) | (w))
+
+#define U_NEON_S8(a)  vreinterpretq_s8_s32(a)
+#define U_NEON_U8(a)  vreinterpretq_u8_s32(a)
+#define U_NEON_S16(a) vreinterpretq_s16_s32(a)
+#define U_NEON_U16(a) vreinterpretq_u16_s32(a)
+#define U_NEON_U32(a) vreinterpretq_u32_s32(a)
+#define U_NEON_S64(a) vreinterpretq_s64_s32(a)
+#define U_NEON_U64(a) vreinterpretq_u64_s32(a)
+
+static inline __m128i
+_mm_setzero_si128(void)
+{
+   return vdupq_n_s32(0);
+}
+
+static inline __m128i
+_mm_set1_epi32(int i)
+{
+   return vdupq_n_s32(i);
+}
+
+static inline __m128i
+_mm_set1_epi16(short w)
+{
+   return vreinterpretq_s32_s16(vdupq_n_s16(w));
+}
+
+static inline __m128i
+_mm_setr_epi32(int e0, int e1, int e2, int e3)
+{
+   const int32_t v[4] = { e0, e1, e2, e3 };
+   return vld1q_s32(v);
+}
+
+static inline __m128i
+_mm_set_epi32(int e3, int e2, int e1, int e0)
+{
+   return _mm_setr_epi32(e0, e1, e2, e3);
+}
+
+static inline __m128i
+_mm_setr_epi16(short e0, short e1, short e2, short e3,
+               short e4, short e5, short e6, short e7)
+{
+   const int16_t v[8] = { e0, e1, e2, e3, e4, e5, e6, e7 };
+   return vreinterpretq_s32_s16(vld1q_s16(v));
+}
+
+static inline __m128i
+_mm_cvtsi32_si128(int a)
+{
+   return vsetq_lane_s32(a, vdupq_n_s32(0), 0);
+}
+
+static inline __m128i
+_mm_load_si128(const __m128i *p)
+{
+   return vld1q_s32((const int32_t *)p);
+}
+
+static inline __m128i
+_mm_loadu_si128(const __m128i *p)
+{
+   return vld1q_s32((const int32_t *)p);
+}
+
+static inline __m128i
+_mm_loadl_epi64(const __m128i *p)
+{
+   return vcombine_s32(vld1_s32((const int32_t *)p), vdup_n_s32(0));
+}
+
+static inline void
+_mm_store_si128(__m128i *p, __m128i a)
+{
+   vst1q_s32((int32_t *)p, a);
+}
+
+static inline void
+_mm_storeu_si128(__m128i *p, __m128i a)
+{
+   vst1q_s32((int32_t *)p, a);
+}
+
+static inline __m128i
+_mm_and_si128(__m128i a, __m128i b)
+{
+   return vandq_s32(a, b);
+}
+
+static inline __m128i
+_mm_or_si128(__m128i a, __m128i b)
+{
+   return vorrq_s32(a, b);
+}
+
+/* ~a & b */
+static inline __m128i
+_mm_andnot_si128(__m128i a, __m128i b)
+{
+   return vbicq_s32(b, a);
+}
+
+static inline __m128i
+_mm_add_epi8(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s8(vaddq_s8(U_NEON_S8(a), U_NEON_S8(b)));
+}
+
+static inline __m128i
+_mm_add_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s16(vaddq_s16(U_NEON_S16(a), U_NEON_S16(b)));
+}
+
+static inline __m128i
+_mm_add_epi32(__m128i a, __m128i b)
+{
+   return vaddq_s32(a, b);
+}
+
+static inline __m128i
+_mm_sub_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s16(vsubq_s16(U_NEON_S16(a), U_NEON_S16(b)));
+}
+
+static inline __m128i
+_mm_sub_epi64(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s64(vsubq_s64(U_NEON_S64(a), U_NEON_S64(b)));
+}
+
+static inline __m128i
+_mm_mullo_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s16(vmulq_s16(U_NEON_S16(a), U_NEON_S16(b)));
+}
+
+/* Multiply the 16 bit elements and add adjacent pairs of the products. */
+static inline __m128i
+_mm_madd_epi16(__m128i a, __m128i b)
+{
+   int32x4_t lo = vmull_s16(vget_low_s16(U_NEON_S16(a)),
+                            vget_low_s16(U_NEON_S16(b)));
+   int32x4_t hi = vmull_high_s16(U_NEON_S16(a), U_NEON_S16(b));
+   return vpaddq_s32(lo, hi);
+}
+
+/* Widening multiply of the even 32 bit elements. */
+static inline __m128i
+_mm_mul_epu32(__m128i a, __m128i b)
+{
+   uint32x2_t a02 = vmovn_u64(U_NEON_U64(a));
+   uint32x2_t b02 = vmovn_u64(U_NEON_U64(b));
+   return vreinterpretq_s32_u64(vmull_u32(a02, b02));
+}
+
+static inline __m128i
+_mm_min_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s16(vminq_s16(U_NEON_S16(a), U_NEON_S16(b)));
+}
+
+static inline __m128i
+_mm_max_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s16(vmaxq_s16(U_NEON_S16(a), U_NEON_S16(b)));
+}
+
+static inline __m128i
+_mm_cmpeq_epi32(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_u32(vceqq_s32(a, b));
+}
+
+/*
+ * NEON shifts by a register shift left for positive counts and right for
+ * negative ones, and like SSE2 they flush to zero (or to the sign) once
+ * the count reaches the element size.
+ */
+
+static inline __m128i
+_mm_slli_epi32(__m128i a, int imm)
+{
+   return vshlq_s32(a, vdupq_n_s32(imm));
+}
+
+static inline __m128i
+_mm_srli_epi32(__m128i a, int imm)
+{
+   return vreinterpretq_s32_u32(vshlq_u32(U_NEON_U32(a), vdupq_n_s32(-imm)));
+}
+
+static inline __m128i
+_mm_srai_epi32(__m128i a, int imm)
+{
+   return vshlq_s32(a, vdupq_n_s32(-(imm > 31 ? 31 : imm)));
+}
+
+static inline __m128i
+_mm_srli_epi16(__m128i a, int imm)
+{
+   return vreinterpretq_s32_u16(vshlq_u16(U_NEON_U16(a),
+                                          vdupq_n_s16(-imm)));
+}
+
+static inline __m128i
+_mm_srai_epi16(__m128i a, int imm)
+{
+   return vreinterpretq_s32_s16(vshlq_s16(U_NEON_S16(a),
+                                          vdupq_n_s16(-(imm > 15 ? 15 : imm))));
+}
+
+static inline __m128i
+_mm_slli_epi64(__m128i a, int imm)
+{
+   return vreinterpretq_s32_u64(vshlq_u64(U_NEON_U64(a), vdupq_n_s64(imm)));
+}
+
+static inline __m128i
+_mm_srli_epi64(__m128i a, int imm)
+{
+   return vreinterpretq_s32_u64(vshlq_u64(U_NEON_U64(a), vdupq_n_s64(-imm)));
+}
+
+/*
+ * The shuffles turn the selector into byte indices for a single table
+ * lookup: element i of the result takes bytes sel(i) * size + [0, size).
+ */
+
+static inline __m128i
+_mm_shuffle_epi32(__m128i a, int imm)
+{
+   const uint32_t sel[4] = {
+      imm & 3, (imm >> 2) & 3, (imm >> 4) & 3, (imm >> 6) & 3
+   };
+   uint32x4_t idx = vmlaq_n_u32(vdupq_n_u32(0x03020100),
+                                vld1q_u32(sel), 0x04040404);
+   return vreinterpretq_s32_u8(vqtbl1q_u8(U_NEON_U8(a),
+                                          vreinterpretq_u8_u32(idx)));
+}
+
+static inline __m128i
+_mm_shufflelo_epi16(__m128i a, int imm)
+{
+   const uint16_t sel[8] = {
+      imm & 3, (imm >> 2) & 3, (imm >> 4) & 3, (imm >> 6) & 3,
+      4, 5, 6, 7
+   };
+   uint16x8_t idx = vmlaq_n_u16(vdupq_n_u16(0x0100),
+                                vld1q_u16(sel), 0x0202);
+   return vreinterpretq_s32_u8(vqtbl1q_u8(U_NEON_U8(a),
+                                          vreinterpretq_u8_u16(idx)));
+}
+
+static inline __m128i
+_mm_shufflehi_epi16(__m128i a, int imm)
+{
+   const uint16_t sel[8] = {
+      0, 1, 2, 3,
+      4 + (imm & 3), 4 + ((imm >> 2) & 3),
+      4 + ((imm >> 4) & 3), 4 + ((imm >> 6) & 3)
+   };
+   uint16x8_t idx = vmlaq_n_u16(vdupq_n_u16(0x0100),
+                                vld1q_u16(sel), 0x0202);
+   return vreinterpretq_s32_u8(vqtbl1q_u8(U_NEON_U8(a),
+                                          vreinterpretq_u8_u16(idx)));
+}
+
+static inline __m128i
+_mm_unpacklo_epi8(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s8(vzip1q_s8(U_NEON_S8(a), U_NEON_S8(b)));
+}
+
+static inline __m128i
+_mm_unpackhi_epi8(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_s8(vzip2q_s8(U_NEON_S8(a), U_NEON_S8(b)));
+}
+
+static inline __m128i
+_mm_unpacklo_epi32(__m128i a, __m128i b)
+{
+   return vzip1q_s32(a, b);
+}
+
+static inline __m128i
+_mm_unpackhi_epi32(__m128i a, __m128i b)
+{
+   return vzip2q_s32(a, b);
+}
+
+static inline __m128i
+_mm_unpacklo_epi64(__m128i a, __m128i b)
+{
+   return vcombine_s32(vget_low_s32(a), vget_low_s32(b));
+}
+
+static inline __m128i
+_mm_unpackhi_epi64(__m128i a, __m128i b)
+{
+   return vcombine_s32(vget_high_s32(a), vget_high_s32(b));
+}
+
+/* Saturate the signed 16 bit elements of a and b to unsigned 8 bits. */
+static inline __m128i
+_mm_packus_epi16(__m128i a, __m128i b)
+{
+   return vreinterpretq_s32_u8(vcombine_u8(vqmovun_s16(U_NEON_S16(a)),
+                                           vqmovun_s16(U_NEON_S16(b))));
+}
+
+/* Enables the u_sse.h helpers. */
+#define U_SSE_NEON 1
+
+#endif /* PIPE_ARCH_AARCH64 */
+
+#include "util/u_sse.h"
+
+#endif /* U_SSE_NEON_H_ */
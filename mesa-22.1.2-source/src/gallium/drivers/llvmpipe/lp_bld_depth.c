@@ -447,6 +447,19 @@ lp_build_occlusion_count(struct gallivm_state *gallivm,
                                        LLVMInt32TypeInContext(context), bits);
       count = LLVMBuildZExt(builder, count, LLVMIntTypeInContext(context, 64), "");
    }
+   else if(util_get_cpu_caps()->has_avx512f && type.length == 16) {
+      /* Compare into a mask register and count its bits. */
+      LLVMTypeRef int_vec_type = lp_build_int_vec_type(gallivm, type);
+      LLVMValueRef bits = LLVMBuildBitCast(builder, maskvalue, int_vec_type, "");
+      bits = LLVMBuildICmp(builder, LLVMIntNE, bits,
+                           LLVMConstNull(int_vec_type), "");
+      bits = LLVMBuildBitCast(builder, bits,
+                              LLVMIntTypeInContext(context, 16), "");
+      bits = LLVMBuildZExt(builder, bits, LLVMInt32TypeInContext(context), "");
+      count = lp_build_intrinsic_unary(builder, "llvm.ctpop.i32",
+                                       LLVMInt32TypeInContext(context), bits);
+      count = LLVMBuildZExt(builder, count, LLVMIntTypeInContext(context, 64), "");
+   }
    else if(util_get_cpu_caps()->has_avx && type.length == 8) {
       const char *movmskintr = "llvm.x86.avx.movmsk.ps.256";
       const char *popcntintr = "llvm.ctpop.i32";
@@ -516,6 +529,87 @@ lp_build_occlusion_count(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Load half of the depth/stencil values of a 4x4 block, that is one load
+ * for up to 8 pixels, or two rows of 4 pixels for the 16 wide case.
+ */
+static LLVMValueRef
+depth_stencil_load_rows(struct gallivm_state *gallivm,
+                        struct lp_type load_type,
+                        boolean is_1d,
+                        LLVMValueRef depth_ptr,
+                        LLVMValueRef depth_offset,
+                        LLVMValueRef depth_stride)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   unsigned num_rows = load_type.length > 4 ? 2 : 1;
+   struct lp_type row_type = load_type;
+   LLVMTypeRef row_ptr_type;
+   LLVMValueRef rows[2];
+   unsigned i;
+
+   row_type.length /= num_rows;
+   row_ptr_type = LLVMPointerType(lp_build_vec_type(gallivm, row_type), 0);
+
+   for (i = 0; i < num_rows; i++) {
+      LLVMValueRef row_ptr;
+
+      if (i > 0 && is_1d) {
+         rows[i] = lp_build_undef(gallivm, row_type);
+         continue;
+      }
+      if (i > 0) {
+         depth_offset = LLVMBuildAdd(builder, depth_offset, depth_stride, "");
+      }
+      row_ptr = LLVMBuildGEP(builder, depth_ptr, &depth_offset, 1, "");
+      row_ptr = LLVMBuildBitCast(builder, row_ptr, row_ptr_type, "");
+      rows[i] = LLVMBuildLoad(builder, row_ptr, "");
+   }
+
+   return num_rows > 1 ? lp_build_concat(gallivm, rows, row_type, num_rows) :
+                         rows[0];
+}
+
+
+/**
+ * Store half of the depth/stencil values of a 4x4 block, counterpart of
+ * depth_stencil_load_rows().
+ */
+static void
+depth_stencil_store_rows(struct gallivm_state *gallivm,
+                         struct lp_type load_type,
+                         boolean is_1d,
+                         LLVMValueRef value,
+                         LLVMValueRef depth_ptr,
+                         LLVMValueRef depth_offset,
+                         LLVMValueRef depth_stride)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   unsigned num_rows = load_type.length > 4 ? 2 : 1;
+   struct lp_type row_type = load_type;
+   LLVMTypeRef row_ptr_type;
+   unsigned i;
+
+   row_type.length /= num_rows;
+   row_ptr_type = LLVMPointerType(lp_build_vec_type(gallivm, row_type), 0);
+
+   for (i = 0; i < num_rows && !(i > 0 && is_1d); i++) {
+      LLVMValueRef row = value, row_ptr;
+
+      if (num_rows > 1) {
+         row = lp_build_extract_range(gallivm, value, i * row_type.length,
+                                      row_type.length);
+      }
+      if (i > 0) {
+         depth_offset = LLVMBuildAdd(builder, depth_offset, depth_stride, "");
+      }
+      row_ptr = LLVMBuildGEP(builder, depth_ptr, &depth_offset, 1, "");
+      row_ptr = LLVMBuildBitCast(builder, row_ptr, row_ptr_type, "");
+      LLVMBuildStore(builder, row, row_ptr);
+   }
+}
+
+
 /**
  * Load depth/stencil values.
  * The stored values are linear, swizzle them.
@@ -543,15 +637,13 @@ lp_build_depth_stencil_load_swizzled(struct gallivm_state *gallivm,
    LLVMBuilderRef builder = gallivm->builder;
    LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 4];
    LLVMValueRef zs_dst1, zs_dst2;
-   LLVMValueRef zs_dst_ptr;
    LLVMValueRef depth_offset1, depth_offset2;
-   LLVMTypeRef load_ptr_type;
+   LLVMValueRef half_stride = depth_stride;
    unsigned depth_bytes = format_desc->block.bits / 8;
    struct lp_type zs_type = lp_depth_type(format_desc, z_src_type.length);
    struct lp_type zs_load_type = zs_type;
 
    zs_load_type.length = zs_load_type.length / 2;
-   load_ptr_type = LLVMPointerType(lp_build_vec_type(gallivm, zs_load_type), 0);
 
    if (z_src_type.length == 4) {
       unsigned i;
@@ -574,30 +666,33 @@ lp_build_depth_stencil_load_swizzled(struct gallivm_state *gallivm,
       unsigned i;
       LLVMValueRef loopx2 = LLVMBuildShl(builder, loop_counter,
                                          lp_build_const_int32(gallivm, 1), "");
-      assert(z_src_type.length == 8);
+      assert(z_src_type.length == 8 || z_src_type.length == 16);
       depth_offset1 = LLVMBuildMul(builder, loopx2, depth_stride, "");
       /*
-       * We load 2x4 values, and need to swizzle them (order
-       * 0,1,4,5,2,3,6,7) - not so hot with avx unfortunately.
+       * We load 2x4 (or 4x4) values, and need to swizzle them (order
+       * 0,1,4,5,2,3,6,7, and the same again for the lower half) - not so
+       * hot with avx unfortunately.
        */
-      for (i = 0; i < 8; i++) {
-         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
+      for (i = 0; i < z_src_type.length; i++) {
+         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2 + (i&8));
+      }
+      if (z_src_type.length == 16) {
+         half_stride = LLVMBuildShl(builder, depth_stride,
+                                    lp_build_const_int32(gallivm, 1), "");
       }
    }
 
-   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, depth_stride, "");
+   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, half_stride, "");
 
    /* Load current z/stencil values from z/stencil buffer */
-   zs_dst_ptr = LLVMBuildGEP(builder, depth_ptr, &depth_offset1, 1, "");
-   zs_dst_ptr = LLVMBuildBitCast(builder, zs_dst_ptr, load_ptr_type, "");
-   zs_dst1 = LLVMBuildLoad(builder, zs_dst_ptr, "");
+   zs_dst1 = depth_stencil_load_rows(gallivm, zs_load_type, is_1d,
+                                     depth_ptr, depth_offset1, depth_stride);
    if (is_1d) {
       zs_dst2 = lp_build_undef(gallivm, zs_load_type);
    }
    else {
-      zs_dst_ptr = LLVMBuildGEP(builder, depth_ptr, &depth_offset2, 1, "");
-      zs_dst_ptr = LLVMBuildBitCast(builder, zs_dst_ptr, load_ptr_type, "");
-      zs_dst2 = LLVMBuildLoad(builder, zs_dst_ptr, "");
+      zs_dst2 = depth_stencil_load_rows(gallivm, zs_load_type, is_1d,
+                                        depth_ptr, depth_offset2, depth_stride);
    }
 
    *z_fb = LLVMBuildShuffleVector(builder, zs_dst1, zs_dst2,
@@ -686,16 +781,14 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
    LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 4];
    LLVMBuilderRef builder = gallivm->builder;
    LLVMValueRef zs_dst1, zs_dst2;
-   LLVMValueRef zs_dst_ptr1, zs_dst_ptr2;
    LLVMValueRef depth_offset1, depth_offset2;
-   LLVMTypeRef load_ptr_type;
+   LLVMValueRef half_stride = depth_stride;
    unsigned depth_bytes = format_desc->block.bits / 8;
    struct lp_type zs_type = lp_depth_type(format_desc, z_src_type.length);
    struct lp_type z_type = zs_type;
    struct lp_type zs_load_type = zs_type;
 
    zs_load_type.length = zs_load_type.length / 2;
-   load_ptr_type = LLVMPointerType(lp_build_vec_type(gallivm, zs_load_type), 0);
 
    z_type.width = z_src_type.width;
 
@@ -720,23 +813,23 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
       unsigned i;
       LLVMValueRef loopx2 = LLVMBuildShl(builder, loop_counter,
                                          lp_build_const_int32(gallivm, 1), "");
-      assert(z_src_type.length == 8);
+      assert(z_src_type.length == 8 || z_src_type.length == 16);
       depth_offset1 = LLVMBuildMul(builder, loopx2, depth_stride, "");
       /*
-       * We load 2x4 values, and need to swizzle them (order
-       * 0,1,4,5,2,3,6,7) - not so hot with avx unfortunately.
+       * We load 2x4 (or 4x4) values, and need to swizzle them (order
+       * 0,1,4,5,2,3,6,7, and the same again for the lower half) - not so
+       * hot with avx unfortunately.
        */
-      for (i = 0; i < 8; i++) {
-         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
+      for (i = 0; i < z_src_type.length; i++) {
+         shuffles[i] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2 + (i&8));
+      }
+      if (z_src_type.length == 16) {
+         half_stride = LLVMBuildShl(builder, depth_stride,
+                                    lp_build_const_int32(gallivm, 1), "");
       }
    }
 
-   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, depth_stride, "");
-
-   zs_dst_ptr1 = LLVMBuildGEP(builder, depth_ptr, &depth_offset1, 1, "");
-   zs_dst_ptr1 = LLVMBuildBitCast(builder, zs_dst_ptr1, load_ptr_type, "");
-   zs_dst_ptr2 = LLVMBuildGEP(builder, depth_ptr, &depth_offset2, 1, "");
-   zs_dst_ptr2 = LLVMBuildBitCast(builder, zs_dst_ptr2, load_ptr_type, "");
+   depth_offset2 = LLVMBuildAdd(builder, depth_offset1, half_stride, "");
 
    if (format_desc->block.bits > 32) {
       s_value = LLVMBuildBitCast(builder, s_value, z_bld.vec_type, "");
@@ -762,12 +855,12 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
          zs_dst2 = lp_build_extract_range(gallivm, z_value, 2, 2);
       }
       else {
-         assert(z_src_type.length == 8);
+         assert(z_src_type.length == 8 || z_src_type.length == 16);
          zs_dst1 = LLVMBuildShuffleVector(builder, z_value, z_value,
                                           LLVMConstVector(&shuffles[0],
                                                           zs_load_type.length), "");
          zs_dst2 = LLVMBuildShuffleVector(builder, z_value, z_value,
-                                          LLVMConstVector(&shuffles[4],
+                                          LLVMConstVector(&shuffles[zs_load_type.length],
                                                           zs_load_type.length), "");
       }
    }
@@ -781,17 +874,18 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
       else {
          unsigned i;
          LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH / 2];
-         assert(z_src_type.length == 8);
-         for (i = 0; i < 8; i++) {
-            shuffles[i*2] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2);
-            shuffles[i*2+1] = lp_build_const_int32(gallivm, (i&1) + (i&2) * 2 + (i&4) / 2 +
+         assert(z_src_type.length == 8 || z_src_type.length == 16);
+         for (i = 0; i < z_src_type.length; i++) {
+            unsigned pos = (i&1) + (i&2) * 2 + (i&4) / 2 + (i&8);
+            shuffles[i*2] = lp_build_const_int32(gallivm, pos);
+            shuffles[i*2+1] = lp_build_const_int32(gallivm, pos +
                                                    z_src_type.length);
          }
          zs_dst1 = LLVMBuildShuffleVector(builder, z_value, s_value,
                                           LLVMConstVector(&shuffles[0],
                                                           z_src_type.length), "");
          zs_dst2 = LLVMBuildShuffleVector(builder, z_value, s_value,
-                                          LLVMConstVector(&shuffles[8],
+                                          LLVMConstVector(&shuffles[z_src_type.length],
                                                           z_src_type.length), "");
       }
       zs_dst1 = LLVMBuildBitCast(builder, zs_dst1,
@@ -800,9 +894,11 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
                                  lp_build_vec_type(gallivm, zs_load_type), "");
    }
 
-   LLVMBuildStore(builder, zs_dst1, zs_dst_ptr1);
+   depth_stencil_store_rows(gallivm, zs_load_type, is_1d, zs_dst1,
+                            depth_ptr, depth_offset1, depth_stride);
    if (!is_1d) {
-      LLVMBuildStore(builder, zs_dst2, zs_dst_ptr2);
+      depth_stencil_store_rows(gallivm, zs_load_type, is_1d, zs_dst2,
+                               depth_ptr, depth_offset2, depth_stride);
    }
 }
 
@@ -71,6 +71,8 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
    if (llvmpipe->pipe.stream_uploader)
       u_upload_destroy(llvmpipe->pipe.stream_uploader);
 
+   pipe->screen->fence_reference(pipe->screen, &llvmpipe->barrier_fence, NULL);
+
    /* This will also destroy llvmpipe->setup:
     */
    if (llvmpipe->draw)
@@ -117,6 +119,9 @@ do_flush( struct pipe_context *pipe,
           unsigned flags)
 {
    llvmpipe_flush(pipe, fence, __FUNCTION__);
+
+   if (flags & PIPE_FLUSH_END_OF_FRAME)
+      lp_setup_end_frame(llvmpipe_context(pipe)->setup);
 }
 
 static void
@@ -146,6 +146,11 @@ struct llvmpipe_context {
    struct lp_setup_context *setup;
    struct lp_setup_variant setup_variant;
 
+   /** Fence of the scenes flushed by the last memory barrier, until they
+    * are known to be done.  See llvmpipe_memory_barrier().
+    */
+   struct pipe_fence_handle *barrier_fence;
+
    /** The primitive drawing context */
    struct draw_context *draw;
 
@@ -65,6 +65,9 @@
 #define PERF_NO_ALPHATEST   0x80  	/* disable alpha testing */
 #define PERF_NO_RAST_LINEAR 0x100  	/* disable linear rast */
 #define PERF_NO_SHADE       0x200  	/* disable fragment shaders */
+#define PERF_NO_HIZ         0x400  	/* disable hierarchical z reject */
+#define PERF_NO_FAST_CLEAR  0x800  	/* disable lazy clears */
+#define PERF_NO_TRI_BATCH   0x1000 	/* disable small triangle batches */
 
 
 extern int LP_PERF;
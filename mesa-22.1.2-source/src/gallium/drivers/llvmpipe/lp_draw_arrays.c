@@ -37,12 +37,95 @@
 #include "util/u_prim.h"
 
 #include "lp_context.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_query.h"
+#include "lp_texture.h"
 
 #include "draw/draw_context.h"
 
 
+static boolean
+resource_busy(struct pipe_context *pipe, struct pipe_resource *resource,
+              boolean read_only)
+{
+   unsigned referenced;
+
+   if (!resource)
+      return FALSE;
+
+   referenced = llvmpipe_is_resource_referenced(pipe, resource, 0);
+   return (referenced & LP_REFERENCED_FOR_WRITE) ||
+          ((referenced & LP_REFERENCED_FOR_READ) && !read_only);
+}
+
+
+/**
+ * Vertex processing runs on this thread rather than on the rasterizer
+ * threads, so after a memory barrier it has to wait for the scenes queued
+ * before it if they use anything the draw reads or writes.
+ */
+static void
+llvmpipe_draw_barrier(struct llvmpipe_context *lp,
+                      const struct pipe_draw_info *info)
+{
+   struct pipe_context *pipe = &lp->pipe;
+   unsigned i;
+
+   if (!llvmpipe_barrier_pending(pipe))
+      return;
+
+   for (i = 0; i < lp->num_vertex_buffers; i++) {
+      if (!lp->vertex_buffer[i].is_user_buffer &&
+          resource_busy(pipe, lp->vertex_buffer[i].buffer.resource, TRUE))
+         goto wait;
+   }
+
+   if (info->index_size && !info->has_user_indices &&
+       resource_busy(pipe, info->index.resource, TRUE))
+      goto wait;
+
+   if (lp->render_cond_buffer &&
+       resource_busy(pipe, &lp->render_cond_buffer->base, TRUE))
+      goto wait;
+
+   for (i = 0; i < lp->num_so_targets; i++) {
+      if (lp->so_targets[i] &&
+          resource_busy(pipe, lp->so_targets[i]->target.buffer, FALSE))
+         goto wait;
+   }
+
+   for (enum pipe_shader_type s = PIPE_SHADER_VERTEX; s < PIPE_SHADER_COMPUTE; s++) {
+      if (s == PIPE_SHADER_FRAGMENT)
+         continue;
+
+      for (i = 0; i < ARRAY_SIZE(lp->constants[s]); i++) {
+         if (resource_busy(pipe, lp->constants[s][i].buffer, TRUE))
+            goto wait;
+      }
+      for (i = 0; i < lp->num_sampler_views[s]; i++) {
+         if (lp->sampler_views[s][i] &&
+             resource_busy(pipe, lp->sampler_views[s][i]->texture, TRUE))
+            goto wait;
+      }
+      for (i = 0; i < lp->num_images[s]; i++) {
+         if (resource_busy(pipe, lp->images[s][i].resource,
+                           !(lp->images[s][i].access & PIPE_IMAGE_ACCESS_WRITE)))
+            goto wait;
+      }
+      for (i = 0; i < ARRAY_SIZE(lp->ssbos[s]); i++) {
+         if (resource_busy(pipe, lp->ssbos[s][i].buffer, FALSE))
+            goto wait;
+      }
+   }
+
+   return;
+
+wait:
+   llvmpipe_wait_barrier(pipe);
+}
+
+
 
 /**
  * Draw vertex arrays, with optional indexing, optional instancing.
@@ -65,6 +148,8 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
    const void *mapped_indices = NULL;
    unsigned i;
 
+   llvmpipe_draw_barrier(lp, info);
+
    if (!llvmpipe_check_render_cond(lp))
       return;
 
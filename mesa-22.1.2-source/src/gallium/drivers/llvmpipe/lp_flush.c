@@ -124,3 +124,63 @@ llvmpipe_flush_resource(struct pipe_context *pipe,
 
    return TRUE;
 }
+
+
+/**
+ * Flush the scene being built if it uses the resource in a way that
+ * conflicts with binding it to the fragment shader.
+ *
+ * Unlike llvmpipe_flush_resource(), this doesn't wait: scenes are
+ * rasterized in order, so fragment shaders only race with the tiles of
+ * their own scene.
+ */
+void
+llvmpipe_flush_resource_for_fs(struct pipe_context *pipe,
+                               struct pipe_resource *resource,
+                               boolean read_only,
+                               const char *reason)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   unsigned referenced =
+      lp_setup_is_resource_referenced_by_current_scene(llvmpipe->setup,
+                                                       resource);
+
+   if ((referenced & LP_REFERENCED_FOR_WRITE) ||
+       ((referenced & LP_REFERENCED_FOR_READ) && !read_only))
+      llvmpipe_flush(pipe, NULL, reason);
+}
+
+
+/**
+ * Returns TRUE if the scenes flushed by the last memory barrier may still
+ * be rasterizing.
+ */
+boolean
+llvmpipe_barrier_pending(struct pipe_context *pipe)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct pipe_screen *screen = pipe->screen;
+
+   if (llvmpipe->barrier_fence &&
+       screen->fence_finish(screen, NULL, llvmpipe->barrier_fence, 0))
+      screen->fence_reference(screen, &llvmpipe->barrier_fence, NULL);
+
+   return llvmpipe->barrier_fence != NULL;
+}
+
+
+/**
+ * Wait for the scenes flushed by the last memory barrier.
+ */
+void
+llvmpipe_wait_barrier(struct pipe_context *pipe)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct pipe_screen *screen = pipe->screen;
+
+   if (llvmpipe->barrier_fence) {
+      screen->fence_finish(screen, NULL, llvmpipe->barrier_fence,
+                           PIPE_TIMEOUT_INFINITE);
+      screen->fence_reference(screen, &llvmpipe->barrier_fence, NULL);
+   }
+}
@@ -52,4 +52,16 @@ llvmpipe_flush_resource(struct pipe_context *pipe,
                         boolean do_not_block,
                         const char *reason);
 
+void
+llvmpipe_flush_resource_for_fs(struct pipe_context *pipe,
+                               struct pipe_resource *resource,
+                               boolean read_only,
+                               const char *reason);
+
+boolean
+llvmpipe_barrier_pending(struct pipe_context *pipe);
+
+void
+llvmpipe_wait_barrier(struct pipe_context *pipe);
+
 #endif
@@ -32,7 +32,7 @@
 #include "util/u_cpu_detect.h"
 #include "util/u_pack_color.h"
 #include "util/u_surface.h"
-#include "util/u_sse.h"
+#include "util/u_sse_neon.h"
 
 #include "lp_jit.h"
 #include "lp_rast.h"
@@ -41,7 +41,7 @@
 #include "lp_linear_priv.h"
 
 
-#if defined(PIPE_ARCH_SSE)
+#if defined(PIPE_ARCH_SSE) || defined(PIPE_ARCH_AARCH64)
 
 
 /* This file contains various special-case fastpaths which implement
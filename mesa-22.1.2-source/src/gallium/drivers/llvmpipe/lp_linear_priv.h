@@ -52,7 +52,7 @@ struct lp_linear_sampler {
 struct lp_linear_interp {
    struct lp_linear_elem base;
 
-#if defined(PIPE_ARCH_SSE)
+#if defined(PIPE_ARCH_SSE) || defined(PIPE_ARCH_AARCH64)
    __m128i a0;
    __m128i dadx;
    __m128i dady;
@@ -73,6 +73,7 @@ is_nearest_sampler(const struct lp_sampler_static_state *sampler)
 {
    return
       sampler->texture_state.target == PIPE_TEXTURE_2D &&
+      !sampler->texture_state.tiled &&
       sampler->sampler_state.min_img_filter == PIPE_TEX_FILTER_NEAREST &&
       sampler->sampler_state.mag_img_filter == PIPE_TEX_FILTER_NEAREST &&
       (sampler->texture_state.level_zero_only ||
@@ -91,6 +92,7 @@ is_linear_sampler(const struct lp_sampler_static_state *sampler)
 {
    return
       sampler->texture_state.target == PIPE_TEXTURE_2D &&
+      !sampler->texture_state.tiled &&
       sampler->sampler_state.min_img_filter == PIPE_TEX_FILTER_LINEAR &&
       sampler->sampler_state.mag_img_filter == PIPE_TEX_FILTER_LINEAR &&
       (sampler->texture_state.level_zero_only ||
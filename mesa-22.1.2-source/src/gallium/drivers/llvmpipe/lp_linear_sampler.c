@@ -32,14 +32,14 @@
 #include "util/u_cpu_detect.h"
 #include "util/u_pack_color.h"
 #include "util/u_rect.h"
-#include "util/u_sse.h"
+#include "util/u_sse_neon.h"
 
 #include "lp_jit.h"
 #include "lp_debug.h"
 #include "lp_state_fs.h"
 #include "lp_linear_priv.h"
 
-#if defined(PIPE_ARCH_SSE)
+#if defined(PIPE_ARCH_SSE) || defined(PIPE_ARCH_AARCH64)
 
 #define FIXED16_SHIFT  16
 #define FIXED16_ONE    (1<<16)
@@ -50,6 +50,7 @@ lp_print_counters(void)
 
       debug_printf("llvmpipe: nr_triangles:                 %9u\n", lp_count.nr_tris);
       debug_printf("llvmpipe: nr_culled_triangles:          %9u\n", lp_count.nr_culled_tris);
+      debug_printf("llvmpipe: nr_batched_triangles:         %9u\n", lp_count.nr_batched_tris);
       debug_printf("llvmpipe: nr_rectangles:                %9u\n", lp_count.nr_rects);
       debug_printf("llvmpipe: nr_culled_rectangles:         %9u\n", lp_count.nr_culled_rects);
 
@@ -113,11 +114,28 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_rect_full_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_rect_fully_covered_4, p1, total_4);
       debug_printf("llvmpipe:   nr_rect_part_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_rect_partially_covered_4, p2, total_4);
 
+      debug_printf("llvmpipe: nr_hiz_rejected_64x64:        %9u\n", lp_count.nr_hiz_rejected_64);
+      debug_printf("llvmpipe: nr_hiz_rejected_16x16:        %9u\n", lp_count.nr_hiz_rejected_16);
+      debug_printf("llvmpipe: nr_hiz_rejected_pixels:       %9u\n", lp_count.nr_hiz_rejected_pixels);
+      debug_printf("llvmpipe: nr_tbdr_64x64:                %9u\n", lp_count.nr_tbdr_64);
+
+      p1 = (float) lp_count.nr_tbdr_fragments / (float) lp_count.nr_tbdr_pixels;
+      p2 = (float) lp_count.nr_tbdr_shaded_fragments / (float) lp_count.nr_tbdr_pixels;
+
+      debug_printf("llvmpipe:   nr_tbdr_pixels:             %9u\n", lp_count.nr_tbdr_pixels);
+      debug_printf("llvmpipe:   nr_tbdr_fragments:          %9u (%4.2f per pixel)\n", lp_count.nr_tbdr_fragments, p1);
+      debug_printf("llvmpipe:   nr_tbdr_shaded_fragments:   %9u (%4.2f per pixel)\n", lp_count.nr_tbdr_shaded_fragments, p2);
+      debug_printf("llvmpipe: nr_fast_clear_skipped_64x64: %9u\n", lp_count.nr_fast_clear_skipped_64);
+      debug_printf("llvmpipe: nr_fast_clear_discarded_64x64:%9u\n", lp_count.nr_fast_clear_discarded_64);
 
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      debug_printf("llvmpipe: nr_scenes:                    %9u\n", lp_count.nr_scenes);
+      debug_printf("llvmpipe:   nr_scene_splits_full:       %9u\n", lp_count.nr_scene_splits_full);
+      debug_printf("llvmpipe:   nr_scene_splits_resources:  %9u\n", lp_count.nr_scene_splits_resources);
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
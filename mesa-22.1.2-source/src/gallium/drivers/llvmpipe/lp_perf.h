@@ -42,6 +42,7 @@ struct lp_counters
 {
    unsigned nr_tris;
    unsigned nr_culled_tris;
+   unsigned nr_batched_tris;
    unsigned nr_rects;
    unsigned nr_culled_rects;
    unsigned nr_empty_64;
@@ -62,6 +63,18 @@ struct lp_counters
    unsigned nr_rect_fully_covered_4;
    unsigned nr_rect_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_rejected_64;
+   unsigned nr_hiz_rejected_16;
+   unsigned nr_hiz_rejected_pixels;
+   unsigned nr_tbdr_64;
+   unsigned nr_tbdr_pixels;             /**< covered by some command */
+   unsigned nr_tbdr_fragments;          /**< covered, over all commands */
+   unsigned nr_tbdr_shaded_fragments;
+   unsigned nr_fast_clear_skipped_64;
+   unsigned nr_fast_clear_discarded_64;
+   unsigned nr_scenes;
+   unsigned nr_scene_splits_full;
+   unsigned nr_scene_splits_resources;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
 
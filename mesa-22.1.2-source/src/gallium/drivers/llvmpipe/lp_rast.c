@@ -74,6 +74,8 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
+   lp_rast_hiz_begin_scene( scene );
+   lp_rast_fast_clear_begin_scene( scene );
    lp_scene_bin_iter_begin( scene );
 }
 
@@ -123,6 +125,41 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
    }
+
+   task->hiz = scene->hiz ? &scene->hiz[y * scene->hiz_stride + x] : NULL;
+   task->hiz_prim.reject = FALSE;
+   task->hiz_prim.tighten = FALSE;
+
+   lp_rast_fast_clear_begin_tile(task, x, y);
+}
+
+
+/**
+ * Fill the current tile of a color buffer with a packed value, in all
+ * bound layers.
+ */
+void
+lp_rast_fill_color(struct lp_rasterizer_task *task,
+                   unsigned cbuf,
+                   union util_color *uc)
+{
+   const struct lp_scene *scene = task->scene;
+   enum pipe_format format = scene->fb.cbufs[cbuf]->format;
+
+   for (unsigned s = 0; s < scene->cbufs[cbuf].nr_samples; s++) {
+      void *map = (char *)scene->cbufs[cbuf].map + scene->cbufs[cbuf].sample_stride * s;
+      util_fill_box(map,
+                    format,
+                    scene->cbufs[cbuf].stride,
+                    scene->cbufs[cbuf].layer_stride,
+                    task->x,
+                    task->y,
+                    0,
+                    task->width,
+                    task->height,
+                    scene->fb_max_layer + 1,
+                    uc);
+   }
 }
 
 
@@ -154,20 +191,8 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
    LP_DBG(DEBUG_RAST, "%s clear value (target format %d) raw 0x%x,0x%x,0x%x,0x%x\n",
           __FUNCTION__, format, uc.ui[0], uc.ui[1], uc.ui[2], uc.ui[3]);
 
-   for (unsigned s = 0; s < scene->cbufs[cbuf].nr_samples; s++) {
-      void *map = (char *)scene->cbufs[cbuf].map + scene->cbufs[cbuf].sample_stride * s;
-      util_fill_box(map,
-                    format,
-                    scene->cbufs[cbuf].stride,
-                    scene->cbufs[cbuf].layer_stride,
-                    task->x,
-                    task->y,
-                    0,
-                    task->width,
-                    task->height,
-                    scene->fb_max_layer + 1,
-                    &uc);
-   }
+   if (!lp_rast_fast_clear_color(task, cbuf, &uc))
+      lp_rast_fill_color(task, cbuf, &uc);
 
    /* this will increase for each rb which probably doesn't mean much */
    LP_COUNT(nr_color_tile_clear);
@@ -175,17 +200,15 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
 
 
 /**
- * Clear the rasterizer's current z/stencil tile.
- * This is a bin command called during bin processing.
- * Clear commands always clear all bound layers.
+ * Write the masked bits of a packed z/stencil value to the current zsbuf
+ * tile, in all bound layers.
  */
-static void
-lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
-                       const union lp_rast_cmd_arg arg)
+void
+lp_rast_fill_zstencil(struct lp_rasterizer_task *task,
+                      uint64_t clear_value64,
+                      uint64_t clear_mask64)
 {
    const struct lp_scene *scene = task->scene;
-   uint64_t clear_value64 = arg.clear_zstencil.value;
-   uint64_t clear_mask64 = arg.clear_zstencil.mask;
    uint32_t clear_value = (uint32_t) clear_value64;
    uint32_t clear_mask = (uint32_t) clear_mask64;
    const unsigned height = task->height;
@@ -195,13 +218,6 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
    unsigned i, j;
    unsigned block_size;
 
-   LP_DBG(DEBUG_RAST, "%s: value=0x%08x, mask=0x%08x\n",
-           __FUNCTION__, clear_value, clear_mask);
-
-   /*
-    * Clear the area of the depth/depth buffer matching this tile.
-    */
-
    if (scene->fb.zsbuf) {
       unsigned layer;
 
@@ -292,6 +308,36 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Clear the rasterizer's current z/stencil tile.
+ * This is a bin command called during bin processing.
+ * Clear commands always clear all bound layers.
+ */
+static void
+lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
+                       const union lp_rast_cmd_arg arg)
+{
+   const struct lp_scene *scene = task->scene;
+   uint64_t clear_value64 = arg.clear_zstencil.value;
+   uint64_t clear_mask64 = arg.clear_zstencil.mask;
+
+   LP_DBG(DEBUG_RAST, "%s: value=0x%08x, mask=0x%08x\n",
+           __FUNCTION__, (uint32_t) clear_value64, (uint32_t) clear_mask64);
+
+   /*
+    * Clear the area of the depth/depth buffer matching this tile.
+    */
+
+   if (scene->fb.zsbuf) {
+      if (!lp_rast_fast_clear_zstencil(task, clear_value64, clear_mask64))
+         lp_rast_fill_zstencil(task, clear_value64, clear_mask64);
+
+      if (task->hiz)
+         lp_rast_hiz_clear(task, clear_value64, clear_mask64);
+   }
+}
+
+
 
 /**
  * Run the shader on all blocks in a tile.  This is used when a tile is
@@ -307,6 +353,7 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    const struct lp_rast_state *state;
    struct lp_fragment_shader_variant *variant;
    const unsigned tile_x = task->x, tile_y = task->y;
+   unsigned hiz_reject = 0;
    unsigned x, y;
 
    if (inputs->disable) {
@@ -323,6 +370,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   if (task->hiz)
+      hiz_reject = lp_rast_hiz_reject_mask(task, 0xffff);
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -334,6 +384,21 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          unsigned depth_sample_stride = 0;
          unsigned i;
 
+         if (hiz_reject & (1 << ((y / 16) * 4 + x / 16)))
+            continue;
+
+         if (task->tbdr) {
+            unsigned tbdr_mask = lp_rast_tbdr_filter(task, inputs,
+                                                     tile_x + x, tile_y + y,
+                                                     0xffff);
+            if (tbdr_mask != 0xffff) {
+               if (tbdr_mask)
+                  lp_rast_shade_quads_visible(task, inputs, tile_x + x,
+                                              tile_y + y, tbdr_mask);
+               continue;
+            }
+         }
+
          /* color buffer */
          for (i = 0; i < scene->fb.nr_cbufs; i++){
             if (scene->fb.cbufs[i]) {
@@ -384,6 +449,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          END_JIT_CALL();
       }
    }
+
+   if (task->hiz)
+      lp_rast_hiz_tighten(task, 0xffff & ~hiz_reject);
 }
 
 
@@ -419,18 +487,9 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
                                 unsigned x, unsigned y,
                                 uint64_t mask)
 {
-   const struct lp_rast_state *state = task->state;
-   struct lp_fragment_shader_variant *variant = state->variant;
-   const struct lp_scene *scene = task->scene;
-   uint8_t *color[PIPE_MAX_COLOR_BUFS];
-   unsigned stride[PIPE_MAX_COLOR_BUFS];
-   unsigned sample_stride[PIPE_MAX_COLOR_BUFS];
-   uint8_t *depth = NULL;
-   unsigned depth_stride = 0;
-   unsigned depth_sample_stride = 0;
-   unsigned i;
+   ASSERTED const struct lp_scene *scene = task->scene;
 
-   assert(state);
+   assert(task->state);
 
    /* Sanity checks */
    assert(x < scene->tiles_x * TILE_SIZE);
@@ -441,6 +500,37 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
    assert((x % 4) == 0);
    assert((y % 4) == 0);
 
+   if (task->tbdr) {
+      mask = lp_rast_tbdr_filter(task, inputs, x, y, (unsigned)mask);
+      if (!mask)
+         return;
+   }
+
+   lp_rast_shade_quads_visible(task, inputs, x, y, mask);
+}
+
+
+/**
+ * Compute shading for the pixels of a 4x4 block in the mask, which were
+ * already filtered by lp_rast_tbdr_filter().
+ */
+void
+lp_rast_shade_quads_visible(struct lp_rasterizer_task *task,
+                            const struct lp_rast_shader_inputs *inputs,
+                            unsigned x, unsigned y,
+                            uint64_t mask)
+{
+   const struct lp_rast_state *state = task->state;
+   struct lp_fragment_shader_variant *variant = state->variant;
+   const struct lp_scene *scene = task->scene;
+   uint8_t *color[PIPE_MAX_COLOR_BUFS];
+   unsigned stride[PIPE_MAX_COLOR_BUFS];
+   unsigned sample_stride[PIPE_MAX_COLOR_BUFS];
+   uint8_t *depth = NULL;
+   unsigned depth_stride = 0;
+   unsigned depth_sample_stride = 0;
+   unsigned i;
+
    /* color buffer */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i]) {
@@ -712,6 +802,9 @@ lp_rast_tile_end(struct lp_rasterizer_task *task)
       lp_rast_end_query(task, lp_rast_arg_query(task->scene->active_queries[i]));
    }
 
+   if (task->fast_clear_active)
+      lp_rast_fast_clear_end_tile(task);
+
    /* debug */
    memset(task->color_tiles, 0, sizeof(task->color_tiles));
    task->depth_tile = NULL;
@@ -773,6 +866,7 @@ rast_flags[] = {
    TRI,                         /* lp_rast_triangle_ms_3_4 */
    TRI,                         /* lp_rast_triangle_ms_3_16 */
    TRI,                         /* lp_rast_triangle_ms_4_16 */
+   TRI,                         /* lp_rast_triangle_batch */
 
    RECT,                        /* rectangle */
    BLIT,                        /* blit */
@@ -822,6 +916,7 @@ dispatch_blit[] = {
    NULL,                        /* lp_rast_triangle_ms_3_4 */
    NULL,                        /* lp_rast_triangle_ms_3_16 */
    NULL,                        /* lp_rast_triangle_ms_4_16 */
+   NULL,                        /* lp_rast_triangle_batch */
 
    NULL,                        /* rectangle */
    lp_rast_blit_tile_to_dest,
@@ -876,6 +971,7 @@ dispatch_tri[] = {
    lp_rast_triangle_ms_3_4,
    lp_rast_triangle_ms_3_16,
    lp_rast_triangle_ms_4_16,
+   lp_rast_triangle_batch,
    lp_rast_rectangle,
    lp_rast_blit_tile,
 };
@@ -926,6 +1022,7 @@ dispatch_tri_debug[] =
    lp_rast_triangle_ms_3_4,
    lp_rast_triangle_ms_3_16,
    lp_rast_triangle_ms_4_16,
+   lp_rast_triangle_batch,
 
    lp_rast_rectangle,
    lp_rast_shade_tile,
@@ -966,6 +1063,8 @@ blit_rasterize_bin(struct lp_rasterizer_task *task,
    if (0) debug_printf("%s\n", __FUNCTION__);
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
+         if (task->fast_clear_active)
+            lp_rast_fast_clear_write(task, block->cmd[k], block->arg[k]);
          dispatch_blit[block->cmd[k]]( task, block->arg[k] );
       }
    }
@@ -983,11 +1082,80 @@ tri_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
+         if (task->hiz &&
+             !lp_rast_hiz_begin_cmd(task, block->cmd[k], block->arg[k]))
+            continue;
+         if (task->fast_clear_active)
+            lp_rast_fast_clear_write(task, block->cmd[k], block->arg[k]);
          dispatch_tri[block->cmd[k]]( task, block->arg[k] );
       }
    }
 }
 
+/**
+ * Rasterize a bin of opaque, depth tested commands in two passes: the
+ * first finds the front-most command of each pixel from the depth planes,
+ * the second shades each pixel with that command only.
+ * \return FALSE if the bin doesn't qualify, and nothing was done.
+ */
+static boolean
+tbdr_rasterize_bin(struct lp_rasterizer_task *task,
+                   const struct cmd_bin *bin)
+{
+   struct lp_hiz_tile *hiz = task->hiz;
+   const struct cmd_block *block;
+   unsigned k;
+
+   if (!lp_rast_tbdr_begin_bin(task, bin))
+      return FALSE;
+
+   /* The depth pass doesn't touch the buffers, so clears and the depth
+    * bounds are left to the shading pass.
+    */
+   task->tbdr = LP_TBDR_DEPTH;
+   task->tbdr_cmd = 0;
+   task->hiz = NULL;
+   for (block = bin->head; block; block = block->next) {
+      for (k = 0; k < block->count; k++) {
+         unsigned cmd = block->cmd[k];
+
+         if (cmd == LP_RAST_OP_CLEAR_COLOR ||
+             cmd == LP_RAST_OP_CLEAR_ZSTENCIL)
+            continue;
+         dispatch_tri[cmd]( task, block->arg[k] );
+         if (cmd != LP_RAST_OP_SET_STATE)
+            task->tbdr_cmd++;
+      }
+   }
+   task->hiz = hiz;
+
+   task->tbdr = LP_TBDR_SHADE;
+   task->tbdr_cmd = 0;
+   for (block = bin->head; block; block = block->next) {
+      for (k = 0; k < block->count; k++) {
+         unsigned cmd = block->cmd[k];
+         boolean draw = cmd != LP_RAST_OP_CLEAR_COLOR &&
+                        cmd != LP_RAST_OP_CLEAR_ZSTENCIL &&
+                        cmd != LP_RAST_OP_SET_STATE;
+
+         if (!task->hiz ||
+             lp_rast_hiz_begin_cmd(task, cmd, block->arg[k])) {
+            /* Commands don't write all the pixels they cover anymore. */
+            task->hiz_prim.tighten = FALSE;
+            if (task->fast_clear_active)
+               lp_rast_fast_clear_write(task, cmd, block->arg[k]);
+            dispatch_tri[cmd]( task, block->arg[k] );
+         }
+         if (draw)
+            task->tbdr_cmd++;
+      }
+   }
+   task->tbdr = LP_TBDR_NONE;
+
+   LP_COUNT(nr_tbdr_64);
+   return TRUE;
+}
+
 static void
 debug_rasterize_bin(struct lp_rasterizer_task *task,
                   const struct cmd_bin *bin)
@@ -999,6 +1167,11 @@ debug_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
+         if (task->hiz &&
+             !lp_rast_hiz_begin_cmd(task, block->cmd[k], block->arg[k]))
+            continue;
+         if (task->fast_clear_active)
+            lp_rast_fast_clear_write(task, block->cmd[k], block->arg[k]);
          dispatch_tri_debug[block->cmd[k]]( task, block->arg[k] );
       }
    }
@@ -1027,7 +1200,8 @@ rasterize_bin(struct lp_rasterizer_task *task,
             !(LP_PERF & PERF_NO_RAST_LINEAR) &&
             (info.type & LP_RAST_FLAGS_RECT))
       lp_linear_rasterize_bin(task, bin);
-   else
+   else if (!task->scene->permit_tbdr ||
+            !tbdr_rasterize_bin(task, bin))
       tri_rasterize_bin(task, bin, x, y);
 
    lp_rast_tile_end(task);
@@ -1293,6 +1467,8 @@ lp_rast_create( unsigned num_threads )
    struct lp_rasterizer *rast;
    unsigned i;
 
+   lp_rast_init_mask_funcs();
+
    rast = CALLOC_STRUCT(lp_rasterizer);
    if (!rast) {
       goto no_rast;
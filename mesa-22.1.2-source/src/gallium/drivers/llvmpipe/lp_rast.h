@@ -180,6 +180,38 @@ struct lp_rast_rectangle {
 };
 
 
+/** Maximum number of primitives in a lp_rast_tri_batch */
+#define LP_RAST_TRI_BATCH_SIZE   8
+/** Maximum number of edges of each primitive in a lp_rast_tri_batch */
+#define LP_RAST_TRI_BATCH_PLANES 4
+
+/**
+ * Small triangles and points which are contained in the same 16x16 block
+ * of a tile and use the same state, binned as a single command.
+ *
+ * The edge functions are stored as structures of arrays, relative to the
+ * block's upper left pixel: a pixel x, y of the block is inside primitive
+ * i if c[j][i] + dcdx[j][i] * x + dcdy[j][i] * y isn't negative for any
+ * plane j < nr_planes.  Unused planes are always inside.
+ */
+struct lp_rast_tri_batch {
+   int32_t c[LP_RAST_TRI_BATCH_PLANES][LP_RAST_TRI_BATCH_SIZE];
+   int32_t dcdx[LP_RAST_TRI_BATCH_PLANES][LP_RAST_TRI_BATCH_SIZE];
+   int32_t dcdy[LP_RAST_TRI_BATCH_PLANES][LP_RAST_TRI_BATCH_SIZE];
+
+   /* inputs for the shader */
+   const struct lp_rast_triangle *tri[LP_RAST_TRI_BATCH_SIZE];
+   unsigned count;
+   unsigned nr_planes;
+
+   /* primitives which may cover each 4x4 block, one bit each */
+   uint8_t blocks[16];
+
+   /* position of the block within the tile */
+   unsigned x, y;
+};
+
+
 struct lp_rast_clear_rb {
    union util_color color_val;
    unsigned cbuf;
@@ -214,6 +246,7 @@ union lp_rast_cmd_arg {
       unsigned plane_mask;
    } triangle;
    const struct lp_rast_rectangle *rectangle;
+   const struct lp_rast_tri_batch *tri_batch;
    const struct lp_rast_state *set_state;
    const struct lp_rast_clear_rb *clear_rb;
    struct {
@@ -270,6 +303,14 @@ lp_rast_arg_rectangle( const struct lp_rast_rectangle *rectangle )
    return arg;
 }
 
+static inline union lp_rast_cmd_arg
+lp_rast_arg_tri_batch( const struct lp_rast_tri_batch *batch )
+{
+   union lp_rast_cmd_arg arg;
+   arg.tri_batch = batch;
+   return arg;
+}
+
 static inline union lp_rast_cmd_arg
 lp_rast_arg_state( const struct lp_rast_state *state )
 {
@@ -360,10 +401,11 @@ lp_rast_arg_null( void )
 #define LP_RAST_OP_MS_TRIANGLE_3_4   0x25
 #define LP_RAST_OP_MS_TRIANGLE_3_16  0x26
 #define LP_RAST_OP_MS_TRIANGLE_4_16  0x27
-#define LP_RAST_OP_RECTANGLE         0x28  /* Keep at end */
-#define LP_RAST_OP_BLIT              0x29  /* Keep at end */
+#define LP_RAST_OP_TRIANGLE_BATCH    0x28
+#define LP_RAST_OP_RECTANGLE         0x29  /* Keep at end */
+#define LP_RAST_OP_BLIT              0x2a  /* Keep at end */
 
-#define LP_RAST_OP_MAX               0x2a
+#define LP_RAST_OP_MAX               0x2b
 #define LP_RAST_OP_MASK              0xff
 
 /* Returned by characterize_bin:
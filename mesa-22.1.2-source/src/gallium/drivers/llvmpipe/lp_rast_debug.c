@@ -65,6 +65,7 @@ static const char *cmd_names[] =
    "lp_rast_triangle_ms_3_4",
    "lp_rast_triangle_ms_3_16",
    "lp_rast_triangle_ms_4_16",
+   "triangle_batch",
    "rectangle",
    "blit_tile",
 };
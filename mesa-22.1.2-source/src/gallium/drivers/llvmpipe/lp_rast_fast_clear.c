@@ -0,0 +1,354 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Lazy clears for the rasterizer.
+ *
+ * For every 64x64 tile of level 0 of a render target or depth buffer we
+ * remember whether it is known to hold a clear value, and which.  A clear
+ * command doesn't write the tile right away, it only becomes pending:
+ *
+ *  - the first command which may write the tile writes the pending clear
+ *    first, or drops it if the command overwrites the whole tile anyway,
+ *  - at the end of the tile a clear still pending is written, unless the
+ *    tile already holds that value, and the tile becomes known to hold it.
+ *
+ * So a clear never outlives its bin and the memory is always up to date
+ * once the scene is rasterized: transfers, sampling and display need no
+ * resolve.  What the clear state saves is rewriting tiles which the
+ * previous clear left untouched, e.g. the background of every frame.
+ *
+ * Only level 0, layer 0 of single-sampled buffers is tracked.  Transfers
+ * which write the resource invalidate the state, and resources written as
+ * shader images or shared with others aren't tracked.
+ */
+
+#include <string.h>
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_pack_color.h"
+#include "util/format/u_format.h"
+#include "lp_debug.h"
+#include "lp_perf.h"
+#include "lp_rast_priv.h"
+#include "lp_texture.h"
+
+
+/**
+ * \return the clear state of the surface's tiles for this scene, or NULL
+ * if it can't be tracked.
+ */
+static struct lp_fast_clear_tile *
+fast_clear_tiles(const struct lp_scene *scene,
+                 struct pipe_surface *surf,
+                 unsigned nr_samples,
+                 unsigned *stride)
+{
+   struct llvmpipe_resource *lpr;
+   unsigned tiles_x, tiles_y;
+
+   if (!surf || !llvmpipe_resource_is_texture(surf->texture))
+      return NULL;
+
+   lpr = llvmpipe_resource(surf->texture);
+
+   if ((LP_PERF & PERF_NO_FAST_CLEAR) ||
+       surf->u.tex.level != 0 ||
+       surf->u.tex.first_layer != 0 ||
+       surf->u.tex.last_layer != 0 ||
+       scene->fb_max_layer != 0 ||
+       nr_samples > 1 ||
+       lpr->no_fast_clear ||
+       lpr->user_ptr ||
+       lpr->backable ||
+       lpr->imported_memory ||
+       (lpr->base.bind & PIPE_BIND_SHARED)) {
+      /* This scene may write the buffer behind our back. */
+      lpr->fast_clear_valid = false;
+      return NULL;
+   }
+
+   tiles_x = DIV_ROUND_UP(lpr->base.width0, TILE_SIZE);
+   tiles_y = DIV_ROUND_UP(lpr->base.height0, TILE_SIZE);
+
+   if (!lpr->fast_clear) {
+      lpr->fast_clear = MALLOC(tiles_x * tiles_y * sizeof *lpr->fast_clear);
+      if (!lpr->fast_clear)
+         return NULL;
+      lpr->fast_clear_valid = false;
+   }
+
+   if (!lpr->fast_clear_valid) {
+      memset(lpr->fast_clear, 0, tiles_x * tiles_y * sizeof *lpr->fast_clear);
+      lpr->fast_clear_valid = true;
+   }
+
+   *stride = tiles_x;
+   return lpr->fast_clear;
+}
+
+
+/**
+ * Pick the buffers of the scene whose clear state is tracked.
+ * Called once per scene by one thread, after lp_scene_begin_rasterization().
+ */
+void
+lp_rast_fast_clear_begin_scene(struct lp_scene *scene)
+{
+   unsigned i, j;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      scene->fast_clear[i] = i < scene->fb.nr_cbufs ?
+         fast_clear_tiles(scene, scene->fb.cbufs[i], scene->cbufs[i].nr_samples,
+                          &scene->fast_clear_stride[i]) : NULL;
+
+      /* The order of clears to a texture bound twice would get lost. */
+      for (j = 0; j < i && scene->fast_clear[i]; j++) {
+         if (scene->fast_clear[j] == scene->fast_clear[i]) {
+            llvmpipe_resource(scene->fb.cbufs[i]->texture)->fast_clear_valid = false;
+            scene->fast_clear[i] = NULL;
+            scene->fast_clear[j] = NULL;
+         }
+      }
+   }
+
+   scene->fast_clear[LP_FAST_CLEAR_ZS] =
+      fast_clear_tiles(scene, scene->fb.zsbuf, scene->zsbuf.nr_samples,
+                       &scene->fast_clear_stride[LP_FAST_CLEAR_ZS]);
+}
+
+
+void
+lp_rast_fast_clear_begin_tile(struct lp_rasterizer_task *task,
+                              int x, int y)
+{
+   const struct lp_scene *scene = task->scene;
+   unsigned i;
+
+   task->clear_pending_mask = 0;
+   task->fast_clear_active = 0;
+
+   for (i = 0; i <= LP_FAST_CLEAR_ZS; i++) {
+      struct lp_fast_clear_tile *tile = NULL;
+
+      if (scene->fast_clear[i]) {
+         tile = &scene->fast_clear[i][y * scene->fast_clear_stride[i] + x];
+         if (tile->mask[0] | tile->mask[1])
+            task->fast_clear_active |= 1 << i;
+      }
+      task->fast_clear[i] = tile;
+   }
+}
+
+
+static void
+fast_clear_pend(struct lp_rasterizer_task *task,
+                unsigned buf,
+                const uint64_t value[2],
+                const uint64_t mask[2])
+{
+   struct lp_fast_clear_tile *pending = &task->clear_pending[buf];
+   unsigned i;
+
+   /* Start from what the tile holds, for partial z/stencil clears. */
+   if (!(task->clear_pending_mask & (1 << buf)))
+      *pending = *task->fast_clear[buf];
+
+   for (i = 0; i < 2; i++) {
+      pending->value[i] = (pending->value[i] & ~mask[i]) | (value[i] & mask[i]);
+      pending->mask[i] |= mask[i];
+   }
+
+   task->clear_pending_mask |= 1 << buf;
+   task->fast_clear_active |= 1 << buf;
+}
+
+
+/**
+ * Make a color clear of the current tile pending.
+ * \return FALSE if the buffer isn't tracked and must be cleared now.
+ */
+boolean
+lp_rast_fast_clear_color(struct lp_rasterizer_task *task,
+                         unsigned cbuf,
+                         const union util_color *uc)
+{
+   enum pipe_format format = task->scene->fb.cbufs[cbuf]->format;
+   uint8_t bytes[16] = { 0 };
+   uint64_t value[2], mask[2];
+
+   if (!task->fast_clear[cbuf])
+      return FALSE;
+
+   memcpy(value, uc, sizeof value);
+   memset(bytes, 0xff, util_format_get_blocksize(format));
+   memcpy(mask, bytes, sizeof mask);
+
+   fast_clear_pend(task, cbuf, value, mask);
+   return TRUE;
+}
+
+
+/**
+ * Make a z/stencil clear of the current tile pending.
+ * \return FALSE if the buffer isn't tracked and must be cleared now.
+ */
+boolean
+lp_rast_fast_clear_zstencil(struct lp_rasterizer_task *task,
+                            uint64_t value,
+                            uint64_t mask)
+{
+   enum pipe_format format = task->scene->fb.zsbuf->format;
+   unsigned bits = util_format_get_blocksizebits(format);
+   const uint64_t values[2] = { value, 0 };
+   uint64_t masks[2] = { mask, 0 };
+
+   if (!task->fast_clear[LP_FAST_CLEAR_ZS])
+      return FALSE;
+
+   if (bits < 64)
+      masks[0] &= (1ull << bits) - 1;
+
+   fast_clear_pend(task, LP_FAST_CLEAR_ZS, values, masks);
+   return TRUE;
+}
+
+
+/**
+ * Write the pending clear of a buffer to the current tile, unless the
+ * tile already holds it.
+ */
+static void
+fast_clear_resolve(struct lp_rasterizer_task *task,
+                   unsigned buf)
+{
+   const struct lp_fast_clear_tile *pending = &task->clear_pending[buf];
+   const struct lp_fast_clear_tile *tile = task->fast_clear[buf];
+   uint64_t stale[2];
+   unsigned i;
+
+   for (i = 0; i < 2; i++) {
+      uint64_t held = tile->mask[i] & ~(tile->value[i] ^ pending->value[i]);
+      stale[i] = pending->mask[i] & ~held;
+   }
+
+   if (!(stale[0] | stale[1])) {
+      LP_COUNT(nr_fast_clear_skipped_64);
+      return;
+   }
+
+   if (buf == LP_FAST_CLEAR_ZS) {
+      lp_rast_fill_zstencil(task, pending->value[0], pending->mask[0]);
+   }
+   else {
+      union util_color uc;
+
+      memset(&uc, 0, sizeof uc);
+      memcpy(&uc, pending->value, sizeof pending->value);
+      lp_rast_fill_color(task, buf, &uc);
+   }
+}
+
+
+/**
+ * Called before a command which isn't a clear is executed on the current
+ * tile, while some of its buffers have a pending clear or known contents.
+ */
+void
+lp_rast_fast_clear_write(struct lp_rasterizer_task *task,
+                         unsigned cmd,
+                         const union lp_rast_cmd_arg arg)
+{
+   unsigned bufs = task->fast_clear_active;
+   unsigned dead;
+
+   switch (cmd) {
+   case LP_RAST_OP_CLEAR_COLOR:
+   case LP_RAST_OP_CLEAR_ZSTENCIL:
+   case LP_RAST_OP_BEGIN_QUERY:
+   case LP_RAST_OP_END_QUERY:
+   case LP_RAST_OP_SET_STATE:
+      return;
+   case LP_RAST_OP_SHADE_TILE_OPAQUE:
+   case LP_RAST_OP_BLIT:
+      if (arg.shade_tile->disable)
+         return;
+      /* These overwrite the whole color tile and leave depth/stencil
+       * alone, so pending color clears are dead.
+       */
+      bufs &= ~(1 << LP_FAST_CLEAR_ZS);
+      dead = task->clear_pending_mask & bufs;
+      LP_COUNT_ADD(nr_fast_clear_discarded_64, util_bitcount(dead));
+      task->clear_pending_mask &= ~dead;
+      break;
+   default:
+      break;
+   }
+
+   while (bufs) {
+      int buf = u_bit_scan(&bufs);
+
+      if (task->clear_pending_mask & (1 << buf)) {
+         fast_clear_resolve(task, buf);
+         task->clear_pending_mask &= ~(1 << buf);
+      }
+
+      /* The command may write anything. */
+      memset(task->fast_clear[buf], 0, sizeof *task->fast_clear[buf]);
+      task->fast_clear_active &= ~(1 << buf);
+   }
+}
+
+
+/**
+ * Write the clears still pending at the end of the current tile.
+ */
+void
+lp_rast_fast_clear_end_tile(struct lp_rasterizer_task *task)
+{
+   const struct lp_scene *scene = task->scene;
+   unsigned bufs = task->clear_pending_mask;
+
+   while (bufs) {
+      int buf = u_bit_scan(&bufs);
+      struct pipe_surface *surf = buf == LP_FAST_CLEAR_ZS ?
+         scene->fb.zsbuf : scene->fb.cbufs[buf];
+      struct lp_fast_clear_tile *tile = task->fast_clear[buf];
+
+      fast_clear_resolve(task, buf);
+
+      /* The framebuffer may be smaller than the surface, and then the
+       * clear didn't reach all of the tile.
+       */
+      if (task->x + task->width >= MIN2(task->x + TILE_SIZE,
+                                        surf->texture->width0) &&
+          task->y + task->height >= MIN2(task->y + TILE_SIZE,
+                                         surf->texture->height0))
+         *tile = task->clear_pending[buf];
+      else
+         memset(tile, 0, sizeof *tile);
+   }
+
+   task->clear_pending_mask = 0;
+   task->fast_clear_active = 0;
+}
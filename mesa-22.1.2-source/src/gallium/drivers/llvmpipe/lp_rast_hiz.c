@@ -0,0 +1,465 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Hierarchical z for the rasterizer.
+ *
+ * For every 64x64 tile of a depth buffer we keep a min/max of the depth
+ * values of each of its 16x16 blocks, and of the whole tile.  The bounds
+ * are conservative: every depth value in the block lies within them.  They
+ * are kept up to date by the rasterizer itself from the depth plane of
+ * each primitive, so no shader code is involved:
+ *
+ *  - clears set them to the clear value,
+ *  - primitives which write depth widen them by the range of depth values
+ *    they can write,
+ *  - blocks fully covered by a primitive which always tests and writes
+ *    depth with an ordering function can tighten them.
+ *
+ * A primitive whose depth range over a tile or block fails the depth test
+ * against the bounds is then skipped for that tile or block.
+ *
+ * Only level 0, layer 0 of single-sampled depth buffers is tracked.
+ * Anything else that writes the buffer invalidates the bounds.
+ */
+
+#include <math.h>
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_pack_color.h"
+#include "util/format/u_format.h"
+#include "lp_debug.h"
+#include "lp_perf.h"
+#include "lp_rast_priv.h"
+#include "lp_state_fs.h"
+#include "lp_texture.h"
+
+
+static void
+hiz_tile_reset(struct lp_hiz_tile *tile)
+{
+   unsigned i;
+
+   for (i = 0; i < 16; i++) {
+      tile->min[i] = -INFINITY;
+      tile->max[i] = INFINITY;
+   }
+   tile->tile_min = -INFINITY;
+   tile->tile_max = INFINITY;
+}
+
+
+static void
+hiz_tile_update(struct lp_hiz_tile *tile)
+{
+   float tile_min = tile->min[0];
+   float tile_max = tile->max[0];
+   unsigned i;
+
+   for (i = 1; i < 16; i++) {
+      tile_min = MIN2(tile_min, tile->min[i]);
+      tile_max = MAX2(tile_max, tile->max[i]);
+   }
+   tile->tile_min = tile_min;
+   tile->tile_max = tile_max;
+}
+
+
+/**
+ * Whether all fragments with depth in [lo, hi] fail the depth test
+ * against a block whose depth values are in [min, max].
+ */
+static inline boolean
+hiz_test_reject(unsigned func, float lo, float hi, float min, float max)
+{
+   switch (func) {
+   case PIPE_FUNC_LESS:
+      return lo >= max;
+   case PIPE_FUNC_LEQUAL:
+      return lo > max;
+   case PIPE_FUNC_GREATER:
+      return hi <= min;
+   case PIPE_FUNC_GEQUAL:
+      return hi < min;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Decide whether the depth bounds of the scene's zsbuf can be used, and
+ * (re)initialize them if needed.
+ * Called once per scene by one thread, after lp_scene_begin_rasterization().
+ */
+void
+lp_rast_hiz_begin_scene(struct lp_scene *scene)
+{
+   struct pipe_surface *zsbuf = scene->fb.zsbuf;
+   const struct util_format_description *desc;
+   const struct util_format_channel_description *chan;
+   struct llvmpipe_resource *lpr;
+   unsigned tiles_x, tiles_y, i;
+
+   scene->hiz = NULL;
+
+   if (!zsbuf || !llvmpipe_resource_is_texture(zsbuf->texture))
+      return;
+
+   lpr = llvmpipe_resource(zsbuf->texture);
+   desc = util_format_description(zsbuf->format);
+
+   if ((LP_PERF & PERF_NO_HIZ) ||
+       !util_format_has_depth(desc) ||
+       zsbuf->u.tex.level != 0 ||
+       zsbuf->u.tex.first_layer != 0 ||
+       zsbuf->u.tex.last_layer != 0 ||
+       scene->zsbuf.nr_samples > 1 ||
+       lpr->dt ||
+       lpr->user_ptr ||
+       lpr->backable ||
+       lpr->imported_memory ||
+       (lpr->base.bind & PIPE_BIND_SHARED)) {
+      /* This scene may write the buffer behind our back. */
+      lpr->hiz_valid = false;
+      return;
+   }
+
+   tiles_x = DIV_ROUND_UP(lpr->base.width0, TILE_SIZE);
+   tiles_y = DIV_ROUND_UP(lpr->base.height0, TILE_SIZE);
+
+   if (!lpr->hiz) {
+      lpr->hiz = MALLOC(tiles_x * tiles_y * sizeof *lpr->hiz);
+      if (!lpr->hiz)
+         return;
+      lpr->hiz_valid = false;
+   }
+
+   if (!lpr->hiz_valid || lpr->hiz_format != zsbuf->format) {
+      for (i = 0; i < tiles_x * tiles_y; i++)
+         hiz_tile_reset(&lpr->hiz[i]);
+      lpr->hiz_format = zsbuf->format;
+      lpr->hiz_valid = true;
+   }
+
+   chan = &desc->channel[desc->swizzle[0]];
+
+   scene->hiz = lpr->hiz;
+   scene->hiz_stride = tiles_x;
+   scene->hiz_unorm = chan->normalized;
+   scene->hiz_eps = chan->normalized ?
+      (float)(1.0 / (double)((1ull << chan->size) - 1)) : 0.0f;
+}
+
+
+/**
+ * Compute the depth range of a primitive's fragments over each block of
+ * the current tile, widen the bounds by what it may write, and test the
+ * whole tile.
+ * \return FALSE if the primitive can be skipped for this tile.
+ */
+static boolean
+hiz_begin_prim(struct lp_rasterizer_task *task,
+               const struct lp_rast_shader_inputs *inputs)
+{
+   const struct lp_scene *scene = task->scene;
+   const struct lp_rast_state *state = task->state;
+   struct lp_rast_hiz_prim *prim = &task->hiz_prim;
+   struct lp_hiz_tile *tile = task->hiz;
+   const struct lp_fragment_shader_variant *variant;
+   const struct lp_fragment_shader_variant_key *key;
+   float z0, dzdx, dzdy, zmin, zmax, eps, z, bx_lo, bx_hi, by_lo, by_hi;
+   boolean known;
+   unsigned i;
+
+   prim->reject = FALSE;
+   prim->tighten = FALSE;
+
+   if (inputs->disable || !state)
+      return TRUE;
+
+   variant = state->variant;
+   key = &variant->key;
+
+   if (!key->depth.enabled ||
+       inputs->layer + inputs->view_index != 0)
+      return TRUE;
+
+   z0 = GET_A0(inputs)[0][2];
+   dzdx = GET_DADX(inputs)[0][2];
+   dzdy = GET_DADY(inputs)[0][2];
+
+   /* Fragment depth is the plane evaluated at the pixel centers, clamped
+    * to the viewport depth range and then to the format's range.
+    */
+   if (key->depth_clamp) {
+      const struct lp_jit_viewport *vp =
+         &state->jit_context.viewports[inputs->viewport_index];
+      zmin = vp->min_depth;
+      zmax = vp->max_depth;
+   }
+   else {
+      zmin = -INFINITY;
+      zmax = INFINITY;
+   }
+   if (scene->hiz_unorm) {
+      zmin = MAX2(zmin, 0.0f);
+      zmax = MIN2(zmax, 1.0f);
+   }
+
+   known = !variant->shader->info.base.writes_z &&
+           isfinite(z0) && isfinite(dzdx) && isfinite(dzdy);
+
+   if (known) {
+      /* Allow for the rounding of the interpolation, and of the conversion
+       * to the depth format.
+       */
+      eps = ldexpf(fabsf(z0) +
+                   fabsf(dzdx) * (float)(task->x + TILE_SIZE) +
+                   fabsf(dzdy) * (float)(task->y + TILE_SIZE), -20) +
+            scene->hiz_eps;
+      known = isfinite(eps);
+   }
+
+   if (known) {
+      z = z0 + dzdx * (float)task->x + dzdy * (float)task->y;
+      bx_lo = MIN2(dzdx * 16.0f, 0.0f);
+      bx_hi = MAX2(dzdx * 16.0f, 0.0f);
+      by_lo = MIN2(dzdy * 16.0f, 0.0f);
+      by_hi = MAX2(dzdy * 16.0f, 0.0f);
+
+      for (i = 0; i < 16; i++) {
+         float zb = z + dzdx * (float)((i & 3) * 16) +
+                        dzdy * (float)((i >> 2) * 16);
+         float lo = zb + bx_lo + by_lo - eps;
+         float hi = zb + bx_hi + by_hi + eps;
+         prim->lo[i] = CLAMP(lo, zmin, zmax);
+         prim->hi[i] = CLAMP(hi, zmin, zmax);
+      }
+   }
+   else {
+      for (i = 0; i < 16; i++) {
+         prim->lo[i] = -INFINITY;
+         prim->hi[i] = INFINITY;
+      }
+   }
+
+   prim->func = key->depth.func;
+   prim->reject = variant->hiz_reject && known;
+   prim->tighten = variant->hiz_tighten && known;
+
+   if (prim->reject) {
+      float tile_lo = prim->lo[0];
+      float tile_hi = prim->hi[0];
+
+      for (i = 1; i < 16; i++) {
+         tile_lo = MIN2(tile_lo, prim->lo[i]);
+         tile_hi = MAX2(tile_hi, prim->hi[i]);
+      }
+
+      if (hiz_test_reject(prim->func, tile_lo, tile_hi,
+                          tile->tile_min, tile->tile_max)) {
+         LP_COUNT(nr_hiz_rejected_64);
+         LP_COUNT_ADD(nr_hiz_rejected_pixels, task->width * task->height);
+         return FALSE;
+      }
+   }
+
+   if (!key->depth.writemask)
+      return TRUE;
+
+   /* Account for whatever may get written.  Fragments only replace depth
+    * values they pass against, so ordering functions move one bound only.
+    */
+   switch (prim->func) {
+   case PIPE_FUNC_NEVER:
+   case PIPE_FUNC_EQUAL:
+      return TRUE;
+   case PIPE_FUNC_LESS:
+   case PIPE_FUNC_LEQUAL:
+      for (i = 0; i < 16; i++)
+         tile->min[i] = MIN2(tile->min[i], prim->lo[i]);
+      break;
+   case PIPE_FUNC_GREATER:
+   case PIPE_FUNC_GEQUAL:
+      for (i = 0; i < 16; i++)
+         tile->max[i] = MAX2(tile->max[i], prim->hi[i]);
+      break;
+   default:
+      for (i = 0; i < 16; i++) {
+         tile->min[i] = MIN2(tile->min[i], prim->lo[i]);
+         tile->max[i] = MAX2(tile->max[i], prim->hi[i]);
+      }
+      break;
+   }
+   hiz_tile_update(tile);
+
+   return TRUE;
+}
+
+
+/**
+ * Set up the depth bounds tests of a command on the current tile.
+ * \return FALSE if the command can be skipped for this tile.
+ */
+boolean
+lp_rast_hiz_begin_cmd(struct lp_rasterizer_task *task,
+                      unsigned cmd,
+                      const union lp_rast_cmd_arg arg)
+{
+   if (cmd == LP_RAST_OP_SHADE_TILE ||
+       cmd == LP_RAST_OP_SHADE_TILE_OPAQUE)
+      return hiz_begin_prim(task, arg.shade_tile);
+   else if (cmd == LP_RAST_OP_RECTANGLE)
+      return hiz_begin_prim(task, &arg.rectangle->inputs);
+   else if ((cmd >= LP_RAST_OP_TRIANGLE_1 &&
+             cmd <= LP_RAST_OP_TRIANGLE_4_16) ||
+            (cmd >= LP_RAST_OP_TRIANGLE_32_1 &&
+             cmd <= LP_RAST_OP_MS_TRIANGLE_4_16))
+      return hiz_begin_prim(task, &arg.triangle.tri->inputs);
+   else if (cmd == LP_RAST_OP_TRIANGLE_BATCH) {
+      const struct lp_rast_tri_batch *batch = arg.tri_batch;
+      unsigned i;
+
+      /* The bounds must still account for whatever each primitive may
+       * write, but its blocks are neither tested nor tightened.
+       */
+      for (i = 0; i < batch->count; i++)
+         hiz_begin_prim(task, &batch->tri[i]->inputs);
+
+      task->hiz_prim.reject = FALSE;
+      task->hiz_prim.tighten = FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * \return the subset of the given 16x16 blocks of the current tile in
+ * which all fragments of the current command fail the depth test.
+ */
+unsigned
+lp_rast_hiz_reject_mask(struct lp_rasterizer_task *task,
+                        unsigned mask)
+{
+   const struct lp_rast_hiz_prim *prim = &task->hiz_prim;
+   const struct lp_hiz_tile *tile = task->hiz;
+   unsigned reject = 0;
+
+   if (!prim->reject)
+      return 0;
+
+   while (mask) {
+      int i = u_bit_scan(&mask);
+
+      if (hiz_test_reject(prim->func, prim->lo[i], prim->hi[i],
+                          tile->min[i], tile->max[i]))
+         reject |= 1 << i;
+   }
+
+   LP_COUNT_ADD(nr_hiz_rejected_16, util_bitcount(reject));
+   LP_COUNT_ADD(nr_hiz_rejected_pixels, 16 * 16 * util_bitcount(reject));
+
+   return reject;
+}
+
+
+/**
+ * Tighten the bounds of the given 16x16 blocks of the current tile, which
+ * the current command has covered completely.
+ */
+void
+lp_rast_hiz_tighten(struct lp_rasterizer_task *task,
+                    unsigned mask)
+{
+   const struct lp_rast_hiz_prim *prim = &task->hiz_prim;
+   struct lp_hiz_tile *tile = task->hiz;
+
+   if (!prim->tighten)
+      return;
+
+   while (mask) {
+      int i = u_bit_scan(&mask);
+
+      /* Blocks sticking out of the framebuffer aren't written entirely. */
+      if ((i & 3) * 16 + 16 > task->width ||
+          (i >> 2) * 16 + 16 > task->height)
+         continue;
+
+      switch (prim->func) {
+      case PIPE_FUNC_LESS:
+      case PIPE_FUNC_LEQUAL:
+         tile->max[i] = MIN2(tile->max[i], prim->hi[i]);
+         break;
+      case PIPE_FUNC_GREATER:
+      case PIPE_FUNC_GEQUAL:
+         tile->min[i] = MAX2(tile->min[i], prim->lo[i]);
+         break;
+      default:
+         break;
+      }
+   }
+   hiz_tile_update(tile);
+}
+
+
+/**
+ * Update the bounds of the current tile for a z/stencil clear.
+ */
+void
+lp_rast_hiz_clear(struct lp_rasterizer_task *task,
+                  uint64_t value,
+                  uint64_t mask)
+{
+   enum pipe_format format = task->scene->fb.zsbuf->format;
+   uint64_t depth_mask = util_pack64_mask_z(format, ~0);
+   struct lp_hiz_tile *tile = task->hiz;
+   float z;
+   unsigned i;
+
+   if (!(mask & depth_mask))
+      return;
+
+   if ((mask & depth_mask) != depth_mask) {
+      hiz_tile_reset(tile);
+      return;
+   }
+
+   util_format_unpack_z_float(format, &z, &value, 1);
+
+   for (i = 0; i < 16; i++) {
+      unsigned x = (i & 3) * 16;
+      unsigned y = (i >> 2) * 16;
+
+      if (x + 16 <= task->width && y + 16 <= task->height) {
+         tile->min[i] = z;
+         tile->max[i] = z;
+      }
+      else if (x < task->width && y < task->height) {
+         tile->min[i] = MIN2(tile->min[i], z);
+         tile->max[i] = MAX2(tile->max[i], z);
+      }
+   }
+   hiz_tile_update(tile);
+}
@@ -53,6 +53,9 @@ lp_rast_linear_clear(struct lp_rasterizer_task *task,
 
    uc = arg.clear_rb->color_val;
 
+   if (lp_rast_fast_clear_color(task, 0, &uc))
+      return;
+
    util_fill_rect(scene->cbufs[0].map,
                   PIPE_FORMAT_B8G8R8A8_UNORM,
                   scene->cbufs[0].stride,
@@ -232,6 +235,7 @@ dispatch_linear[] = {
    NULL,                        /* lp_rast_triangle_ms_3_4 */
    NULL,                        /* lp_rast_triangle_ms_3_16 */
    NULL,                        /* lp_rast_triangle_ms_4_16 */
+   NULL,                        /* lp_rast_triangle_batch */
 
    lp_rast_linear_rect,         /* rect */
    lp_rast_linear_tile,         /* blit */
@@ -257,6 +261,8 @@ lp_linear_rasterize_bin(struct lp_rasterizer_task *task,
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
          assert(dispatch_linear[block->cmd[k]]);
+         if (task->fast_clear_active)
+            lp_rast_fast_clear_write(task, block->cmd[k], block->arg[k]);
          dispatch_linear[block->cmd[k]]( task, block->arg[k] );
       }
    }
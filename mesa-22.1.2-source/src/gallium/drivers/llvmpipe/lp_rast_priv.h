@@ -76,6 +76,61 @@ extern const struct lp_rasterizer_task *jit_task;
 struct lp_rasterizer;
 struct cmd_bin;
 
+/**
+ * Conservative depth bounds of a 64x64 tile and of its sixteen 16x16
+ * blocks.  Unknown bounds are -INFINITY, INFINITY.  See lp_rast_hiz.c.
+ */
+struct lp_hiz_tile
+{
+   float min[16], max[16];
+   float tile_min, tile_max;
+};
+
+/**
+ * Depth range of the fragments of the current command over each 16x16
+ * block of the current tile.
+ */
+struct lp_rast_hiz_prim
+{
+   float lo[16], hi[16];
+   unsigned func;       /**< PIPE_FUNC_x depth test */
+   boolean reject;      /**< blocks may be rejected against the bounds */
+   boolean tighten;     /**< fully covered blocks tighten the bounds */
+};
+
+/**
+ * What is known about the contents of a buffer's 64x64 tile: the bits set
+ * in mask hold the ones of value in every pixel.  A zero mask means
+ * nothing is known.  See lp_rast_fast_clear.c.
+ */
+struct lp_fast_clear_tile
+{
+   uint64_t value[2];
+   uint64_t mask[2];
+};
+
+/**
+ * Front-most command of each pixel of a tile, for bins rasterized in a
+ * depth pass and a shading pass.  See lp_rast_tbdr.c.
+ */
+struct lp_rast_tbdr
+{
+   float z[TILE_SIZE * TILE_SIZE];
+   uint16_t cmd[TILE_SIZE * TILE_SIZE];
+   unsigned func;       /**< PIPE_FUNC_x depth test of the bin's commands */
+   float scale;         /**< depth values are rounded to multiples of 1/scale */
+};
+
+enum lp_rast_tbdr_pass
+{
+   LP_TBDR_NONE = 0,
+   LP_TBDR_DEPTH,       /**< find the front-most command of each pixel */
+   LP_TBDR_SHADE,       /**< shade the pixels where it is the front-most */
+};
+
+/** Index of the zsbuf in the fast clear arrays, after the color buffers */
+#define LP_FAST_CLEAR_ZS PIPE_MAX_COLOR_BUFS
+
 /**
  * Per-thread rasterization state
  */
@@ -91,6 +146,23 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /** Depth bounds of the current tile, or NULL if not tracked */
+   struct lp_hiz_tile *hiz;
+   struct lp_rast_hiz_prim hiz_prim;
+
+   /** Clear state of the current tile of each buffer, or NULL */
+   struct lp_fast_clear_tile *fast_clear[PIPE_MAX_COLOR_BUFS + 1];
+   /** Clears of the current tile which haven't been written yet */
+   struct lp_fast_clear_tile clear_pending[PIPE_MAX_COLOR_BUFS + 1];
+   unsigned clear_pending_mask;
+   /** Buffers whose tile has a pending clear or known contents */
+   unsigned fast_clear_active;
+
+   /** Current pass over a bin of opaque commands, and its command */
+   enum lp_rast_tbdr_pass tbdr;
+   unsigned tbdr_cmd;
+   struct lp_rast_tbdr tbdr_tile;
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
@@ -131,6 +203,12 @@ struct lp_rasterizer
    util_barrier barrier;
 };
 
+unsigned
+lp_rast_tbdr_filter(struct lp_rasterizer_task *task,
+                    const struct lp_rast_shader_inputs *inputs,
+                    unsigned x, unsigned y,
+                    unsigned mask);
+
 void
 lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
                                 const struct lp_rast_shader_inputs *inputs,
@@ -141,6 +219,11 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
                          const struct lp_rast_shader_inputs *inputs,
                          unsigned x, unsigned y,
                          unsigned mask);
+void
+lp_rast_shade_quads_visible(struct lp_rasterizer_task *task,
+                            const struct lp_rast_shader_inputs *inputs,
+                            unsigned x, unsigned y,
+                            uint64_t mask);
 
 
 /**
@@ -241,6 +324,15 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
    unsigned depth_sample_stride = 0;
    unsigned i;
 
+   if (task->tbdr) {
+      unsigned tbdr_mask = lp_rast_tbdr_filter(task, inputs, x, y, 0xffff);
+      if (tbdr_mask != 0xffff) {
+         if (tbdr_mask)
+            lp_rast_shade_quads_visible(task, inputs, x, y, tbdr_mask);
+         return;
+      }
+   }
+
    /* color buffer */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i]) {
@@ -378,6 +470,14 @@ void lp_rast_triangle_ms_3_16( struct lp_rasterizer_task *,
 void lp_rast_triangle_ms_4_16( struct lp_rasterizer_task *,
                             const union lp_rast_cmd_arg );
 
+void lp_rast_triangle_batch( struct lp_rasterizer_task *,
+                             const union lp_rast_cmd_arg );
+
+unsigned
+lp_rast_tri_batch_masks(const struct lp_rast_tri_batch *batch,
+                        int x, int y,
+                        unsigned *masks);
+
 void lp_rast_triangle_ms_32_1( struct lp_rasterizer_task *,
                          const union lp_rast_cmd_arg );
 void lp_rast_triangle_ms_32_2( struct lp_rasterizer_task *,
@@ -407,6 +507,106 @@ void lp_rast_triangle_ms_32_4_16( struct lp_rasterizer_task *,
 void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg);
+
+
+/**
+ * Coverage mask builders of the triangle rasterizer.  Both evaluate the
+ * edge functions of nr_planes planes over a 4x4 grid of steps, step i
+ * being c + (i & 3) * dcdx + (i >> 2) * dcdy, and OR the sign bits of the
+ * planes into bit i of the masks.  build_masks() also does so for the
+ * values offset by cdiff, into partmask.
+ */
+struct lp_rast_mask_funcs {
+   void (*build_masks)(unsigned nr_planes,
+                       const int32_t *c,
+                       const int32_t *cdiff,
+                       const int32_t *dcdx,
+                       const int32_t *dcdy,
+                       unsigned *outmask,
+                       unsigned *partmask);
+   unsigned (*build_mask_linear)(unsigned nr_planes,
+                                 const int32_t *c,
+                                 const int32_t *dcdx,
+                                 const int32_t *dcdy);
+};
+
+/** The wider builders picked for this CPU, or NULL for the SSE2 ones. */
+extern struct lp_rast_mask_funcs lp_rast_mask_funcs;
+
+void
+lp_rast_init_mask_funcs(void);
+
+void
+lp_rast_mask_funcs_baseline(struct lp_rast_mask_funcs *funcs);
+
+boolean
+lp_rast_mask_funcs_avx2(struct lp_rast_mask_funcs *funcs);
+
+boolean
+lp_rast_mask_funcs_avx512(struct lp_rast_mask_funcs *funcs);
+
+boolean
+lp_rast_mask_funcs_neon(struct lp_rast_mask_funcs *funcs);
+
+void
+lp_rast_hiz_begin_scene(struct lp_scene *scene);
+
+boolean
+lp_rast_hiz_begin_cmd(struct lp_rasterizer_task *task,
+                      unsigned cmd,
+                      const union lp_rast_cmd_arg arg);
+
+unsigned
+lp_rast_hiz_reject_mask(struct lp_rasterizer_task *task,
+                        unsigned mask);
+
+void
+lp_rast_hiz_tighten(struct lp_rasterizer_task *task,
+                    unsigned mask);
+
+void
+lp_rast_hiz_clear(struct lp_rasterizer_task *task,
+                  uint64_t value,
+                  uint64_t mask);
+
+boolean
+lp_rast_tbdr_begin_bin(struct lp_rasterizer_task *task,
+                       const struct cmd_bin *bin);
+
+void
+lp_rast_fill_color(struct lp_rasterizer_task *task,
+                   unsigned cbuf,
+                   union util_color *uc);
+
+void
+lp_rast_fill_zstencil(struct lp_rasterizer_task *task,
+                      uint64_t value,
+                      uint64_t mask);
+
+void
+lp_rast_fast_clear_begin_scene(struct lp_scene *scene);
+
+void
+lp_rast_fast_clear_begin_tile(struct lp_rasterizer_task *task,
+                              int x, int y);
+
+boolean
+lp_rast_fast_clear_color(struct lp_rasterizer_task *task,
+                         unsigned cbuf,
+                         const union util_color *uc);
+
+boolean
+lp_rast_fast_clear_zstencil(struct lp_rasterizer_task *task,
+                            uint64_t value,
+                            uint64_t mask);
+
+void
+lp_rast_fast_clear_write(struct lp_rasterizer_task *task,
+                         unsigned cmd,
+                         const union lp_rast_cmd_arg arg);
+
+void
+lp_rast_fast_clear_end_tile(struct lp_rasterizer_task *task);
  
 void
 lp_debug_bin( const struct cmd_bin *bin, int x, int y );
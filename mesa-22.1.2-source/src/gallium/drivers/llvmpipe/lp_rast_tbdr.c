@@ -0,0 +1,225 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Deferred shading of opaque geometry, per tile.
+ *
+ * With LP_TBDR=1, a bin whose draw commands are all opaque, depth tested
+ * and depth writing with the same ordering function (see the tbdr flag of
+ * the shader variants) is rasterized twice:
+ *
+ *  - a depth pass evaluates the depth plane of each command over the
+ *    pixels it covers, and records which command is front-most at each
+ *    pixel.  Nothing is shaded or written.
+ *  - a shading pass executes the bin as usual, except that each command
+ *    only shades the pixels where it is front-most.
+ *
+ * Since the front-most fragment is the one which ends up in the buffers
+ * when everything is drawn in order, high overdraw costs about one shaded
+ * fragment per pixel.  The depth test still happens in the shading pass,
+ * against the real depth buffer: when the front-most fragment fails it,
+ * all the others would have too.
+ *
+ * The depth pass rounds depth values to the precision of the depth buffer,
+ * but not exactly like the shaders do, so fragments with (nearly) the same
+ * depth may resolve differently than in order rendering.
+ */
+
+#include <math.h>
+#include "util/u_math.h"
+#include "util/format/u_format.h"
+#include "lp_debug.h"
+#include "lp_perf.h"
+#include "lp_rast_priv.h"
+#include "lp_state_fs.h"
+
+
+/**
+ * Whether fragments of depth a are drawn over fragments of depth b.
+ */
+static inline boolean
+tbdr_depth_test(unsigned func, float a, float b)
+{
+   switch (func) {
+   case PIPE_FUNC_LESS:
+      return a < b;
+   case PIPE_FUNC_LEQUAL:
+      return a <= b;
+   case PIPE_FUNC_GREATER:
+      return a > b;
+   case PIPE_FUNC_GEQUAL:
+      return a >= b;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Check whether the bin can be rasterized in a depth and a shading pass,
+ * and prepare the depth pass.
+ */
+boolean
+lp_rast_tbdr_begin_bin(struct lp_rasterizer_task *task,
+                       const struct cmd_bin *bin)
+{
+   const struct lp_scene *scene = task->scene;
+   struct lp_rast_tbdr *tbdr = &task->tbdr_tile;
+   const struct lp_rast_state *state = NULL;
+   const struct cmd_block *block;
+   const struct util_format_description *desc;
+   const struct util_format_channel_description *chan;
+   unsigned func = PIPE_FUNC_NEVER;
+   unsigned draws = 0;
+   unsigned i, k;
+   float init;
+
+   if (!scene->fb.zsbuf ||
+       scene->fb_max_samples > 1 ||
+       scene->fb_max_layer != 0 ||
+       scene->num_active_queries)
+      return FALSE;
+
+   for (block = bin->head; block; block = block->next) {
+      for (k = 0; k < block->count; k++) {
+         unsigned cmd = block->cmd[k];
+
+         if (cmd == LP_RAST_OP_SET_STATE) {
+            state = block->arg[k].set_state;
+         }
+         else if (cmd == LP_RAST_OP_CLEAR_COLOR ||
+                  cmd == LP_RAST_OP_CLEAR_ZSTENCIL) {
+            /* Clears would have to happen between the passes. */
+            if (draws)
+               return FALSE;
+         }
+         else if ((cmd >= LP_RAST_OP_TRIANGLE_1 &&
+                   cmd <= LP_RAST_OP_SHADE_TILE) ||
+                  (cmd >= LP_RAST_OP_TRIANGLE_32_1 &&
+                   cmd <= LP_RAST_OP_TRIANGLE_32_4_16) ||
+                  cmd == LP_RAST_OP_RECTANGLE) {
+            if (!state || !state->variant->tbdr)
+               return FALSE;
+            if (draws && state->variant->key.depth.func != func)
+               return FALSE;
+            func = state->variant->key.depth.func;
+            draws++;
+         }
+         else {
+            return FALSE;
+         }
+      }
+   }
+
+   /* A single command gains nothing. */
+   if (draws < 2 || draws >= UINT16_MAX)
+      return FALSE;
+
+   desc = util_format_description(scene->fb.zsbuf->format);
+   chan = &desc->channel[desc->swizzle[0]];
+
+   tbdr->func = func;
+   tbdr->scale = chan->normalized ?
+      (float)((1ull << chan->size) - 1) : 0.0f;
+
+   init = func == PIPE_FUNC_LESS || func == PIPE_FUNC_LEQUAL ?
+      INFINITY : -INFINITY;
+   for (i = 0; i < TILE_SIZE * TILE_SIZE; i++) {
+      tbdr->z[i] = init;
+      tbdr->cmd[i] = UINT16_MAX;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Called for every 4x4 block a command covers.  In the depth pass, record
+ * where the current command is front-most; in the shading pass, return
+ * which of the covered pixels it is front-most at.
+ * \param x, y  location of the 4x4 block in window coords
+ */
+unsigned
+lp_rast_tbdr_filter(struct lp_rasterizer_task *task,
+                    const struct lp_rast_shader_inputs *inputs,
+                    unsigned x, unsigned y,
+                    unsigned mask)
+{
+   struct lp_rast_tbdr *tbdr = &task->tbdr_tile;
+   const unsigned base = (y - task->y) * TILE_SIZE + (x - task->x);
+   const struct lp_fragment_shader_variant_key *key;
+   float z0, dzdx, dzdy, zmin, zmax;
+   unsigned visible = 0;
+
+   if (task->tbdr == LP_TBDR_SHADE) {
+      while (mask) {
+         int i = u_bit_scan(&mask);
+
+         if (tbdr->cmd[base + (i >> 2) * TILE_SIZE + (i & 3)] == task->tbdr_cmd)
+            visible |= 1 << i;
+      }
+      LP_COUNT_ADD(nr_tbdr_shaded_fragments, util_bitcount(visible));
+      return visible;
+   }
+
+   key = &task->state->variant->key;
+
+   z0 = GET_A0(inputs)[0][2];
+   dzdx = GET_DADX(inputs)[0][2];
+   dzdy = GET_DADY(inputs)[0][2];
+
+   if (key->depth_clamp) {
+      const struct lp_jit_viewport *vp =
+         &task->state->jit_context.viewports[inputs->viewport_index];
+      zmin = vp->min_depth;
+      zmax = vp->max_depth;
+   }
+   else {
+      zmin = -INFINITY;
+      zmax = INFINITY;
+   }
+   if (tbdr->scale) {
+      zmin = MAX2(zmin, 0.0f);
+      zmax = MIN2(zmax, 1.0f);
+   }
+
+   while (mask) {
+      int i = u_bit_scan(&mask);
+      unsigned idx = base + (i >> 2) * TILE_SIZE + (i & 3);
+      float z = z0 + dzdx * (float)(x + (i & 3)) + dzdy * (float)(y + (i >> 2));
+
+      z = CLAMP(z, zmin, zmax);
+      if (tbdr->scale)
+         z = floorf(z * tbdr->scale + 0.5f);
+
+      LP_COUNT(nr_tbdr_fragments);
+      if (tbdr_depth_test(tbdr->func, z, tbdr->z[idx])) {
+         if (tbdr->cmd[idx] == UINT16_MAX)
+            LP_COUNT(nr_tbdr_pixels);
+         tbdr->z[idx] = z;
+         tbdr->cmd[idx] = task->tbdr_cmd;
+      }
+   }
+
+   return 0;
+}
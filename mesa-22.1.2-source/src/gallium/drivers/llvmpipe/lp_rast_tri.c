@@ -30,6 +30,7 @@
  */
 
 #include <limits.h>
+#include "c11/threads.h"
 #include "util/u_math.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
@@ -746,6 +747,187 @@ lp_rast_triangle_32_3_4(struct lp_rasterizer_task *task,
 #define BUILD_MASK_LINEAR(c, dcdx, dcdy) build_mask_linear(c, dcdx, dcdy)
 #endif
 
+
+struct lp_rast_mask_funcs lp_rast_mask_funcs;
+
+
+static void
+build_masks_baseline(unsigned nr_planes,
+                     const int32_t *c,
+                     const int32_t *cdiff,
+                     const int32_t *dcdx,
+                     const int32_t *dcdy,
+                     unsigned *outmask,
+                     unsigned *partmask)
+{
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++)
+      BUILD_MASKS(c[j], cdiff[j], dcdx[j], dcdy[j], outmask, partmask);
+}
+
+
+static unsigned
+build_mask_linear_baseline(unsigned nr_planes,
+                           const int32_t *c,
+                           const int32_t *dcdx,
+                           const int32_t *dcdy)
+{
+   unsigned mask = 0;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++)
+      mask |= BUILD_MASK_LINEAR(c[j], dcdx[j], dcdy[j]);
+
+   return mask;
+}
+
+
+void
+lp_rast_mask_funcs_baseline(struct lp_rast_mask_funcs *funcs)
+{
+   funcs->build_masks = build_masks_baseline;
+   funcs->build_mask_linear = build_mask_linear_baseline;
+}
+
+
+static void
+init_mask_funcs(void)
+{
+   struct lp_rast_mask_funcs funcs;
+
+   if (lp_rast_mask_funcs_avx512(&funcs) ||
+       lp_rast_mask_funcs_avx2(&funcs) ||
+       lp_rast_mask_funcs_neon(&funcs))
+      lp_rast_mask_funcs = funcs;
+}
+
+
+/**
+ * Pick the widest coverage mask builders this CPU supports.
+ */
+void
+lp_rast_init_mask_funcs(void)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, init_mask_funcs);
+}
+
+
+/* The builders are called once for all planes.  The SSE2 ones are inlined
+ * when there is nothing wider.
+ */
+static inline void
+build_masks_planes(unsigned nr_planes,
+                   const int32_t *c,
+                   const int32_t *cdiff,
+                   const int32_t *dcdx,
+                   const int32_t *dcdy,
+                   unsigned *outmask,
+                   unsigned *partmask)
+{
+   if (lp_rast_mask_funcs.build_masks)
+      lp_rast_mask_funcs.build_masks(nr_planes, c, cdiff, dcdx, dcdy,
+                                     outmask, partmask);
+   else
+      build_masks_baseline(nr_planes, c, cdiff, dcdx, dcdy,
+                           outmask, partmask);
+}
+
+
+static inline unsigned
+build_mask_linear_planes(unsigned nr_planes,
+                         const int32_t *c,
+                         const int32_t *dcdx,
+                         const int32_t *dcdy)
+{
+   if (lp_rast_mask_funcs.build_mask_linear)
+      return lp_rast_mask_funcs.build_mask_linear(nr_planes, c, dcdx, dcdy);
+   else
+      return build_mask_linear_baseline(nr_planes, c, dcdx, dcdy);
+}
+
+
+/**
+ * Compute the coverage masks of the primitives of a batch over the 4x4
+ * block at x, y of the batch's 16x16 block.  Only the primitives whose
+ * bounds touch the block are evaluated, the others get an empty mask.
+ * \return the union of the masks
+ */
+unsigned
+lp_rast_tri_batch_masks(const struct lp_rast_tri_batch *batch,
+                        int x, int y,
+                        unsigned *masks)
+{
+   unsigned live = batch->blocks[(y / 4) * 4 + x / 4];
+   unsigned any = 0;
+   unsigned i, j;
+
+   for (i = 0; i < LP_RAST_TRI_BATCH_SIZE; i++)
+      masks[i] = 0;
+
+   while (live) {
+      int32_t c[LP_RAST_TRI_BATCH_PLANES];
+      int32_t dcdx[LP_RAST_TRI_BATCH_PLANES];
+      int32_t dcdy[LP_RAST_TRI_BATCH_PLANES];
+
+      int32_t out = 0;
+
+      i = u_bit_scan(&live);
+      for (j = 0; j < batch->nr_planes; j++) {
+         dcdx[j] = batch->dcdx[j][i];
+         dcdy[j] = batch->dcdy[j][i];
+         c[j] = (int32_t)((uint32_t)batch->c[j][i] +
+                          (uint32_t)dcdx[j] * x + (uint32_t)dcdy[j] * y);
+
+         /* Trivial reject, from the largest value in the block */
+         out |= c[j] + 3 * (MAX2(dcdx[j], 0) + MAX2(dcdy[j], 0));
+      }
+      if (out < 0)
+         continue;
+
+      masks[i] = 0xffff & ~build_mask_linear_planes(batch->nr_planes,
+                                                     c, dcdx, dcdy);
+      any |= masks[i];
+   }
+
+   return any;
+}
+
+
+/**
+ * Rasterize a batch of small triangles or points: for each 4x4 block of
+ * their 16x16 block, compute the coverage of those touching it, then
+ * shade them in order.
+ */
+void
+lp_rast_triangle_batch(struct lp_rasterizer_task *task,
+                       const union lp_rast_cmd_arg arg)
+{
+   const struct lp_rast_tri_batch *batch = arg.tri_batch;
+   const int x = task->x + batch->x;
+   const int y = task->y + batch->y;
+   unsigned masks[LP_RAST_TRI_BATCH_SIZE];
+   int ix, iy;
+   unsigned i;
+
+   for (iy = 0; iy < 16; iy += 4) {
+      for (ix = 0; ix < 16; ix += 4) {
+         if (!lp_rast_tri_batch_masks(batch, ix, iy, masks))
+            continue;
+
+         for (i = 0; i < batch->count; i++) {
+            const struct lp_rast_triangle *tri = batch->tri[i];
+
+            if (masks[i] && !tri->inputs.disable)
+               lp_rast_shade_quads_mask(task, &tri->inputs,
+                                        x + ix, y + iy, masks[i]);
+         }
+      }
+   }
+}
+
+
 #define RASTER_64 1
 
 #define TAG(x) x##_1
@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * AArch64 NEON coverage mask builders for the triangle rasterizer.
+ *
+ * One register holds a row of four steps of a plane.  The planes are
+ * ORed together and the sign bits of the 16 steps are gathered with a
+ * shift and an across-vector add per row.
+ */
+
+#include "pipe/p_config.h"
+#include "lp_rast_priv.h"
+
+#if defined(PIPE_ARCH_AARCH64)
+
+#include <arm_neon.h>
+
+
+struct neon_rows {
+   int32x4_t row[4];
+};
+
+
+static inline struct neon_rows
+steps_neon(int32_t c, int32_t dcdx, int32_t dcdy)
+{
+   static const int32_t x[4] = { 0, 1, 2, 3 };
+   struct neon_rows r;
+
+   r.row[0] = vmlaq_n_s32(vdupq_n_s32(c), vld1q_s32(x), dcdx);
+   r.row[1] = vaddq_s32(r.row[0], vdupq_n_s32(dcdy));
+   r.row[2] = vaddq_s32(r.row[1], vdupq_n_s32(dcdy));
+   r.row[3] = vaddq_s32(r.row[2], vdupq_n_s32(dcdy));
+   return r;
+}
+
+
+static inline unsigned
+sign_bits_neon(const struct neon_rows *r)
+{
+   static const int32_t shift[4] = { -31, -30, -29, -28 };
+   const int32x4_t vshift = vld1q_s32(shift);
+   unsigned mask = 0;
+   unsigned i;
+
+   /* Move the sign bit of lane i down to bit i, then add the lanes. */
+   for (i = 0; i < 4; i++) {
+      uint32x4_t sign = vandq_u32(vreinterpretq_u32_s32(r->row[i]),
+                                  vdupq_n_u32(0x80000000));
+      mask |= vaddvq_u32(vshlq_u32(sign, vshift)) << (4 * i);
+   }
+
+   return mask;
+}
+
+
+static void
+build_masks_neon(unsigned nr_planes,
+                 const int32_t *c,
+                 const int32_t *cdiff,
+                 const int32_t *dcdx,
+                 const int32_t *dcdy,
+                 unsigned *outmask,
+                 unsigned *partmask)
+{
+   struct neon_rows out, part;
+   unsigned i, j;
+
+   for (i = 0; i < 4; i++) {
+      out.row[i] = vdupq_n_s32(0);
+      part.row[i] = vdupq_n_s32(0);
+   }
+
+   for (j = 0; j < nr_planes; j++) {
+      struct neon_rows r = steps_neon(c[j], dcdx[j], dcdy[j]);
+      int32x4_t vcdiff = vdupq_n_s32(cdiff[j]);
+
+      for (i = 0; i < 4; i++) {
+         out.row[i] = vorrq_s32(out.row[i], r.row[i]);
+         part.row[i] = vorrq_s32(part.row[i], vaddq_s32(r.row[i], vcdiff));
+      }
+   }
+
+   *outmask |= sign_bits_neon(&out);
+   *partmask |= sign_bits_neon(&part);
+}
+
+
+static unsigned
+build_mask_linear_neon(unsigned nr_planes,
+                       const int32_t *c,
+                       const int32_t *dcdx,
+                       const int32_t *dcdy)
+{
+   struct neon_rows acc;
+   unsigned i, j;
+
+   for (i = 0; i < 4; i++)
+      acc.row[i] = vdupq_n_s32(0);
+
+   for (j = 0; j < nr_planes; j++) {
+      struct neon_rows r = steps_neon(c[j], dcdx[j], dcdy[j]);
+
+      for (i = 0; i < 4; i++)
+         acc.row[i] = vorrq_s32(acc.row[i], r.row[i]);
+   }
+
+   return sign_bits_neon(&acc);
+}
+
+
+boolean
+lp_rast_mask_funcs_neon(struct lp_rast_mask_funcs *funcs)
+{
+   /* NEON is part of the AArch64 baseline. */
+   funcs->build_masks = build_masks_neon;
+   funcs->build_mask_linear = build_mask_linear_neon;
+   return TRUE;
+}
+
+#else
+
+boolean
+lp_rast_mask_funcs_neon(struct lp_rast_mask_funcs *funcs)
+{
+   return FALSE;
+}
+
+#endif /* PIPE_ARCH_AARCH64 */
@@ -46,41 +46,46 @@ TAG(do_block_4)(struct lp_rasterizer_task *task,
                 int x, int y,
                 const int64_t *c)
 {
+   int32_t mc[NR_PLANES], mdcdx[NR_PLANES], mdcdy[NR_PLANES];
    int j;
 #ifndef MULTISAMPLE
-   unsigned mask = 0xffff;
+   unsigned mask;
 #else
    uint64_t mask = UINT64_MAX;
 #endif
 
    for (j = 0; j < NR_PLANES; j++) {
+#ifdef RASTER_64
+      mdcdx[j] = -plane[j].dcdx >> FIXED_ORDER;
+      mdcdy[j] = plane[j].dcdy >> FIXED_ORDER;
+#else
+      mdcdx[j] = -plane[j].dcdx;
+      mdcdy[j] = plane[j].dcdy;
+#endif
+   }
+
 #ifndef MULTISAMPLE
+   for (j = 0; j < NR_PLANES; j++) {
 #ifdef RASTER_64
-      mask &= ~BUILD_MASK_LINEAR(((c[j] - 1) >> (int64_t)FIXED_ORDER),
-                                 -plane[j].dcdx >> FIXED_ORDER,
-                                 plane[j].dcdy >> FIXED_ORDER);
+      mc[j] = (int32_t)((c[j] - 1) >> (int64_t)FIXED_ORDER);
 #else
-      mask &= ~BUILD_MASK_LINEAR((c[j] - 1),
-                                 -plane[j].dcdx,
-                                 plane[j].dcdy);
+      mc[j] = (int32_t)(c[j] - 1);
 #endif
+   }
+   mask = 0xffff & ~build_mask_linear_planes(NR_PLANES, mc, mdcdx, mdcdy);
 #else
-      for (unsigned s = 0; s < 4; s++) {
+   for (unsigned s = 0; s < 4; s++) {
+      for (j = 0; j < NR_PLANES; j++) {
          int64_t new_c = (c[j]) + ((IMUL64(task->scene->fixed_sample_pos[s][1], plane[j].dcdy) + IMUL64(task->scene->fixed_sample_pos[s][0], -plane[j].dcdx)) >> FIXED_ORDER);
-         uint32_t build_mask;
 #ifdef RASTER_64
-         build_mask = BUILD_MASK_LINEAR((int32_t)((new_c - 1) >> (int64_t)FIXED_ORDER),
-                                        -plane[j].dcdx >> FIXED_ORDER,
-                                        plane[j].dcdy >> FIXED_ORDER);
+         mc[j] = (int32_t)((new_c - 1) >> (int64_t)FIXED_ORDER);
 #else
-         build_mask = BUILD_MASK_LINEAR((new_c - 1),
-                                        -plane[j].dcdx,
-                                        plane[j].dcdy);
+         mc[j] = (int32_t)(new_c - 1);
 #endif
-         mask &= ~((uint64_t)build_mask << (s * 16));
       }
-#endif
+      mask &= ~((uint64_t)build_mask_linear_planes(NR_PLANES, mc, mdcdx, mdcdy) << (s * 16));
    }
+#endif
 
    /* Now pass to the shader:
     */
@@ -99,6 +104,7 @@ TAG(do_block_16)(struct lp_rasterizer_task *task,
                  int x, int y,
                  const int64_t *c)
 {
+   int32_t mco[NR_PLANES], mcdiff[NR_PLANES], mdcdx[NR_PLANES], mdcdy[NR_PLANES];
    unsigned outmask, inmask, partmask, partial_mask;
    unsigned j;
 
@@ -129,12 +135,15 @@ TAG(do_block_16)(struct lp_rasterizer_task *task,
       cdiff = cio - cox;
 #endif
 
-      BUILD_MASKS(co, cdiff,
-                  dcdx, dcdy,
-                  &outmask,   /* sign bits from c[i][0..15] + cox */
-                  &partmask); /* sign bits from c[i][0..15] + cio */
+      mco[j] = co;              /* sign bits from c[i][0..15] + cox */
+      mcdiff[j] = cdiff;        /* sign bits from c[i][0..15] + cio */
+      mdcdx[j] = dcdx;
+      mdcdy[j] = dcdy;
    }
 
+   build_masks_planes(NR_PLANES, mco, mcdiff, mdcdx, mdcdy,
+                      &outmask, &partmask);
+
    if (outmask == 0xffff)
       return;
 
@@ -204,8 +213,10 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
    const int x = task->x, y = task->y;
    struct lp_rast_plane plane[NR_PLANES];
    int64_t c[NR_PLANES];
+   int32_t mco[NR_PLANES], mcdiff[NR_PLANES], mdcdx[NR_PLANES], mdcdy[NR_PLANES];
    unsigned outmask, inmask, partmask, partial_mask;
-   unsigned j = 0;
+   unsigned full_mask = 0;
+   unsigned j;
 
    if (tri->inputs.disable) {
       /* This triangle was partially binned and has been disabled */
@@ -215,7 +226,13 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
    outmask = 0;                 /* outside one or more trivial reject planes */
    partmask = 0;                /* outside one or more trivial accept planes */
 
-   while (plane_mask) {
+   /* This variant is only picked for triangles with exactly NR_PLANES
+    * planes left in plane_mask.  Looping over NR_PLANES rather than the bits
+    * of the mask lets the compiler see that plane[] and c[] are filled in.
+    */
+   assert(util_bitcount(plane_mask) == NR_PLANES);
+
+   for (j = 0; j < NR_PLANES; j++) {
       int i = ffs(plane_mask) - 1;
       plane[j] = tri_plane[i];
       plane_mask &= ~(1 << i);
@@ -282,15 +299,16 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
          co = c[j] + cox;
          cdiff = cio - cox;
 #endif
-         BUILD_MASKS(co, cdiff,
-                     dcdx, dcdy,
-                     &outmask,   /* sign bits from c[i][0..15] + cox */
-                     &partmask); /* sign bits from c[i][0..15] + cio */
+         mco[j] = co;           /* sign bits from c[i][0..15] + cox */
+         mcdiff[j] = cdiff;     /* sign bits from c[i][0..15] + cio */
+         mdcdx[j] = dcdx;
+         mdcdy[j] = dcdy;
       }
-
-      j++;
    }
 
+   build_masks_planes(NR_PLANES, mco, mcdiff, mdcdx, mdcdy,
+                      &outmask, &partmask);
+
    if (outmask == 0xffff)
       return;
 
@@ -307,6 +325,15 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 
    LP_COUNT_ADD(nr_empty_16, util_bitcount(0xffff & ~(partial_mask | inmask)));
 
+   /* Skip blocks where the depth bounds say every fragment fails:
+    */
+   if (task->hiz) {
+      unsigned hiz_reject = lp_rast_hiz_reject_mask(task, partial_mask | inmask);
+      partial_mask &= ~hiz_reject;
+      inmask &= ~hiz_reject;
+      full_mask = inmask;
+   }
+
    /* Iterate over partials:
     */
    while (partial_mask) {
@@ -342,6 +369,9 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
       LP_COUNT(nr_fully_covered_16);
       block_full_16(task, tri, px, py);
    }
+
+   if (full_mask)
+      lp_rast_hiz_tighten(task, full_mask);
 }
 
 #if defined(PIPE_ARCH_SSE) && defined(TRI_16)
@@ -0,0 +1,235 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * AVX2 and AVX-512 coverage mask builders for the triangle rasterizer.
+ *
+ * The SSE2 builders in lp_rast_tri.c evaluate one plane at a time, four
+ * edge values per instruction, and pack the results down to bytes for
+ * the sign bits.  Here all 16 steps of a plane fit in two (AVX2) or one
+ * (AVX-512) registers, and the planes are ORed together before the sign
+ * bits are extracted once.
+ */
+
+#include "pipe/p_config.h"
+#include "lp_rast_priv.h"
+
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+
+#include <immintrin.h>
+#include "util/u_cpu_detect.h"
+
+/* The kernels are built for the baseline target and only run on CPUs that
+ * have the instructions, so they are compiled for them one by one.
+ */
+#if defined(__GNUC__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+
+/*
+ * Step i of the 4x4 grid is x = i & 3, y = i >> 2.  Multiplying the plane
+ * increments by those is done by masking the increment and its double
+ * with the bits of x and y.
+ */
+
+TARGET("avx2") static inline __m256i
+steps_avx2(int32_t c, int32_t dcdx, int32_t dcdy, __m256i *rows23)
+{
+   const __m256i x1 = _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+   const __m256i x2 = _mm256_setr_epi32(0, 0, -1, -1, 0, 0, -1, -1);
+   const __m256i y1 = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+   __m256i vdcdx = _mm256_set1_epi32(dcdx);
+   __m256i vdcdy = _mm256_set1_epi32(dcdy);
+   __m256i rows01;
+
+   rows01 = _mm256_add_epi32(_mm256_set1_epi32(c),
+                             _mm256_and_si256(vdcdx, x1));
+   rows01 = _mm256_add_epi32(rows01,
+                             _mm256_and_si256(_mm256_add_epi32(vdcdx, vdcdx), x2));
+   rows01 = _mm256_add_epi32(rows01, _mm256_and_si256(vdcdy, y1));
+
+   *rows23 = _mm256_add_epi32(rows01, _mm256_add_epi32(vdcdy, vdcdy));
+   return rows01;
+}
+
+
+TARGET("avx2") static inline unsigned
+sign_bits_avx2(__m256i rows01, __m256i rows23)
+{
+   return _mm256_movemask_ps(_mm256_castsi256_ps(rows01)) |
+          (_mm256_movemask_ps(_mm256_castsi256_ps(rows23)) << 8);
+}
+
+
+TARGET("avx2") static void
+build_masks_avx2(unsigned nr_planes,
+                 const int32_t *c,
+                 const int32_t *cdiff,
+                 const int32_t *dcdx,
+                 const int32_t *dcdy,
+                 unsigned *outmask,
+                 unsigned *partmask)
+{
+   __m256i out01 = _mm256_setzero_si256(), out23 = out01;
+   __m256i part01 = out01, part23 = out01;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++) {
+      __m256i rows23;
+      __m256i rows01 = steps_avx2(c[j], dcdx[j], dcdy[j], &rows23);
+      __m256i vcdiff = _mm256_set1_epi32(cdiff[j]);
+
+      out01 = _mm256_or_si256(out01, rows01);
+      out23 = _mm256_or_si256(out23, rows23);
+      part01 = _mm256_or_si256(part01, _mm256_add_epi32(rows01, vcdiff));
+      part23 = _mm256_or_si256(part23, _mm256_add_epi32(rows23, vcdiff));
+   }
+
+   *outmask |= sign_bits_avx2(out01, out23);
+   *partmask |= sign_bits_avx2(part01, part23);
+}
+
+
+TARGET("avx2") static unsigned
+build_mask_linear_avx2(unsigned nr_planes,
+                       const int32_t *c,
+                       const int32_t *dcdx,
+                       const int32_t *dcdy)
+{
+   __m256i acc01 = _mm256_setzero_si256(), acc23 = acc01;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++) {
+      __m256i rows23;
+      __m256i rows01 = steps_avx2(c[j], dcdx[j], dcdy[j], &rows23);
+
+      acc01 = _mm256_or_si256(acc01, rows01);
+      acc23 = _mm256_or_si256(acc23, rows23);
+   }
+
+   return sign_bits_avx2(acc01, acc23);
+}
+
+
+TARGET("avx512f") static inline __m512i
+steps_avx512(int32_t c, int32_t dcdx, int32_t dcdy)
+{
+   /* Lanes with bit 0 / bit 1 of x, and bit 0 / bit 1 of y set. */
+   const __mmask16 x1 = 0xaaaa, x2 = 0xcccc, y1 = 0xf0f0, y2 = 0xff00;
+   __m512i vdcdx = _mm512_set1_epi32(dcdx);
+   __m512i vdcdy = _mm512_set1_epi32(dcdy);
+   __m512i v = _mm512_set1_epi32(c);
+
+   v = _mm512_mask_add_epi32(v, x1, v, vdcdx);
+   v = _mm512_mask_add_epi32(v, x2, v, _mm512_add_epi32(vdcdx, vdcdx));
+   v = _mm512_mask_add_epi32(v, y1, v, vdcdy);
+   v = _mm512_mask_add_epi32(v, y2, v, _mm512_add_epi32(vdcdy, vdcdy));
+   return v;
+}
+
+
+TARGET("avx512f") static void
+build_masks_avx512(unsigned nr_planes,
+                   const int32_t *c,
+                   const int32_t *cdiff,
+                   const int32_t *dcdx,
+                   const int32_t *dcdy,
+                   unsigned *outmask,
+                   unsigned *partmask)
+{
+   const __m512i zero = _mm512_setzero_si512();
+   __m512i out = zero, part = zero;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++) {
+      __m512i v = steps_avx512(c[j], dcdx[j], dcdy[j]);
+
+      out = _mm512_or_si512(out, v);
+      part = _mm512_or_si512(part,
+                             _mm512_add_epi32(v, _mm512_set1_epi32(cdiff[j])));
+   }
+
+   *outmask |= _mm512_cmplt_epi32_mask(out, zero);
+   *partmask |= _mm512_cmplt_epi32_mask(part, zero);
+}
+
+
+TARGET("avx512f") static unsigned
+build_mask_linear_avx512(unsigned nr_planes,
+                         const int32_t *c,
+                         const int32_t *dcdx,
+                         const int32_t *dcdy)
+{
+   const __m512i zero = _mm512_setzero_si512();
+   __m512i acc = zero;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++)
+      acc = _mm512_or_si512(acc, steps_avx512(c[j], dcdx[j], dcdy[j]));
+
+   return _mm512_cmplt_epi32_mask(acc, zero);
+}
+
+
+boolean
+lp_rast_mask_funcs_avx2(struct lp_rast_mask_funcs *funcs)
+{
+   if (!util_get_cpu_caps()->has_avx2)
+      return FALSE;
+
+   funcs->build_masks = build_masks_avx2;
+   funcs->build_mask_linear = build_mask_linear_avx2;
+   return TRUE;
+}
+
+
+boolean
+lp_rast_mask_funcs_avx512(struct lp_rast_mask_funcs *funcs)
+{
+   if (!util_get_cpu_caps()->has_avx512f)
+      return FALSE;
+
+   funcs->build_masks = build_masks_avx512;
+   funcs->build_mask_linear = build_mask_linear_avx512;
+   return TRUE;
+}
+
+#else
+
+boolean
+lp_rast_mask_funcs_avx2(struct lp_rast_mask_funcs *funcs)
+{
+   return FALSE;
+}
+
+
+boolean
+lp_rast_mask_funcs_avx512(struct lp_rast_mask_funcs *funcs)
+{
+   return FALSE;
+}
+
+#endif /* PIPE_ARCH_X86 || PIPE_ARCH_X86_64 */
@@ -245,6 +245,8 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                               zsbuf->u.tex.first_layer);
       scene->zsbuf.map = NULL;
    }
+   scene->hiz = NULL;
+   memset(scene->fast_clear, 0, sizeof scene->fast_clear);
 
    /* Reset all command lists:
     */
@@ -310,13 +312,26 @@ lp_scene_end_rasterization(struct lp_scene *scene )
    /* Free all scene data blocks:
     */
    {
+      struct lp_setup_context *setup = scene->setup;
       struct data_block_list *list = &scene->data;
       struct data_block *block, *tmp;
 
       for (block = list->head; block; block = tmp) {
          tmp = block->next;
-         if (block != &list->first)
+         if (block == &list->first)
+            continue;
+
+         /* Keep up to a default scene's worth of blocks for the next
+          * scenes.  Bigger scenes are rare, and get the rest from malloc.
+          */
+         if (setup->num_free_blocks < LP_SCENE_MAX_SIZE / DATA_BLOCK_SIZE) {
+            block->next = setup->free_blocks;
+            setup->free_blocks = block;
+            setup->num_free_blocks++;
+         }
+         else {
             FREE(block);
+         }
       }
 
       list->head = &list->first;
@@ -328,6 +343,7 @@ lp_scene_end_rasterization(struct lp_scene *scene )
    scene->resources = NULL;
    scene->writeable_resources = NULL;
    scene->frag_shaders = NULL;
+   scene->setup->scene_memory -= scene->scene_size;
    scene->scene_size = 0;
    scene->resource_reference_size = 0;
 
@@ -366,17 +382,27 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
 struct data_block *
 lp_scene_new_data_block( struct lp_scene *scene )
 {
-   if (scene->scene_size + DATA_BLOCK_SIZE > LP_SCENE_MAX_SIZE) {
+   if (scene->scene_size + DATA_BLOCK_SIZE > scene->max_size) {
       if (0) debug_printf("%s: failed\n", __FUNCTION__);
       scene->alloc_failed = TRUE;
       return NULL;
    }
    else {
-      struct data_block *block = MALLOC_STRUCT(data_block);
-      if (!block)
-         return NULL;
-      
+      struct lp_setup_context *setup = scene->setup;
+      struct data_block *block = setup->free_blocks;
+
+      if (block) {
+         setup->free_blocks = block->next;
+         setup->num_free_blocks--;
+      }
+      else {
+         block = MALLOC_STRUCT(data_block);
+         if (!block)
+            return NULL;
+      }
+
       scene->scene_size += sizeof *block;
+      setup->scene_memory += sizeof *block;
 
       block->used = 0;
       block->next = scene->data.head;
@@ -529,16 +555,17 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
    const struct resource_ref *ref;
    int i;
 
-   for (ref = scene->resources; ref; ref = ref->next) {
+   /* A resource may be on both lists, so look for writes first. */
+   for (ref = scene->writeable_resources; ref; ref = ref->next) {
       for (i = 0; i < ref->count; i++)
          if (ref->resource[i] == resource)
-            return LP_REFERENCED_FOR_READ;
+            return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   for (ref = scene->writeable_resources; ref; ref = ref->next) {
+   for (ref = scene->resources; ref; ref = ref->next) {
       for (i = 0; i < ref->count; i++)
          if (ref->resource[i] == resource)
-            return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+            return LP_REFERENCED_FOR_READ;
    }
 
    return 0;
@@ -657,8 +684,8 @@ void lp_scene_end_binning( struct lp_scene *scene )
 {
    if (LP_DEBUG & DEBUG_SCENE) {
       debug_printf("rasterize scene:\n");
-      debug_printf("  scene_size: %u\n",
-                   scene->scene_size);
+      debug_printf("  scene_size: %u of %u\n",
+                   scene->scene_size, scene->max_size);
       debug_printf("  data size: %u\n",
                    lp_scene_data_size(scene));
 
@@ -41,6 +41,8 @@
 
 struct lp_scene_queue;
 struct lp_rast_state;
+struct lp_hiz_tile;
+struct lp_fast_clear_tile;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
  * Will need a 64-bit version for larger framebuffers.
@@ -59,9 +61,14 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
-/* Scene temporary storage is clamped to this size:
+/* Scene temporary storage is clamped to this size, or to
+ * LP_SCENE_TILE_SIZE per tile of bigger framebuffers as long as all the
+ * scenes in flight stay within LP_SCENE_MAX_SIZE_LIMIT or a fraction of
+ * the available system memory (see lp_setup.c).
  */
 #define LP_SCENE_MAX_SIZE (36*1024*1024)
+#define LP_SCENE_TILE_SIZE (32*1024)
+#define LP_SCENE_MAX_SIZE_LIMIT (1024*1024*1024)
 
 /* The maximum amount of texture storage referenced by a scene is
  * clamped to this size:
@@ -162,6 +169,22 @@ struct lp_scene {
    /* max samples for bound framebuffer */
    unsigned fb_max_samples;
 
+   /* Depth bounds of the zsbuf tiles, or NULL if not tracked for this
+    * scene.  Valid only between begin_rasterization() and
+    * end_rasterization().
+    */
+   struct lp_hiz_tile *hiz;
+   unsigned hiz_stride;   /**< tiles per row of the hiz array */
+   boolean hiz_unorm;     /**< depth values are clamped to [0, 1] */
+   float hiz_eps;         /**< depth format precision */
+
+   /* Clear state of the tiles of each color buffer and of the zsbuf
+    * (LP_FAST_CLEAR_ZS), or NULL where not tracked for this scene.  Valid
+    * only between begin_rasterization() and end_rasterization().
+    */
+   struct lp_fast_clear_tile *fast_clear[PIPE_MAX_COLOR_BUFS + 1];
+   unsigned fast_clear_stride[PIPE_MAX_COLOR_BUFS + 1];  /**< tiles per row */
+
    /** the framebuffer to render the scene into */
    struct pipe_framebuffer_state fb;
 
@@ -180,6 +203,9 @@ struct lp_scene {
     */
    unsigned scene_size;
 
+   /** Limit of scene_size for this scene */
+   unsigned max_size;
+
    /** Sum of sizes of all resources referenced by the scene.  Sums
     * all the textures read by the scene:
     */
@@ -187,6 +213,7 @@ struct lp_scene {
 
    boolean alloc_failed;
    boolean permit_linear_rasterizer;
+   boolean permit_tbdr;  /**< see lp_rast_tbdr.c */
 
    /**
     * Number of active tiles in each dimension.
@@ -245,7 +272,7 @@ lp_scene_alloc( struct lp_scene *scene, unsigned size)
    if (LP_DEBUG & DEBUG_MEM)
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size, block->used, (unsigned)DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
 
    if (block->used + size > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
@@ -279,7 +306,7 @@ lp_scene_alloc_aligned( struct lp_scene *scene, unsigned size,
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size + alignment - 1,
 		   block->used, (unsigned)DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
        
    if (block->used + size + alignment - 1 > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
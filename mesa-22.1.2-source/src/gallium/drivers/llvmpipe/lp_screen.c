@@ -95,6 +95,9 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
    { "no_rast_linear", PERF_NO_RAST_LINEAR, NULL },
    { "no_shade",       PERF_NO_SHADE, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
+   { "no_fast_clear",  PERF_NO_FAST_CLEAR, NULL },
+   { "no_tri_batch",   PERF_NO_TRI_BATCH, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -237,6 +240,8 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return 16;
    case PIPE_CAP_TEXTURE_TRANSFER_MODES:
       return 0;
+   case PIPE_CAP_PREFER_PBO_DOWNLOAD_DRAW:
+      return 1;
    case PIPE_CAP_MAX_VIEWPORTS:
       return PIPE_MAX_VIEWPORTS;
    case PIPE_CAP_ENDIANNESS:
@@ -938,6 +943,8 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
       return;
 
    _mesa_sha1_update(&ctx, &gallivm_perf, sizeof(gallivm_perf));
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof(lp_native_vector_width));
    update_cache_sha1_cpu(&ctx);
    _mesa_sha1_final(&ctx, sha1);
    disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
@@ -1073,6 +1080,8 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
    screen->allow_cl = !!getenv("LP_CL");
+   screen->tiled_textures = debug_get_bool_option("LP_TILED_TEXTURES", FALSE);
+   screen->tbdr = debug_get_bool_option("LP_TBDR", FALSE);
    screen->use_tgsi = (LP_DEBUG & DEBUG_TGSI_IR);
    screen->num_threads = util_get_cpu_caps()->nr_cpus > 1 ? util_get_cpu_caps()->nr_cpus : 0;
 #ifdef EMBEDDED_DEVICE
@@ -43,12 +43,14 @@
 #include "util/u_viewport.h"
 #include "draw/draw_pipe.h"
 #include "util/os_time.h"
+#include "util/os_misc.h"
 #include "lp_context.h"
 #include "lp_memory.h"
 #include "lp_scene.h"
 #include "lp_texture.h"
 #include "lp_debug.h"
 #include "lp_fence.h"
+#include "lp_perf.h"
 #include "lp_query.h"
 #include "lp_rast.h"
 #include "lp_setup_context.h"
@@ -65,6 +67,44 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
                              const char *reason);
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
+/**
+ * Size limit of a new scene: LP_SCENE_MAX_SIZE, or LP_SCENE_TILE_SIZE per
+ * tile of big framebuffers.  Scenes only get more than LP_SCENE_MAX_SIZE as
+ * long as all the scenes in flight stay within scene_memory_limit.
+ */
+static unsigned
+lp_setup_scene_max_size(const struct lp_setup_context *setup,
+                        const struct lp_scene *scene)
+{
+   uint64_t size = (uint64_t)scene->tiles_x * scene->tiles_y *
+                   LP_SCENE_TILE_SIZE;
+   uint64_t available = 0;
+
+   if (setup->scene_memory < setup->scene_memory_limit)
+      available = setup->scene_memory_limit - setup->scene_memory;
+
+   return (unsigned)MAX2(MIN2(size, available), LP_SCENE_MAX_SIZE);
+}
+
+
+/**
+ * Account for a scene being flushed before it's complete, because it
+ * couldn't take more commands.
+ */
+static void
+lp_setup_count_split(struct lp_setup_context *setup)
+{
+   if (lp_scene_is_oom(setup->scene)) {
+      setup->frame.splits_full++;
+      LP_COUNT(nr_scene_splits_full);
+   }
+   else {
+      setup->frame.splits_resources++;
+      LP_COUNT(nr_scene_splits_resources);
+   }
+}
+
+
 static unsigned
 lp_setup_wait_empty_scene(struct lp_setup_context *setup)
 {
@@ -113,7 +153,9 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
 
    setup->scene = setup->scenes[i];
    setup->scene->permit_linear_rasterizer = setup->permit_linear_rasterizer;
+   setup->scene->permit_tbdr = llvmpipe_screen(setup->pipe->screen)->tbdr;
    lp_scene_begin_binning(setup->scene, &setup->fb);
+   setup->scene->max_size = lp_setup_scene_max_size(setup, setup->scene);
 }
 
 
@@ -207,6 +249,11 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 
    lp_scene_end_binning(scene);
 
+   LP_COUNT(nr_scenes);
+   setup->frame.scenes++;
+   setup->frame.max_used = MAX2(setup->frame.max_used, scene->scene_size);
+   setup->frame.max_size = MAX2(setup->frame.max_size, scene->max_size);
+
    lp_fence_reference(&setup->last_fence, scene->fence);
 
    if (setup->last_fence)
@@ -401,6 +448,25 @@ lp_setup_flush( struct lp_setup_context *setup,
 }
 
 
+/**
+ * Report the scenes of the frame.
+ */
+void
+lp_setup_end_frame( struct lp_setup_context *setup )
+{
+   if (LP_DEBUG & DEBUG_SCENE)
+      debug_printf("llvmpipe: frame: %u scenes, %u split when full, "
+                   "%u split for textures, biggest %u of %u bytes\n",
+                   setup->frame.scenes,
+                   setup->frame.splits_full,
+                   setup->frame.splits_resources,
+                   setup->frame.max_used,
+                   setup->frame.max_size);
+
+   memset(&setup->frame, 0, sizeof setup->frame);
+}
+
+
 void
 lp_setup_bind_framebuffer( struct lp_setup_context *setup,
                            const struct pipe_framebuffer_state *fb )
@@ -896,11 +962,14 @@ lp_setup_set_linear_mode( struct lp_setup_context *setup,
    /* The linear rasterizer requires sse2 both at compile and runtime,
     * in particular for the code in lp_rast_linear_fallback.c.  This
     * is more than ten-year-old technology, so it's a reasonable
-    * baseline.
+    * baseline.  On AArch64 the same kernels are built on NEON, which
+    * every AArch64 CPU has.
     */
 #if defined(PIPE_ARCH_SSE)
    setup->permit_linear_rasterizer = (mode &&
                                       util_get_cpu_caps()->has_sse2);
+#elif defined(PIPE_ARCH_AARCH64)
+   setup->permit_linear_rasterizer = mode;
 #else
    setup->permit_linear_rasterizer = FALSE;
 #endif
@@ -1162,6 +1231,7 @@ unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
                                 const struct pipe_resource *texture )
 {
+   unsigned referenced = LP_UNREFERENCED;
    unsigned i, j;
 
    /* check the render targets */
@@ -1185,11 +1255,37 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
          return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
       }
 
-      /* check resources referenced by the scene */
-      unsigned ref = lp_scene_is_resource_referenced(scene, texture);
-      if (ref)
-         return ref;
+      /* check resources referenced by the scene: a later scene may write
+       * what an earlier one only reads
+       */
+      referenced |= lp_scene_is_resource_referenced(scene, texture);
+   }
+
+   return referenced;
+}
+
+
+/**
+ * Is the given texture referenced by the scene being built?  Unlike the
+ * scenes already flushed, this one may still get more commands for tiles
+ * that are being read or written.
+ */
+unsigned
+lp_setup_is_resource_referenced_by_current_scene(const struct lp_setup_context *setup,
+                                                 const struct pipe_resource *texture)
+{
+   unsigned i;
+
+   for (i = 0; i < setup->fb.nr_cbufs; i++) {
+      if (setup->fb.cbufs[i] && setup->fb.cbufs[i]->texture == texture)
+         return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
+   if (setup->fb.zsbuf && setup->fb.zsbuf->texture == texture) {
+      return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+   }
+
+   if (setup->scene)
+      return lp_scene_is_resource_referenced(setup->scene, texture);
 
    return LP_UNREFERENCED;
 }
@@ -1534,6 +1630,8 @@ lp_setup_update_state( struct lp_setup_context *setup,
        * Cannot call lp_setup_flush_and_restart() directly here
        * because of potential recursion.
        */
+      lp_setup_count_split(setup);
+
       if (!set_scene_state(setup, SETUP_FLUSHED, __FUNCTION__))
          return FALSE;
 
@@ -1589,6 +1687,13 @@ lp_setup_destroy( struct lp_setup_context *setup )
 
    LP_DBG(DEBUG_SETUP, "number of scenes used: %d\n", setup->num_active_scenes);
    slab_destroy(&setup->scene_slab);
+
+   while (setup->free_blocks) {
+      struct data_block *block = setup->free_blocks;
+      setup->free_blocks = block->next;
+      FREE(block);
+   }
+
    lp_fence_reference(&setup->last_fence, NULL);
 
    FREE( setup );
@@ -1606,6 +1711,7 @@ lp_setup_create( struct pipe_context *pipe,
 {
    struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct lp_setup_context *setup;
+   uint64_t available_memory;
    unsigned i;
 
    setup = CALLOC_STRUCT(lp_setup_context);
@@ -1629,6 +1735,14 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_rasterize_stage(draw, setup->vbuf);
    draw_set_render(draw, &setup->base);
 
+   /* The scenes in flight may grow up to a sixteenth of the available
+    * memory together.
+    */
+   setup->scene_memory_limit = LP_SCENE_MAX_SIZE_LIMIT;
+   if (os_get_available_system_memory(&available_memory))
+      setup->scene_memory_limit = MIN2(setup->scene_memory_limit,
+                                       available_memory / 16);
+
    slab_create(&setup->scene_slab,
                sizeof(struct lp_scene),
                INITIAL_SCENES);
@@ -1794,6 +1908,8 @@ lp_setup_flush_and_restart(struct lp_setup_context *setup)
 
    assert(setup->state == SETUP_ACTIVE);
 
+   lp_setup_count_split(setup);
+
    if (!set_scene_state(setup, SETUP_FLUSHED, __FUNCTION__))
       return FALSE;
    
@@ -67,6 +67,9 @@ lp_setup_flush( struct lp_setup_context *setup,
                 struct pipe_fence_handle **fence,
                 const char *reason);
 
+void
+lp_setup_end_frame( struct lp_setup_context *setup );
+
 
 void
 lp_setup_bind_framebuffer( struct lp_setup_context *setup,
@@ -154,6 +157,10 @@ unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
                                 const struct pipe_resource *texture );
 
+unsigned
+lp_setup_is_resource_referenced_by_current_scene(const struct lp_setup_context *setup,
+                                                 const struct pipe_resource *texture);
+
 void
 lp_setup_set_sample_mask(struct lp_setup_context *setup,
                          uint32_t sample_mask);
@@ -96,6 +96,26 @@ struct lp_setup_context
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
+   /** Data blocks of rasterized scenes, for reuse by the next ones */
+   struct data_block *free_blocks;
+   unsigned num_free_blocks;
+
+   /** Data block memory of the scenes being binned or rasterized */
+   uint64_t scene_memory;
+   /** Bound of scene_memory for scenes bigger than LP_SCENE_MAX_SIZE,
+    * from the available system memory
+    */
+   uint64_t scene_memory_limit;
+
+   /** Scene statistics of the current frame */
+   struct {
+      unsigned scenes;
+      unsigned splits_full;       /**< scenes flushed because full */
+      unsigned splits_resources;  /**< ... or referencing too much texture data */
+      unsigned max_used;          /**< biggest scene_size */
+      unsigned max_size;          /**< biggest scene max_size */
+   } frame;
+
    struct lp_fence *last_fence;
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -771,6 +771,181 @@ floor_pot(uint32_t n)
 }
 
 
+/**
+ * Append a triangle to a batch, with its edge functions relative to the
+ * batch's block at x, y in the framebuffer.
+ * \param blocks  the 4x4 blocks of the batch it may cover
+ */
+static void
+tri_batch_add(struct lp_rast_tri_batch *batch,
+              const struct lp_rast_triangle *tri,
+              int nr_planes, int x, int y,
+              unsigned blocks)
+{
+   const struct lp_rast_plane *plane = GET_PLANES(tri);
+   unsigned n = batch->count++;
+   int i;
+
+   STATIC_ASSERT(LP_RAST_TRI_BATCH_SIZE <= 8 * sizeof batch->blocks[0]);
+
+   for (i = 0; i < LP_RAST_TRI_BATCH_PLANES; i++) {
+      if (i < nr_planes) {
+         /* Biased so that pixels on the outside of the edge are negative. */
+         batch->c[i][n] = (int32_t)(plane[i].c -
+                                    IMUL64(plane[i].dcdx, x) +
+                                    IMUL64(plane[i].dcdy, y) - 1);
+         batch->dcdx[i][n] = -plane[i].dcdx;
+         batch->dcdy[i][n] = plane[i].dcdy;
+      }
+      else {
+         batch->c[i][n] = 0;
+         batch->dcdx[i][n] = 0;
+         batch->dcdy[i][n] = 0;
+      }
+   }
+
+   while (blocks) {
+      i = u_bit_scan(&blocks);
+      batch->blocks[i] |= 1 << n;
+   }
+
+   batch->nr_planes = MAX2(batch->nr_planes, nr_planes);
+   batch->tri[n] = tri;
+}
+
+
+/**
+ * The 4x4 blocks of the 16x16 block at x, y in the framebuffer which a
+ * triangle's edge functions don't trivially reject.
+ */
+static unsigned
+tri_batch_blocks(const struct lp_rast_triangle *tri,
+                 int nr_planes, int x, int y)
+{
+   const struct lp_rast_plane *plane = GET_PLANES(tri);
+   unsigned blocks = 0;
+   int b, i;
+
+   for (b = 0; b < 16; b++) {
+      int bx = x + (b & 3) * 4, by = y + (b >> 2) * 4;
+      boolean out = FALSE;
+
+      for (i = 0; i < nr_planes; i++) {
+         /* Largest value of the edge function in the block */
+         int64_t c = plane[i].c -
+                     IMUL64(plane[i].dcdx, bx) +
+                     IMUL64(plane[i].dcdy, by) +
+                     3 * (int64_t)(MAX2(-plane[i].dcdx, 0) +
+                                   MAX2(plane[i].dcdy, 0));
+         out |= c <= 0;
+      }
+      if (!out)
+         blocks |= 1 << b;
+   }
+
+   return blocks;
+}
+
+
+/**
+ * Try to bin a small triangle contained in a 16x16 block of tile ix, iy
+ * together with the one(s) binned right before it: if the bin ends with
+ * a small triangle, or a batch of them, drawn with the same state and
+ * fitting in the same 16x16 block, that command is turned into or
+ * extended as a LP_RAST_OP_TRIANGLE_BATCH.
+ * \return FALSE if the triangle must be binned by itself
+ */
+static boolean
+lp_setup_batch_triangle(struct lp_setup_context *setup,
+                        struct lp_rast_triangle *tri,
+                        int nr_planes,
+                        const struct u_rect *bbox,
+                        int ix, int iy)
+{
+   struct lp_scene *scene = setup->scene;
+   struct cmd_bin *bin = lp_scene_get_bin(scene, ix, iy);
+   struct cmd_block *tail = bin->tail;
+   struct lp_rast_tri_batch *batch;
+   union lp_rast_cmd_arg *arg;
+   int x0, y0, x1, y1;
+   unsigned px, py, cmd;
+   unsigned blocks = 0;
+   int nr_prev, by;
+
+   if (!tail || tail->count == 0 ||
+       bin->last_state != setup->fs.stored)
+      return FALSE;
+
+   cmd = tail->cmd[tail->count - 1];
+   arg = &tail->arg[tail->count - 1];
+
+   if (cmd == LP_RAST_OP_TRIANGLE_BATCH) {
+      batch = (struct lp_rast_tri_batch *)arg->tri_batch;
+      if (batch->count == LP_RAST_TRI_BATCH_SIZE)
+         return FALSE;
+      px = batch->x;
+      py = batch->y;
+   }
+   else if (cmd == LP_RAST_OP_TRIANGLE_32_3_4 ||
+            cmd == LP_RAST_OP_TRIANGLE_32_3_16 ||
+            cmd == LP_RAST_OP_TRIANGLE_32_4_16) {
+      px = MIN2(arg->triangle.plane_mask & 0xff, TILE_SIZE - 16);
+      py = MIN2(arg->triangle.plane_mask >> 8, TILE_SIZE - 16);
+      batch = NULL;
+   }
+   else {
+      return FALSE;
+   }
+
+   /* Bounding box within the batch's block */
+   x0 = bbox->x0 - ix * TILE_SIZE - (int)px;
+   y0 = bbox->y0 - iy * TILE_SIZE - (int)py;
+   x1 = bbox->x1 - ix * TILE_SIZE - (int)px;
+   y1 = bbox->y1 - iy * TILE_SIZE - (int)py;
+   if (x0 < 0 || x1 >= 16 || y0 < 0 || y1 >= 16)
+      return FALSE;
+
+   /* Larger triangles are rasterized faster by themselves, as the batch
+    * only knows which 4x4 blocks their bounding box touches.
+    */
+   if (x1 - x0 >= 8 || y1 - y0 >= 8)
+      return FALSE;
+
+   if (!batch) {
+      batch = lp_scene_alloc_aligned(scene, sizeof *batch, 16);
+      if (!batch)
+         return FALSE;
+
+      memset(batch->blocks, 0, sizeof batch->blocks);
+      batch->count = 0;
+      batch->nr_planes = 0;
+      batch->x = px;
+      batch->y = py;
+
+      /* The bounding box of the binned triangle isn't known anymore. */
+      nr_prev = cmd == LP_RAST_OP_TRIANGLE_32_4_16 ? 4 : 3;
+      tri_batch_add(batch, arg->triangle.tri, nr_prev,
+                    ix * TILE_SIZE + px, iy * TILE_SIZE + py,
+                    tri_batch_blocks(arg->triangle.tri, nr_prev,
+                                     ix * TILE_SIZE + px,
+                                     iy * TILE_SIZE + py));
+      LP_COUNT(nr_batched_tris);
+
+      tail->cmd[tail->count - 1] = LP_RAST_OP_TRIANGLE_BATCH;
+      *arg = lp_rast_arg_tri_batch(batch);
+   }
+
+   for (by = y0 / 4; by <= y1 / 4; by++)
+      blocks |= ((2 << (x1 / 4)) - (1 << (x0 / 4))) << (by * 4);
+
+   tri_batch_add(batch, tri, nr_planes,
+                 ix * TILE_SIZE + px, iy * TILE_SIZE + py, blocks);
+   LP_COUNT(nr_batched_tris);
+
+   return TRUE;
+}
+
+
 boolean
 lp_setup_bin_triangle(struct lp_setup_context *setup,
                       struct lp_rast_triangle *tri,
@@ -824,6 +999,15 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
       assert(iy0 == bbox->y1 / TILE_SIZE &&
 	     ix0 == bbox->x1 / TILE_SIZE);
 
+      /* Small triangles (and points) are batched with the previous ones
+       * if they share a 16x16 block.
+       */
+      if (!setup->multisample && use_32bits &&
+          (nr_planes == 3 || nr_planes == 4) && sz < 16 &&
+          !(LP_PERF & PERF_NO_TRI_BATCH) &&
+          lp_setup_batch_triangle(setup, tri, nr_planes, bbox, ix0, iy0))
+         return TRUE;
+
       if (nr_planes == 3) {
          if (sz < 4)
          {
@@ -39,12 +39,14 @@
 #include "lp_state_cs.h"
 #include "lp_context.h"
 #include "lp_debug.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_perf.h"
 #include "lp_screen.h"
 #include "lp_memory.h"
 #include "lp_query.h"
 #include "lp_cs_tpool.h"
+#include "lp_texture.h"
 #include "frontend/sw_winsys.h"
 #include "nir/nir_to_tgsi_info.h"
 #include "util/mesa-sha1.h"
@@ -639,6 +641,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1u << (i & 31))) {
             lp_sampler_static_texture_state(&cs_sampler[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+            cs_sampler[i].texture_state.tiled = llvmpipe_sampler_view_is_tiled(
+               lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
          }
       }
    }
@@ -648,6 +652,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
             lp_sampler_static_texture_state(&cs_sampler[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+            cs_sampler[i].texture_state.tiled = llvmpipe_sampler_view_is_tiled(
+               lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
          }
       }
    }
@@ -1394,6 +1400,9 @@ static void llvmpipe_launch_grid(struct pipe_context *pipe,
    struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct lp_cs_job_info job_info;
 
+   /* Compute shaders don't run in scene order, see llvmpipe_memory_barrier(). */
+   llvmpipe_wait_barrier(pipe);
+
    if (!llvmpipe_check_render_cond(llvmpipe))
       return;
 
@@ -105,6 +105,7 @@
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
+#include "lp_texture.h"
 #include "nir/nir_to_tgsi_info.h"
 
 #include "lp_screen.h"
@@ -509,6 +510,10 @@ static void fs_fb_fetch(const struct lp_build_fs_iface *iface,
          x = (i & 1) + ((i >> 2) << 1);
          if (!key->resource_1d)
             y = (i & 2) >> 1;
+      } else if (block_size == 16) {
+         /* the whole 4x4 block, as four 2x2 quads */
+         x = (i & 1) + ((i >> 1) & 2);
+         y = key->resource_1d ? 0 : ((i >> 1) & 1) + ((i >> 2) & 2);
       }
 
       LLVMValueRef x_val;
@@ -2407,7 +2412,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
    undef_src_val = lp_build_undef(gallivm, fs_type);
 
    row_type.length = fs_type.length;
-   vector_width    = dst_type.floating ? lp_native_vector_width : lp_integer_vector_width;
+   vector_width    = dst_type.floating ? MIN2(lp_native_vector_width, 256) : lp_integer_vector_width;
 
    /* Compute correct swizzle and count channels */
    memset(swizzle, LP_BLD_SWIZZLE_DONTCARE, TGSI_NUM_CHANNELS);
@@ -2978,6 +2983,58 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Split the 16 wide shader outputs and masks of a 4x4 block into
+ * num_halves 8 wide ones, in place.
+ */
+static void
+split_fs_outputs(struct gallivm_state *gallivm,
+                 const struct lp_fragment_shader_variant_key *key,
+                 struct lp_type fs_type,
+                 unsigned num_halves,
+                 boolean dual_source_blend,
+                 LLVMValueRef *fs_mask,
+                 LLVMValueRef fs_out_color[LP_MAX_SAMPLES][PIPE_MAX_COLOR_BUFS][TGSI_NUM_CHANNELS][16 / 4])
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_type half_type = fs_type;
+   unsigned nr_cbufs = MAX2(key->nr_cbufs, dual_source_blend ? 2 : 0);
+   unsigned half_length = fs_type.length / 2;
+   int s;
+   unsigned cbuf, chan, h;
+
+   half_type.length = half_length;
+
+   /* Backwards, so that every mask is read before it is overwritten. */
+   for (s = key->coverage_samples - 1; s >= 0; s--) {
+      LLVMValueRef mask = fs_mask[s];
+      for (h = 0; h < num_halves; h++) {
+         fs_mask[s * num_halves + h] =
+            lp_build_extract_range(gallivm, mask, h * half_length, half_length);
+      }
+   }
+
+   for (s = 0; s < key->min_samples; s++) {
+      for (cbuf = 0; cbuf < nr_cbufs; cbuf++) {
+         for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+            LLVMValueRef color = LLVMBuildLoad(builder,
+                                               fs_out_color[s][cbuf][chan][0], "");
+            for (h = 0; h < num_halves; h++) {
+               LLVMValueRef half_ptr = lp_build_alloca(gallivm,
+                                                       lp_build_vec_type(gallivm, half_type),
+                                                       "");
+               LLVMBuildStore(builder,
+                              lp_build_extract_range(gallivm, color,
+                                                     h * half_length, half_length),
+                              half_ptr);
+               fs_out_color[s][cbuf][chan][h] = half_ptr;
+            }
+         }
+      }
+   }
+}
+
+
 /**
  * Generate the runtime callable function for the whole fragment pipeline.
  * Note that the function which we generate operates on a block of 16
@@ -2995,6 +3052,7 @@ generate_fragment(struct llvmpipe_context *lp,
    struct lp_shader_input inputs[PIPE_MAX_SHADER_INPUTS];
    char func_name[64];
    struct lp_type fs_type;
+   struct lp_type blend_fs_type;
    struct lp_type blend_type;
    LLVMTypeRef fs_elem_type;
    LLVMTypeRef blend_vec_type;
@@ -3026,6 +3084,7 @@ generate_fragment(struct llvmpipe_context *lp,
    LLVMValueRef function;
    LLVMValueRef facing;
    unsigned num_fs;
+   unsigned num_blend_fs;
    unsigned i;
    unsigned chan;
    unsigned cbuf;
@@ -3180,7 +3239,7 @@ generate_fragment(struct llvmpipe_context *lp,
    num_fs = 16 / fs_type.length; /* number of loops per 4x4 stamp */
    /* for 1d resources only run "upper half" of stamp */
    if (key->resource_1d)
-      num_fs /= 2;
+      num_fs = MAX2(num_fs / 2, 1);
 
    {
       LLVMValueRef num_loop = lp_build_const_int32(gallivm, num_fs);
@@ -3329,6 +3388,21 @@ generate_fragment(struct llvmpipe_context *lp,
 
    sampler->destroy(sampler);
    image->destroy(image);
+
+   /*
+    * The blend code deals with at most 8 wide rows, so with 16 wide
+    * shading hand it the block as two 8 wide halves (quads 0-1 and 2-3,
+    * the same the 8 wide loop would have produced).
+    */
+   blend_fs_type = fs_type;
+   num_blend_fs = num_fs;
+   if (fs_type.length == 16) {
+      blend_fs_type.length = 8;
+      num_blend_fs = key->resource_1d ? 1 : 2;
+      split_fs_outputs(gallivm, key, fs_type, num_blend_fs, dual_source_blend,
+                       fs_mask, fs_out_color);
+   }
+
    /* Loop over color outputs / color buffers to do blending.
     */
    for(cbuf = 0; cbuf < key->nr_cbufs; cbuf++) {
@@ -3358,7 +3432,7 @@ generate_fragment(struct llvmpipe_context *lp,
                                                        &index, 1, ""), "");
 
          for (unsigned s = 0; s < key->cbuf_nr_samples[cbuf]; s++) {
-            unsigned mask_idx = num_fs * (key->multisample ? s : 0);
+            unsigned mask_idx = num_blend_fs * (key->multisample ? s : 0);
             unsigned out_idx = key->min_samples == 1 ? 0 : s;
             LLVMValueRef out_ptr = color_ptr;;
 
@@ -3372,7 +3446,8 @@ generate_fragment(struct llvmpipe_context *lp,
 
             generate_unswizzled_blend(gallivm, cbuf, variant,
                                       key->cbuf_format[cbuf],
-                                      num_fs, fs_type, &fs_mask[mask_idx], fs_out_color[out_idx],
+                                      num_blend_fs, blend_fs_type,
+                                      &fs_mask[mask_idx], fs_out_color[out_idx],
                                       context_ptr, out_ptr, stride,
                                       partial_mask, do_branch);
          }
@@ -3661,6 +3736,52 @@ generate_variant(struct llvmpipe_context *lp,
          shader->info.cbuf[0][3].file != TGSI_FILE_NULL
          ? TRUE : FALSE;
 
+   /* Skipping fragments that are known to fail the depth test must not
+    * lose any side effect, and the depth test must be a plain ordering of
+    * the interpolated depth.
+    */
+   variant->hiz_reject =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL ||
+          key->depth.func == PIPE_FUNC_GREATER ||
+          key->depth.func == PIPE_FUNC_GEQUAL) &&
+         !key->multisample &&
+         !(key->stencil[0].enabled &&
+           (key->stencil[0].writemask ||
+            (key->stencil[1].enabled && key->stencil[1].writemask))) &&
+         !shader->info.base.writes_z &&
+         !shader->info.base.writes_stencil &&
+         !shader->info.base.writes_memory;
+
+   /* Tightening the bounds requires every covered pixel to be depth tested
+    * and written.
+    */
+   variant->hiz_tighten =
+         variant->hiz_reject &&
+         key->depth.writemask &&
+         !key->stencil[0].enabled &&
+         !key->alpha.enabled &&
+         !key->blend.alpha_to_coverage &&
+         !shader->info.base.uses_kill &&
+         !shader->info.base.writes_samplemask;
+
+   /* Only the front-most fragment of a pixel can be shaded when what it
+    * writes doesn't depend on what was there, nothing else is written, and
+    * which one is front-most follows from the interpolated depth alone.
+    */
+   variant->tbdr =
+         variant->hiz_tighten &&
+         !key->blend.logicop_enable &&
+         !shader->info.base.uses_fbfetch;
+   for (unsigned i = 0; i < key->nr_cbufs; i++) {
+      if (key->cbuf_format[i] != PIPE_FORMAT_NONE &&
+          (key->blend.rt[i].blend_enable ||
+           !util_format_colormask_full(util_format_description(key->cbuf_format[i]),
+                                       key->blend.rt[i].colormask)))
+         variant->tbdr = FALSE;
+   }
+
    /* We only care about opaque blits for now */
    if (variant->opaque &&
        (shader->kind == LP_FS_KIND_BLIT_RGBA ||
@@ -3680,6 +3801,7 @@ generate_variant(struct llvmpipe_context *lp,
       }
 
       if (target == PIPE_TEXTURE_2D &&
+          !samp0->texture_state.tiled &&
           min_img_filter == PIPE_TEX_FILTER_NEAREST &&
           mag_img_filter == PIPE_TEX_FILTER_NEAREST &&
           min_mip_filter == PIPE_TEX_MIPFILTER_NONE &&
@@ -4068,8 +4190,12 @@ llvmpipe_set_shader_buffers(struct pipe_context *pipe,
 
       if (buffer && buffer->buffer) {
          boolean read_only = !(writable_bitmask & (1 << idx));
-         llvmpipe_flush_resource(pipe, buffer->buffer, 0, read_only, false,
-                                 false, "buffer");
+         if (shader == PIPE_SHADER_FRAGMENT)
+            llvmpipe_flush_resource_for_fs(pipe, buffer->buffer, read_only,
+                                           "buffer");
+         else
+            llvmpipe_flush_resource(pipe, buffer->buffer, 0, read_only, false,
+                                    false, "buffer");
       }
 
       if (shader == PIPE_SHADER_VERTEX ||
@@ -4111,8 +4237,14 @@ llvmpipe_set_shader_images(struct pipe_context *pipe,
 
       if (image && image->resource) {
          bool read_only = !(image->access & PIPE_IMAGE_ACCESS_WRITE);
-         llvmpipe_flush_resource(pipe, image->resource, 0, read_only, false,
-                                 false, "image");
+         if (!read_only && llvmpipe_resource_is_texture(image->resource))
+            llvmpipe_resource(image->resource)->no_fast_clear = true;
+         if (shader == PIPE_SHADER_FRAGMENT)
+            llvmpipe_flush_resource_for_fs(pipe, image->resource, read_only,
+                                           "image");
+         else
+            llvmpipe_flush_resource(pipe, image->resource, 0, read_only, false,
+                                    false, "image");
       }
    }
 
@@ -4349,6 +4481,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1u << (i & 31))) {
             lp_sampler_static_texture_state(&fs_sampler[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            fs_sampler[i].texture_state.tiled = llvmpipe_sampler_view_is_tiled(
+               lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -4358,6 +4492,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
             lp_sampler_static_texture_state(&fs_sampler[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            fs_sampler[i].texture_state.tiled = llvmpipe_sampler_view_is_tiled(
+               lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -164,6 +164,21 @@ struct lp_fragment_shader_variant
    unsigned potentially_opaque:1;
 
    unsigned blit:1;
+
+   /*
+    * Hierarchical z: whether blocks may be skipped when the depth bounds
+    * say every fragment fails the depth test, and whether fully covered
+    * blocks can tighten the bounds (see lp_rast_hiz.c).
+    */
+   unsigned hiz_reject:1;
+   unsigned hiz_tighten:1;
+
+   /*
+    * Whether the fragments of each pixel may be shaded only when they
+    * are the front-most of their tile (see lp_rast_tbdr.c).
+    */
+   unsigned tbdr:1;
+
    unsigned linear_input_mask:16;
    struct pipe_reference reference;
    boolean opaque;
@@ -32,7 +32,7 @@
 #include "util/u_cpu_detect.h"
 #include "util/u_pack_color.h"
 #include "util/u_surface.h"
-#include "util/u_sse.h"
+#include "util/u_sse_neon.h"
 
 #include "lp_jit.h"
 #include "lp_rast.h"
@@ -41,9 +41,7 @@
 #include "lp_linear_priv.h"
 
 
-#if defined(PIPE_ARCH_SSE)
-
-#include <emmintrin.h>
+#if defined(PIPE_ARCH_SSE) || defined(PIPE_ARCH_AARCH64)
 
 
 struct nearest_sampler {
@@ -686,7 +684,8 @@ llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
          variant->jit_linear                  = blit_rgba;
       }
       else if (is_one_inv_src_alpha_blend(variant) &&
-               util_get_cpu_caps()->has_sse2) {
+               (util_get_cpu_caps()->has_sse2 ||
+                util_get_cpu_caps()->has_neon)) {
          variant->jit_linear                  = blit_rgba_blend_premul;
       }
       return;
@@ -711,7 +710,7 @@ llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
 void
 llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
 {
-   /* don't bother if there is no SSE */
+   /* don't bother if there is no SSE or NEON */
 }
 #endif
 
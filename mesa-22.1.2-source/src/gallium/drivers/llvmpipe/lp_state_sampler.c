@@ -40,6 +40,7 @@
 #include "lp_debug.h"
 #include "frontend/sw_winsys.h"
 #include "lp_flush.h"
+#include "lp_texture.h"
 
 
 static void *
@@ -149,8 +150,12 @@ llvmpipe_set_sampler_views(struct pipe_context *pipe,
                       "context\n", i);
       }
 
-      if (view)
-         llvmpipe_flush_resource(pipe, view->texture, 0, true, false, false, "sampler_view");
+      if (view) {
+         if (shader == PIPE_SHADER_FRAGMENT)
+            llvmpipe_flush_resource_for_fs(pipe, view->texture, true, "sampler_view");
+         else
+            llvmpipe_flush_resource(pipe, view->texture, 0, true, false, false, "sampler_view");
+      }
 
       if (take_ownership) {
          pipe_sampler_view_reference(&llvmpipe->sampler_views[shader][start + i],
@@ -179,10 +184,20 @@ llvmpipe_set_sampler_views(struct pipe_context *pipe,
        shader == PIPE_SHADER_GEOMETRY ||
        shader == PIPE_SHADER_TESS_CTRL ||
        shader == PIPE_SHADER_TESS_EVAL) {
+      boolean tiled[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+      for (i = 0; i < llvmpipe->num_sampler_views[shader]; i++)
+         tiled[i] = llvmpipe_sampler_view_is_tiled(
+            llvmpipe->sampler_views[shader][i]);
+
       draw_set_sampler_views(llvmpipe->draw,
                              shader,
                              llvmpipe->sampler_views[shader],
                              llvmpipe->num_sampler_views[shader]);
+      draw_set_sampler_views_tiled(llvmpipe->draw,
+                                   shader,
+                                   tiled,
+                                   llvmpipe->num_sampler_views[shader]);
    }
    else if (shader == PIPE_SHADER_COMPUTE) {
       llvmpipe->cs_dirty |= LP_CSNEW_SAMPLER_VIEW;
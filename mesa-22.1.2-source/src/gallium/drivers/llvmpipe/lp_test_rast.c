@@ -0,0 +1,1457 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file
+ * Unit tests and throughput measurement for the triangle coverage mask
+ * builders.
+ *
+ * Every mask builder available on this CPU is checked against a scalar
+ * evaluation of the edge functions.  With an output file (-o), the
+ * coverage of triangles of several sizes is also computed the way the
+ * rasterizer descends from 64x64 tiles to 16x16 and 4x4 blocks and
+ * pixels, and the triangles per second of each builder are written out.
+ *
+ * Batches of small triangles sharing a 16x16 block are checked and
+ * measured the same way, against rasterizing each of them by itself.
+ *
+ * Finally, whole scenes are rendered with and without deferred shading
+ * (LP_TBDR) of overlapping opaque triangles, and with and without batches
+ * of small triangles, and with and without hierarchical z over occluded
+ * triangles, which must give the same images, and lazy clears are
+ * checked across a sequence of scenes.
+ */
+
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "frontend/sw_winsys.h"
+#include "cso_cache/cso_context.h"
+#include "util/os_time.h"
+#include "util/u_draw_quad.h"
+#include "util/u_dump.h"
+#include "util/u_inlines.h"
+#include "util/u_pack_color.h"
+#include "util/u_simple_shaders.h"
+#include "lp_perf.h"
+#include "lp_public.h"
+#include "lp_rast_priv.h"
+#include "lp_screen.h"
+#include "lp_test.h"
+#include "lp_texture.h"
+
+
+struct mask_isa {
+   const char *name;
+   boolean (*get)(struct lp_rast_mask_funcs *funcs);
+};
+
+
+static boolean
+get_baseline(struct lp_rast_mask_funcs *funcs)
+{
+   lp_rast_mask_funcs_baseline(funcs);
+   return TRUE;
+}
+
+
+#ifdef LP_TEST_NEON_EMU
+/* lp_test_rast_neon.c: the NEON builders on the emulated intrinsics. */
+boolean
+lp_rast_mask_funcs_neon_emu(struct lp_rast_mask_funcs *funcs);
+#endif
+
+
+static const struct mask_isa mask_isas[] = {
+   { "baseline", get_baseline },
+   { "avx2", lp_rast_mask_funcs_avx2 },
+   { "avx512", lp_rast_mask_funcs_avx512 },
+   { "neon", lp_rast_mask_funcs_neon },
+#ifdef LP_TEST_NEON_EMU
+   { "neon-emu", lp_rast_mask_funcs_neon_emu },
+#endif
+};
+
+
+#define MAX_PLANES 8
+
+
+static unsigned
+ref_mask_linear(unsigned nr_planes, const int32_t *c,
+                const int32_t *dcdx, const int32_t *dcdy)
+{
+   unsigned mask = 0;
+   unsigned i, j;
+
+   for (j = 0; j < nr_planes; j++) {
+      for (i = 0; i < 16; i++) {
+         uint32_t v = (uint32_t)c[j] +
+                      (uint32_t)dcdx[j] * (i & 3) +
+                      (uint32_t)dcdy[j] * (i >> 2);
+         mask |= (v >> 31) << i;
+      }
+   }
+
+   return mask;
+}
+
+
+static int32_t
+random_plane_value(void)
+{
+   /* Mostly small values, so that signs change within the grid, and some
+    * large ones to exercise wraparound.
+    */
+   if (rand() % 8 == 0)
+      return (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+   return (rand() % 4096) - 2048;
+}
+
+
+static boolean
+test_masks(unsigned verbose, const struct mask_isa *isa,
+           const struct lp_rast_mask_funcs *funcs)
+{
+   int32_t c[MAX_PLANES], cdiff[MAX_PLANES], dcdx[MAX_PLANES], dcdy[MAX_PLANES];
+   int32_t cpart[MAX_PLANES];
+   unsigned nr_planes = 1 + rand() % MAX_PLANES;
+   unsigned outmask = 0, partmask = 0, linear;
+   unsigned ref_out, ref_part, ref_linear;
+   unsigned j;
+
+   for (j = 0; j < nr_planes; j++) {
+      c[j] = random_plane_value();
+      cdiff[j] = random_plane_value();
+      dcdx[j] = random_plane_value();
+      dcdy[j] = random_plane_value();
+      cpart[j] = (int32_t)((uint32_t)c[j] + (uint32_t)cdiff[j]);
+   }
+
+   funcs->build_masks(nr_planes, c, cdiff, dcdx, dcdy, &outmask, &partmask);
+   linear = funcs->build_mask_linear(nr_planes, c, dcdx, dcdy);
+
+   ref_out = ref_mask_linear(nr_planes, c, dcdx, dcdy);
+   ref_part = ref_mask_linear(nr_planes, cpart, dcdx, dcdy);
+   ref_linear = ref_out;
+
+   if (outmask != ref_out || partmask != ref_part || linear != ref_linear) {
+      fprintf(stderr, "%s: %u planes: got %04x %04x %04x, expected %04x %04x %04x\n",
+              isa->name, nr_planes, outmask, partmask, linear,
+              ref_out, ref_part, ref_linear);
+      return FALSE;
+   }
+
+   if (verbose >= 2)
+      fprintf(stderr, "%s: %u planes: ok\n", isa->name, nr_planes);
+
+   return TRUE;
+}
+
+
+/*
+ * Coverage of a triangle in integer pixel coordinates, as the rasterizer
+ * finds it: E(x, y) = a * x + b * y + k per edge, a pixel is outside if
+ * any E is negative.
+ */
+
+struct test_tri {
+   int32_t a[3], b[3], k[3];
+   int minx, miny, maxx, maxy;
+};
+
+
+static void
+setup_tri(struct test_tri *tri, const int v[3][2])
+{
+   unsigned j;
+
+   tri->minx = MIN3(v[0][0], v[1][0], v[2][0]);
+   tri->miny = MIN3(v[0][1], v[1][1], v[2][1]);
+   tri->maxx = MAX3(v[0][0], v[1][0], v[2][0]);
+   tri->maxy = MAX3(v[0][1], v[1][1], v[2][1]);
+
+   for (j = 0; j < 3; j++) {
+      const int *p = v[j], *q = v[(j + 1) % 3];
+
+      tri->a[j] = p[1] - q[1];
+      tri->b[j] = q[0] - p[0];
+      tri->k[j] = -(tri->a[j] * p[0] + tri->b[j] * p[1]);
+   }
+}
+
+
+/**
+ * Edge function inputs of the blocks of size "step" of a grid at x, y:
+ * c is at the corner most inside each block, c + cdiff at the corner most
+ * outside.
+ */
+static void
+block_planes(const struct test_tri *tri, int x, int y, int step,
+             int32_t *c, int32_t *cdiff, int32_t *dcdx, int32_t *dcdy)
+{
+   const int32_t span = step - 1;
+   unsigned j;
+
+   for (j = 0; j < 3; j++) {
+      int32_t e = tri->a[j] * x + tri->b[j] * y + tri->k[j];
+      int32_t emax = MAX2(tri->a[j], 0) * span + MAX2(tri->b[j], 0) * span;
+      int32_t emin = MIN2(tri->a[j], 0) * span + MIN2(tri->b[j], 0) * span;
+
+      c[j] = e + emax;
+      cdiff[j] = emin - emax;
+      dcdx[j] = tri->a[j] * step;
+      dcdy[j] = tri->b[j] * step;
+   }
+}
+
+
+static unsigned
+cover_block_4(const struct lp_rast_mask_funcs *funcs,
+              const struct test_tri *tri, int x, int y)
+{
+   int32_t c[3];
+   unsigned j;
+
+   for (j = 0; j < 3; j++)
+      c[j] = tri->a[j] * x + tri->b[j] * y + tri->k[j];
+
+   return util_bitcount(0xffff & ~funcs->build_mask_linear(3, c, tri->a, tri->b));
+}
+
+
+static unsigned
+cover_block(const struct lp_rast_mask_funcs *funcs,
+            const struct test_tri *tri, int x, int y, int size)
+{
+   const int step = size / 4;
+   int32_t c[3], cdiff[3], dcdx[3], dcdy[3];
+   unsigned outmask = 0, partmask = 0, inmask, partial;
+   unsigned covered = 0;
+
+   block_planes(tri, x, y, step, c, cdiff, dcdx, dcdy);
+   funcs->build_masks(3, c, cdiff, dcdx, dcdy, &outmask, &partmask);
+
+   inmask = ~partmask & 0xffff;
+   partial = partmask & ~outmask & 0xffff;
+
+   covered += util_bitcount(inmask) * step * step;
+
+   while (partial) {
+      int i = u_bit_scan(&partial);
+      int bx = x + (i & 3) * step, by = y + (i >> 2) * step;
+
+      if (step == 4)
+         covered += cover_block_4(funcs, tri, bx, by);
+      else
+         covered += cover_block(funcs, tri, bx, by, step);
+   }
+
+   return covered;
+}
+
+
+static unsigned
+cover_tri(const struct lp_rast_mask_funcs *funcs, const struct test_tri *tri)
+{
+   unsigned covered = 0;
+   int x, y;
+
+   for (y = tri->miny & ~(TILE_SIZE - 1); y <= tri->maxy; y += TILE_SIZE)
+      for (x = tri->minx & ~(TILE_SIZE - 1); x <= tri->maxx; x += TILE_SIZE)
+         covered += cover_block(funcs, tri, x, y, TILE_SIZE);
+
+   return covered;
+}
+
+
+static unsigned
+ref_cover_tri(const struct test_tri *tri)
+{
+   unsigned covered = 0;
+   int x, y;
+   unsigned j;
+
+   for (y = tri->miny; y <= tri->maxy; y++) {
+      for (x = tri->minx; x <= tri->maxx; x++) {
+         boolean inside = TRUE;
+
+         for (j = 0; j < 3; j++)
+            inside &= tri->a[j] * x + tri->b[j] * y + tri->k[j] >= 0;
+         covered += inside;
+      }
+   }
+
+   return covered;
+}
+
+
+#define NUM_BENCH_TRIS 256
+
+
+static void
+random_tris(struct test_tri *tris, unsigned count, int size)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      int v[3][2];
+      int x = rand() % 1024, y = rand() % 1024;
+
+      /* Counter-clockwise, with the inside on the positive side.  Setup
+       * culls zero area triangles, and keeping the second and third
+       * vertices off the diagonal ensures there are none.
+       */
+      v[0][0] = x;
+      v[0][1] = y;
+      v[1][0] = x + size;
+      v[1][1] = y + rand() % size;
+      v[2][0] = x + rand() % size;
+      v[2][1] = y + size;
+
+      setup_tri(&tris[i], v);
+   }
+}
+
+
+static boolean
+test_coverage(unsigned verbose, FILE *fp, int size)
+{
+   struct test_tri tris[NUM_BENCH_TRIS];
+   unsigned expected[NUM_BENCH_TRIS];
+   boolean success = TRUE;
+   unsigned i, k;
+
+   random_tris(tris, NUM_BENCH_TRIS, size);
+   for (i = 0; i < NUM_BENCH_TRIS; i++)
+      expected[i] = ref_cover_tri(&tris[i]);
+
+   for (k = 0; k < ARRAY_SIZE(mask_isas); k++) {
+      struct lp_rast_mask_funcs funcs;
+      unsigned repeat = 1;
+      int64_t start, elapsed;
+
+      if (!mask_isas[k].get(&funcs))
+         continue;
+
+      for (i = 0; i < NUM_BENCH_TRIS; i++) {
+         unsigned covered = cover_tri(&funcs, &tris[i]);
+         if (covered != expected[i]) {
+            fprintf(stderr, "%s: %dx%d triangle %u: covered %u pixels, expected %u\n",
+                    mask_isas[k].name, size, size, i, covered, expected[i]);
+            success = FALSE;
+            break;
+         }
+      }
+
+      if (!fp)
+         continue;
+
+      /* Repeat until the measurement takes long enough to be meaningful. */
+      do {
+         unsigned r;
+
+         start = os_time_get_nano();
+         for (r = 0; r < repeat; r++)
+            for (i = 0; i < NUM_BENCH_TRIS; i++)
+               cover_tri(&funcs, &tris[i]);
+         elapsed = os_time_get_nano() - start;
+         repeat *= 2;
+      } while (elapsed < 10000000 && repeat < (1 << 20));
+      repeat /= 2;
+
+      fprintf(fp, "%s\t%d\t%.0f\n", mask_isas[k].name, size,
+              (double)repeat * NUM_BENCH_TRIS * 1e9 / (double)MAX2(elapsed, 1));
+      fflush(fp);
+
+      if (verbose >= 1)
+         fprintf(stderr, "%s: %dx%d: %.1f ns/triangle\n", mask_isas[k].name,
+                 size, size, (double)elapsed / ((double)repeat * NUM_BENCH_TRIS));
+   }
+
+   return success;
+}
+
+
+/*
+ * Batches of small triangles: LP_RAST_TRI_BATCH_SIZE triangles at a time
+ * are placed in the same 16x16 block.
+ */
+
+#define NUM_BENCH_BATCHES (NUM_BENCH_TRIS / LP_RAST_TRI_BATCH_SIZE)
+
+
+static void
+random_block_tris(struct test_tri *tris, int *block_x, int *block_y,
+                  unsigned count, int size)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      int v[3][2];
+      int x, y;
+
+      if (i % LP_RAST_TRI_BATCH_SIZE == 0) {
+         block_x[i / LP_RAST_TRI_BATCH_SIZE] = (rand() % 64) * 16;
+         block_y[i / LP_RAST_TRI_BATCH_SIZE] = (rand() % 64) * 16;
+      }
+
+      /* The bounding box is size + 1 pixels wide. */
+      x = block_x[i / LP_RAST_TRI_BATCH_SIZE] + rand() % (16 - size);
+      y = block_y[i / LP_RAST_TRI_BATCH_SIZE] + rand() % (16 - size);
+
+      v[0][0] = x;
+      v[0][1] = y;
+      v[1][0] = x + size;
+      v[1][1] = y + rand() % size;
+      v[2][0] = x + rand() % size;
+      v[2][1] = y + size;
+
+      setup_tri(&tris[i], v);
+   }
+}
+
+
+static void
+setup_batch(struct lp_rast_tri_batch *batch, const struct test_tri *tris,
+            int x, int y)
+{
+   unsigned i, j;
+   int bx, by;
+
+   memset(batch->blocks, 0, sizeof batch->blocks);
+
+   for (i = 0; i < LP_RAST_TRI_BATCH_SIZE; i++)
+      for (by = (tris[i].miny - y) / 4; by <= (tris[i].maxy - y) / 4; by++)
+         for (bx = (tris[i].minx - x) / 4; bx <= (tris[i].maxx - x) / 4; bx++)
+            batch->blocks[by * 4 + bx] |= 1 << i;
+
+   for (j = 0; j < LP_RAST_TRI_BATCH_PLANES; j++) {
+      for (i = 0; i < LP_RAST_TRI_BATCH_SIZE; i++) {
+         if (j < 3) {
+            batch->c[j][i] = tris[i].a[j] * x + tris[i].b[j] * y + tris[i].k[j];
+            batch->dcdx[j][i] = tris[i].a[j];
+            batch->dcdy[j][i] = tris[i].b[j];
+         }
+         else {
+            batch->c[j][i] = 0;
+            batch->dcdx[j][i] = 0;
+            batch->dcdy[j][i] = 0;
+         }
+         batch->tri[i] = NULL;
+      }
+   }
+   batch->count = LP_RAST_TRI_BATCH_SIZE;
+   batch->nr_planes = 3;
+   batch->x = 0;
+   batch->y = 0;
+}
+
+
+static void
+cover_batch(const struct lp_rast_tri_batch *batch, unsigned *covered)
+{
+   unsigned masks[LP_RAST_TRI_BATCH_SIZE];
+   unsigned i;
+   int x, y;
+
+   for (i = 0; i < LP_RAST_TRI_BATCH_SIZE; i++)
+      covered[i] = 0;
+
+   for (y = 0; y < 16; y += 4)
+      for (x = 0; x < 16; x += 4)
+         if (lp_rast_tri_batch_masks(batch, x, y, masks))
+            for (i = 0; i < batch->count; i++)
+               covered[i] += util_bitcount(masks[i]);
+}
+
+
+static boolean
+test_batch(unsigned verbose, FILE *fp, int size)
+{
+   struct test_tri tris[NUM_BENCH_TRIS];
+   int block_x[NUM_BENCH_BATCHES], block_y[NUM_BENCH_BATCHES];
+   struct lp_rast_tri_batch batches[NUM_BENCH_BATCHES];
+   unsigned covered[LP_RAST_TRI_BATCH_SIZE];
+   struct lp_rast_mask_funcs funcs;
+   boolean success = TRUE;
+   unsigned i, k, mode;
+
+   random_block_tris(tris, block_x, block_y, NUM_BENCH_TRIS, size);
+   for (k = 0; k < NUM_BENCH_BATCHES; k++)
+      setup_batch(&batches[k], &tris[k * LP_RAST_TRI_BATCH_SIZE],
+                  block_x[k], block_y[k]);
+
+   for (k = 0; k < NUM_BENCH_BATCHES; k++) {
+      cover_batch(&batches[k], covered);
+      for (i = 0; i < LP_RAST_TRI_BATCH_SIZE; i++) {
+         unsigned expected = ref_cover_tri(&tris[k * LP_RAST_TRI_BATCH_SIZE + i]);
+         if (covered[i] != expected) {
+            fprintf(stderr, "batch: %dx%d triangle %u: covered %u pixels, expected %u\n",
+                    size, size, k * LP_RAST_TRI_BATCH_SIZE + i,
+                    covered[i], expected);
+            success = FALSE;
+         }
+      }
+   }
+
+   if (!fp)
+      return success;
+
+   /* Each triangle by itself, the way the rasterizer handles a triangle
+    * contained in a 16x16 block, and then in batches.
+    */
+   lp_rast_mask_funcs_baseline(&funcs);
+
+   for (mode = 0; mode < 2; mode++) {
+      const char *name = mode ? "batch" : "single";
+      unsigned repeat = 1;
+      int64_t start, elapsed;
+
+      do {
+         unsigned r;
+
+         start = os_time_get_nano();
+         for (r = 0; r < repeat; r++) {
+            if (mode) {
+               for (k = 0; k < NUM_BENCH_BATCHES; k++)
+                  cover_batch(&batches[k], covered);
+            }
+            else {
+               for (i = 0; i < NUM_BENCH_TRIS; i++)
+                  cover_block(&funcs, &tris[i],
+                              block_x[i / LP_RAST_TRI_BATCH_SIZE],
+                              block_y[i / LP_RAST_TRI_BATCH_SIZE], 16);
+            }
+         }
+         elapsed = os_time_get_nano() - start;
+         repeat *= 2;
+      } while (elapsed < 10000000 && repeat < (1 << 20));
+      repeat /= 2;
+
+      fprintf(fp, "%s\t%d\t%.0f\n", name, size,
+              (double)repeat * NUM_BENCH_TRIS * 1e9 / (double)MAX2(elapsed, 1));
+      fflush(fp);
+
+      if (verbose >= 1)
+         fprintf(stderr, "%s: %dx%d: %.1f ns/triangle\n", name,
+                 size, size, (double)elapsed / ((double)repeat * NUM_BENCH_TRIS));
+   }
+
+   return success;
+}
+
+
+/*
+ * Whole scenes, rendered through a context in different modes which must
+ * give the same images.  Vertices are a position in window coordinates
+ * and a color.
+ */
+
+#define RENDER_SIZE 256
+
+
+struct test_vertex {
+   float pos[4];
+   float color[4];
+};
+
+
+static bool
+test_winsys_format_supported(struct sw_winsys *ws, unsigned tex_usage,
+                             enum pipe_format format)
+{
+   return false;
+}
+
+
+static struct sw_winsys test_winsys = {
+   .is_displaytarget_format_supported = test_winsys_format_supported,
+};
+
+
+static void
+read_back(struct pipe_context *pipe, struct pipe_resource *res,
+          uint8_t *data)
+{
+   const unsigned stride = util_format_get_stride(res->format, RENDER_SIZE);
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   const uint8_t *map;
+   unsigned y;
+
+   u_box_2d(0, 0, RENDER_SIZE, RENDER_SIZE, &box);
+   map = pipe->texture_map(pipe, res, 0, PIPE_MAP_READ, &box, &transfer);
+   for (y = 0; y < RENDER_SIZE; y++)
+      memcpy(data + y * stride, map + y * transfer->stride, stride);
+   pipe->texture_unmap(pipe, transfer);
+}
+
+
+/**
+ * A context drawing into a RENDER_SIZE x RENDER_SIZE color buffer and,
+ * unless zs_format is PIPE_FORMAT_NONE, a depth/stencil buffer, across
+ * as many scenes as a test needs.
+ */
+struct render_target {
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+   struct pipe_resource *cres;
+   struct pipe_resource *zsres;
+   struct pipe_framebuffer_state fb;
+   void *vs, *fs;
+};
+
+
+/**
+ * \param func  depth test function, PIPE_FUNC_ALWAYS disables the depth
+ *              test and depth writes
+ */
+static void
+render_target_init(struct render_target *rt, struct pipe_screen *screen,
+                   enum pipe_format zs_format, enum pipe_compare_func func)
+{
+   static const enum tgsi_semantic names[] = {
+      TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_COLOR
+   };
+   static const uint indices[] = { 0, 0 };
+   struct pipe_resource templ;
+   struct pipe_surface surf_templ;
+   struct pipe_viewport_state vp;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_rasterizer_state rast;
+   struct pipe_blend_state blend;
+   struct cso_velems_state velems;
+
+   memset(rt, 0, sizeof *rt);
+   rt->pipe = screen->context_create(screen, NULL, 0);
+   rt->cso = cso_create_context(rt->pipe, 0);
+
+   memset(&surf_templ, 0, sizeof surf_templ);
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   templ.width0 = RENDER_SIZE;
+   templ.height0 = RENDER_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET;
+   rt->cres = screen->resource_create(screen, &templ);
+   surf_templ.format = rt->cres->format;
+   rt->fb.cbufs[0] = rt->pipe->create_surface(rt->pipe, rt->cres, &surf_templ);
+   rt->fb.nr_cbufs = 1;
+   rt->fb.width = RENDER_SIZE;
+   rt->fb.height = RENDER_SIZE;
+
+   if (zs_format != PIPE_FORMAT_NONE) {
+      templ.format = zs_format;
+      templ.bind = PIPE_BIND_DEPTH_STENCIL;
+      rt->zsres = screen->resource_create(screen, &templ);
+      surf_templ.format = rt->zsres->format;
+      rt->fb.zsbuf = rt->pipe->create_surface(rt->pipe, rt->zsres,
+                                              &surf_templ);
+   }
+
+   /* Positions are in window space, but the viewport still bounds what is
+    * drawn and sets the depth range.
+    */
+   memset(&vp, 0, sizeof vp);
+   vp.scale[0] = vp.scale[1] = RENDER_SIZE / 2.0f;
+   vp.translate[0] = vp.translate[1] = RENDER_SIZE / 2.0f;
+   vp.scale[2] = vp.translate[2] = 0.5f;
+   vp.swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X;
+   vp.swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y;
+   vp.swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z;
+   vp.swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W;
+
+   memset(&dsa, 0, sizeof dsa);
+   if (rt->zsres && func != PIPE_FUNC_ALWAYS) {
+      dsa.depth_enabled = 1;
+      dsa.depth_writemask = 1;
+      dsa.depth_func = func;
+   }
+
+   memset(&rast, 0, sizeof rast);
+   rast.cull_face = PIPE_FACE_NONE;
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+
+   memset(&velems, 0, sizeof velems);
+   velems.count = 2;
+   velems.velems[0].src_offset = offsetof(struct test_vertex, pos);
+   velems.velems[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   velems.velems[1].src_offset = offsetof(struct test_vertex, color);
+   velems.velems[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   rt->vs = util_make_vertex_passthrough_shader(rt->pipe, 2, names, indices,
+                                                TRUE);
+   rt->fs = util_make_fragment_passthrough_shader(rt->pipe,
+                                                  TGSI_SEMANTIC_COLOR,
+                                                  TGSI_INTERPOLATE_PERSPECTIVE,
+                                                  FALSE);
+
+   cso_set_framebuffer(rt->cso, &rt->fb);
+   cso_set_viewport(rt->cso, &vp);
+   cso_set_depth_stencil_alpha(rt->cso, &dsa);
+   cso_set_rasterizer(rt->cso, &rast);
+   cso_set_blend(rt->cso, &blend);
+   cso_set_vertex_elements(rt->cso, &velems);
+   cso_set_vertex_shader_handle(rt->cso, rt->vs);
+   cso_set_fragment_shader_handle(rt->cso, rt->fs);
+}
+
+
+static void
+render_target_draw(struct render_target *rt,
+                   const struct test_vertex *verts, unsigned count)
+{
+   struct pipe_resource *vbuf;
+
+   vbuf = pipe_buffer_create(rt->pipe->screen, PIPE_BIND_VERTEX_BUFFER,
+                             PIPE_USAGE_DEFAULT, count * sizeof *verts);
+   pipe_buffer_write(rt->pipe, vbuf, 0, count * sizeof *verts, verts);
+   util_draw_vertex_buffer(rt->pipe, rt->cso, vbuf, 0, 0, PIPE_PRIM_TRIANGLES,
+                           count, 2);
+   pipe_resource_reference(&vbuf, NULL);
+}
+
+
+/** Rasterize the current scene and wait for it. */
+static void
+render_target_finish(struct render_target *rt)
+{
+   struct pipe_screen *screen = rt->pipe->screen;
+   struct pipe_fence_handle *fence = NULL;
+
+   rt->pipe->flush(rt->pipe, &fence, 0);
+   screen->fence_finish(screen, NULL, fence, PIPE_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+}
+
+
+static void
+render_target_fini(struct render_target *rt)
+{
+   cso_destroy_context(rt->cso);
+   rt->pipe->delete_vs_state(rt->pipe, rt->vs);
+   rt->pipe->delete_fs_state(rt->pipe, rt->fs);
+   pipe_surface_reference(&rt->fb.cbufs[0], NULL);
+   pipe_surface_reference(&rt->fb.zsbuf, NULL);
+   pipe_resource_reference(&rt->cres, NULL);
+   pipe_resource_reference(&rt->zsres, NULL);
+   rt->pipe->destroy(rt->pipe);
+}
+
+
+/**
+ * Draw a list of triangles over a cleared framebuffer, and read back the
+ * color and, unless zs_format is PIPE_FORMAT_NONE, the depth buffer.
+ * \param func  depth test function, the depth buffer is cleared to the
+ *              far value for it
+ */
+static void
+render_tris(struct pipe_screen *screen, enum pipe_format zs_format,
+            enum pipe_compare_func func,
+            const struct test_vertex *verts, unsigned count,
+            uint8_t *cbuf, uint8_t *zsbuf)
+{
+   const union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 1.0f } };
+   const double clear_depth = func == PIPE_FUNC_LESS ? 1.0 : 0.0;
+   struct render_target rt;
+
+   render_target_init(&rt, screen, zs_format, func);
+
+   rt.pipe->clear(rt.pipe,
+                  PIPE_CLEAR_COLOR | (rt.zsres ? PIPE_CLEAR_DEPTHSTENCIL : 0),
+                  NULL, &clear_color, clear_depth, 0);
+   render_target_draw(&rt, verts, count);
+
+   read_back(rt.pipe, rt.cres, cbuf);
+   if (rt.zsres)
+      read_back(rt.pipe, rt.zsres, zsbuf);
+
+   render_target_fini(&rt);
+}
+
+
+static void
+random_color(float *color)
+{
+   unsigned k;
+
+   for (k = 0; k < 4; k++)
+      color[k] = (rand() % 256) / 255.0f;
+}
+
+
+/*
+ * Deferred against immediate shading: NUM_TBDR_TRIS large triangles in
+ * random depth order, each within its own depth range so that no two of
+ * them are nearly coplanar anywhere, are rendered both ways.
+ */
+
+#define NUM_TBDR_TRIS 32
+
+
+static boolean
+test_tbdr_scene(unsigned verbose, struct pipe_screen *screen,
+                enum pipe_format zs_format, enum pipe_compare_func func)
+{
+   const unsigned cbuf_size = RENDER_SIZE * RENDER_SIZE * 4;
+   const unsigned zsbuf_size =
+      util_format_get_stride(zs_format, RENDER_SIZE) * RENDER_SIZE;
+   struct test_vertex verts[NUM_TBDR_TRIS * 3];
+   unsigned order[NUM_TBDR_TRIS];
+   uint8_t *cbuf[2], *zsbuf[2];
+   boolean success = TRUE;
+   unsigned i, j, mode;
+
+   for (i = 0; i < NUM_TBDR_TRIS; i++)
+      order[i] = i;
+   for (i = NUM_TBDR_TRIS - 1; i > 0; i--) {
+      unsigned t, r = rand() % (i + 1);
+      t = order[i];
+      order[i] = order[r];
+      order[r] = t;
+   }
+
+   for (i = 0; i < NUM_TBDR_TRIS; i++) {
+      for (j = 0; j < 3; j++) {
+         float *pos = verts[i * 3 + j].pos;
+
+         /* Mostly larger than the framebuffer. */
+         pos[0] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+         pos[1] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+         pos[2] = (order[i] + 0.1f + 0.8f * (rand() % 1024) / 1024.0f) /
+                  NUM_TBDR_TRIS;
+         pos[3] = 1.0f;
+         random_color(verts[i * 3 + j].color);
+      }
+   }
+
+   for (mode = 0; mode < 2; mode++) {
+      cbuf[mode] = MALLOC(cbuf_size);
+      zsbuf[mode] = MALLOC(zsbuf_size);
+
+      llvmpipe_screen(screen)->tbdr = mode;
+      lp_reset_counters();
+      render_tris(screen, zs_format, func, verts, ARRAY_SIZE(verts),
+                  cbuf[mode], zsbuf[mode]);
+   }
+   llvmpipe_screen(screen)->tbdr = FALSE;
+
+   if (memcmp(cbuf[0], cbuf[1], cbuf_size) ||
+       memcmp(zsbuf[0], zsbuf[1], zsbuf_size)) {
+      fprintf(stderr, "tbdr: %s, %s: deferred shading differs from immediate\n",
+              util_format_short_name(zs_format), util_str_func(func, TRUE));
+      success = FALSE;
+   }
+
+   /* Counters are only kept in debug builds.  Each pixel is shaded once
+    * in deferred bins, however many triangles cover it.
+    */
+   if (LP_COUNT_GET(nr_tbdr_64) > 0 &&
+       (LP_COUNT_GET(nr_tbdr_shaded_fragments) != LP_COUNT_GET(nr_tbdr_pixels) ||
+        LP_COUNT_GET(nr_tbdr_fragments) <= LP_COUNT_GET(nr_tbdr_pixels))) {
+      fprintf(stderr, "tbdr: %s, %s: shaded %u fragments over %u pixels, covered by %u\n",
+              util_format_short_name(zs_format), util_str_func(func, TRUE),
+              LP_COUNT_GET(nr_tbdr_shaded_fragments),
+              LP_COUNT_GET(nr_tbdr_pixels),
+              LP_COUNT_GET(nr_tbdr_fragments));
+      success = FALSE;
+   }
+
+   if (verbose >= 1)
+      fprintf(stderr, "tbdr: %s, %s: %u deferred tiles, %.2f fragments shaded per pixel, of %.2f\n",
+              util_format_short_name(zs_format), util_str_func(func, TRUE),
+              LP_COUNT_GET(nr_tbdr_64),
+              (double)LP_COUNT_GET(nr_tbdr_shaded_fragments) /
+              MAX2(LP_COUNT_GET(nr_tbdr_pixels), 1),
+              (double)LP_COUNT_GET(nr_tbdr_fragments) /
+              MAX2(LP_COUNT_GET(nr_tbdr_pixels), 1));
+
+   for (mode = 0; mode < 2; mode++) {
+      FREE(cbuf[mode]);
+      FREE(zsbuf[mode]);
+   }
+
+   return success;
+}
+
+
+/*
+ * Batched against unbatched small triangles: clusters of up to 16
+ * triangles of at most 8x8 pixels, at subpixel positions and with either
+ * winding, within 16x16 pixels so that setup batches most of them.  Each
+ * triangle has its own color, so the images show both the coverage and
+ * the order of the triangles.
+ */
+
+#define NUM_SMALL_TRIS 2048
+
+
+static boolean
+test_batch_scene(unsigned verbose, struct pipe_screen *screen)
+{
+   const unsigned cbuf_size = RENDER_SIZE * RENDER_SIZE * 4;
+   struct test_vertex *verts = MALLOC(NUM_SMALL_TRIS * 3 * sizeof *verts);
+   uint8_t *cbuf[2];
+   boolean success = TRUE;
+   unsigned batched = 0;
+   float x = 0.0f, y = 0.0f;
+   unsigned i, j, mode;
+
+   for (i = 0; i < NUM_SMALL_TRIS; i++) {
+      const int size = 1 + rand() % 8;
+      float x0, y0, color[4];
+
+      if (i % 16 == 0 || rand() % 8 == 0) {
+         x = rand() % (RENDER_SIZE - 16);
+         y = rand() % (RENDER_SIZE - 16);
+      }
+
+      /* In 1/16 pixel steps, the first vertex anywhere the triangle stays
+       * within 16 pixels of the cluster origin, the others within size
+       * pixels of it.
+       */
+      x0 = x + (rand() % (16 * (16 - size))) / 16.0f;
+      y0 = y + (rand() % (16 * (16 - size))) / 16.0f;
+      random_color(color);
+
+      for (j = 0; j < 3; j++) {
+         float *pos = verts[i * 3 + j].pos;
+
+         pos[0] = x0 + (j ? (rand() % (16 * size + 1)) / 16.0f : 0.0f);
+         pos[1] = y0 + (j ? (rand() % (16 * size + 1)) / 16.0f : 0.0f);
+         pos[2] = 0.5f;
+         pos[3] = 1.0f;
+         memcpy(verts[i * 3 + j].color, color, sizeof color);
+      }
+   }
+
+   for (mode = 0; mode < 2; mode++) {
+      cbuf[mode] = MALLOC(cbuf_size);
+
+      if (mode)
+         LP_PERF &= ~PERF_NO_TRI_BATCH;
+      else
+         LP_PERF |= PERF_NO_TRI_BATCH;
+      lp_reset_counters();
+      render_tris(screen, PIPE_FORMAT_NONE, PIPE_FUNC_ALWAYS,
+                  verts, NUM_SMALL_TRIS * 3, cbuf[mode], NULL);
+      if (mode)
+         batched = LP_COUNT_GET(nr_batched_tris);
+   }
+
+   if (memcmp(cbuf[0], cbuf[1], cbuf_size)) {
+      unsigned diff = 0;
+
+      for (i = 0; i < cbuf_size; i += 4)
+         diff += memcmp(cbuf[0] + i, cbuf[1] + i, 4) != 0;
+      fprintf(stderr, "batch: %u pixels differ from unbatched triangles\n",
+              diff);
+      success = FALSE;
+   }
+
+#ifdef DEBUG
+   if (!batched) {
+      fprintf(stderr, "batch: no triangles batched\n");
+      success = FALSE;
+   }
+#endif
+
+   if (verbose >= 1)
+      fprintf(stderr, "batch: %u of %u triangles batched\n",
+              batched, NUM_SMALL_TRIS);
+
+   for (mode = 0; mode < 2; mode++)
+      FREE(cbuf[mode]);
+   FREE(verts);
+
+   return success;
+}
+
+
+/*
+ * Lazy clears (lp_rast_fast_clear.c) across scenes: a color and a
+ * Z24_UNORM_S8_UINT buffer of 4x4 tiles are cleared, drawn to, cleared
+ * again to the same and to other values, and written by transfers, with
+ * the memory checked after every scene.
+ */
+
+#define FC_RED   0xffff0000
+#define FC_GREEN 0xff00ff00
+#define FC_BLUE  0xff0000ff
+#define FC_WHITE 0xffffffff
+
+
+/** Whether the rasterizer knows the tile to hold the color value. */
+static boolean
+fast_clear_known(struct pipe_resource *res, unsigned tx, unsigned ty,
+                 uint32_t value)
+{
+   const struct llvmpipe_resource *lpr = llvmpipe_resource(res);
+   const struct lp_fast_clear_tile *tile;
+
+   if (!lpr->fast_clear || !lpr->fast_clear_valid)
+      return FALSE;
+
+   tile = &lpr->fast_clear[ty * DIV_ROUND_UP(res->width0, TILE_SIZE) + tx];
+   return (uint32_t)tile->mask[0] == 0xffffffff &&
+          (uint32_t)tile->value[0] == value;
+}
+
+
+static boolean
+fast_clear_check(struct render_target *rt, const char *step,
+                 const uint32_t *color, uint32_t zs)
+{
+   uint32_t *data = MALLOC(RENDER_SIZE * RENDER_SIZE * 4);
+   unsigned bad_color = 0, bad_zs = 0;
+   unsigned i;
+
+   read_back(rt->pipe, rt->cres, (uint8_t *)data);
+   for (i = 0; i < RENDER_SIZE * RENDER_SIZE; i++)
+      bad_color += data[i] != color[i];
+
+   read_back(rt->pipe, rt->zsres, (uint8_t *)data);
+   for (i = 0; i < RENDER_SIZE * RENDER_SIZE; i++)
+      bad_zs += data[i] != zs;
+
+   FREE(data);
+
+   if (bad_color || bad_zs) {
+      fprintf(stderr, "fast clear: %s: %u color and %u z/stencil pixels wrong\n",
+              step, bad_color, bad_zs);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+
+static void
+fast_clear(struct render_target *rt, uint32_t color, double depth,
+           unsigned stencil)
+{
+   union pipe_color_union uc;
+
+   uc.f[0] = ((color >> 16) & 0xff) / 255.0f;
+   uc.f[1] = ((color >> 8) & 0xff) / 255.0f;
+   uc.f[2] = (color & 0xff) / 255.0f;
+   uc.f[3] = (color >> 24) / 255.0f;
+   rt->pipe->clear(rt->pipe, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+                   NULL, &uc, depth, stencil);
+}
+
+
+static boolean
+test_fast_clear_scene(unsigned verbose, struct pipe_screen *screen)
+{
+   /* Covers all of tile column 0, rows 0 and 1 of column 1 and parts of
+    * the other tiles of columns 1 and 2: pixels with 8x + 3y <= 1530.
+    */
+   static const struct test_vertex tri[3] = {
+      { {   0.0f,   0.0f, 0.5f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+      { { 192.0f,   0.0f, 0.5f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+      { {   0.0f, 512.0f, 0.5f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+   };
+   const unsigned poke_x = 200, poke_y = 200;
+   const uint32_t sentinel = 0x12345678;
+   const uint32_t white = FC_WHITE, zs_poke = 0x12ffffff;
+   uint32_t *expected = MALLOC(RENDER_SIZE * RENDER_SIZE * 4);
+   struct render_target rt;
+   struct pipe_box box;
+   boolean success = TRUE;
+   unsigned x, y, i;
+   uint8_t *map;
+
+   LP_PERF &= ~PERF_NO_FAST_CLEAR;
+   render_target_init(&rt, screen, PIPE_FORMAT_Z24_UNORM_S8_UINT,
+                      PIPE_FUNC_ALWAYS);
+
+   /* 1. A clear by itself: written, and then known for every tile. */
+   fast_clear(&rt, FC_RED, 1.0, 0);
+   render_target_finish(&rt);
+   for (i = 0; i < RENDER_SIZE * RENDER_SIZE; i++)
+      expected[i] = FC_RED;
+   if (!fast_clear_check(&rt, "clear", expected, 0x00ffffff))
+      success = FALSE;
+   for (i = 0; i < 16; i++) {
+      if (!fast_clear_known(rt.cres, i % 4, i / 4, FC_RED)) {
+         fprintf(stderr, "fast clear: clear: tile %u not known\n", i);
+         success = FALSE;
+         break;
+      }
+   }
+
+   /* 2. The same clear and an opaque triangle in one scene: the clear is
+    * dropped where the triangle covers whole tiles, and skipped where the
+    * tiles already hold it.
+    */
+   lp_reset_counters();
+   fast_clear(&rt, FC_RED, 1.0, 0);
+   render_target_draw(&rt, tri, 3);
+   render_target_finish(&rt);
+   for (y = 0; y < RENDER_SIZE; y++)
+      for (x = 0; x < RENDER_SIZE; x++)
+         expected[y * RENDER_SIZE + x] = 8 * x + 3 * y <= 1530 ?
+                                         FC_GREEN : FC_RED;
+   if (!fast_clear_check(&rt, "clear and draw", expected, 0x00ffffff))
+      success = FALSE;
+   if (fast_clear_known(rt.cres, 0, 0, FC_RED) ||
+       !fast_clear_known(rt.cres, 3, 0, FC_RED)) {
+      fprintf(stderr, "fast clear: clear and draw: wrong tiles known\n");
+      success = FALSE;
+   }
+#ifdef DEBUG
+   if (!LP_COUNT_GET(nr_fast_clear_discarded_64) ||
+       !LP_COUNT_GET(nr_fast_clear_skipped_64)) {
+      fprintf(stderr, "fast clear: clear and draw: %u tiles dropped, %u skipped\n",
+              LP_COUNT_GET(nr_fast_clear_discarded_64),
+              LP_COUNT_GET(nr_fast_clear_skipped_64));
+      success = FALSE;
+   }
+#endif
+
+   /* 3. The same clear again, in a new scene.  A pixel is changed behind
+    * the rasterizer's back in a tile known to hold the clear color, and
+    * must survive: the tile is skipped.  The drawn tiles are rewritten.
+    */
+   map = llvmpipe_resource_map(rt.cres, 0, 0, LP_TEX_USAGE_READ_WRITE);
+   memcpy(map + poke_y * llvmpipe_resource_stride(rt.cres, 0) + poke_x * 4,
+          &sentinel, 4);
+   llvmpipe_resource_unmap(rt.cres, 0, 0);
+   fast_clear(&rt, FC_RED, 1.0, 0);
+   render_target_finish(&rt);
+   for (i = 0; i < RENDER_SIZE * RENDER_SIZE; i++)
+      expected[i] = FC_RED;
+   expected[poke_y * RENDER_SIZE + poke_x] = sentinel;
+   if (!fast_clear_check(&rt, "same clear", expected, 0x00ffffff))
+      success = FALSE;
+
+   /* 4. A different clear rewrites every tile. */
+   fast_clear(&rt, FC_BLUE, 0.0, 0x55);
+   render_target_finish(&rt);
+   for (i = 0; i < RENDER_SIZE * RENDER_SIZE; i++)
+      expected[i] = FC_BLUE;
+   if (!fast_clear_check(&rt, "other clear", expected, 0x55000000))
+      success = FALSE;
+
+   /* 5. A transfer write invalidates what is known, so that the same
+    * clear rewrites the tiles again.
+    */
+   u_box_2d(100, 100, 1, 1, &box);
+   rt.pipe->texture_subdata(rt.pipe, rt.cres, 0, PIPE_MAP_WRITE, &box,
+                            &white, 4, 4);
+   rt.pipe->texture_subdata(rt.pipe, rt.zsres, 0, PIPE_MAP_WRITE, &box,
+                            &zs_poke, 4, 4);
+   if (llvmpipe_resource(rt.cres)->fast_clear_valid ||
+       llvmpipe_resource(rt.zsres)->fast_clear_valid) {
+      fprintf(stderr, "fast clear: transfer: clear state still valid\n");
+      success = FALSE;
+   }
+   fast_clear(&rt, FC_BLUE, 0.0, 0x55);
+   render_target_finish(&rt);
+   if (!fast_clear_check(&rt, "clear after transfer", expected, 0x55000000))
+      success = FALSE;
+
+   if (verbose >= 1)
+      fprintf(stderr, "fast clear: %u tiles dropped, %u skipped\n",
+              LP_COUNT_GET(nr_fast_clear_discarded_64),
+              LP_COUNT_GET(nr_fast_clear_skipped_64));
+
+   render_target_fini(&rt);
+   FREE(expected);
+
+   return success;
+}
+
+
+/*
+ * Hierarchical z (lp_rast_hiz.c) against none.  A scene draws a near
+ * occluder over the whole framebuffer, and a transfer writes far depth
+ * values into a block.  A second scene draws triangles behind the
+ * occluder, and a third one triangles crossing it.  Depth bounds
+ * rejecting the hidden triangles mustn't change the images after either
+ * scene.  The transfer must invalidate the bounds, or the hidden
+ * triangles would be rejected in the block too.
+ */
+
+#define NUM_HIZ_TRIS 16
+
+
+static void
+hiz_scenes(struct pipe_screen *screen, enum pipe_format zs_format,
+           enum pipe_compare_func func,
+           const struct test_vertex *occluder,
+           const struct test_vertex *hidden,
+           const struct test_vertex *crossing,
+           uint8_t **cbuf, uint8_t **zsbuf)
+{
+   const union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 1.0f } };
+   const double far = func == PIPE_FUNC_LESS ? 1.0 : 0.0;
+   const uint32_t far_value = util_pack_z_stencil(zs_format, far, 0);
+   uint32_t block[16 * 16];
+   struct render_target rt;
+   struct pipe_box box;
+   unsigned i;
+
+   render_target_init(&rt, screen, zs_format, func);
+
+   rt.pipe->clear(rt.pipe, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+                  NULL, &clear_color, far, 0);
+   render_target_draw(&rt, occluder, 3);
+   render_target_finish(&rt);
+
+   for (i = 0; i < ARRAY_SIZE(block); i++)
+      block[i] = far_value;
+   u_box_2d(80, 80, 16, 16, &box);
+   rt.pipe->texture_subdata(rt.pipe, rt.zsres, 0, PIPE_MAP_WRITE, &box,
+                            block, 16 * 4, 0);
+
+   render_target_draw(&rt, hidden, NUM_HIZ_TRIS * 3);
+   read_back(rt.pipe, rt.cres, cbuf[0]);
+   read_back(rt.pipe, rt.zsres, zsbuf[0]);
+
+   render_target_draw(&rt, crossing, NUM_HIZ_TRIS * 3);
+   read_back(rt.pipe, rt.cres, cbuf[1]);
+   read_back(rt.pipe, rt.zsres, zsbuf[1]);
+
+   render_target_fini(&rt);
+}
+
+
+static boolean
+test_hiz_scene(unsigned verbose, struct pipe_screen *screen,
+               enum pipe_format zs_format, enum pipe_compare_func func)
+{
+   static const char *scenes[2] = { "hidden", "crossing" };
+   const unsigned size = RENDER_SIZE * RENDER_SIZE * 4;
+   /* Depth of the occluder, and the range behind it. */
+   const float near = func == PIPE_FUNC_LESS ? 0.25f : 0.75f;
+   const float hidden_lo = func == PIPE_FUNC_LESS ? 0.3f : 0.05f;
+   struct test_vertex occluder[3];
+   struct test_vertex hidden[NUM_HIZ_TRIS * 3];
+   struct test_vertex crossing[NUM_HIZ_TRIS * 3];
+   uint8_t *cbuf[2][2], *zsbuf[2][2];
+   unsigned rejected = 0;
+   boolean success = TRUE;
+   unsigned i, j, mode, scene;
+
+   /* One triangle covering the whole framebuffer, so that it tightens
+    * the bounds of every block.
+    */
+   memset(occluder, 0, sizeof occluder);
+   for (j = 0; j < 3; j++) {
+      occluder[j].pos[0] = j == 1 ? 4.0f * RENDER_SIZE : 0.0f;
+      occluder[j].pos[1] = j == 2 ? 4.0f * RENDER_SIZE : 0.0f;
+      occluder[j].pos[2] = near;
+      occluder[j].pos[3] = 1.0f;
+      occluder[j].color[0] = 1.0f;
+      occluder[j].color[3] = 1.0f;
+   }
+
+   /* A hidden triangle over the whole framebuffer too, then triangles
+    * mostly larger than the framebuffer.  The crossing ones are close to
+    * the occluder, to catch bounds a bit off.
+    */
+   memcpy(hidden, occluder, sizeof occluder);
+   for (j = 0; j < 3; j++) {
+      hidden[j].pos[2] = hidden_lo + 0.1f;
+      random_color(hidden[j].color);
+   }
+   for (i = 0; i < NUM_HIZ_TRIS * 3; i++) {
+      if (i >= 3) {
+         hidden[i].pos[0] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+         hidden[i].pos[1] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+         hidden[i].pos[2] = hidden_lo + 0.6f * (rand() % 1024) / 1024.0f;
+         hidden[i].pos[3] = 1.0f;
+         random_color(hidden[i].color);
+      }
+
+      crossing[i].pos[0] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+      crossing[i].pos[1] = (float)(rand() % (3 * RENDER_SIZE)) - RENDER_SIZE;
+      crossing[i].pos[2] = near + 0.2f * (rand() % 1024) / 1024.0f - 0.1f;
+      crossing[i].pos[3] = 1.0f;
+      random_color(crossing[i].color);
+   }
+
+   for (mode = 0; mode < 2; mode++) {
+      for (scene = 0; scene < 2; scene++) {
+         cbuf[mode][scene] = MALLOC(size);
+         zsbuf[mode][scene] = MALLOC(size);
+      }
+
+      if (mode)
+         LP_PERF &= ~PERF_NO_HIZ;
+      else
+         LP_PERF |= PERF_NO_HIZ;
+      lp_reset_counters();
+      hiz_scenes(screen, zs_format, func, occluder, hidden, crossing,
+                 cbuf[mode], zsbuf[mode]);
+      if (mode)
+         rejected = LP_COUNT_GET(nr_hiz_rejected_64);
+   }
+
+   for (scene = 0; scene < 2; scene++) {
+      if (memcmp(cbuf[0][scene], cbuf[1][scene], size) ||
+          memcmp(zsbuf[0][scene], zsbuf[1][scene], size)) {
+         fprintf(stderr, "hiz: %s, %s: %s: images differ from no depth bounds\n",
+                 util_format_short_name(zs_format), util_str_func(func, TRUE),
+                 scenes[scene]);
+         success = FALSE;
+      }
+   }
+
+#ifdef DEBUG
+   if (!rejected) {
+      fprintf(stderr, "hiz: %s, %s: no tiles rejected\n",
+              util_format_short_name(zs_format), util_str_func(func, TRUE));
+      success = FALSE;
+   }
+#endif
+
+   if (verbose >= 1)
+      fprintf(stderr, "hiz: %s, %s: %u tiles rejected\n",
+              util_format_short_name(zs_format), util_str_func(func, TRUE),
+              rejected);
+
+   for (mode = 0; mode < 2; mode++) {
+      for (scene = 0; scene < 2; scene++) {
+         FREE(cbuf[mode][scene]);
+         FREE(zsbuf[mode][scene]);
+      }
+   }
+
+   return success;
+}
+
+
+static boolean
+test_render(unsigned verbose)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_Z24_UNORM_S8_UINT,
+      PIPE_FORMAT_Z32_FLOAT,
+   };
+   static const enum pipe_compare_func funcs[] = {
+      PIPE_FUNC_LESS,
+      PIPE_FUNC_GEQUAL,
+   };
+   const int perf = LP_PERF;
+   struct pipe_screen *screen;
+   boolean success = TRUE;
+   unsigned i, j;
+
+   screen = llvmpipe_create_screen(&test_winsys);
+   if (!screen)
+      return FALSE;
+
+   for (i = 0; i < ARRAY_SIZE(formats); i++) {
+      for (j = 0; j < ARRAY_SIZE(funcs); j++) {
+         if (!test_tbdr_scene(verbose, screen, formats[i], funcs[j]))
+            success = FALSE;
+         if (!test_hiz_scene(verbose, screen, formats[i], funcs[j]))
+            success = FALSE;
+      }
+   }
+
+   if (!test_batch_scene(verbose, screen))
+      success = FALSE;
+
+   if (!test_fast_clear_scene(verbose, screen))
+      success = FALSE;
+
+   LP_PERF = perf;
+   screen->destroy(screen);
+
+   return success;
+}
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "isa\t"
+           "size\t"
+           "tris_per_sec\n");
+
+   fflush(fp);
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   static const int sizes[] = { 2, 8, 32, 128, 512 };
+   static const int batch_sizes[] = { 1, 2, 4, 8, 12 };
+   boolean success = TRUE;
+   unsigned long i;
+   unsigned k;
+
+   for (k = 0; k < ARRAY_SIZE(mask_isas); k++) {
+      struct lp_rast_mask_funcs funcs;
+
+      if (!mask_isas[k].get(&funcs))
+         continue;
+
+      for (i = 0; i < n; i++)
+         if (!test_masks(verbose, &mask_isas[k], &funcs))
+            success = FALSE;
+   }
+
+   for (k = 0; k < ARRAY_SIZE(sizes); k++)
+      if (!test_coverage(verbose, fp, sizes[k]))
+         success = FALSE;
+
+   for (k = 0; k < ARRAY_SIZE(batch_sizes); k++)
+      if (!test_batch(verbose, fp, batch_sizes[k]))
+         success = FALSE;
+
+   if (!test_render(verbose))
+      success = FALSE;
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 1);
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 100000);
+}
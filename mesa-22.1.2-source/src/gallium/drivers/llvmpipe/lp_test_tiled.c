@@ -0,0 +1,484 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file
+ * Unit tests for sampling tiled textures.
+ *
+ * Uploads random texels with llvmpipe_tiled_copy_box(), then fetches and
+ * samples every texel of every level and layer with the generated code and
+ * compares against the linear source.  The same is done with tiling off, so
+ * both layouts are checked against one reference.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+
+#include "util/u_box.h"
+#include "util/u_memory.h"
+#include "util/u_math.h"
+#include "util/format/u_format.h"
+
+#include "gallivm/lp_bld.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_sample.h"
+#include "gallivm/lp_bld_tgsi.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "lp_jit.h"
+#include "lp_screen.h"
+#include "lp_state_fs.h"
+#include "lp_tex_sample.h"
+#include "lp_texture.h"
+
+#include "lp_test.h"
+
+
+struct tiled_test_case
+{
+   enum pipe_format format;
+   enum pipe_texture_target target;
+   unsigned width, height, array_size, last_level;
+};
+
+/* Every case is at least four tiles wide and high, so that tiling is used. */
+static const struct tiled_test_case test_cases[] = {
+   { PIPE_FORMAT_R8_UNORM, PIPE_TEXTURE_2D, 300, 280, 1, 3 },
+   { PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_TEXTURE_2D_ARRAY, 200, 130, 3, 1 },
+   { PIPE_FORMAT_R32G32B32A32_FLOAT, PIPE_TEXTURE_2D, 100, 70, 1, 0 },
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "format\t"
+           "tiled\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct tiled_test_case *test,
+              boolean tiled,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%s\t%u\n", util_format_name(test->format), tiled);
+
+   fflush(fp);
+}
+
+
+/**
+ * Four coordinates (s, t, layer, lod) of four texels in, four channels of
+ * four texels out.  The coordinates are integers for fetches and floats
+ * for sampling.
+ */
+typedef void
+(*sample_ptr_t)(const struct lp_jit_context *context,
+                const void *coords, float texel[4][4]);
+
+
+static LLVMValueRef
+add_sample_test(struct gallivm_state *gallivm,
+                LLVMTypeRef context_ptr_type,
+                const struct lp_sampler_static_state *static_state,
+                unsigned op)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   const struct lp_type type = lp_type_float_vec(32, 128);
+   const struct lp_type coord_type = op == LP_SAMPLER_OP_FETCH ?
+      lp_int_type(type) : type;
+   LLVMTypeRef coord_vec_type = lp_build_vec_type(gallivm, coord_type);
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   struct lp_build_sampler_soa *sampler;
+   struct lp_sampler_params params;
+   LLVMTypeRef args[3];
+   LLVMValueRef func, coords_ptr, texel_ptr;
+   LLVMValueRef coords[5], offsets[3] = { NULL }, texel[4];
+   LLVMBasicBlockRef block;
+   unsigned i;
+
+   args[0] = context_ptr_type;
+   args[1] = LLVMPointerType(coord_vec_type, 0);
+   args[2] = LLVMPointerType(vec_type, 0);
+
+   func = LLVMAddFunction(gallivm->module,
+                          op == LP_SAMPLER_OP_FETCH ? "fetch" : "sample",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, ARRAY_SIZE(args), 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   coords_ptr = LLVMGetParam(func, 1);
+   texel_ptr = LLVMGetParam(func, 2);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   for (i = 0; i < 4; i++) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, i);
+      coords[i] = LLVMBuildLoad(builder,
+                                LLVMBuildGEP(builder, coords_ptr,
+                                             &index, 1, ""), "");
+   }
+   coords[4] = NULL;
+
+   memset(&params, 0, sizeof params);
+   params.type = type;
+   params.sample_key =
+      (op << LP_SAMPLER_OP_TYPE_SHIFT) |
+      (LP_SAMPLER_LOD_EXPLICIT << LP_SAMPLER_LOD_CONTROL_SHIFT) |
+      (LP_SAMPLER_LOD_PER_ELEMENT << LP_SAMPLER_LOD_PROPERTY_SHIFT);
+   params.context_ptr = LLVMGetParam(func, 0);
+   params.coords = coords;
+   params.offsets = offsets;
+   params.lod = coords[3];
+   params.texel = texel;
+
+   sampler = lp_llvm_sampler_soa_create(static_state, 1);
+   sampler->emit_tex_sample(sampler, gallivm, &params);
+   sampler->destroy(sampler);
+
+   for (i = 0; i < 4; i++) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, i);
+      LLVMBuildStore(builder, texel[i],
+                     LLVMBuildGEP(builder, texel_ptr, &index, 1, ""));
+   }
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+static void
+upload(struct llvmpipe_resource *lpr, unsigned level, unsigned layer,
+       uint8_t *linear, unsigned stride)
+{
+   struct pipe_box box;
+
+   u_box_3d(0, 0, layer,
+            u_minify(lpr->base.width0, level),
+            u_minify(lpr->base.height0, level), 1, &box);
+
+   if (lpr->tiled) {
+      llvmpipe_tiled_copy_box(lpr, level, &box, linear, stride, 0, TRUE);
+   } else {
+      uint8_t *image = llvmpipe_get_texture_image_address(lpr, layer, level);
+      unsigned y;
+
+      for (y = 0; y < box.height; y++)
+         memcpy(image + y * lpr->row_stride[level], linear + y * stride,
+                stride);
+   }
+}
+
+
+static void
+fill_jit_texture(struct lp_jit_texture *jit_tex,
+                 const struct llvmpipe_resource *lpr)
+{
+   const struct pipe_resource *res = &lpr->base;
+   unsigned j;
+
+   jit_tex->base = lpr->tex_data;
+   jit_tex->width = res->width0;
+   jit_tex->height = res->height0;
+   jit_tex->depth = res->target == PIPE_TEXTURE_2D_ARRAY ?
+      res->array_size : res->depth0;
+   jit_tex->first_level = 0;
+   jit_tex->last_level = res->last_level;
+   jit_tex->num_samples = res->nr_samples;
+   jit_tex->sample_stride = 0;
+
+   for (j = 0; j <= res->last_level; j++) {
+      jit_tex->mip_offsets[j] = lpr->mip_offsets[j];
+      jit_tex->row_stride[j] = lpr->row_stride[j];
+      jit_tex->img_stride[j] = lpr->img_stride[j];
+   }
+}
+
+
+PIPE_ALIGN_STACK
+static boolean
+test_one(unsigned verbose, FILE *fp,
+         const struct tiled_test_case *test,
+         boolean tiled)
+{
+   const struct util_format_description *desc =
+      util_format_description(test->format);
+   const unsigned block_bytes = desc->block.bits / 8;
+   struct llvmpipe_screen screen;
+   struct pipe_resource templat;
+   struct pipe_resource *res;
+   struct llvmpipe_resource *lpr;
+   struct pipe_sampler_view view;
+   struct pipe_sampler_state sampler_state;
+   struct lp_sampler_static_state static_state;
+   struct lp_fragment_shader_variant *variant;
+   struct lp_jit_context *jit_context;
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   LLVMValueRef fetch, sample;
+   sample_ptr_t fetch_ptr, sample_ptr;
+   uint8_t *linear[PIPE_MAX_TEXTURE_LEVELS][3];
+   boolean success = TRUE;
+   unsigned level, layer, i;
+
+   memset(&screen, 0, sizeof screen);
+   llvmpipe_init_screen_resource_funcs(&screen.base);
+   screen.tiled_textures = tiled;
+
+   memset(&templat, 0, sizeof templat);
+   templat.target = test->target;
+   templat.format = test->format;
+   templat.width0 = test->width;
+   templat.height0 = test->height;
+   templat.depth0 = 1;
+   templat.array_size = test->array_size;
+   templat.last_level = test->last_level;
+   templat.bind = PIPE_BIND_SAMPLER_VIEW;
+
+   res = screen.base.resource_create(&screen.base, &templat);
+   lpr = llvmpipe_resource(res);
+   if (lpr->tiled != tiled) {
+      printf("%s: tiled is %u, expected %u\n",
+             util_format_name(test->format), lpr->tiled, tiled);
+      success = FALSE;
+      goto out;
+   }
+
+   /* Random texels, kept linear for the reference. */
+   srand(1);
+   for (level = 0; level <= test->last_level; level++) {
+      const unsigned width = u_minify(test->width, level);
+      const unsigned height = u_minify(test->height, level);
+      const unsigned stride = width * block_bytes;
+
+      for (layer = 0; layer < test->array_size; layer++) {
+         linear[level][layer] = MALLOC(stride * height);
+
+         if (desc->channel[0].type == UTIL_FORMAT_TYPE_FLOAT) {
+            float *texels = (float *)linear[level][layer];
+            for (i = 0; i < stride * height / 4; i++)
+               texels[i] = (float)rand() / RAND_MAX;
+         } else {
+            for (i = 0; i < stride * height; i++)
+               linear[level][layer][i] = rand();
+         }
+
+         upload(lpr, level, layer, linear[level][layer], stride);
+      }
+   }
+
+   memset(&view, 0, sizeof view);
+   view.format = test->format;
+   view.target = test->target;
+   view.texture = res;
+   view.u.tex.first_level = 0;
+   view.u.tex.last_level = test->last_level;
+   view.u.tex.first_layer = 0;
+   view.u.tex.last_layer = test->array_size - 1;
+   view.swizzle_r = PIPE_SWIZZLE_X;
+   view.swizzle_g = PIPE_SWIZZLE_Y;
+   view.swizzle_b = PIPE_SWIZZLE_Z;
+   view.swizzle_a = PIPE_SWIZZLE_W;
+
+   memset(&sampler_state, 0, sizeof sampler_state);
+   sampler_state.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.min_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler_state.mag_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NEAREST;
+   sampler_state.normalized_coords = 1;
+   sampler_state.max_lod = test->last_level;
+
+   memset(&static_state, 0, sizeof static_state);
+   lp_sampler_static_texture_state(&static_state.texture_state, &view);
+   static_state.texture_state.tiled = lpr->tiled;
+   lp_sampler_static_sampler_state(&static_state.sampler_state,
+                                   &sampler_state);
+
+   context = LLVMContextCreate();
+   gallivm = gallivm_create("test_module_tiled", context, NULL);
+
+   variant = CALLOC_STRUCT(lp_fragment_shader_variant);
+   variant->gallivm = gallivm;
+   lp_jit_init_types(variant);
+
+   fetch = add_sample_test(gallivm, variant->jit_context_ptr_type,
+                           &static_state, LP_SAMPLER_OP_FETCH);
+   sample = add_sample_test(gallivm, variant->jit_context_ptr_type,
+                            &static_state, LP_SAMPLER_OP_TEXTURE);
+
+   gallivm_compile_module(gallivm);
+
+   fetch_ptr = (sample_ptr_t) gallivm_jit_function(gallivm, fetch);
+   sample_ptr = (sample_ptr_t) gallivm_jit_function(gallivm, sample);
+
+   gallivm_free_ir(gallivm);
+
+   jit_context = align_malloc(sizeof *jit_context, 16);
+   memset(jit_context, 0, sizeof *jit_context);
+   fill_jit_texture(&jit_context->textures[0], lpr);
+   jit_context->samplers[0].min_lod = sampler_state.min_lod;
+   jit_context->samplers[0].max_lod = sampler_state.max_lod;
+
+   for (level = 0; level <= test->last_level; level++) {
+      const unsigned width = u_minify(test->width, level);
+      const unsigned height = u_minify(test->height, level);
+
+      for (layer = 0; layer < test->array_size; layer++) {
+         unsigned x, y;
+
+         for (y = 0; y < height && success; y++) {
+            for (x = 0; x < width && success; x += 4) {
+               PIPE_ALIGN_VAR(16) int32_t icoords[4][4];
+               PIPE_ALIGN_VAR(16) float fcoords[4][4];
+               PIPE_ALIGN_VAR(16) float fetched[4][4];
+               PIPE_ALIGN_VAR(16) float sampled[4][4];
+               float expected[4];
+               unsigned j, k;
+
+               for (j = 0; j < 4; j++) {
+                  const unsigned tx = MIN2(x + j, width - 1);
+
+                  icoords[0][j] = tx;
+                  icoords[1][j] = y;
+                  icoords[2][j] = layer;
+                  icoords[3][j] = level;
+                  fcoords[0][j] = (tx + 0.5f) / width;
+                  fcoords[1][j] = (y + 0.5f) / height;
+                  fcoords[2][j] = layer;
+                  fcoords[3][j] = level;
+               }
+
+               fetch_ptr(jit_context, icoords, fetched);
+               sample_ptr(jit_context, fcoords, sampled);
+
+               for (j = 0; j < 4; j++) {
+                  const unsigned tx = icoords[0][j];
+                  boolean match = TRUE;
+
+                  util_format_unpack_rgba(test->format, expected,
+                                          linear[level][layer] +
+                                          (y * width + tx) * block_bytes, 1);
+
+                  for (k = 0; k < 4; k++) {
+                     if (fabs(fetched[k][j] - expected[k]) > 1e-5 ||
+                         fabs(sampled[k][j] - expected[k]) > 1e-5)
+                        match = FALSE;
+                  }
+
+                  if (!match) {
+                     printf("FAILED\n");
+                     printf("  %s, tiled %u, level %u, layer %u, texel (%u,%u)\n",
+                            util_format_name(test->format), tiled,
+                            level, layer, tx, y);
+                     printf("  %.9g %.9g %.9g %.9g fetched\n",
+                            fetched[0][j], fetched[1][j],
+                            fetched[2][j], fetched[3][j]);
+                     printf("  %.9g %.9g %.9g %.9g sampled\n",
+                            sampled[0][j], sampled[1][j],
+                            sampled[2][j], sampled[3][j]);
+                     printf("  %.9g %.9g %.9g %.9g expected\n",
+                            expected[0], expected[1],
+                            expected[2], expected[3]);
+                     fflush(stdout);
+                     success = FALSE;
+                     break;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   align_free(jit_context);
+   FREE(variant);
+   gallivm_destroy(gallivm);
+   LLVMContextDispose(context);
+
+   for (level = 0; level <= test->last_level; level++) {
+      for (layer = 0; layer < test->array_size; layer++)
+         FREE(linear[level][layer]);
+   }
+
+out:
+   screen.base.resource_destroy(&screen.base, res);
+
+   if (verbose)
+      printf("%s, tiled %u: %s\n", util_format_name(test->format), tiled,
+             success ? "ok" : "FAIL");
+
+   if (fp)
+      write_tsv_row(fp, test, tiled, success);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+   unsigned i, tiled;
+
+   for (i = 0; i < ARRAY_SIZE(test_cases); i++) {
+      for (tiled = 0; tiled < 2; tiled++) {
+         if (!test_one(verbose, fp, &test_cases[i], tiled))
+            success = FALSE;
+      }
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return TRUE;
+}
@@ -0,0 +1,466 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file
+ * Unit tests and throughput measurement for the native vector width of
+ * the generated fragment shaders.
+ *
+ * Full screen quads are drawn with a bilinear texturing, an ALU heavy, a
+ * blended and a depth tested fragment shader, once for each native
+ * vector width the CPU supports beyond 128 bits: 256 bits with AVX, and
+ * 512 bits with AVX-512 (what GALLIVM_PERF=avx512 selects).  The images
+ * of the two widths must be identical.  With an output file (-o), the
+ * quads are drawn into a large framebuffer and the milliseconds per frame
+ * of every workload and width are written out.
+ */
+
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "frontend/sw_winsys.h"
+#include "cso_cache/cso_context.h"
+#include "tgsi/tgsi_text.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_sampler.h"
+#include "util/u_simple_shaders.h"
+#include "lp_public.h"
+#include "lp_test.h"
+
+
+#define CHECK_SIZE 128
+#define BENCH_SIZE 1024
+#define BENCH_FRAMES 40
+#define TEXTURE_SIZE 512
+
+
+static const char *alu_fs_text =
+   "FRAG\n"
+   "DCL IN[0], GENERIC[0], PERSPECTIVE\n"
+   "DCL OUT[0], COLOR\n"
+   "DCL TEMP[0..1]\n"
+   "IMM[0] FLT32 { 0.9, 0.1, 0.5, 1.0 }\n"
+   "  0: MOV TEMP[0], IN[0]\n"
+   "  1: MAD TEMP[1], TEMP[0], IMM[0].xxxx, IMM[0].yyyy\n"
+   "  2: MAD TEMP[0], TEMP[1], TEMP[1], IMM[0].zzzz\n"
+   "  3: MAD TEMP[1], TEMP[0], IMM[0].xxxx, IMM[0].yyyy\n"
+   "  4: MAD TEMP[0], TEMP[1], TEMP[1], IMM[0].zzzz\n"
+   "  5: MAD TEMP[1], TEMP[0], IMM[0].xxxx, IMM[0].yyyy\n"
+   "  6: MAD TEMP[0], TEMP[1], TEMP[1], IMM[0].zzzz\n"
+   "  7: MAD TEMP[1], TEMP[0], IMM[0].xxxx, IMM[0].yyyy\n"
+   "  8: MAD TEMP[0], TEMP[1], TEMP[1], IMM[0].zzzz\n"
+   "  9: RSQ TEMP[1].x, TEMP[0].xxxx\n"
+   " 10: RSQ TEMP[1].y, TEMP[0].yyyy\n"
+   " 11: MUL TEMP[0].xy, TEMP[0], TEMP[1]\n"
+   " 12: SIN TEMP[1].x, TEMP[0].xxxx\n"
+   " 13: COS TEMP[1].y, TEMP[0].yyyy\n"
+   " 14: MAD TEMP[0].xy, TEMP[1], IMM[0].zzzz, IMM[0].zzzz\n"
+   " 15: MOV TEMP[0].w, IMM[0].wwww\n"
+   " 16: MOV_SAT OUT[0], TEMP[0]\n"
+   " 17: END\n";
+
+
+enum workload {
+   WORKLOAD_TEXTURE,
+   WORKLOAD_ALU,
+   WORKLOAD_BLEND,
+   WORKLOAD_DEPTH,
+   NUM_WORKLOADS
+};
+
+
+static const char *workload_names[NUM_WORKLOADS] = {
+   "texture", "alu", "blend", "depth",
+};
+
+
+struct width_test {
+   unsigned size;
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+   struct pipe_resource *vbuf, *cres, *zsres, *tex;
+   struct pipe_sampler_view *view;
+   struct pipe_framebuffer_state fb;
+   void *vs, *fs_tex, *fs_alu;
+};
+
+
+static bool
+test_winsys_format_supported(struct sw_winsys *ws, unsigned tex_usage,
+                             enum pipe_format format)
+{
+   return false;
+}
+
+
+static struct sw_winsys test_winsys = {
+   .is_displaytarget_format_supported = test_winsys_format_supported,
+};
+
+
+static boolean
+width_test_init(struct width_test *t, unsigned size)
+{
+   static const float verts[4][2][4] = {
+      { { -1, -1, 0, 1 }, { 0, 0, 0, 1 } },
+      { {  1, -1, 0, 1 }, { 1, 0, 0, 1 } },
+      { {  1,  1, 0, 1 }, { 1, 1, 0, 1 } },
+      { { -1,  1, 0, 1 }, { 0, 1, 0, 1 } },
+   };
+   static const enum tgsi_semantic names[] = {
+      TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC
+   };
+   static const uint indices[] = { 0, 0 };
+   struct tgsi_token tokens[1000];
+   struct pipe_shader_state fs_state;
+   struct pipe_sampler_view view_templ;
+   struct pipe_resource templ;
+   struct pipe_surface surf_templ;
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   uint32_t *texels;
+   unsigned i;
+
+   memset(t, 0, sizeof *t);
+   t->size = size;
+   t->screen = llvmpipe_create_screen(&test_winsys);
+   if (!t->screen)
+      return FALSE;
+   t->pipe = t->screen->context_create(t->screen, NULL, 0);
+   t->cso = cso_create_context(t->pipe, 0);
+
+   t->vbuf = pipe_buffer_create(t->screen, PIPE_BIND_VERTEX_BUFFER,
+                                PIPE_USAGE_DEFAULT, sizeof verts);
+   pipe_buffer_write(t->pipe, t->vbuf, 0, sizeof verts, verts);
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   templ.width0 = TEXTURE_SIZE;
+   templ.height0 = TEXTURE_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_SAMPLER_VIEW;
+   t->tex = t->screen->resource_create(t->screen, &templ);
+
+   u_box_2d(0, 0, TEXTURE_SIZE, TEXTURE_SIZE, &box);
+   texels = t->pipe->texture_map(t->pipe, t->tex, 0, PIPE_MAP_WRITE, &box,
+                                 &transfer);
+   srand(1);
+   for (i = 0; i < TEXTURE_SIZE * transfer->stride / 4; i++)
+      texels[i] = rand() | 0xff000000;
+   t->pipe->texture_unmap(t->pipe, transfer);
+
+   u_sampler_view_default_template(&view_templ, t->tex, t->tex->format);
+   t->view = t->pipe->create_sampler_view(t->pipe, t->tex, &view_templ);
+
+   templ.width0 = size;
+   templ.height0 = size;
+   templ.bind = PIPE_BIND_RENDER_TARGET;
+   t->cres = t->screen->resource_create(t->screen, &templ);
+   templ.format = PIPE_FORMAT_Z24_UNORM_S8_UINT;
+   templ.bind = PIPE_BIND_DEPTH_STENCIL;
+   t->zsres = t->screen->resource_create(t->screen, &templ);
+
+   memset(&surf_templ, 0, sizeof surf_templ);
+   surf_templ.format = t->cres->format;
+   t->fb.cbufs[0] = t->pipe->create_surface(t->pipe, t->cres, &surf_templ);
+   surf_templ.format = t->zsres->format;
+   t->fb.zsbuf = t->pipe->create_surface(t->pipe, t->zsres, &surf_templ);
+   t->fb.nr_cbufs = 1;
+   t->fb.width = size;
+   t->fb.height = size;
+
+   t->vs = util_make_vertex_passthrough_shader(t->pipe, 2, names, indices,
+                                               FALSE);
+   t->fs_tex = util_make_fragment_tex_shader(t->pipe, TGSI_TEXTURE_2D,
+                                             TGSI_INTERPOLATE_PERSPECTIVE,
+                                             TGSI_RETURN_TYPE_FLOAT,
+                                             TGSI_RETURN_TYPE_FLOAT,
+                                             false, false);
+   if (!tgsi_text_translate(alu_fs_text, tokens, ARRAY_SIZE(tokens)))
+      return FALSE;
+   memset(&fs_state, 0, sizeof fs_state);
+   pipe_shader_state_from_tgsi(&fs_state, tokens);
+   t->fs_alu = t->pipe->create_fs_state(t->pipe, &fs_state);
+
+   return TRUE;
+}
+
+
+static void
+width_test_fini(struct width_test *t)
+{
+   cso_destroy_context(t->cso);
+   t->pipe->delete_vs_state(t->pipe, t->vs);
+   t->pipe->delete_fs_state(t->pipe, t->fs_tex);
+   t->pipe->delete_fs_state(t->pipe, t->fs_alu);
+   pipe_sampler_view_reference(&t->view, NULL);
+   pipe_surface_reference(&t->fb.cbufs[0], NULL);
+   pipe_surface_reference(&t->fb.zsbuf, NULL);
+   pipe_resource_reference(&t->vbuf, NULL);
+   pipe_resource_reference(&t->cres, NULL);
+   pipe_resource_reference(&t->zsres, NULL);
+   pipe_resource_reference(&t->tex, NULL);
+   t->pipe->destroy(t->pipe);
+   t->screen->destroy(t->screen);
+}
+
+
+static void
+bind_workload(struct width_test *t, enum workload w)
+{
+   struct pipe_blend_state blend;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_rasterizer_state rast;
+   struct pipe_sampler_state sampler;
+   const struct pipe_sampler_state *samplers[] = { &sampler };
+   struct pipe_viewport_state vp;
+   struct cso_velems_state velems;
+
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   if (w == WORKLOAD_BLEND) {
+      blend.rt[0].blend_enable = 1;
+      blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+      blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+      blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_COLOR;
+      blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_SRC_COLOR;
+      blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_COLOR;
+      blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_COLOR;
+   }
+
+   memset(&dsa, 0, sizeof dsa);
+   if (w == WORKLOAD_DEPTH) {
+      dsa.depth_enabled = 1;
+      dsa.depth_writemask = 1;
+      dsa.depth_func = PIPE_FUNC_LESS;
+   }
+
+   memset(&rast, 0, sizeof rast);
+   rast.cull_face = PIPE_FACE_NONE;
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+
+   memset(&sampler, 0, sizeof sampler);
+   sampler.wrap_s = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_t = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_r = PIPE_TEX_WRAP_REPEAT;
+   sampler.min_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler.mag_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler.normalized_coords = 1;
+
+   memset(&vp, 0, sizeof vp);
+   vp.scale[0] = vp.scale[1] = t->size / 2.0f;
+   vp.translate[0] = vp.translate[1] = t->size / 2.0f;
+   vp.scale[2] = vp.translate[2] = 0.5f;
+   vp.swizzle_x = PIPE_VIEWPORT_SWIZZLE_POSITIVE_X;
+   vp.swizzle_y = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Y;
+   vp.swizzle_z = PIPE_VIEWPORT_SWIZZLE_POSITIVE_Z;
+   vp.swizzle_w = PIPE_VIEWPORT_SWIZZLE_POSITIVE_W;
+
+   memset(&velems, 0, sizeof velems);
+   velems.count = 2;
+   velems.velems[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   velems.velems[1].src_offset = 16;
+   velems.velems[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   cso_set_framebuffer(t->cso, &t->fb);
+   cso_set_blend(t->cso, &blend);
+   cso_set_depth_stencil_alpha(t->cso, &dsa);
+   cso_set_rasterizer(t->cso, &rast);
+   cso_set_viewport(t->cso, &vp);
+   cso_set_samplers(t->cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+   t->pipe->set_sampler_views(t->pipe, PIPE_SHADER_FRAGMENT, 0, 1, 0, false,
+                              &t->view);
+   cso_set_vertex_elements(t->cso, &velems);
+   cso_set_vertex_shader_handle(t->cso, t->vs);
+   cso_set_fragment_shader_handle(t->cso, w == WORKLOAD_ALU ||
+                                          w == WORKLOAD_DEPTH ?
+                                          t->fs_alu : t->fs_tex);
+}
+
+
+/**
+ * Clear and draw one frame of a workload, and wait for it.  The blended
+ * and depth tested workloads draw two quads, so that the second one
+ * blends with or is rejected by the first.
+ */
+static void
+draw_frame(struct width_test *t, enum workload w)
+{
+   const union pipe_color_union clear_color = {
+      .f = { 0.2f, 0.3f, 0.4f, 1.0f }
+   };
+   struct pipe_fence_handle *fence = NULL;
+   unsigned quads = w == WORKLOAD_BLEND || w == WORKLOAD_DEPTH ? 2 : 1;
+   unsigned i;
+
+   t->pipe->clear(t->pipe, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL, NULL,
+                  &clear_color, 1.0, 0);
+   for (i = 0; i < quads; i++)
+      util_draw_vertex_buffer(t->pipe, t->cso, t->vbuf, 0, 0,
+                              PIPE_PRIM_QUADS, 4, 2);
+   t->pipe->flush(t->pipe, &fence, 0);
+   t->screen->fence_finish(t->screen, NULL, fence, PIPE_TIMEOUT_INFINITE);
+   t->screen->fence_reference(t->screen, &fence, NULL);
+}
+
+
+static void
+read_back(struct width_test *t, uint8_t *data)
+{
+   const unsigned stride = t->size * 4;
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   const uint8_t *map;
+   unsigned y;
+
+   u_box_2d(0, 0, t->size, t->size, &box);
+   map = t->pipe->texture_map(t->pipe, t->cres, 0, PIPE_MAP_READ, &box,
+                              &transfer);
+   for (y = 0; y < t->size; y++)
+      memcpy(data + y * stride, map + y * transfer->stride, stride);
+   t->pipe->texture_unmap(t->pipe, transfer);
+}
+
+
+static unsigned
+get_widths(unsigned *widths)
+{
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+   unsigned n = 0;
+
+   if (caps->has_avx)
+      widths[n++] = 256;
+#if LLVM_VERSION_MAJOR >= 4
+   if (caps->has_avx512f && caps->has_avx512bw &&
+       caps->has_avx512dq && caps->has_avx512vl)
+      widths[n++] = 512;
+#endif
+   return n;
+}
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "width\t"
+           "workload\t"
+           "ms_per_frame\n");
+
+   fflush(fp);
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   const unsigned size = fp ? BENCH_SIZE : CHECK_SIZE;
+   const unsigned native_width = lp_native_vector_width;
+   unsigned widths[2];
+   unsigned nr_widths = get_widths(widths);
+   uint8_t *images[2][NUM_WORKLOADS];
+   boolean success = TRUE;
+   unsigned i, w;
+
+   /* Shaders are compiled for the native width when the context creates
+    * them, so one screen per width is enough.
+    */
+   for (i = 0; i < nr_widths; i++) {
+      struct width_test t;
+
+      lp_native_vector_width = widths[i];
+      if (!width_test_init(&t, size)) {
+         lp_native_vector_width = native_width;
+         return FALSE;
+      }
+
+      for (w = 0; w < NUM_WORKLOADS; w++) {
+         bind_workload(&t, w);
+
+         /* The first frame compiles the shaders. */
+         draw_frame(&t, w);
+         if (fp) {
+            int64_t start = os_time_get_nano();
+            unsigned f;
+
+            for (f = 0; f < BENCH_FRAMES; f++)
+               draw_frame(&t, w);
+
+            fprintf(fp, "%u\t%s\t%.3f\n", widths[i], workload_names[w],
+                    (os_time_get_nano() - start) / 1e6 / BENCH_FRAMES);
+            fflush(fp);
+         }
+
+         images[i][w] = malloc(size * size * 4);
+         read_back(&t, images[i][w]);
+      }
+
+      width_test_fini(&t);
+   }
+
+   lp_native_vector_width = native_width;
+
+   for (w = 0; w < NUM_WORKLOADS; w++) {
+      for (i = 1; i < nr_widths; i++) {
+         if (memcmp(images[0][w], images[i][w], size * size * 4) != 0) {
+            fprintf(stderr, "%s: %u and %u bit images differ\n",
+                    workload_names[w], widths[0], widths[i]);
+            success = FALSE;
+         }
+      }
+      for (i = 0; i < nr_widths; i++)
+         free(images[i][w]);
+   }
+
+   if (verbose)
+      fprintf(stderr, "%u vector widths checked\n", nr_widths);
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 1);
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 1);
+}
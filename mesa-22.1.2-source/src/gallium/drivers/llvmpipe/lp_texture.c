@@ -43,6 +43,8 @@
 #include "util/simple_list.h"
 #include "util/u_transfer.h"
 
+#include "gallivm/lp_bld_sample.h"
+
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_screen.h"
@@ -66,6 +68,53 @@ static mtx_t resource_list_mutex = _MTX_INITIALIZER_NP;
 static unsigned id_counter = 0;
 
 
+/**
+ * Whether to store a texture in tiles (see lp_static_texture_state::tiled).
+ *
+ * Only done for textures that are never rendered to nor used as shader
+ * images, since the rasterizer and the image code address texels row by
+ * row, and only for textures large enough to span several tiles.
+ */
+static boolean
+llvmpipe_texture_use_tiling(const struct llvmpipe_screen *screen,
+                            const struct pipe_resource *pt)
+{
+   const struct util_format_description *desc =
+      util_format_description(pt->format);
+   unsigned tile_size;
+
+   if (!screen->tiled_textures)
+      return FALSE;
+
+   if (pt->bind != PIPE_BIND_SAMPLER_VIEW ||
+       pt->nr_samples > 1 ||
+       (pt->flags & (PIPE_RESOURCE_FLAG_MAP_PERSISTENT |
+                     PIPE_RESOURCE_FLAG_MAP_COHERENT |
+                     PIPE_RESOURCE_FLAG_SPARSE)))
+      return FALSE;
+
+   switch (pt->target) {
+   case PIPE_TEXTURE_2D:
+   case PIPE_TEXTURE_2D_ARRAY:
+   case PIPE_TEXTURE_RECT:
+   case PIPE_TEXTURE_3D:
+   case PIPE_TEXTURE_CUBE:
+   case PIPE_TEXTURE_CUBE_ARRAY:
+      break;
+   default:
+      return FALSE;
+   }
+
+   if (desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.bits % 8 != 0)
+      return FALSE;
+
+   tile_size = 1 << lp_sampler_tile_log2(desc->block.bits / 8);
+
+   return pt->width0 >= 4 * tile_size && pt->height0 >= 4 * tile_size;
+}
+
+
 /**
  * Conventional allocation path for non-display textures:
  * Compute strides and allocate data (unless asked not to).
@@ -96,6 +145,11 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
    assert(LP_MAX_TEXTURE_2D_LEVELS <= LP_MAX_TEXTURE_LEVELS);
    assert(LP_MAX_TEXTURE_3D_LEVELS <= LP_MAX_TEXTURE_LEVELS);
 
+   /* Only textures with storage of their own may be tiled, memory
+    * objects and user memory keep the layout the caller expects.
+    */
+   lpr->tiled = allocate && llvmpipe_texture_use_tiling(screen, pt);
+
    for (level = 0; level <= pt->last_level; level++) {
       uint64_t mipsize;
       unsigned align_x, align_y, nblocksx, nblocksy, block_size, num_slices;
@@ -126,12 +180,24 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
                                           align(height, align_y));
       block_size = util_format_get_blocksize(pt->format);
 
-      if (util_format_is_compressed(pt->format))
-         lpr->row_stride[level] = nblocksx * block_size;
-      else
-         lpr->row_stride[level] = align(nblocksx * block_size, util_get_cpu_caps()->cacheline);
+      if (lpr->tiled) {
+         /* Row stride is the size of a row of tiles. */
+         const unsigned tile_log2 = lp_sampler_tile_log2(block_size);
+         const unsigned tile_size = 1 << tile_log2;
 
-      lpr->img_stride[level] = (uint64_t)lpr->row_stride[level] * nblocksy;
+         lpr->row_stride[level] = DIV_ROUND_UP(nblocksx, tile_size) *
+                                  (block_size << (2 * tile_log2));
+         lpr->img_stride[level] = (uint64_t)lpr->row_stride[level] *
+                                  DIV_ROUND_UP(nblocksy, tile_size);
+      }
+      else {
+         if (util_format_is_compressed(pt->format))
+            lpr->row_stride[level] = nblocksx * block_size;
+         else
+            lpr->row_stride[level] = align(nblocksx * block_size, util_get_cpu_caps()->cacheline);
+
+         lpr->img_stride[level] = (uint64_t)lpr->row_stride[level] * nblocksy;
+      }
 
       /* Number of 3D image slices, cube faces or texture array layers */
       if (lpr->base.target == PIPE_TEXTURE_CUBE) {
@@ -466,6 +532,8 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    mtx_unlock(&resource_list_mutex);
 #endif
 
+   FREE(lpr->hiz);
+   FREE(lpr->fast_clear);
    FREE(lpr);
 }
 
@@ -589,6 +657,9 @@ llvmpipe_resource_from_handle(struct pipe_screen *_screen,
    assert(lpr->base.height0 == height);
 #endif
 
+   /* Others may write it. */
+   lpr->no_fast_clear = true;
+
    lpr->dt = winsys->displaytarget_from_handle(winsys,
                                                template,
                                                whandle,
@@ -628,6 +699,8 @@ llvmpipe_resource_get_handle(struct pipe_screen *screen,
    if (!lpr->dt)
       return false;
 
+   lpr->no_fast_clear = true;
+
    return winsys->displaytarget_get_handle(winsys, lpr->dt, whandle);
 }
 
@@ -668,6 +741,66 @@ fail:
    return NULL;
 }
 
+/**
+ * Move bit i of v to bit 2*i, for the Morton order inside a tile.
+ */
+static inline unsigned
+spread_bits(unsigned v)
+{
+   v = (v | (v << 8)) & 0x00ff00ff;
+   v = (v | (v << 4)) & 0x0f0f0f0f;
+   v = (v | (v << 2)) & 0x33333333;
+   v = (v | (v << 1)) & 0x55555555;
+   return v;
+}
+
+
+/**
+ * Copy a box of a tiled texture level to or from a linear buffer.  This
+ * is the CPU side of the addressing lp_build_sample_offset() does for
+ * tiled textures.
+ */
+void
+llvmpipe_tiled_copy_box(struct llvmpipe_resource *lpr,
+                        unsigned level,
+                        const struct pipe_box *box,
+                        uint8_t *linear,
+                        unsigned stride,
+                        unsigned layer_stride,
+                        boolean to_tiled)
+{
+   const unsigned block_bytes = util_format_get_blocksize(lpr->base.format);
+   const unsigned tile_log2 = lp_sampler_tile_log2(block_bytes);
+   const unsigned tile_mask = (1 << tile_log2) - 1;
+   const unsigned tile_bytes = block_bytes << (2 * tile_log2);
+   const unsigned row_stride = lpr->row_stride[level];
+   int x, y, z;
+
+   for (z = 0; z < box->depth; z++) {
+      uint8_t *image = llvmpipe_get_texture_image_address(lpr, box->z + z,
+                                                          level);
+
+      for (y = 0; y < box->height; y++) {
+         const unsigned ty = box->y + y;
+         uint8_t *tile_row = image + (ty >> tile_log2) * row_stride;
+         const unsigned y_morton = spread_bits(ty & tile_mask) << 1;
+         uint8_t *row = linear + z * layer_stride + y * stride;
+
+         for (x = 0; x < box->width; x++) {
+            const unsigned tx = box->x + x;
+            uint8_t *texel = tile_row + (tx >> tile_log2) * tile_bytes +
+               (spread_bits(tx & tile_mask) | y_morton) * block_bytes;
+
+            if (to_tiled)
+               memcpy(texel, row + x * block_bytes, block_bytes);
+            else
+               memcpy(row + x * block_bytes, texel, block_bytes);
+         }
+      }
+   }
+}
+
+
 void *
 llvmpipe_transfer_map_ms( struct pipe_context *pipe,
                           struct pipe_resource *resource,
@@ -690,6 +823,11 @@ llvmpipe_transfer_map_ms( struct pipe_context *pipe,
    assert(resource);
    assert(level <= resource->last_level);
 
+   /* Tiled textures are only ever mapped through a linear copy. */
+   if (llvmpipe_resource(resource)->tiled &&
+       (usage & (PIPE_MAP_DIRECTLY | PIPE_MAP_PERSISTENT)))
+      return NULL;
+
    /*
     * Transfers, like other pipe operations, must happen in order, so flush the
     * context if necessary.
@@ -761,6 +899,32 @@ llvmpipe_transfer_map_ms( struct pipe_context *pipe,
 
    format = lpr->base.format;
 
+   if (lpr->tiled) {
+      /* Detile the box into a linear copy, which is tiled again on unmap
+       * if it was mapped for writing.
+       */
+      pt->stride = box->width * util_format_get_blocksize(format);
+      pt->layer_stride = pt->stride * box->height;
+
+      lpt->staging = align_malloc((size_t)pt->layer_stride * box->depth, 64);
+      if (!lpt->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(lpt);
+         *transfer = NULL;
+         return NULL;
+      }
+
+      if (!(usage & (PIPE_MAP_DISCARD_RANGE |
+                     PIPE_MAP_DISCARD_WHOLE_RESOURCE)))
+         llvmpipe_tiled_copy_box(lpr, level, box, lpt->staging,
+                                 pt->stride, pt->layer_stride, FALSE);
+
+      if (usage & PIPE_MAP_WRITE)
+         screen->timestamp++;
+
+      return lpt->staging;
+   }
+
    map = llvmpipe_resource_map(resource,
                                level,
                                box->z,
@@ -774,6 +938,12 @@ llvmpipe_transfer_map_ms( struct pipe_context *pipe,
       /* Do something to notify sharing contexts of a texture change.
        */
       screen->timestamp++;
+
+      /* The depth bounds and clear state don't know what gets written
+       * here.
+       */
+      lpr->hiz_valid = false;
+      lpr->fast_clear_valid = false;
    }
 
    map +=
@@ -799,11 +969,23 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
+
    assert(transfer->resource);
 
-   llvmpipe_resource_unmap(transfer->resource,
-                           transfer->level,
-                           transfer->box.z);
+   if (lpt->staging) {
+      if (transfer->usage & PIPE_MAP_WRITE)
+         llvmpipe_tiled_copy_box(llvmpipe_resource(transfer->resource),
+                                 transfer->level, &transfer->box,
+                                 lpt->staging, transfer->stride,
+                                 transfer->layer_stride, TRUE);
+      align_free(lpt->staging);
+   }
+   else {
+      llvmpipe_resource_unmap(transfer->resource,
+                              transfer->level,
+                              transfer->box.z);
+   }
 
    /* Effectively do the texture_update work here - if texture images
     * needed post-processing to put them into hardware layout, this is
@@ -820,7 +1002,12 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
                                  unsigned level)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
-   if (!(presource->bind & (PIPE_BIND_DEPTH_STENCIL |
+
+   /* Buffers may be bound as shader images or buffers whatever they were
+    * created for.
+    */
+   if (presource->target != PIPE_BUFFER &&
+       !(presource->bind & (PIPE_BIND_DEPTH_STENCIL |
                             PIPE_BIND_RENDER_TARGET |
                             PIPE_BIND_SAMPLER_VIEW |
                             PIPE_BIND_SHADER_BUFFER |
@@ -949,8 +1136,15 @@ static void
 llvmpipe_memory_barrier(struct pipe_context *pipe,
 			unsigned flags)
 {
-   /* this may be an overly large hammer for this nut. */
-   llvmpipe_finish(pipe, "barrier");
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   /* Scenes are rasterized in order, so the fragment shaders of later
+    * scenes see whatever earlier ones wrote, and CPU access waits for the
+    * scenes referencing the resource.  Only vertex processing and compute
+    * shaders, which don't run on the rasterizer threads, may need to wait
+    * for the scenes queued here: see llvmpipe_wait_barrier().
+    */
+   llvmpipe_flush(pipe, &llvmpipe->barrier_fence, "barrier");
 }
 
 static struct pipe_memory_allocation *llvmpipe_allocate_memory(struct pipe_screen *screen, uint64_t size)
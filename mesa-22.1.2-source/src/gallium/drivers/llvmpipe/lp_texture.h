@@ -48,6 +48,8 @@ struct llvmpipe_context;
 struct llvmpipe_screen;
 
 struct sw_displaytarget;
+struct lp_hiz_tile;
+struct lp_fast_clear_tile;
 
 
 /**
@@ -100,6 +102,29 @@ struct llvmpipe_resource
    uint64_t backing_offset;
    bool backable;
    bool imported_memory;
+
+   /**
+    * Texels are stored in tiles (see lp_static_texture_state::tiled),
+    * which only llvmpipe's own samplers and transfers know about.
+    */
+   bool tiled;
+
+   /**
+    * Conservative depth bounds of level 0, per 64x64 tile, maintained by
+    * the rasterizer for depth buffers (see lp_rast_hiz.c).
+    */
+   struct lp_hiz_tile *hiz;
+   enum pipe_format hiz_format;  /**< surface format the bounds are for */
+   bool hiz_valid;
+
+   /**
+    * What is known to be cleared in level 0, per 64x64 tile, maintained by
+    * the rasterizer for render targets (see lp_rast_fast_clear.c).
+    */
+   struct lp_fast_clear_tile *fast_clear;
+   bool fast_clear_valid;
+   /** Written other than by the rasterizer or transfers, e.g. as an image */
+   bool no_fast_clear;
 #ifdef DEBUG
    /** for linked list */
    struct llvmpipe_resource *prev, *next;
@@ -110,6 +135,9 @@ struct llvmpipe_resource
 struct llvmpipe_transfer
 {
    struct pipe_transfer base;
+
+   /** Linear copy of the box, for textures stored in tiles */
+   void *staging;
 };
 
 struct llvmpipe_memory_object
@@ -174,6 +202,17 @@ llvmpipe_resource_is_texture(const struct pipe_resource *resource)
 }
 
 
+/**
+ * Whether the texture of a sampler view is stored in tiles.
+ */
+static inline boolean
+llvmpipe_sampler_view_is_tiled(const struct pipe_sampler_view *view)
+{
+   return view && view->texture &&
+          llvmpipe_resource_const(view->texture)->tiled;
+}
+
+
 static inline boolean
 llvmpipe_resource_is_1d(const struct pipe_resource *resource)
 {
@@ -247,6 +286,16 @@ llvmpipe_get_texture_image_address(struct llvmpipe_resource *lpr,
                                    unsigned face_slice, unsigned level);
 
 
+void
+llvmpipe_tiled_copy_box(struct llvmpipe_resource *lpr,
+                        unsigned level,
+                        const struct pipe_box *box,
+                        uint8_t *linear,
+                        unsigned stride,
+                        unsigned layer_stride,
+                        boolean to_tiled);
+
+
 extern void
 llvmpipe_print_resources(void);
 
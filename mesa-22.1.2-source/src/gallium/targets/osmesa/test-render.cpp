@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 
+#define GL_GLEXT_PROTOTYPES
 #include "GL/osmesa.h"
 #include "util/macros.h"
 #include "util/u_endian.h"
@@ -308,3 +309,379 @@ TEST(OSMesaRenderTest, resize)
       EXPECT_EQ(draw2[i], be_bswap32(0x0000ff00));
    EXPECT_EQ(draw1[0], be_bswap32(0x000000ff));
 }
+
+static void
+half_quad(float x0, float x1)
+{
+   glVertex2f(x0, -1);
+   glVertex2f(x1, -1);
+   glVertex2f(x1, 1);
+   glVertex2f(x0, -1);
+   glVertex2f(x1, 1);
+   glVertex2f(x0, 1);
+}
+
+/* The draws of consecutive display lists are merged, and their copy to the
+ * current attribs has to happen in order with the draws of the next lists.
+ */
+TEST(OSMesaRenderTest, display_list_current_color)
+{
+   std::unique_ptr<osmesa_context, decltype(&OSMesaDestroyContext)> ctx{
+      OSMesaCreateContext(GL_RGBA, NULL), &OSMesaDestroyContext};
+   ASSERT_TRUE(ctx);
+
+   uint32_t pixels[2];
+   ASSERT_EQ(OSMesaMakeCurrent(ctx.get(), pixels, GL_UNSIGNED_BYTE, 2, 1), GL_TRUE);
+
+   GLuint lists = glGenLists(3);
+
+   glNewList(lists, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   glColor3f(1, 0, 0);
+   half_quad(-1, 0);
+   glEnd();
+   glEndList();
+
+   glNewList(lists + 1, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   glColor3f(0, 0, 1);
+   half_quad(0, 1);
+   glEnd();
+   glEndList();
+
+   /* No color, so this one uses the current color of the previous list. */
+   glNewList(lists + 2, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   half_quad(0, 1);
+   glEnd();
+   glEndList();
+
+   static const GLubyte both[] = { 0, 1 };
+   glColor3f(0, 1, 0);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glListBase(lists);
+   glCallLists(2, GL_UNSIGNED_BYTE, both);
+   glFinish();
+   EXPECT_EQ(pixels[0], be_bswap32(0xff0000ff));
+   EXPECT_EQ(pixels[1], be_bswap32(0xffff0000));
+
+   GLfloat color[4];
+   glGetFloatv(GL_CURRENT_COLOR, color);
+   EXPECT_EQ(color[0], 0.0f);
+   EXPECT_EQ(color[1], 0.0f);
+   EXPECT_EQ(color[2], 1.0f);
+
+   static const GLubyte first_and_no_color[] = { 0, 2 };
+   glColor3f(0, 1, 0);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glCallLists(2, GL_UNSIGNED_BYTE, first_and_no_color);
+   glFinish();
+   EXPECT_EQ(pixels[0], be_bswap32(0xff0000ff));
+   EXPECT_EQ(pixels[1], be_bswap32(0xff0000ff));
+
+   glDeleteLists(lists, 3);
+}
+
+TEST(OSMesaRenderTest, display_list_material)
+{
+   std::unique_ptr<osmesa_context, decltype(&OSMesaDestroyContext)> ctx{
+      OSMesaCreateContext(GL_RGBA, NULL), &OSMesaDestroyContext};
+   ASSERT_TRUE(ctx);
+
+   uint32_t pixels[2];
+   ASSERT_EQ(OSMesaMakeCurrent(ctx.get(), pixels, GL_UNSIGNED_BYTE, 2, 1), GL_TRUE);
+
+   static const GLfloat black[] = { 0, 0, 0, 1 };
+   static const GLfloat green[] = { 0, 1, 0, 1 };
+   static const GLfloat blue[] = { 0, 0, 1, 1 };
+
+   glLightModelfv(GL_LIGHT_MODEL_AMBIENT, black);
+   glEnable(GL_LIGHTING);
+   glEnable(GL_LIGHT0);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, blue);
+   glNormal3f(0, 0, 1);
+
+   GLuint lists = glGenLists(2);
+
+   glNewList(lists, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, green);
+   half_quad(-1, 0);
+   glEnd();
+   glEndList();
+
+   /* Lit with the material set by the previous list. */
+   glNewList(lists + 1, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   half_quad(0, 1);
+   glEnd();
+   glEndList();
+
+   static const GLubyte both[] = { 0, 1 };
+   glClear(GL_COLOR_BUFFER_BIT);
+   glListBase(lists);
+   glCallLists(2, GL_UNSIGNED_BYTE, both);
+   glFinish();
+   EXPECT_EQ(pixels[0], be_bswap32(0xff00ff00));
+   EXPECT_EQ(pixels[1], be_bswap32(0xff00ff00));
+
+   /* The same with ColorMaterial, where the color of the first list sets the
+    * material.
+    */
+   glNewList(lists, GL_COMPILE);
+   glBegin(GL_TRIANGLES);
+   glColor3f(1, 0, 0);
+   half_quad(-1, 0);
+   glEnd();
+   glEndList();
+
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, blue);
+   glColor3f(0, 0, 1);
+   glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+   glEnable(GL_COLOR_MATERIAL);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glCallLists(2, GL_UNSIGNED_BYTE, both);
+   glFinish();
+   EXPECT_EQ(pixels[0], be_bswap32(0xff0000ff));
+   EXPECT_EQ(pixels[1], be_bswap32(0xff0000ff));
+
+   glDeleteLists(lists, 2);
+}
+
+static const int barrier_size = 8;
+
+class OSMesaBarrierTest : public testing::Test {
+protected:
+   void SetUp() override
+   {
+      static const int attribs[] = {
+         OSMESA_FORMAT, OSMESA_RGBA,
+         OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+         OSMESA_CONTEXT_MAJOR_VERSION, 4,
+         OSMESA_CONTEXT_MINOR_VERSION, 5,
+         0
+      };
+
+      ctx = OSMesaCreateContextAttribs(attribs, NULL);
+      ASSERT_TRUE(ctx);
+      ASSERT_EQ(OSMesaMakeCurrent(ctx, pixels, GL_UNSIGNED_BYTE,
+                                  barrier_size, barrier_size), GL_TRUE);
+
+      glGenVertexArrays(1, &vao);
+      glBindVertexArray(vao);
+   }
+
+   void TearDown() override
+   {
+      glDeleteVertexArrays(1, &vao);
+      if (ctx)
+         OSMesaDestroyContext(ctx);
+   }
+
+   GLuint
+   program(const char *vs, const char *fs)
+   {
+      GLuint prog = glCreateProgram();
+      attach(prog, GL_VERTEX_SHADER, vs);
+      attach(prog, GL_FRAGMENT_SHADER, fs);
+      return link(prog);
+   }
+
+   GLuint
+   compute_program(const char *cs)
+   {
+      GLuint prog = glCreateProgram();
+      attach(prog, GL_COMPUTE_SHADER, cs);
+      return link(prog);
+   }
+
+   /* Writes pixel index + 1 to element pixel index of the buffer at binding
+    * 0 for every pixel of the framebuffer.
+    */
+   void
+   write_buffer_in_fs()
+   {
+      GLuint prog = program(
+         "#version 450\n"
+         "void main() {\n"
+         "   vec2 pos = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 4.0 - 1.0;\n"
+         "   gl_Position = vec4(pos, 0.0, 1.0);\n"
+         "}\n",
+         "#version 450\n"
+         "layout(std430, binding = 0) buffer B { uint v[]; };\n"
+         "out vec4 color;\n"
+         "void main() {\n"
+         "   uint i = uint(gl_FragCoord.y) * 8u + uint(gl_FragCoord.x);\n"
+         "   v[i] = i + 1u;\n"
+         "   color = vec4(0.0);\n"
+         "}\n");
+      glUseProgram(prog);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      glDeleteProgram(prog);
+   }
+
+   OSMesaContext ctx = NULL;
+   uint32_t pixels[barrier_size * barrier_size];
+   GLuint vao = 0;
+
+private:
+   void
+   attach(GLuint prog, GLenum type, const char *source)
+   {
+      GLuint shader = glCreateShader(type);
+      glShaderSource(shader, 1, &source, NULL);
+      glCompileShader(shader);
+
+      GLint status;
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+      EXPECT_EQ(status, GL_TRUE);
+
+      glAttachShader(prog, shader);
+      glDeleteShader(shader);
+   }
+
+   GLuint
+   link(GLuint prog)
+   {
+      GLint status;
+      glLinkProgram(prog);
+      glGetProgramiv(prog, GL_LINK_STATUS, &status);
+      EXPECT_EQ(status, GL_TRUE);
+      return prog;
+   }
+};
+
+/* Fragment shader writes, then compute shader reads. */
+TEST_F(OSMesaBarrierTest, fs_write_cs_read)
+{
+   const unsigned n = barrier_size * barrier_size;
+   GLuint bufs[2];
+
+   glGenBuffers(2, bufs);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufs[0]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, n * 4, NULL, GL_DYNAMIC_COPY);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufs[1]);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, n * 4, NULL, GL_DYNAMIC_COPY);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bufs[0]);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bufs[1]);
+
+   write_buffer_in_fs();
+   glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+   GLuint prog = compute_program(
+      "#version 450\n"
+      "layout(local_size_x = 64) in;\n"
+      "layout(std430, binding = 0) buffer B { uint v[]; };\n"
+      "layout(std430, binding = 1) buffer C { uint w[]; };\n"
+      "void main() {\n"
+      "   w[gl_GlobalInvocationID.x] = v[gl_GlobalInvocationID.x] * 2u;\n"
+      "}\n");
+   glUseProgram(prog);
+   glDispatchCompute(n / 64, 1, 1);
+   glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+   uint32_t data[barrier_size * barrier_size];
+   glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(data), data);
+   for (unsigned i = 0; i < n; i++)
+      EXPECT_EQ(data[i], (i + 1) * 2);
+
+   glDeleteProgram(prog);
+   glDeleteBuffers(2, bufs);
+   EXPECT_EQ(glGetError(), GL_NO_ERROR);
+}
+
+/* Fragment shader writes, then vertex shader reads.  The same program does
+ * both, so that nothing but the barrier orders them.
+ */
+TEST_F(OSMesaBarrierTest, fs_write_vs_read)
+{
+   const unsigned n = barrier_size * barrier_size;
+   GLuint buf;
+
+   glGenBuffers(1, &buf);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+   glBufferData(GL_SHADER_STORAGE_BUFFER, n * 4, NULL, GL_DYNAMIC_COPY);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buf);
+
+   /* Pass 0 covers the framebuffer and writes pixel index + 1 for every
+    * pixel.  Pass 1 draws one point per pixel, red if the vertex shader
+    * read the value written for that pixel.
+    */
+   GLuint prog = program(
+      "#version 450\n"
+      "layout(std430, binding = 0) buffer B { uint v[]; };\n"
+      "uniform int pass;\n"
+      "out vec4 vcolor;\n"
+      "void main() {\n"
+      "   uint i = uint(gl_VertexID);\n"
+      "   if (pass == 0) {\n"
+      "      vec2 pos = vec2(i & 1u, i >> 1u) * 4.0 - 1.0;\n"
+      "      gl_Position = vec4(pos, 0.0, 1.0);\n"
+      "      vcolor = vec4(0.0);\n"
+      "   } else {\n"
+      "      vec2 pos = (vec2(i % 8u, i / 8u) + 0.5) / 4.0 - 1.0;\n"
+      "      gl_Position = vec4(pos, 0.0, 1.0);\n"
+      "      vcolor = v[i] == i + 1u ? vec4(1, 0, 0, 1) : vec4(0, 0, 1, 1);\n"
+      "   }\n"
+      "}\n",
+      "#version 450\n"
+      "layout(std430, binding = 0) buffer B { uint v[]; };\n"
+      "uniform int pass;\n"
+      "in vec4 vcolor;\n"
+      "out vec4 color;\n"
+      "void main() {\n"
+      "   if (pass == 0)\n"
+      "      v[uint(gl_FragCoord.y) * 8u + uint(gl_FragCoord.x)] =\n"
+      "         uint(gl_FragCoord.y) * 8u + uint(gl_FragCoord.x) + 1u;\n"
+      "   color = vcolor;\n"
+      "}\n");
+   GLint pass = glGetUniformLocation(prog, "pass");
+
+   glUseProgram(prog);
+   glUniform1i(pass, 0);
+   glDrawArrays(GL_TRIANGLES, 0, 3);
+   glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+   glUniform1i(pass, 1);
+   glDrawArrays(GL_POINTS, 0, n);
+   glFinish();
+
+   for (unsigned i = 0; i < n; i++)
+      EXPECT_EQ(pixels[i], be_bswap32(0xff0000ff));
+
+   glDeleteProgram(prog);
+   glDeleteBuffers(1, &buf);
+   EXPECT_EQ(glGetError(), GL_NO_ERROR);
+}
+
+/* Fragment shader writes, then the CPU reads a persistent mapping. */
+TEST_F(OSMesaBarrierTest, fs_write_persistent_map_read)
+{
+   const unsigned n = barrier_size * barrier_size;
+   const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT;
+   GLuint buf;
+
+   glGenBuffers(1, &buf);
+   glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+   glBufferStorage(GL_SHADER_STORAGE_BUFFER, n * 4, NULL, flags);
+   const uint32_t *map = (const uint32_t *)
+      glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, n * 4, flags);
+   ASSERT_TRUE(map);
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buf);
+
+   write_buffer_in_fs();
+   glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+   GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    GL_TIMEOUT_IGNORED);
+   ASSERT_TRUE(status == GL_ALREADY_SIGNALED ||
+               status == GL_CONDITION_SATISFIED);
+   glDeleteSync(fence);
+
+   for (unsigned i = 0; i < n; i++)
+      EXPECT_EQ(map[i], i + 1);
+
+   glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+   glDeleteBuffers(1, &buf);
+   EXPECT_EQ(glGetError(), GL_NO_ERROR);
+}
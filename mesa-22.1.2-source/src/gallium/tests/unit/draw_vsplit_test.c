@@ -0,0 +1,283 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Splits indexed triangle lists with the vsplit front end into a middle
+ * end that checks every segment against the original index sequence, with
+ * and without the render's index limit, and checks that the vertex cache
+ * reorder only changes the order of the triangles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "draw/draw_private.h"
+#include "draw/draw_pt.h"
+#include "draw/draw_vbuf.h"
+#include "util/u_memory.h"
+
+#define GRID 256
+#define MAX_VERTICES 4096
+
+/* i915's (4096 - 430 * 4) / 2 */
+#define I915_MAX_INDICES 1188
+
+struct test_middle_end {
+   struct draw_pt_middle_end base;
+   const unsigned *ref;
+   unsigned ref_count;
+   unsigned pos;
+   unsigned max_draw_count;
+   unsigned invocations;
+   unsigned errors;
+};
+
+static void
+test_prepare(struct draw_pt_middle_end *middle, unsigned prim, unsigned opt,
+             unsigned *max_vertices)
+{
+   *max_vertices = MAX_VERTICES;
+}
+
+static void
+test_check(struct test_middle_end *test, const unsigned *fetch_elts,
+           unsigned fetch_start, unsigned fetch_count,
+           const ushort *draw_elts, unsigned draw_count)
+{
+   unsigned i;
+
+   test->invocations += fetch_count;
+   test->max_draw_count = MAX2(test->max_draw_count, draw_count);
+
+   if (fetch_count > MAX_VERTICES)
+      test->errors++;
+
+   for (i = 0; i < draw_count; i++) {
+      unsigned elt;
+
+      if (draw_elts[i] >= fetch_count) {
+         test->errors++;
+         continue;
+      }
+
+      elt = fetch_elts ? fetch_elts[draw_elts[i]] : fetch_start + draw_elts[i];
+      if (test->pos >= test->ref_count || elt != test->ref[test->pos])
+         test->errors++;
+      test->pos++;
+   }
+}
+
+static void
+test_run(struct draw_pt_middle_end *middle, const unsigned *fetch_elts,
+         unsigned fetch_count, const ushort *draw_elts, unsigned draw_count,
+         unsigned prim_flags)
+{
+   test_check((struct test_middle_end *) middle, fetch_elts, 0, fetch_count,
+              draw_elts, draw_count);
+}
+
+static boolean
+test_run_linear_elts(struct draw_pt_middle_end *middle, unsigned fetch_start,
+                     unsigned fetch_count, const ushort *draw_elts,
+                     unsigned draw_count, unsigned prim_flags)
+{
+   test_check((struct test_middle_end *) middle, NULL, fetch_start,
+              fetch_count, draw_elts, draw_count);
+   return TRUE;
+}
+
+/* Splits the triangle list and checks that the middle end sees exactly the
+ * same indices, and no more than max_indices at a time if there's a limit.
+ */
+static boolean
+test_split(const char *name, const unsigned *elts, unsigned count,
+           unsigned max_indices)
+{
+   struct draw_context *draw = CALLOC_STRUCT(draw_context);
+   struct vbuf_render render;
+   struct test_middle_end test;
+   struct draw_pt_front_end *frontend;
+   boolean success;
+
+   memset(&test, 0, sizeof test);
+   test.base.prepare = test_prepare;
+   test.base.run = test_run;
+   test.base.run_linear_elts = test_run_linear_elts;
+   test.ref = elts;
+   test.ref_count = count;
+
+   memset(&render, 0, sizeof render);
+   render.max_indices = max_indices;
+   if (max_indices)
+      draw->render = &render;
+
+   draw->pt.user.elts = elts;
+   draw->pt.user.eltSize = 4;
+   draw->pt.user.eltMax = count;
+   draw->pt.user.min_index = 0;
+   draw->pt.user.max_index = ~0;
+
+   frontend = draw_pt_vsplit(draw);
+   frontend->prepare(frontend, PIPE_PRIM_TRIANGLES, &test.base, 0);
+   frontend->run(frontend, 0, count);
+   frontend->destroy(frontend);
+   FREE(draw);
+
+   if (test.pos != count)
+      test.errors++;
+   if (max_indices && test.max_draw_count > max_indices)
+      test.errors++;
+
+   success = test.errors == 0;
+   printf("%s: %u triangles, %.3f invocations per triangle, "
+          "at most %u indices at once: %s\n",
+          name, count / 3, (double) test.invocations / (count / 3),
+          test.max_draw_count, success ? "ok" : "FAIL");
+   return success;
+}
+
+static int
+compare_triangle(const void *a, const void *b)
+{
+   const unsigned *ta = a, *tb = b;
+   unsigned i;
+
+   for (i = 0; i < 3; i++) {
+      if (ta[i] != tb[i])
+         return ta[i] < tb[i] ? -1 : 1;
+   }
+   return 0;
+}
+
+/* Same triangles, each with its vertices in the same order. */
+static boolean
+same_triangles(const unsigned *a, const unsigned *b, unsigned count)
+{
+   unsigned *sa = MALLOC(count * sizeof *sa);
+   unsigned *sb = MALLOC(count * sizeof *sb);
+   boolean same;
+
+   memcpy(sa, a, count * sizeof *sa);
+   memcpy(sb, b, count * sizeof *sb);
+   qsort(sa, count / 3, 3 * sizeof *sa, compare_triangle);
+   qsort(sb, count / 3, 3 * sizeof *sb, compare_triangle);
+   same = memcmp(sa, sb, count * sizeof *sa) == 0;
+
+   FREE(sa);
+   FREE(sb);
+   return same;
+}
+
+static const unsigned *
+test_reorder(struct draw_context *draw, const unsigned *elts, unsigned count)
+{
+   struct pipe_draw_info info;
+   struct pipe_draw_start_count_bias draw_info;
+   const void *reordered;
+
+   memset(&info, 0, sizeof info);
+   info.mode = PIPE_PRIM_TRIANGLES;
+   info.index_size = 4;
+
+   memset(&draw_info, 0, sizeof draw_info);
+   draw_info.start = 0;
+   draw_info.count = count;
+
+   draw->pt.user.elts = elts;
+   draw->pt.user.eltSize = 4;
+   draw->pt.user.eltMax = count;
+
+   /* only index buffers drawn again get reordered */
+   reordered = draw_pt_reorder_elts(draw, &info, &draw_info);
+   if (reordered)
+      return NULL;
+
+   return draw_pt_reorder_elts(draw, &info, &draw_info);
+}
+
+int main(int argc, char **argv)
+{
+   const unsigned num_tris = (GRID - 1) * (GRID - 1) * 2;
+   const unsigned count = num_tris * 3;
+   unsigned *elts = MALLOC(count * sizeof *elts);
+   boolean success = TRUE;
+   unsigned x, y, i, j, n = 0;
+   int shuffled;
+
+   for (y = 0; y < GRID - 1; y++) {
+      for (x = 0; x < GRID - 1; x++) {
+         const unsigned a = y * GRID + x, b = a + 1, c = a + GRID, d = c + 1;
+
+         elts[n++] = a; elts[n++] = b; elts[n++] = c;
+         elts[n++] = b; elts[n++] = d; elts[n++] = c;
+      }
+   }
+
+   for (shuffled = 0; shuffled <= 1; shuffled++) {
+      struct draw_context *draw = CALLOC_STRUCT(draw_context);
+      const char *name = shuffled ? "shuffled" : "ordered";
+      const unsigned *reordered;
+      char label[64];
+
+      if (shuffled) {
+         srand(1);
+         for (i = num_tris - 1; i > 0; i--) {
+            const unsigned r = rand() % (i + 1);
+
+            for (j = 0; j < 3; j++) {
+               const unsigned tmp = elts[i * 3 + j];
+               elts[i * 3 + j] = elts[r * 3 + j];
+               elts[r * 3 + j] = tmp;
+            }
+         }
+      }
+
+      success &= test_split(name, elts, count, 0);
+
+      snprintf(label, sizeof label, "%s, %u indices", name, I915_MAX_INDICES);
+      success &= test_split(label, elts, count, I915_MAX_INDICES);
+
+      reordered = test_reorder(draw, elts, count);
+      if (!reordered || !same_triangles(elts, reordered, count)) {
+         printf("%s: reorder changed the triangles\n", name);
+         success = FALSE;
+      } else {
+         snprintf(label, sizeof label, "%s, reordered", name);
+         success &= test_split(label, reordered, count, 0);
+      }
+
+      draw_pt_reorder_destroy(draw);
+      FREE(draw);
+   }
+
+   FREE(elts);
+
+   if (!success) {
+      printf("Failure!\n");
+      return 1;
+   }
+
+   printf("Success!\n");
+   return 0;
+}
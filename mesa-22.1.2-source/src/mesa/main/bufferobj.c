@@ -559,7 +559,7 @@ bufferobj_copy_subdata(struct gl_context *ctx,
    struct pipe_context *pipe = ctx->pipe;
    struct pipe_box box;
 
-   dst->MinMaxCacheDirty = true;
+   vbo_minmax_cache_invalidate(dst, writeOffset, size);
    if (!size)
       return;
 
@@ -2195,7 +2195,7 @@ buffer_storage(struct gl_context *ctx, struct gl_buffer_object *bufObj,
 
    bufObj->Written = GL_TRUE;
    bufObj->Immutable = GL_TRUE;
-   bufObj->MinMaxCacheDirty = true;
+   vbo_minmax_cache_invalidate(bufObj, 0, bufObj->Size);
 
    if (memObj) {
       res = bufferobj_data_mem(ctx, target, size, memObj, offset,
@@ -2440,7 +2440,7 @@ buffer_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
    FLUSH_VERTICES(ctx, 0, 0);
 
    bufObj->Written = GL_TRUE;
-   bufObj->MinMaxCacheDirty = true;
+   vbo_minmax_cache_invalidate(bufObj, 0, bufObj->Size);
 
 #ifdef VBO_DEBUG
    printf("glBufferDataARB(%u, sz %ld, from %p, usage 0x%x)\n",
@@ -2628,7 +2628,7 @@ _mesa_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
 
    bufObj->NumSubDataCalls++;
    bufObj->Written = GL_TRUE;
-   bufObj->MinMaxCacheDirty = true;
+   vbo_minmax_cache_invalidate(bufObj, offset, size);
 
    _mesa_bufferobj_subdata(ctx, offset, size, data, bufObj);
 }
@@ -2833,7 +2833,7 @@ clear_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
    if (size == 0)
       return;
 
-   bufObj->MinMaxCacheDirty = true;
+   vbo_minmax_cache_invalidate(bufObj, offset, size);
 
    if (!ctx->pipe->clear_buffer) {
       clear_buffer_subdata_sw(ctx, offset, size,
@@ -3749,7 +3749,7 @@ map_buffer_range(struct gl_context *ctx, struct gl_buffer_object *bufObj,
 
    if (access & GL_MAP_WRITE_BIT) {
       bufObj->Written = GL_TRUE;
-      bufObj->MinMaxCacheDirty = true;
+      vbo_minmax_cache_invalidate(bufObj, offset, length);
    }
 
 #ifdef VBO_DEBUG
@@ -11141,6 +11141,16 @@ execute_list(struct gl_context *ctx, GLuint list)
    while (1) {
       const OpCode opcode = n[0].opcode;
 
+      /* The draws of consecutive vertex lists are merged, and must be
+       * done before anything else changes the state.
+       */
+      if (opcode != OPCODE_VERTEX_LIST &&
+          opcode != OPCODE_VERTEX_LIST_COPY_CURRENT &&
+          opcode != OPCODE_CONTINUE &&
+          opcode != OPCODE_END_OF_LIST &&
+          opcode != OPCODE_CALL_LIST)
+         vbo_save_flush_merged_draws(ctx);
+
       switch (opcode) {
          case OPCODE_ERROR:
             _mesa_error(ctx, n[1].e, "%s", (const char *) get_pointer(&n[2]));
@@ -13760,6 +13770,7 @@ _mesa_CallList(GLuint list)
 
    _mesa_HashLockMutex(ctx->Shared->DisplayList);
    execute_list(ctx, list);
+   vbo_save_flush_merged_draws(ctx);
    _mesa_HashUnlockMutex(ctx->Shared->DisplayList);
    ctx->CompileFlag = save_compile_flag;
 
@@ -13840,6 +13851,7 @@ _mesa_CallLists(GLsizei n, GLenum type, const GLvoid * lists)
 {
    GET_CURRENT_CONTEXT(ctx);
    GLboolean save_compile_flag;
+   FLUSH_CURRENT(ctx, 0);
 
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glCallLists %d\n", n);
@@ -13946,6 +13958,7 @@ _mesa_CallLists(GLsizei n, GLenum type, const GLvoid * lists)
       break;
    }
 
+   vbo_save_flush_merged_draws(ctx);
    _mesa_HashUnlockMutex(ctx->Shared->DisplayList);
    ctx->CompileFlag = save_compile_flag;
 
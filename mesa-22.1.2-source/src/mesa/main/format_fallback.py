@@ -80,6 +80,26 @@ def get_intensity_to_red_map(formats):
 
         yield i_name, r_name
 
+def get_rgbx_to_rgba_map(formats):
+    names = set(fmt.name for fmt in formats)
+
+    for fmt in formats:
+        if not fmt.has_channel('r') or not fmt.has_channel('x'):
+            continue
+
+        # MESA_FORMAT_R9G9B9E5_FLOAT also has an x channel, but it isn't
+        # padding.
+        if 'X' not in fmt.name:
+            continue
+
+        rgbx_name = fmt.name
+        rgba_name = rgbx_name.replace("X", "A")
+
+        if rgba_name not in names:
+            continue
+
+        yield rgbx_name, rgba_name
+
 TEMPLATE = Template(COPYRIGHT + """
 #include "formats.h"
 #include "util/macros.h"
@@ -117,6 +137,24 @@ _mesa_get_intensity_format_red(mesa_format format)
       return format;
    }
 }
+
+/**
+ * If the format has a padding channel (X), return the same format with an
+ * alpha channel (A) in its place.  For other formats, return the format
+ * as-is.
+ */
+mesa_format
+_mesa_format_fallback_rgbx_to_rgba(mesa_format format)
+{
+   switch (format) {
+%for rgbx, rgba in rgbx_to_rgba_map:
+   case ${rgbx}:
+      return ${rgba};
+%endfor
+   default:
+      return format;
+   }
+}
 """);
 
 def main():
@@ -127,6 +165,7 @@ def main():
     template_env = {
         'unorm_to_srgb_map': list(get_unorm_to_srgb_map(formats)),
         'intensity_to_red_map': list(get_intensity_to_red_map(formats)),
+        'rgbx_to_rgba_map': list(get_rgbx_to_rgba_map(formats)),
     }
 
     with open(pargs.out, 'w') as f:
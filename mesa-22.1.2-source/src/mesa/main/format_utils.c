@@ -29,6 +29,8 @@
 #include "glformats.h"
 #include "format_pack.h"
 #include "format_unpack.h"
+#include "pipe/p_defines.h"
+#include "util/format/u_format_swizzle.h"
 
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(MESA_ARRAY_FORMAT_BASE_FORMAT_RGBA_VARIANTS,
@@ -820,6 +822,63 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+/**
+ * Tries the SIMD kernels for the most common conversions of texture uploads
+ * and readbacks: shuffling 8-bit channels (RGB -> RGBA, BGRA <-> RGBA) and
+ * 8-bit unorm <-> float.
+ *
+ * The arguments are exactly the same as for _mesa_swizzle_and_convert
+ *
+ * \return  true if a SIMD kernel performed the swizzle-and-convert
+ *          operation, false otherwise
+ */
+static bool
+swizzle_convert_try_simd(void *dst,
+                         enum mesa_array_format_datatype dst_type,
+                         int num_dst_channels,
+                         const void *src,
+                         enum mesa_array_format_datatype src_type,
+                         int num_src_channels,
+                         const uint8_t swizzle[4], bool normalized, int count)
+{
+   STATIC_ASSERT((int)MESA_FORMAT_SWIZZLE_ZERO == (int)PIPE_SWIZZLE_0);
+   STATIC_ASSERT((int)MESA_FORMAT_SWIZZLE_ONE == (int)PIPE_SWIZZLE_1);
+   STATIC_ASSERT((int)MESA_FORMAT_SWIZZLE_NONE == (int)PIPE_SWIZZLE_NONE);
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+       dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE) {
+      return util_format_swizzle_8bit(dst, num_dst_channels,
+                                      src, num_src_channels, swizzle,
+                                      normalized ? UINT8_MAX : 1, count);
+   }
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_BYTE &&
+       dst_type == MESA_ARRAY_FORMAT_TYPE_BYTE) {
+      return util_format_swizzle_8bit(dst, num_dst_channels,
+                                      src, num_src_channels, swizzle,
+                                      normalized ? INT8_MAX : 1, count);
+   }
+
+   if (!normalized)
+      return false;
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+       dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT) {
+      return util_format_unorm8_to_float(dst, num_dst_channels,
+                                         src, num_src_channels,
+                                         swizzle, count);
+   }
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT &&
+       dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE) {
+      return util_format_float_to_unorm8(dst, num_dst_channels,
+                                         src, num_src_channels,
+                                         swizzle, count);
+   }
+
+   return false;
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1539,6 +1598,11 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_simd(void_dst, dst_type, num_dst_channels,
+                                void_src, src_type, num_src_channels,
+                                swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
@@ -725,6 +725,9 @@ _mesa_get_srgb_format_linear(mesa_format format);
 extern mesa_format
 _mesa_get_intensity_format_red(mesa_format format);
 
+extern mesa_format
+_mesa_format_fallback_rgbx_to_rgba(mesa_format format);
+
 extern mesa_format
 _mesa_get_uncompressed_format(mesa_format format);
 
@@ -36,7 +36,9 @@
 #include "main/glthread.h"
 #include "main/glthread_marshal.h"
 #include "main/hash.h"
+#include "util/hash_table.h"
 #include "util/u_atomic.h"
+#include "util/u_debug.h"
 #include "util/u_thread.h"
 #include "util/u_cpu_detect.h"
 
@@ -122,6 +124,7 @@ _mesa_glthread_init(struct gl_context *ctx)
    }
    glthread->next_batch = &glthread->batches[glthread->next];
    glthread->used = 0;
+   glthread->batch_size = MARSHAL_MAX_CMD_SIZE / 8;
 
    glthread->enabled = true;
    glthread->stats.queue = &glthread->queue;
@@ -140,6 +143,16 @@ _mesa_glthread_init(struct gl_context *ctx)
    ctx->CurrentClientDispatch = ctx->MarshalExec;
 
    glthread->LastDListChangeBatchIndex = -1;
+   glthread->UnpackAlignment = 4;
+
+   glthread->DeferErrors =
+      debug_get_bool_option("MESA_GLTHREAD_DEFER_ERRORS", false);
+
+   if (debug_get_bool_option("MESA_GLTHREAD_REPORT_SYNCS", false)) {
+      glthread->SyncCounts =
+         _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                 _mesa_key_string_equal);
+   }
 
    /* Execute the thread initialization function in the thread. */
    struct util_queue_fence fence;
@@ -156,6 +169,40 @@ free_vao(void *data, UNUSED void *userData)
    free(data);
 }
 
+static int
+compare_sync_counts(const void *a, const void *b)
+{
+   const struct hash_entry *ea = *(const struct hash_entry **)a;
+   const struct hash_entry *eb = *(const struct hash_entry **)b;
+
+   return (int)((uintptr_t)eb->data - (uintptr_t)ea->data);
+}
+
+static void
+report_sync_counts(struct glthread_state *glthread)
+{
+   struct hash_table *counts = glthread->SyncCounts;
+   struct hash_entry **entries =
+      malloc(MAX2(counts->entries, 1) * sizeof(*entries));
+   unsigned num_entries = 0;
+
+   if (!entries)
+      return;
+
+   hash_table_foreach(counts, entry)
+      entries[num_entries++] = entry;
+
+   qsort(entries, num_entries, sizeof(*entries), compare_sync_counts);
+
+   fprintf(stderr, "glthread: %u syncs\n", glthread->stats.num_syncs);
+   for (unsigned i = 0; i < num_entries; i++) {
+      fprintf(stderr, "glthread: %8u %s\n",
+              (unsigned)(uintptr_t)entries[i]->data,
+              (const char *)entries[i]->key);
+   }
+   free(entries);
+}
+
 void
 _mesa_glthread_destroy(struct gl_context *ctx, const char *reason)
 {
@@ -176,6 +223,12 @@ _mesa_glthread_destroy(struct gl_context *ctx, const char *reason)
    _mesa_HashDeleteAll(glthread->VAOs, free_vao, NULL);
    _mesa_DeleteHashTable(glthread->VAOs);
 
+   if (glthread->SyncCounts) {
+      report_sync_counts(glthread);
+      _mesa_hash_table_destroy(glthread->SyncCounts, NULL);
+      glthread->SyncCounts = NULL;
+   }
+
    ctx->GLThread.enabled = false;
    ctx->CurrentClientDispatch = ctx->CurrentServerDispatch;
 
@@ -235,6 +288,19 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
       return;
    }
 
+   /* Adapt the batch size to the worker thread. If it hasn't finished the
+    * previous batch yet, it's slower than this thread, and bigger batches
+    * make the queue overhead per call smaller. If it has, it's waiting for
+    * work, and smaller batches let it start sooner.
+    */
+   if (!util_queue_fence_is_signalled(&glthread->batches[glthread->last].fence)) {
+      glthread->batch_size = MIN2(glthread->batch_size * 2,
+                                  MARSHAL_MAX_BATCH_SIZE / 8);
+   } else {
+      glthread->batch_size = MAX2(glthread->batch_size / 2,
+                                  MARSHAL_MAX_CMD_SIZE / 8);
+   }
+
    p_atomic_add(&glthread->stats.num_offloaded_items, glthread->used);
    next->used = glthread->used;
 
@@ -301,10 +367,24 @@ _mesa_glthread_finish(struct gl_context *ctx)
 void
 _mesa_glthread_finish_before(struct gl_context *ctx, const char *func)
 {
+   struct glthread_state *glthread = &ctx->GLThread;
+   unsigned num_syncs = glthread->stats.num_syncs;
+
    _mesa_glthread_finish(ctx);
 
-   /* Uncomment this if you want to know where glthread syncs. */
-   /*printf("fallback to sync: %s\n", func);*/
+   /* Count the functions that had to wait for the worker thread. */
+   if (unlikely(glthread->SyncCounts) &&
+       glthread->stats.num_syncs != num_syncs) {
+      uint32_t hash = _mesa_hash_string(func);
+      struct hash_entry *entry =
+         _mesa_hash_table_search_pre_hashed(glthread->SyncCounts, hash, func);
+
+      if (entry)
+         entry->data = (void *)((uintptr_t)entry->data + 1);
+      else
+         _mesa_hash_table_insert_pre_hashed(glthread->SyncCounts, hash, func,
+                                            (void *)(uintptr_t)1);
+   }
 }
 
 void
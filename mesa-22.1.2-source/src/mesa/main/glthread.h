@@ -35,6 +35,17 @@
  */
 #define MARSHAL_MAX_CMD_SIZE (8 * 1024)
 
+/* The maximum size of one batch.
+ *
+ * Batches start at MARSHAL_MAX_CMD_SIZE and grow up to this while the worker
+ * thread can't keep up with the app thread, which makes the u_queue overhead
+ * per call smaller when most of the time is spent in the worker thread.
+ *
+ * Every batch slot is this big, so it's kept at twice MARSHAL_MAX_CMD_SIZE:
+ * that halves the queue overhead and only adds 64 KiB per context.
+ */
+#define MARSHAL_MAX_BATCH_SIZE (2 * MARSHAL_MAX_CMD_SIZE)
+
 /* The number of batch slots in memory.
  *
  * One batch is being executed, one batch is being filled, the rest are
@@ -60,6 +71,7 @@ extern "C" {
 struct gl_context;
 struct gl_buffer_object;
 struct _mesa_HashTable;
+struct hash_table;
 
 struct glthread_attrib_binding {
    struct gl_buffer_object *buffer; /**< where non-VBO data was uploaded */
@@ -109,7 +121,7 @@ struct glthread_batch
    unsigned used;
 
    /** Data contained in the command buffer. */
-   uint64_t buffer[MARSHAL_MAX_CMD_SIZE / 8];
+   uint64_t buffer[MARSHAL_MAX_BATCH_SIZE / 8];
 };
 
 struct glthread_client_attrib {
@@ -122,6 +134,16 @@ struct glthread_client_attrib {
 
    /** Whether this element of the client attrib stack contains saved state. */
    bool Valid;
+
+   GLint UnpackAlignment;
+   GLint UnpackRowLength;
+   GLint UnpackSkipPixels;
+   GLint UnpackSkipRows;
+   GLuint CurrentPixelPackBufferName;
+   GLuint CurrentPixelUnpackBufferName;
+
+   /** Whether the pixel store state above was saved. */
+   bool PixelStoreValid;
 };
 
 /* For glPushAttrib / glPopAttrib. */
@@ -153,6 +175,18 @@ struct glthread_state
    /** Whether GLThread is enabled. */
    bool enabled;
 
+   /**
+    * Whether glGetError returns the errors of the commands executed so far
+    * without waiting for the queued ones (MESA_GLTHREAD_DEFER_ERRORS).
+    */
+   bool DeferErrors;
+
+   /**
+    * Number of syncs per function name, reported when the context is
+    * destroyed, or NULL (MESA_GLTHREAD_REPORT_SYNCS).
+    */
+   struct hash_table *SyncCounts;
+
    /** Display lists. */
    GLenum ListMode; /**< Zero if not inside display list, else list mode. */
    unsigned ListBase;
@@ -176,6 +210,9 @@ struct glthread_state
    /** Number of uint64_t elements filled already. */
    unsigned used;
 
+   /** Number of uint64_t elements after which the batch is submitted. */
+   unsigned batch_size;
+
    /** Upload buffer. */
    struct gl_buffer_object *upload_buffer;
    uint8_t *upload_ptr;
@@ -232,8 +269,21 @@ struct glthread_state
    /** Enable states. */
    bool CullFace;
 
+   /**
+    * Whether glBegin was called without glEnd, also when glBegin was only
+    * compiled into a display list. glBegin/glEnd in called display lists
+    * aren't seen.
+    */
+   bool InsideBeginEnd;
+
    GLuint CurrentDrawFramebuffer;
    GLuint CurrentProgram;
+
+   /** Pixel unpack state needed to know the size of client images. */
+   GLint UnpackAlignment;
+   GLint UnpackRowLength;
+   GLint UnpackSkipPixels;
+   GLint UnpackSkipRows;
 };
 
 void _mesa_glthread_init(struct gl_context *ctx);
@@ -307,6 +357,11 @@ void _mesa_glthread_ClientAttribDefault(struct gl_context *ctx, GLbitfield mask)
 void _mesa_glthread_InterleavedArrays(struct gl_context *ctx, GLenum format,
                                       GLsizei stride, const GLvoid *pointer);
 void _mesa_glthread_ProgramChanged(struct gl_context *ctx);
+bool _mesa_glthread_TexSubImage2D_upload(struct gl_context *ctx, GLenum target,
+                                         GLint level, GLint xoffset,
+                                         GLint yoffset, GLsizei width,
+                                         GLsizei height, GLenum format,
+                                         GLenum type, const GLvoid *pixels);
 
 #ifdef __cplusplus
 }
@@ -300,6 +300,30 @@ _mesa_marshal_BufferData_merged(GLuint target_or_name, GLsizeiptr size,
    bool copy_data = data && !external_mem;
    size_t cmd_size = sizeof(struct marshal_cmd_BufferData) + (copy_data ? size : 0);
 
+   /* Data that doesn't fit into a command is copied to an upload buffer
+    * instead of syncing.  The storage is allocated first and then filled
+    * with a GPU copy from the upload buffer.
+    */
+   if (ctx->GLThread.SupportsBufferUploads && copy_data &&
+       cmd_size > MARSHAL_MAX_CMD_SIZE && size > 0 && size <= INT_MAX &&
+       !(named && target_or_name == 0)) {
+      struct gl_buffer_object *upload_buffer = NULL;
+      unsigned upload_offset = 0;
+
+      _mesa_glthread_upload(ctx, data, size, &upload_offset, &upload_buffer,
+                            NULL);
+
+      if (upload_buffer) {
+         _mesa_marshal_BufferData_merged(target_or_name, size, NULL, usage,
+                                         named, ext_dsa, func);
+         _mesa_marshal_InternalBufferSubDataCopyMESA((GLintptr)upload_buffer,
+                                                     upload_offset,
+                                                     target_or_name, 0, size,
+                                                     named, ext_dsa);
+         return;
+      }
+   }
+
    if (unlikely(size < 0 || size > INT_MAX || cmd_size > MARSHAL_MAX_CMD_SIZE ||
                 (named && target_or_name == 0))) {
       _mesa_glthread_finish_before(ctx, func);
@@ -423,9 +447,12 @@ _mesa_marshal_BufferSubData_merged(GLuint target_or_name, GLintptr offset,
    /* TODO: Handle offset == 0 && size < buffer_size.
     *       If offset == 0 and size == buffer_size, it's better to discard
     *       the buffer storage, but we don't know the buffer size in glthread.
+    *       That's still better than syncing if the data doesn't fit into
+    *       a command.
     */
    if (ctx->GLThread.SupportsBufferUploads &&
-       data && offset > 0 && size > 0) {
+       data && size > 0 &&
+       (offset > 0 || cmd_size > MARSHAL_MAX_CMD_SIZE)) {
       struct gl_buffer_object *upload_buffer = NULL;
       unsigned upload_offset = 0;
 
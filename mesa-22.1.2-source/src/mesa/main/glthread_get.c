@@ -23,6 +23,48 @@
 
 #include "main/glthread_marshal.h"
 #include "main/dispatch.h"
+#include "util/u_atomic.h"
+
+uint32_t
+_mesa_unmarshal_GetError(struct gl_context *ctx,
+                         const struct marshal_cmd_GetError *cmd,
+                         const uint64_t *last)
+{
+   unreachable("never executed");
+   return 0;
+}
+
+GLenum GLAPIENTRY
+_mesa_marshal_GetError(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   /* Return the errors of the commands that have been executed so far.
+    * The errors of the queued commands are returned by a later glGetError.
+    * The worker thread only sets ErrorValue when it's GL_NO_ERROR, so it
+    * doesn't change it between the read and the reset here.
+    *
+    * Inside glBegin/glEnd, sync so that _mesa_GetError sets the error.
+    */
+   if (ctx->GLThread.DeferErrors && !ctx->GLThread.InsideBeginEnd) {
+      GLenum e = p_atomic_read(&ctx->ErrorValue);
+
+      if (e != GL_NO_ERROR)
+         p_atomic_set(&ctx->ErrorValue, GL_NO_ERROR);
+
+      /* The worker thread may be counting repeated errors at the same time,
+       * but that only makes a debug message miss a few of them.
+       */
+      p_atomic_set(&ctx->ErrorDebugCount, 0);
+
+      if (_mesa_is_no_error_enabled(ctx) && e != GL_OUT_OF_MEMORY)
+         e = GL_NO_ERROR;
+      return e;
+   }
+
+   _mesa_glthread_finish_before(ctx, "GetError");
+   return CALL_GetError(ctx->CurrentServerDispatch, ());
+}
 
 uint32_t
 _mesa_unmarshal_GetIntegerv(struct gl_context *ctx,
@@ -41,9 +83,43 @@ _mesa_marshal_GetIntegerv(GLenum pname, GLint *p)
    /* TODO: Use get_hash_params.py to return values for items containing:
     * - CONST(
     * - CONTEXT_[A-Z]*(Const
+    *
+    * Limits are immutable after context creation, so they are read directly
+    * here. Only the ones valid in all APIs (or in all APIs where they are
+    * checked below) are handled, so that glGetIntegerv still sets the same
+    * errors.
     */
 
    switch (pname) {
+   case GL_MAX_TEXTURE_SIZE:
+      *p = ctx->Const.MaxTextureSize;
+      return;
+   case GL_MAX_CUBE_MAP_TEXTURE_SIZE:
+      *p = 1 << (ctx->Const.MaxCubeTextureLevels - 1);
+      return;
+   case GL_MAX_RENDERBUFFER_SIZE:
+      *p = ctx->Const.MaxRenderbufferSize;
+      return;
+   case GL_MAX_VIEWPORT_DIMS:
+      p[0] = ctx->Const.MaxViewportWidth;
+      p[1] = ctx->Const.MaxViewportHeight;
+      return;
+   case GL_MAJOR_VERSION:
+   case GL_MINOR_VERSION:
+      if ((_mesa_is_desktop_gl(ctx) && ctx->Version >= 30) ||
+          _mesa_is_gles3(ctx)) {
+         *p = pname == GL_MAJOR_VERSION ? ctx->Version / 10 : ctx->Version % 10;
+         return;
+      }
+      break;
+
+   case GL_VERTEX_ARRAY_BINDING:
+      *p = ctx->GLThread.CurrentVAO->Name;
+      return;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+      *p = ctx->GLThread.CurrentVAO->CurrentElementBufferName;
+      return;
+
    case GL_ACTIVE_TEXTURE:
       *p = GL_TEXTURE0 + ctx->GLThread.ActiveTexture;
       return;
@@ -61,7 +61,7 @@ _mesa_glthread_allocate_command(struct gl_context *ctx,
 
    assert (num_elements <= MARSHAL_MAX_CMD_SIZE / 8);
 
-   if (unlikely(glthread->used + num_elements > MARSHAL_MAX_CMD_SIZE / 8))
+   if (unlikely(glthread->used + num_elements > glthread->batch_size))
       _mesa_glthread_flush_batch(ctx);
 
    struct glthread_batch *next = glthread->next_batch;
@@ -475,6 +475,33 @@ _mesa_glthread_Disable(struct gl_context *ctx, GLenum cap)
    }
 }
 
+static inline void
+_mesa_glthread_PixelStorei(struct gl_context *ctx, GLenum pname, GLint param)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   /* Only track the values that don't set an error. */
+   const bool no_error = _mesa_is_no_error_enabled(ctx);
+
+   switch (pname) {
+   case GL_UNPACK_ALIGNMENT:
+      if (no_error || param == 1 || param == 2 || param == 4 || param == 8)
+         glthread->UnpackAlignment = param;
+      break;
+   case GL_UNPACK_ROW_LENGTH:
+      if (no_error || (ctx->API != API_OPENGLES && param >= 0))
+         glthread->UnpackRowLength = param;
+      break;
+   case GL_UNPACK_SKIP_PIXELS:
+      if (no_error || (ctx->API != API_OPENGLES && param >= 0))
+         glthread->UnpackSkipPixels = param;
+      break;
+   case GL_UNPACK_SKIP_ROWS:
+      if (no_error || (ctx->API != API_OPENGLES && param >= 0))
+         glthread->UnpackSkipRows = param;
+      break;
+   }
+}
+
 static inline int
 _mesa_glthread_IsEnabled(struct gl_context *ctx, GLenum cap)
 {
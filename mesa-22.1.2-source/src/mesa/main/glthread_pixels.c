@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main/glthread_marshal.h"
+#include "main/dispatch.h"
+#include "main/glformats.h"
+#include "main/image.h"
+
+/**
+ * Copy the client pixels of glTexSubImage2D into an upload buffer and
+ * enqueue the upload from there, so that the app thread doesn't have to
+ * wait for the driver thread.  The copy covers the whole region addressed
+ * with the current unpack state, which glthread tracks.
+ *
+ * Return false if the call should be synchronous instead, e.g. because
+ * a pixel unpack buffer is bound or the format isn't understood here (in
+ * which case the driver thread reports the error).
+ */
+bool
+_mesa_glthread_TexSubImage2D_upload(struct gl_context *ctx, GLenum target,
+                                    GLint level, GLint xoffset, GLint yoffset,
+                                    GLsizei width, GLsizei height,
+                                    GLenum format, GLenum type,
+                                    const GLvoid *pixels)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   if (!glthread->SupportsBufferUploads || glthread->ListMode ||
+       glthread->CurrentPixelUnpackBufferName || !pixels ||
+       width <= 0 || height <= 0 || type == GL_BITMAP)
+      return false;
+
+   GLint bpp = _mesa_bytes_per_pixel(format, type);
+   if (bpp <= 0)
+      return false;
+
+   struct gl_pixelstore_attrib unpack;
+   memset(&unpack, 0, sizeof(unpack));
+   unpack.Alignment = glthread->UnpackAlignment;
+   unpack.RowLength = glthread->UnpackRowLength;
+   unpack.SkipPixels = glthread->UnpackSkipPixels;
+   unpack.SkipRows = glthread->UnpackSkipRows;
+
+   /* The skipped pixels and rows are included in the copy, so that the
+    * driver thread can use the same unpack state on the upload buffer.
+    */
+   const uint8_t *end =
+      (const uint8_t *)_mesa_image_address2d(&unpack, pixels, width, height,
+                                             format, type, height - 1, 0) +
+      (size_t)width * bpp;
+   size_t size = end - (const uint8_t *)pixels;
+
+   if (size > INT_MAX)
+      return false;
+
+   struct gl_buffer_object *upload_buffer = NULL;
+   unsigned upload_offset = 0;
+
+   _mesa_glthread_upload(ctx, pixels, size, &upload_offset, &upload_buffer,
+                         NULL);
+   if (!upload_buffer)
+      return false;
+
+   _mesa_marshal_InternalTexSubImage2DUploadMESA((GLintptr)upload_buffer,
+                                                 upload_offset, target, level,
+                                                 xoffset, yoffset, width,
+                                                 height, format, type);
+   return true;
+}
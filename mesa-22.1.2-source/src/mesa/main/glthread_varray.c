@@ -594,6 +594,18 @@ _mesa_glthread_PushClientAttrib(struct gl_context *ctx, GLbitfield mask,
       top->Valid = false;
    }
 
+   if (mask & GL_CLIENT_PIXEL_STORE_BIT) {
+      top->UnpackAlignment = glthread->UnpackAlignment;
+      top->UnpackRowLength = glthread->UnpackRowLength;
+      top->UnpackSkipPixels = glthread->UnpackSkipPixels;
+      top->UnpackSkipRows = glthread->UnpackSkipRows;
+      top->CurrentPixelPackBufferName = glthread->CurrentPixelPackBufferName;
+      top->CurrentPixelUnpackBufferName = glthread->CurrentPixelUnpackBufferName;
+      top->PixelStoreValid = true;
+   } else {
+      top->PixelStoreValid = false;
+   }
+
    glthread->ClientAttribStackTop++;
 
    if (set_default)
@@ -613,6 +625,15 @@ _mesa_glthread_PopClientAttrib(struct gl_context *ctx)
    struct glthread_client_attrib *top =
       &glthread->ClientAttribStack[glthread->ClientAttribStackTop];
 
+   if (top->PixelStoreValid) {
+      glthread->UnpackAlignment = top->UnpackAlignment;
+      glthread->UnpackRowLength = top->UnpackRowLength;
+      glthread->UnpackSkipPixels = top->UnpackSkipPixels;
+      glthread->UnpackSkipRows = top->UnpackSkipRows;
+      glthread->CurrentPixelPackBufferName = top->CurrentPixelPackBufferName;
+      glthread->CurrentPixelUnpackBufferName = top->CurrentPixelUnpackBufferName;
+   }
+
    if (!top->Valid)
       return;
 
@@ -644,6 +665,15 @@ _mesa_glthread_ClientAttribDefault(struct gl_context *ctx, GLbitfield mask)
 {
    struct glthread_state *glthread = &ctx->GLThread;
 
+   if (mask & GL_CLIENT_PIXEL_STORE_BIT) {
+      glthread->UnpackAlignment = 4;
+      glthread->UnpackRowLength = 0;
+      glthread->UnpackSkipPixels = 0;
+      glthread->UnpackSkipRows = 0;
+      glthread->CurrentPixelPackBufferName = 0;
+      glthread->CurrentPixelUnpackBufferName = 0;
+   }
+
    if (!(mask & GL_CLIENT_VERTEX_ARRAY_BIT))
       return;
 
@@ -86,10 +86,16 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (table->NumDirect || _mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
+   if (table->Direct) {
+      for (unsigned i = 0; i < MESA_HASH_DIRECT_NUM_BLOCKS; i++)
+         free(table->Direct[i]);
+      free(table->Direct);
+   }
+
    _mesa_hash_table_destroy(table->ht, NULL);
    if (table->id_alloc) {
       util_idalloc_fini(table->id_alloc);
@@ -102,7 +108,7 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
 static void init_name_reuse(struct _mesa_HashTable *table)
 {
-   assert(_mesa_hash_table_num_entries(table->ht) == 0);
+   assert(_mesa_HashNumEntries(table) == 0);
    table->id_alloc = MALLOC_STRUCT(util_idalloc);
    util_idalloc_init(table->id_alloc, 8);
    ASSERTED GLuint reserve0 = util_idalloc_alloc(table->id_alloc);
@@ -129,8 +135,8 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(table);
    assert(key);
 
-   if (key == DELETED_KEY_VALUE)
-      return table->deleted_key_data;
+   if (key < MESA_HASH_DIRECT_MAX_KEY)
+      return _mesa_HashLookupDirect(table, key);
 
    entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                               uint_hash(key),
@@ -143,39 +149,109 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 
 
 /**
- * Lookup an entry in the hash table.
- * 
+ * Lookup a name that is not in the direct array.
+ *
  * \param table the hash table.
  * \param key the key.
- * 
+ * \param locked whether the caller already holds the hash table mutex.
+ *
  * \return pointer to user's data or NULL if key not in table
+ * \sa _mesa_HashLookup
  */
 void *
-_mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
+_mesa_HashLookupOutlier(struct _mesa_HashTable *table, GLuint key, bool locked)
 {
    void *res;
-   _mesa_HashLockMutex(table);
+
+   _mesa_HashLockMaybeLocked(table, locked);
    res = _mesa_HashLookup_unlocked(table, key);
-   _mesa_HashUnlockMutex(table);
+   _mesa_HashUnlockMaybeLocked(table, locked);
    return res;
 }
 
 
 /**
- * Lookup an entry in the hash table without locking the mutex.
- *
- * The hash table mutex must be locked manually by calling
- * _mesa_HashLockMutex() before calling this function.
- *
- * \param table the hash table.
- * \param key the key.
- *
- * \return pointer to user's data or NULL if key not in table
+ * Bitset of the used slots of a direct block, which follows its pointers.
  */
-void *
-_mesa_HashLookupLocked(struct _mesa_HashTable *table, GLuint key)
+static inline BITSET_WORD *
+direct_block_used(void **block)
+{
+   return (BITSET_WORD *)(block + MESA_HASH_DIRECT_BLOCK_SIZE);
+}
+
+static bool
+direct_block_is_empty(void **block)
 {
-   return _mesa_HashLookup_unlocked(table, key);
+   const BITSET_WORD *used = direct_block_used(block);
+
+   for (unsigned i = 0; i < BITSET_WORDS(MESA_HASH_DIRECT_BLOCK_SIZE); i++) {
+      if (used[i])
+         return false;
+   }
+   return true;
+}
+
+/**
+ * Store a data pointer in the direct array, allocating the array and the
+ * block if needed.  The mutex must be held.
+ */
+static void
+hash_set_direct(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   unsigned block_index = key >> MESA_HASH_DIRECT_BLOCK_SIZE_LOG2;
+   unsigned index = key & (MESA_HASH_DIRECT_BLOCK_SIZE - 1);
+   void ***block_ptr;
+   void **block;
+   BITSET_WORD *used;
+   void **slot;
+
+   if (!table->Direct) {
+      if (!data)
+         return;
+
+      void ***direct = calloc(MESA_HASH_DIRECT_NUM_BLOCKS, sizeof(void **));
+      if (!direct) {
+         _mesa_error_no_memory(__func__);
+         return;
+      }
+      p_atomic_set(&table->Direct, direct);
+   }
+
+   block_ptr = &table->Direct[block_index];
+   block = *block_ptr;
+
+   if (!block) {
+      if (!data)
+         return;
+
+      block = calloc(1, MESA_HASH_DIRECT_BLOCK_SIZE * sizeof(void *) +
+                        BITSET_WORDS(MESA_HASH_DIRECT_BLOCK_SIZE) *
+                        sizeof(BITSET_WORD));
+      if (!block) {
+         _mesa_error_no_memory(__func__);
+         return;
+      }
+      p_atomic_set(block_ptr, block);
+   }
+
+   slot = &block[index];
+   used = direct_block_used(block);
+   if (*slot) {
+      table->NumDirect--;
+      BITSET_CLEAR(used, index);
+   }
+   if (data) {
+      table->NumDirect++;
+      BITSET_SET(used, index);
+   }
+
+   if (data)
+      BITSET_SET(table->DirectUsed, block_index);
+   else if (direct_block_is_empty(block))
+      BITSET_CLEAR(table->DirectUsed, block_index);
+
+   /* Release, so that lock-free lookups see the initialized object. */
+   p_atomic_set(slot, data);
 }
 
 
@@ -191,8 +267,8 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = data;
+   if (key < MESA_HASH_DIRECT_MAX_KEY) {
+      hash_set_direct(table, key, data);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
       if (entry) {
@@ -271,8 +347,8 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(!table->InDeleteAll);
    #endif
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = NULL;
+   if (key < MESA_HASH_DIRECT_MAX_KEY) {
+      hash_set_direct(table, key, NULL);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                                  uint_hash(key),
@@ -299,6 +375,36 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
    _mesa_HashUnlockMutex(table);
 }
 
+/**
+ * Next name after \p key that is in use in the direct array, or 0 if there
+ * is none.
+ */
+static GLuint
+direct_next_key(const struct _mesa_HashTable *table, GLuint key)
+{
+   key++;
+   while (key < MESA_HASH_DIRECT_MAX_KEY) {
+      unsigned block_index = key >> MESA_HASH_DIRECT_BLOCK_SIZE_LOG2;
+      unsigned index = key & (MESA_HASH_DIRECT_BLOCK_SIZE - 1);
+
+      if (!BITSET_TEST(table->DirectUsed, block_index)) {
+         key = (block_index + 1) << MESA_HASH_DIRECT_BLOCK_SIZE_LOG2;
+         continue;
+      }
+
+      const BITSET_WORD *used = direct_block_used(table->Direct[block_index]);
+      BITSET_WORD word = used[BITSET_BITWORD(index)] >>
+                         (index % BITSET_WORDBITS);
+      if (word)
+         return key + ffs(word) - 1;
+
+      key = (key | (BITSET_WORDBITS - 1)) + 1;
+   }
+
+   return 0;
+}
+
+
 /**
  * Delete all entries in a hash table, but don't delete the table itself.
  * Invoke the given callback function for each table entry.
@@ -318,14 +424,15 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
    #ifndef NDEBUG
    table->InDeleteAll = GL_TRUE;
    #endif
+   for (GLuint key = direct_next_key(table, 0); key;
+        key = direct_next_key(table, key)) {
+      callback(_mesa_HashLookupDirect(table, key), userData);
+      hash_set_direct(table, key, NULL);
+   }
    hash_table_foreach(table->ht, entry) {
       callback(entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
-   if (table->deleted_key_data) {
-      callback(table->deleted_key_data, userData);
-      table->deleted_key_data = NULL;
-   }
    if (table->id_alloc) {
       util_idalloc_fini(table->id_alloc);
       free(table->id_alloc);
@@ -354,11 +461,13 @@ hash_walk_unlocked(const struct _mesa_HashTable *table,
    assert(table);
    assert(callback);
 
+   for (GLuint key = direct_next_key(table, 0); key;
+        key = direct_next_key(table, key)) {
+      callback(_mesa_HashLookupDirect(table, key), userData);
+   }
    hash_table_foreach(table->ht, entry) {
       callback(entry->data, userData);
    }
-   if (table->deleted_key_data)
-      callback(table->deleted_key_data, userData);
 }
 
 
@@ -391,8 +500,10 @@ _mesa_HashWalkLocked(const struct _mesa_HashTable *table,
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
-   if (table->deleted_key_data)
-      _mesa_debug(NULL, "%u %p\n", DELETED_KEY_VALUE, table->deleted_key_data);
+   for (GLuint key = direct_next_key(table, 0); key;
+        key = direct_next_key(table, key)) {
+      _mesa_debug(NULL, "%u %p\n", key, _mesa_HashLookupDirect(table, key));
+   }
 
    hash_table_foreach(table->ht, entry) {
       _mesa_debug(NULL, "%u %p\n", (unsigned)(uintptr_t) entry->key,
@@ -474,12 +585,5 @@ _mesa_HashFindFreeKeys(struct _mesa_HashTable *table, GLuint* keys, GLuint numKe
 GLuint
 _mesa_HashNumEntries(const struct _mesa_HashTable *table)
 {
-   GLuint count = 0;
-
-   if (table->deleted_key_data)
-      count++;
-
-   count += _mesa_hash_table_num_entries(table->ht);
-
-   return count;
+   return table->NumDirect + _mesa_hash_table_num_entries(table->ht);
 }
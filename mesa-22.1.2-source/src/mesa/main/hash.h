@@ -37,20 +37,25 @@
 #include "glheader.h"
 
 #include "c11/threads.h"
+#include "util/bitset.h"
+#include "util/macros.h"
 #include "util/simple_mtx.h"
+#include "util/u_atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 struct util_idalloc;
 
 /**
- * Magic GLuint object name that gets stored outside of the struct hash_table.
+ * Magic GLuint object name used as the deleted key of the struct hash_table.
  *
  * The hash table needs a particular pointer to be the marker for a key that
  * was deleted from the table, along with NULL for the "never allocated in the
- * table" marker.  Legacy GL allows any GLuint to be used as a GL object name,
- * and we use a 1:1 mapping from GLuints to key pointers, so we need to be
- * able to track a GLuint that happens to match the deleted key outside of
- * struct hash_table.  We tell the hash table to use "1" as the deleted key
- * value, so that we test the deleted-key-in-the-table path as best we can.
+ * table" marker.  We use a 1:1 mapping from GLuints to key pointers, and
+ * names below MESA_HASH_DIRECT_MAX_KEY never go into the hash table, so "1"
+ * can never clash with a real key.
  */
 #define DELETED_KEY_VALUE 1
 
@@ -98,18 +103,43 @@ uint_key(GLuint id)
 }
 /** @} */
 
+/**
+ * GL names are handed out densely starting from 1, so names below
+ * MESA_HASH_DIRECT_MAX_KEY are stored in a two-level array indexed by the
+ * name itself rather than in the hash table, which only keeps the outliers
+ * (names picked by the application, or genned after many deletions without
+ * name reuse).
+ *
+ * The array of blocks and the blocks are allocated on first use and only
+ * freed along with the table, and their slots are written with release
+ * semantics, so lookups of direct names don't need to take the mutex.  Each block is followed by a
+ * bitset of its used slots, so that walking the table only visits names that
+ * are in use.
+ */
+#define MESA_HASH_DIRECT_BLOCK_SIZE_LOG2 10
+#define MESA_HASH_DIRECT_BLOCK_SIZE (1u << MESA_HASH_DIRECT_BLOCK_SIZE_LOG2)
+#define MESA_HASH_DIRECT_NUM_BLOCKS 1024
+#define MESA_HASH_DIRECT_MAX_KEY \
+   (MESA_HASH_DIRECT_NUM_BLOCKS * MESA_HASH_DIRECT_BLOCK_SIZE)
+
 /**
  * The hash table data structure.
  */
 struct _mesa_HashTable {
-   struct hash_table *ht;
+   /**
+    * MESA_HASH_DIRECT_NUM_BLOCKS blocks of data pointers of names below
+    * MESA_HASH_DIRECT_MAX_KEY, or NULL until the first one is inserted
+    */
+   void ***Direct;
+   /** Blocks of Direct with at least one non-NULL entry */
+   BITSET_DECLARE(DirectUsed, MESA_HASH_DIRECT_NUM_BLOCKS);
+   GLuint NumDirect;                     /**< non-NULL entries in Direct */
+   struct hash_table *ht;                /**< names not in Direct */
    GLuint MaxKey;                        /**< highest key inserted so far */
    simple_mtx_t Mutex;                   /**< mutual exclusion lock */
    /* Used when name reuse is enabled */
    struct util_idalloc* id_alloc;
 
-   /** Value that would be in the table for DELETED_KEY_VALUE. */
-   void *deleted_key_data;
    #ifndef NDEBUG
    GLboolean InDeleteAll;                /**< Debug check */
    #endif
@@ -119,7 +149,49 @@ extern struct _mesa_HashTable *_mesa_NewHashTable(void);
 
 extern void _mesa_DeleteHashTable(struct _mesa_HashTable *table);
 
-extern void *_mesa_HashLookup(struct _mesa_HashTable *table, GLuint key);
+extern void *_mesa_HashLookupOutlier(struct _mesa_HashTable *table, GLuint key,
+                                     bool locked);
+
+/**
+ * Lookup the data of a name in the direct array, without locking.
+ */
+static inline void *
+_mesa_HashLookupDirect(const struct _mesa_HashTable *table, GLuint key)
+{
+   void ***direct = p_atomic_read(&table->Direct);
+   void **block;
+
+   if (!direct)
+      return NULL;
+
+   block = p_atomic_read(&direct[key >> MESA_HASH_DIRECT_BLOCK_SIZE_LOG2]);
+   if (!block)
+      return NULL;
+
+   return p_atomic_read(&block[key & (MESA_HASH_DIRECT_BLOCK_SIZE - 1)]);
+}
+
+/**
+ * Lookup an entry in the hash table.
+ *
+ * Only names outside of the direct array take the mutex.
+ *
+ * \param table the hash table.
+ * \param key the key.
+ *
+ * \return pointer to user's data or NULL if key not in table
+ */
+static inline void *
+_mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
+{
+   assert(table);
+   assert(key);
+
+   if (likely(key < MESA_HASH_DIRECT_MAX_KEY))
+      return _mesa_HashLookupDirect(table, key);
+
+   return _mesa_HashLookupOutlier(table, key, false);
+}
 
 extern void _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data,
                              GLboolean isGenName);
@@ -155,7 +227,28 @@ _mesa_HashUnlockMutex(struct _mesa_HashTable *table)
    simple_mtx_unlock(&table->Mutex);
 }
 
-extern void *_mesa_HashLookupLocked(struct _mesa_HashTable *table, GLuint key);
+/**
+ * Lookup an entry in the hash table without locking the mutex.
+ *
+ * The hash table mutex must be locked manually by calling
+ * _mesa_HashLockMutex() before calling this function.
+ *
+ * \param table the hash table.
+ * \param key the key.
+ *
+ * \return pointer to user's data or NULL if key not in table
+ */
+static inline void *
+_mesa_HashLookupLocked(struct _mesa_HashTable *table, GLuint key)
+{
+   assert(table);
+   assert(key);
+
+   if (likely(key < MESA_HASH_DIRECT_MAX_KEY))
+      return _mesa_HashLookupDirect(table, key);
+
+   return _mesa_HashLookupOutlier(table, key, true);
+}
 
 extern void _mesa_HashInsertLocked(struct _mesa_HashTable *table,
                                    GLuint key, void *data, GLboolean isGenName);
@@ -202,7 +295,7 @@ _mesa_HashWalkMaybeLocked(const struct _mesa_HashTable *table,
       _mesa_HashWalk(table, callback, userData);
 }
 
-static inline struct gl_buffer_object *
+static inline void *
 _mesa_HashLookupMaybeLocked(struct _mesa_HashTable *table, GLuint key,
                             bool locked)
 {
@@ -237,4 +330,8 @@ _mesa_HashUnlockMaybeLocked(struct _mesa_HashTable *table, bool locked)
       _mesa_HashUnlockMutex(table);
 }
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
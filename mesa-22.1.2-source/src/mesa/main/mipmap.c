@@ -41,9 +41,17 @@
 #include "util/half_float.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_math.h"
+#include "util/u_parallel.h"
 
 #include "state_tracker/st_cb_texture.h"
 
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || \
+    (defined(_M_X64) && !defined(_M_ARM64EC))
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+
 /**
  * Compute the expected number of mipmap levels in the texture given
  * the width/height/depth of the base image and the GL_TEXTURE_BASE_LEVEL/
@@ -164,28 +172,156 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+#ifdef MIPMAP_SSE2
+
 /**
- * Average together two rows of a source image to produce a single new
- * row in the dest image.  It's legal for the two source rows to point
- * to the same data.  The source width must be equal to either the
- * dest width or two times the dest width.
- * \param datatype  GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_FLOAT, etc.
- * \param comps  number of components per pixel (1..4)
+ * Add up the horizontally adjacent pixels of 16-bit channel sums, lo and hi
+ * holding 16 / comps source pixels.  Returns the channel sums of the
+ * 8 / comps destination pixels.
  */
-static void
-do_row(GLenum datatype, GLuint comps, GLint srcWidth,
-       const GLvoid *srcRowA, const GLvoid *srcRowB,
-       GLint dstWidth, GLvoid *dstRow)
+static inline __m128i
+pair_sum_u16(__m128i lo, __m128i hi, GLuint comps)
 {
-   const GLuint k0 = (srcWidth == dstWidth) ? 0 : 1;
-   const GLuint colStride = (srcWidth == dstWidth) ? 1 : 2;
+   if (comps == 1) {
+      /* PMADDWD adds adjacent 16-bit lanes into a 32-bit one. */
+      const __m128i one = _mm_set1_epi16(1);
+      return _mm_packs_epi32(_mm_madd_epi16(lo, one),
+                             _mm_madd_epi16(hi, one));
+   }
 
-   assert(comps >= 1);
-   assert(comps <= 4);
+   if (comps == 2) {
+      /* Put the even pixels in the low and the odd ones in the high half. */
+      lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+      hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+   }
 
-   /* This assertion is no longer valid with non-power-of-2 textures
-   assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
-   */
+   return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                        _mm_unpackhi_epi64(lo, hi));
+}
+
+/**
+ * SSE2 version of the GL_UNSIGNED_BYTE cases of do_row(), with the same
+ * results.  Returns the number of destination pixels done.
+ */
+static GLint
+do_row_ubyte_sse2(GLuint comps, GLuint colStride,
+                  const GLubyte *rowA, const GLubyte *rowB,
+                  GLint dstWidth, GLubyte *dst)
+{
+   const GLint bytes = dstWidth * comps;
+   GLint n;
+
+   if (colStride == 1) {
+      /* (a + a + b + b) / 4 rounds the average down, PAVGB rounds it up. */
+      const __m128i one = _mm_set1_epi8(1);
+
+      for (n = 0; n + 16 <= bytes; n += 16) {
+         __m128i a = _mm_loadu_si128((const __m128i *)(rowA + n));
+         __m128i b = _mm_loadu_si128((const __m128i *)(rowB + n));
+         __m128i odd = _mm_and_si128(_mm_xor_si128(a, b), one);
+         _mm_storeu_si128((__m128i *)(dst + n),
+                          _mm_sub_epi8(_mm_avg_epu8(a, b), odd));
+      }
+      return n / comps;
+   }
+
+   if (comps == 3)
+      return 0;
+
+   const __m128i zero = _mm_setzero_si128();
+
+   for (n = 0; n + 16 <= bytes; n += 16) {
+      __m128i a0 = _mm_loadu_si128((const __m128i *)(rowA + 2 * n));
+      __m128i a1 = _mm_loadu_si128((const __m128i *)(rowA + 2 * n + 16));
+      __m128i b0 = _mm_loadu_si128((const __m128i *)(rowB + 2 * n));
+      __m128i b1 = _mm_loadu_si128((const __m128i *)(rowB + 2 * n + 16));
+      __m128i s0 = pair_sum_u16(_mm_add_epi16(_mm_unpacklo_epi8(a0, zero),
+                                              _mm_unpacklo_epi8(b0, zero)),
+                                _mm_add_epi16(_mm_unpackhi_epi8(a0, zero),
+                                              _mm_unpackhi_epi8(b0, zero)),
+                                comps);
+      __m128i s1 = pair_sum_u16(_mm_add_epi16(_mm_unpacklo_epi8(a1, zero),
+                                              _mm_unpacklo_epi8(b1, zero)),
+                                _mm_add_epi16(_mm_unpackhi_epi8(a1, zero),
+                                              _mm_unpackhi_epi8(b1, zero)),
+                                comps);
+      _mm_storeu_si128((__m128i *)(dst + n),
+                       _mm_packus_epi16(_mm_srli_epi16(s0, 2),
+                                        _mm_srli_epi16(s1, 2)));
+   }
+   return n / comps;
+}
+
+/**
+ * SSE2 version of the GL_FLOAT cases of do_row().  The additions are done
+ * in the same order, so the results are the same.  Returns the number of
+ * destination pixels done.
+ */
+static GLint
+do_row_float_sse2(GLuint comps, GLuint colStride,
+                  const GLfloat *rowA, const GLfloat *rowB,
+                  GLint dstWidth, GLfloat *dst)
+{
+   const __m128 quarter = _mm_set1_ps(0.25F);
+   const GLint floats = dstWidth * comps;
+   GLint n;
+
+   if (colStride == 1) {
+      for (n = 0; n + 4 <= floats; n += 4) {
+         __m128 a = _mm_loadu_ps(rowA + n);
+         __m128 b = _mm_loadu_ps(rowB + n);
+         __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(a, a), b), b);
+         _mm_storeu_ps(dst + n, _mm_mul_ps(sum, quarter));
+      }
+      return n / comps;
+   }
+
+   if (comps == 3)
+      return 0;
+
+   for (n = 0; n + 4 <= floats; n += 4) {
+      __m128 a0 = _mm_loadu_ps(rowA + 2 * n);
+      __m128 a1 = _mm_loadu_ps(rowA + 2 * n + 4);
+      __m128 b0 = _mm_loadu_ps(rowB + 2 * n);
+      __m128 b1 = _mm_loadu_ps(rowB + 2 * n + 4);
+      __m128 aj, ak, bj, bk;
+
+      if (comps == 1) {
+         aj = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+         ak = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+         bj = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0));
+         bk = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1));
+      } else if (comps == 2) {
+         aj = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 0, 1, 0));
+         ak = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 2, 3, 2));
+         bj = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(1, 0, 1, 0));
+         bk = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 2, 3, 2));
+      } else {
+         aj = a0;
+         ak = a1;
+         bj = b0;
+         bk = b1;
+      }
+
+      __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(aj, ak), bj), bk);
+      _mm_storeu_ps(dst + n, _mm_mul_ps(sum, quarter));
+   }
+   return n / comps;
+}
+
+#endif /* MIPMAP_SSE2 */
+
+
+/**
+ * The plain C version of do_row(), with the column stride (1 or 2) given
+ * instead of the source width.
+ */
+static void
+do_row_scalar(GLenum datatype, GLuint comps, GLuint colStride,
+              const GLvoid *srcRowA, const GLvoid *srcRowB,
+              GLint dstWidth, GLvoid *dstRow)
+{
+   const GLuint k0 = colStride - 1;
 
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
@@ -788,6 +924,69 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
 }
 
 
+/**
+ * Average together two rows of a source image to produce a single new
+ * row in the dest image.  It's legal for the two source rows to point
+ * to the same data.  The source width must be equal to either the
+ * dest width or two times the dest width.
+ * \param datatype  GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_FLOAT, etc.
+ * \param comps  number of components per pixel (1..4)
+ */
+static void
+do_row(GLenum datatype, GLuint comps, GLint srcWidth,
+       const GLvoid *srcRowA, const GLvoid *srcRowB,
+       GLint dstWidth, GLvoid *dstRow)
+{
+   const GLuint colStride = (srcWidth == dstWidth) ? 1 : 2;
+
+   assert(comps >= 1);
+   assert(comps <= 4);
+
+   /* This assertion is no longer valid with non-power-of-2 textures
+   assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
+   */
+
+#ifdef MIPMAP_SSE2
+   {
+      GLint done = 0;
+
+      if (datatype == GL_UNSIGNED_BYTE)
+         done = do_row_ubyte_sse2(comps, colStride, srcRowA, srcRowB,
+                                  dstWidth, dstRow);
+      else if (datatype == GL_FLOAT)
+         done = do_row_float_sse2(comps, colStride, srcRowA, srcRowB,
+                                  dstWidth, dstRow);
+
+      /* do_row_scalar() does the rest of the row. */
+      if (done) {
+         const GLint bpt = bytes_per_pixel(datatype, comps);
+
+         srcRowA = (const GLubyte *) srcRowA + done * colStride * bpt;
+         srcRowB = (const GLubyte *) srcRowB + done * colStride * bpt;
+         dstRow = (GLubyte *) dstRow + done * bpt;
+         dstWidth -= done;
+      }
+   }
+#endif
+
+   do_row_scalar(datatype, comps, colStride, srcRowA, srcRowB,
+                 dstWidth, dstRow);
+}
+
+
+void
+_mesa_generate_mipmap_row(GLenum datatype, GLuint comps, GLint srcWidth,
+                          const void *srcRowA, const void *srcRowB,
+                          GLint dstWidth, void *dstRow, bool simd)
+{
+   if (simd)
+      do_row(datatype, comps, srcWidth, srcRowA, srcRowB, dstWidth, dstRow);
+   else
+      do_row_scalar(datatype, comps, srcWidth == dstWidth ? 1 : 2,
+                    srcRowA, srcRowB, dstWidth, dstRow);
+}
+
+
 /**
  * Average together four rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -1560,6 +1759,126 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/* Number of levels generated together from each band of the source level. */
+#define MIPMAP_MAX_FUSED_LEVELS 4
+
+/* Target size of the source rows of a band, so that a band and the levels
+ * generated from it stay in the cache.
+ */
+#define MIPMAP_BAND_SRC_BYTES (256 * 1024)
+
+/**
+ * Borderless 2D images of one or more successive levels, the first one
+ * being the source of the others.  The destination images are split into
+ * bands of rows, generated in parallel.
+ */
+struct mipmap_2d_job {
+   GLenum datatype;
+   GLuint comps;
+   GLuint num_levels;            /**< destination levels */
+   GLint depth;                  /**< slices per level */
+   GLint width[MIPMAP_MAX_FUSED_LEVELS + 1];
+   GLint height[MIPMAP_MAX_FUSED_LEVELS + 1];
+   GLint row_stride[MIPMAP_MAX_FUSED_LEVELS + 1];
+   GLubyte **maps[MIPMAP_MAX_FUSED_LEVELS + 1]; /**< [level][slice] */
+   GLint band_height;            /**< first destination level rows per band */
+   GLint bands_per_slice;
+};
+
+
+/**
+ * Rows of the first destination level per band: a power of two, so that
+ * the bands of the next levels stay aligned on two source rows.
+ */
+static GLint
+mipmap_band_height(GLint srcRowBytes)
+{
+   GLint band_height = 1;
+
+   while (4 * band_height * srcRowBytes <= MIPMAP_BAND_SRC_BYTES)
+      band_height *= 2;
+
+   return band_height;
+}
+
+
+/**
+ * Generate one band of every destination level of a mipmap_2d_job.  Each
+ * level of the band only reads the band of the previous level, while it's
+ * still in the cache.
+ */
+static void
+generate_2d_band(void *data, unsigned task)
+{
+   const struct mipmap_2d_job *job = data;
+   const GLint slice = task / job->bands_per_slice;
+   const GLint band = task % job->bands_per_slice;
+   GLint y0 = band * job->band_height;
+   GLint y1 = y0 + job->band_height;
+   GLuint level;
+   GLint row;
+
+   for (level = 1; level <= job->num_levels; level++) {
+      const GLint srcHeight = job->height[level - 1];
+      const GLint dstHeight = job->height[level];
+      const GLint srcRowStride = job->row_stride[level - 1];
+      const GLint dstRowStride = job->row_stride[level];
+      const GLubyte *src = job->maps[level - 1][slice];
+      GLubyte *dst = job->maps[level][slice];
+      /* same as make_2d_mipmap() */
+      const GLint srcRowStep = (srcHeight > 1 && srcHeight > dstHeight) ? 2 : 1;
+
+      if (level > 1 && srcRowStep == 2) {
+         y0 /= 2;
+         y1 /= 2;
+      }
+
+      for (row = y0; row < MIN2(y1, dstHeight); row++) {
+         const GLubyte *srcA = src + row * srcRowStep * srcRowStride;
+         const GLubyte *srcB = srcRowStep == 2 ? srcA + srcRowStride : srcA;
+
+         do_row(job->datatype, job->comps, job->width[level - 1], srcA, srcB,
+                job->width[level], dst + row * dstRowStride);
+      }
+   }
+}
+
+
+static bool
+mipmap_target_is_2d(GLenum target)
+{
+   switch (target) {
+   case GL_TEXTURE_2D:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+   case GL_TEXTURE_2D_ARRAY_EXT:
+   case GL_TEXTURE_CUBE_MAP_ARRAY:
+      return true;
+   default:
+      return false;
+   }
+}
+
+
+static void
+make_2d_mipmap_levels(struct mipmap_2d_job *job)
+{
+   const GLint bpt = bytes_per_pixel(job->datatype, job->comps);
+
+   job->band_height = mipmap_band_height(job->width[0] * bpt);
+   assert(job->num_levels >= 1);
+   assert(job->num_levels <= MIN2(util_logbase2(job->band_height) + 1,
+                                  MIPMAP_MAX_FUSED_LEVELS));
+   job->bands_per_slice = DIV_ROUND_UP(job->height[1], job->band_height);
+
+   util_parallel_for(job->depth * job->bands_per_slice, generate_2d_band, job);
+}
+
+
 static void
 make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight, GLint srcDepth,
@@ -1734,6 +2053,22 @@ _mesa_generate_mipmap_level(GLenum target,
 {
    int i;
 
+   if (border == 0 && mipmap_target_is_2d(target)) {
+      struct mipmap_2d_job job = {
+         .datatype = datatype,
+         .comps = comps,
+         .num_levels = 1,
+         .depth = dstDepth,
+         .width = { srcWidth, dstWidth },
+         .height = { srcHeight, dstHeight },
+         .row_stride = { srcRowStride, dstRowStride },
+         .maps = { (GLubyte **) srcData, dstData },
+      };
+
+      make_2d_mipmap_levels(&job);
+      return;
+   }
+
    switch (target) {
    case GL_TEXTURE_1D:
       make_1d_mipmap(datatype, comps, border,
@@ -1785,6 +2120,98 @@ _mesa_generate_mipmap_level(GLenum target,
 }
 
 
+/**
+ * Generate up to MIPMAP_MAX_FUSED_LEVELS levels following srcLevel of a
+ * borderless 2D, cube or array texture in one pass.
+ * \return the number of levels generated, 0 if none could be.
+ */
+static GLuint
+generate_2d_mipmap_levels(struct gl_context *ctx, GLenum target,
+                          struct gl_texture_object *texObj,
+                          GLenum datatype, GLuint comps,
+                          GLuint srcLevel, GLuint maxLevel)
+{
+   struct gl_texture_image *images[MIPMAP_MAX_FUSED_LEVELS + 1];
+   struct mipmap_2d_job job = {
+      .datatype = datatype,
+      .comps = comps,
+   };
+   GLboolean success = GL_TRUE;
+   GLuint max_levels, l;
+   GLint slice;
+
+   images[0] = _mesa_select_tex_image(texObj, target, srcLevel);
+   assert(images[0]);
+
+   max_levels =
+      MIN2(util_logbase2(mipmap_band_height(images[0]->Width *
+                                            bytes_per_pixel(datatype, comps))) + 1,
+           MIPMAP_MAX_FUSED_LEVELS);
+
+   while (job.num_levels < max_levels &&
+          srcLevel + job.num_levels < maxLevel) {
+      struct gl_texture_image *dstImage =
+         _mesa_select_tex_image(texObj, target, srcLevel + job.num_levels + 1);
+      if (!dstImage)
+         break;
+      images[++job.num_levels] = dstImage;
+   }
+
+   if (!job.num_levels)
+      return 0;
+
+   /* Map all slices of every level.  The levels in between are written and
+    * then read back as the source of the next one.
+    */
+   job.depth = images[0]->Depth;
+   for (l = 0; l <= job.num_levels; l++) {
+      GLbitfield mode = l == 0 ? GL_MAP_READ_BIT :
+                        l == job.num_levels ? GL_MAP_WRITE_BIT :
+                        GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;
+
+      job.width[l] = images[l]->Width;
+      job.height[l] = images[l]->Height;
+      job.maps[l] = calloc(job.depth, sizeof(GLubyte *));
+      if (!job.maps[l]) {
+         success = GL_FALSE;
+         break;
+      }
+
+      for (slice = 0; slice < job.depth; slice++) {
+         st_MapTextureImage(ctx, images[l], slice,
+                            0, 0, job.width[l], job.height[l], mode,
+                            &job.maps[l][slice], &job.row_stride[l]);
+         if (!job.maps[l][slice]) {
+            success = GL_FALSE;
+            break;
+         }
+      }
+      if (!success)
+         break;
+   }
+
+   if (success)
+      make_2d_mipmap_levels(&job);
+
+   for (l = 0; l <= job.num_levels; l++) {
+      if (job.maps[l]) {
+         for (slice = 0; slice < job.depth; slice++) {
+            if (job.maps[l][slice])
+               st_UnmapTextureImage(ctx, images[l], slice);
+         }
+         free(job.maps[l]);
+      }
+   }
+
+   if (!success) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "mipmap generation");
+      return 0;
+   }
+
+   return job.num_levels;
+}
+
+
 /**
  * compute next (level+1) image size
  * \return GL_FALSE if no smaller size can be generated (eg. src is 1x1x1 size)
@@ -1979,6 +2406,16 @@ generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
       srcDepth = srcImage->Depth;
       border = srcImage->Border;
 
+      if (border == 0 && mipmap_target_is_2d(target)) {
+         GLuint num_levels =
+            generate_2d_mipmap_levels(ctx, target, texObj, datatype, comps,
+                                      level, maxLevel);
+         if (!num_levels)
+            break;
+         level += num_levels - 1;
+         continue;
+      }
+
       /* get dest gl_texture_image */
       dstImage = _mesa_select_tex_image(texObj, target, level + 1);
       if (!dstImage) {
@@ -26,8 +26,14 @@
 #ifndef MIPMAP_H
 #define MIPMAP_H
 
+#include <stdbool.h>
+
 #include "glheader.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 struct gl_texture_object;
 
@@ -50,4 +56,17 @@ _mesa_next_mipmap_level_size(GLenum target, GLint border,
                        GLint srcWidth, GLint srcHeight, GLint srcDepth,
                        GLint *dstWidth, GLint *dstHeight, GLint *dstDepth);
 
+/**
+ * Box filter one row of a mipmap level, for the unit tests: \p simd picks
+ * the SSE2 code that _mesa_generate_mipmap() uses, or the plain C code.
+ */
+extern void
+_mesa_generate_mipmap_row(GLenum datatype, GLuint comps, GLint srcWidth,
+                          const void *srcRowA, const void *srcRowB,
+                          GLint dstWidth, void *dstRow, bool simd);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* MIPMAP_H */
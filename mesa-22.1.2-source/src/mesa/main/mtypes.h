@@ -1427,6 +1427,7 @@ struct gl_buffer_object
    /** Memoization of min/max index computations for static index buffers */
    simple_mtx_t MinMaxCacheMutex;
    struct hash_table *MinMaxCache;
+   struct vbo_minmax_blocks *MinMaxBlocks;
    unsigned MinMaxCacheHitIndices;
    unsigned MinMaxCacheMissIndices;
    bool MinMaxCacheDirty;
@@ -480,6 +480,15 @@ read_rgba_pixels( struct gl_context *ctx,
    }
    rb_format = _mesa_get_srgb_format_linear(rb->Format);
 
+   /* Formats with a padding channel aren't array formats, which would make
+    * _mesa_format_convert() unpack them to a temporary image first.  Read
+    * them as their RGBA equivalents instead, with the rebase swizzle below
+    * replacing the padding with one, so that they are swizzled straight
+    * into the destination.
+    */
+   if (rb->_BaseFormat == GL_RGB)
+      rb_format = _mesa_format_fallback_rgbx_to_rgba(rb_format);
+
    /*
     * Depending on the base formats involved in the conversion we might need to
     * rebase some values, so for these formats we compute a rebase swizzle.
@@ -0,0 +1,229 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "main/hash.h"
+
+static void
+count_entry(void *data, void *userData)
+{
+   (*(unsigned *)userData)++;
+}
+
+/* Names from the direct array and the hash table side by side. */
+TEST(HashTable, DirectAndOutliers)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   const GLuint outliers[] = {
+      MESA_HASH_DIRECT_MAX_KEY, MESA_HASH_DIRECT_MAX_KEY + 1,
+      0x80000000u, 0xfffffffeu,
+   };
+   std::vector<uint32_t> objects(5000 + ARRAY_SIZE(outliers));
+
+   for (GLuint i = 1; i <= 5000; i++)
+      _mesa_HashInsert(table, i, &objects[i - 1], GL_TRUE);
+   for (unsigned i = 0; i < ARRAY_SIZE(outliers); i++)
+      _mesa_HashInsert(table, outliers[i], &objects[5000 + i], GL_FALSE);
+
+   EXPECT_EQ(_mesa_HashNumEntries(table), 5000 + ARRAY_SIZE(outliers));
+   for (GLuint i = 1; i <= 5000; i++)
+      EXPECT_EQ(_mesa_HashLookup(table, i), &objects[i - 1]);
+   for (unsigned i = 0; i < ARRAY_SIZE(outliers); i++)
+      EXPECT_EQ(_mesa_HashLookup(table, outliers[i]), &objects[5000 + i]);
+   EXPECT_EQ(_mesa_HashLookup(table, 5001), nullptr);
+   EXPECT_EQ(_mesa_HashLookup(table, MESA_HASH_DIRECT_MAX_KEY - 1), nullptr);
+   EXPECT_EQ(_mesa_HashLookup(table, 0x80000001u), nullptr);
+
+   /* Replacing doesn't add an entry. */
+   _mesa_HashInsert(table, 1, &objects[1], GL_FALSE);
+   EXPECT_EQ(_mesa_HashLookup(table, 1), &objects[1]);
+   EXPECT_EQ(_mesa_HashNumEntries(table), 5000 + ARRAY_SIZE(outliers));
+
+   for (GLuint i = 1; i <= 5000; i += 2)
+      _mesa_HashRemove(table, i);
+   _mesa_HashRemove(table, 0x80000000u);
+
+   for (GLuint i = 1; i <= 5000; i++)
+      EXPECT_EQ(_mesa_HashLookup(table, i), i % 2 ? nullptr : &objects[i - 1]);
+   EXPECT_EQ(_mesa_HashLookup(table, 0x80000000u), nullptr);
+
+   unsigned count = 0;
+   _mesa_HashWalk(table, count_entry, &count);
+   EXPECT_EQ(count, 2500 + ARRAY_SIZE(outliers) - 1);
+   EXPECT_EQ(_mesa_HashNumEntries(table), count);
+
+   count = 0;
+   _mesa_HashDeleteAll(table, count_entry, &count);
+   EXPECT_EQ(count, 2500 + ARRAY_SIZE(outliers) - 1);
+   EXPECT_EQ(_mesa_HashNumEntries(table), 0);
+   EXPECT_EQ(_mesa_HashLookup(table, 2), nullptr);
+   EXPECT_EQ(_mesa_HashLookup(table, 0xfffffffeu), nullptr);
+
+   _mesa_DeleteHashTable(table);
+}
+
+static void
+collect_entry(void *data, void *userData)
+{
+   ((std::vector<void *> *)userData)->push_back(data);
+}
+
+/* Walks only visit the names in use, however far apart they are. */
+TEST(HashTable, SparseWalk)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   const GLuint names[] = {
+      1, 31, 32, 33, 1023, 1024, 5000, MESA_HASH_DIRECT_MAX_KEY - 1,
+   };
+   uint32_t objects[ARRAY_SIZE(names)];
+
+   for (unsigned i = 0; i < ARRAY_SIZE(names); i++)
+      _mesa_HashInsert(table, names[i], &objects[i], GL_FALSE);
+   _mesa_HashRemove(table, 32);
+   _mesa_HashRemove(table, 1024);
+   _mesa_HashRemove(table, MESA_HASH_DIRECT_MAX_KEY - 1);
+
+   std::vector<void *> walked;
+   _mesa_HashWalk(table, collect_entry, &walked);
+   const std::vector<void *> expected = {
+      &objects[0], &objects[1], &objects[3], &objects[4], &objects[6],
+   };
+   EXPECT_EQ(walked, expected);
+
+   walked.clear();
+   _mesa_HashDeleteAll(table, collect_entry, &walked);
+   EXPECT_EQ(walked, expected);
+
+   walked.clear();
+   _mesa_HashWalk(table, collect_entry, &walked);
+   EXPECT_TRUE(walked.empty());
+
+   /* Blocks emptied by removals are reused. */
+   _mesa_HashInsert(table, 1024, &objects[5], GL_FALSE);
+   _mesa_HashWalk(table, collect_entry, &walked);
+   EXPECT_EQ(walked, std::vector<void *>{&objects[5]});
+   _mesa_HashRemove(table, 1024);
+
+   _mesa_DeleteHashTable(table);
+}
+
+TEST(HashTable, NameReuse)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   uint32_t objects[64];
+   GLuint keys[64];
+
+   _mesa_HashEnableNameReuse(table);
+
+   ASSERT_TRUE(_mesa_HashFindFreeKeys(table, keys, 64));
+   for (unsigned i = 0; i < 64; i++)
+      _mesa_HashInsert(table, keys[i], &objects[i], GL_TRUE);
+
+   _mesa_HashRemove(table, keys[10]);
+   EXPECT_EQ(_mesa_HashFindFreeKeyBlock(table, 1), keys[10]);
+   EXPECT_EQ(_mesa_HashNumEntries(table), 63);
+
+   unsigned count = 0;
+   _mesa_HashDeleteAll(table, count_entry, &count);
+   EXPECT_EQ(count, 63);
+
+   _mesa_DeleteHashTable(table);
+}
+
+/* The direct array is only allocated by the first name that goes into it,
+ * so tables that stay empty or only hold outliers don't pay for it.
+ */
+TEST(HashTable, LazyDirect)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   uint32_t objects[2];
+   unsigned count = 0;
+
+   EXPECT_EQ(_mesa_HashLookup(table, 1), nullptr);
+   _mesa_HashRemove(table, 1);
+   _mesa_HashWalk(table, count_entry, &count);
+   EXPECT_EQ(count, 0);
+   EXPECT_EQ(table->Direct, nullptr);
+
+   _mesa_HashInsert(table, 0x80000000u, &objects[0], GL_FALSE);
+   EXPECT_EQ(table->Direct, nullptr);
+   EXPECT_EQ(_mesa_HashLookup(table, 7), nullptr);
+
+   _mesa_HashInsert(table, 7, &objects[1], GL_FALSE);
+   EXPECT_NE(table->Direct, nullptr);
+   EXPECT_EQ(_mesa_HashLookup(table, 7), &objects[1]);
+   EXPECT_EQ(_mesa_HashLookup(table, 0x80000000u), &objects[0]);
+
+   _mesa_HashRemove(table, 7);
+   _mesa_HashRemove(table, 0x80000000u);
+   EXPECT_EQ(_mesa_HashNumEntries(table), 0);
+
+   _mesa_DeleteHashTable(table);
+}
+
+/* Per-call cost of the lookups done by glBind*(): genned names, which are
+ * in the direct array, and application-picked names far apart, which are in
+ * the hash table.  Prints nanoseconds per lookup.
+ */
+TEST(HashTable, BindLookupPerf)
+{
+   static const unsigned num_objects = 4096;
+   static const unsigned num_lookups = 4000000;
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   std::vector<uint32_t> objects(2 * num_objects);
+
+   for (GLuint i = 0; i < num_objects; i++) {
+      _mesa_HashInsert(table, i + 1, &objects[i], GL_TRUE);
+      _mesa_HashInsert(table, MESA_HASH_DIRECT_MAX_KEY + i * 65537u,
+                       &objects[num_objects + i], GL_FALSE);
+   }
+
+   for (unsigned outlier = 0; outlier < 2; outlier++) {
+      uintptr_t sum = 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < num_lookups; i++) {
+         /* Stride through the names like a draw loop binding textures. */
+         GLuint index = (i * 7) % num_objects;
+         GLuint name = outlier ? MESA_HASH_DIRECT_MAX_KEY + index * 65537u
+                               : index + 1;
+         sum += (uintptr_t)_mesa_HashLookup(table, name);
+      }
+      auto elapsed = std::chrono::duration<double, std::nano>(
+         std::chrono::steady_clock::now() - start).count();
+
+      EXPECT_NE(sum, 0);
+      printf("%-24s %6.2f ns/op\n", outlier ? "lookup (hashed)" : "lookup (direct)",
+             elapsed / num_lookups);
+   }
+
+   for (GLuint i = 0; i < num_objects; i++) {
+      _mesa_HashRemove(table, i + 1);
+      _mesa_HashRemove(table, MESA_HASH_DIRECT_MAX_KEY + i * 65537u);
+   }
+   _mesa_DeleteHashTable(table);
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "main/mtypes.h"
+#include "main/draw.h"
+#include "vbo/vbo.h"
+#include "frontend/api.h"
+#include "pipe/p_context.h"
+#include "pipe/p_state.h"
+
+/* Index buffer min/max of draws that go through the vbo caches, with the
+ * buffer "mapped" straight from client memory by a fake pipe_context.
+ */
+class minmax_cache : public ::testing::Test {
+protected:
+   static const unsigned num_indices = 512 * 1024;
+
+   void SetUp() override
+   {
+      ctx = (struct gl_context *) calloc(1, sizeof(*ctx));
+      ctx->pipe = &pipe;
+      ctx->st_opts = &st_opts;
+      pipe.buffer_map = buffer_map;
+      pipe.buffer_unmap = buffer_unmap;
+
+      indices.resize(num_indices);
+      for (unsigned i = 0; i < num_indices; i++)
+         indices[i] = 100 + (i * 7) % 50000;
+
+      resource.width0 = num_indices * sizeof(GLushort);
+      obj = (struct gl_buffer_object *) calloc(1, sizeof(*obj));
+      obj->RefCount = 1;
+      simple_mtx_init(&obj->MinMaxCacheMutex, mtx_plain);
+      obj->Size = resource.width0;
+      obj->buffer = &resource;
+      data = indices.data();
+   }
+
+   void TearDown() override
+   {
+      vbo_delete_minmax_cache(obj);
+      simple_mtx_destroy(&obj->MinMaxCacheMutex);
+      free(obj);
+      free(ctx);
+   }
+
+   static void *buffer_map(struct pipe_context *pipe,
+                           struct pipe_resource *resource, unsigned level,
+                           unsigned usage, const struct pipe_box *box,
+                           struct pipe_transfer **out_transfer)
+   {
+      static struct pipe_transfer transfer;
+      *out_transfer = &transfer;
+      return (char *) data + box->x;
+   }
+
+   static void buffer_unmap(struct pipe_context *pipe,
+                            struct pipe_transfer *transfer)
+   {
+   }
+
+   /* glBufferSubData() of some indices. */
+   void sub_data(unsigned start, unsigned count, GLushort value)
+   {
+      std::fill(&indices[start], &indices[start + count], value);
+      vbo_minmax_cache_invalidate(obj, start * sizeof(GLushort),
+                                  count * sizeof(GLushort));
+   }
+
+   /* Min/max of a glDrawElements() of the whole buffer. */
+   void draw(GLuint *min, GLuint *max)
+   {
+      struct _mesa_prim prim = {};
+      struct _mesa_index_buffer ib = {};
+
+      prim.mode = GL_TRIANGLES;
+      prim.count = num_indices;
+      ib.count = num_indices;
+      ib.index_size_shift = 1;
+      ib.obj = obj;
+      ib.ptr = NULL;
+
+      vbo_get_minmax_indices(ctx, &prim, &ib, min, max, 1, false, 0);
+   }
+
+   static void *data;
+   struct gl_context *ctx;
+   struct pipe_context pipe = {};
+   struct st_config_options st_opts = {};
+   struct pipe_resource resource = {};
+   struct gl_buffer_object *obj;
+   std::vector<GLushort> indices;
+};
+
+void *minmax_cache::data;
+
+/* An application streaming small glBufferSubData() updates between draws
+ * misses the cache of draw ranges every time, but the block summary only
+ * has to scan the blocks that were written, and must not be thrown away.
+ */
+TEST_F(minmax_cache, sub_data_streaming)
+{
+   GLuint min, max;
+
+   for (unsigned frame = 0; frame < 64; frame++) {
+      const unsigned start = (frame * 4099) % (num_indices - 64);
+      sub_data(start, 64, 10 + frame);
+
+      draw(&min, &max);
+      EXPECT_EQ(min, *std::min_element(indices.begin(), indices.end()));
+      EXPECT_EQ(max, *std::max_element(indices.begin(), indices.end()));
+   }
+
+   EXPECT_NE(obj->MinMaxBlocks, nullptr);
+   EXPECT_FALSE(obj->UsageHistory & USAGE_DISABLE_MINMAX_CACHE);
+   EXPECT_GT(obj->MinMaxCacheHitIndices, obj->MinMaxCacheMissIndices);
+
+   /* Write behind the caches' back into a block that isn't written by the
+    * next glBufferSubData().  Only the block summary can still remember the
+    * old contents, so seeing them proves that the draw used it.
+    */
+   indices[num_indices / 2] = 60000;
+   sub_data(0, 64, 10);
+
+   draw(&min, &max);
+   EXPECT_EQ(min, 10u);
+   EXPECT_LT(max, 60000u);
+}
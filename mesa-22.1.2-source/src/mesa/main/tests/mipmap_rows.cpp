@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "main/glheader.h"
+#include "main/mipmap.h"
+
+/* The SSE2 row kernels must give the same bits as the plain C code, for
+ * both column strides, for every pixel size and for widths that leave a
+ * scalar tail.
+ */
+template<typename T>
+static void
+check_rows(GLenum datatype, T (*random_value)(std::mt19937 &))
+{
+   std::mt19937 rng(42);
+
+   for (GLuint comps = 1; comps <= 4; comps++) {
+      for (GLint dstWidth = 1; dstWidth <= 70; dstWidth++) {
+         const GLint srcWidths[] = {
+            dstWidth, 2 * dstWidth, 2 * dstWidth + 1,
+         };
+
+         for (GLint srcWidth : srcWidths) {
+            std::vector<T> a(srcWidth * comps), b(srcWidth * comps);
+            std::vector<T> simd(dstWidth * comps), scalar(dstWidth * comps);
+
+            for (unsigned i = 0; i < a.size(); i++) {
+               a[i] = random_value(rng);
+               b[i] = random_value(rng);
+            }
+
+            _mesa_generate_mipmap_row(datatype, comps, srcWidth,
+                                      a.data(), b.data(), dstWidth,
+                                      simd.data(), true);
+            _mesa_generate_mipmap_row(datatype, comps, srcWidth,
+                                      a.data(), b.data(), dstWidth,
+                                      scalar.data(), false);
+
+            ASSERT_EQ(0, memcmp(simd.data(), scalar.data(),
+                                simd.size() * sizeof(T)))
+               << "comps " << comps << ", width " << srcWidth
+               << " -> " << dstWidth;
+         }
+      }
+   }
+}
+
+static GLubyte
+random_ubyte(std::mt19937 &rng)
+{
+   return rng() & 0xff;
+}
+
+static GLfloat
+random_float(std::mt19937 &rng)
+{
+   /* Mix magnitudes so that the order of the additions matters. */
+   std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+   std::uniform_int_distribution<int> exponent(-20, 20);
+   return ldexpf(value(rng), exponent(rng));
+}
+
+TEST(MipmapRows, UnsignedByte)
+{
+   check_rows<GLubyte>(GL_UNSIGNED_BYTE, random_ubyte);
+}
+
+TEST(MipmapRows, Float)
+{
+   check_rows<GLfloat>(GL_FLOAT, random_float);
+}
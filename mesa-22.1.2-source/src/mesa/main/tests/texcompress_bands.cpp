@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "main/formats.h"
+#include "main/texcompress.h"
+#include "main/texcompress_astc.h"
+#include "main/texcompress_etc.h"
+
+/* Large images are decoded in bands of block rows, possibly on several
+ * threads.  The result must be the same as decoding the whole image in
+ * one go on the calling thread.  The sizes give many bands, a short last
+ * band and a partial last block column.
+ */
+static const unsigned width = 1001, height = 699;
+
+static std::vector<uint8_t>
+random_blocks(mesa_format format, unsigned *src_stride)
+{
+   std::mt19937 rng(7);
+   unsigned bw, bh;
+
+   _mesa_get_format_block_size(format, &bw, &bh);
+   *src_stride = DIV_ROUND_UP(width, bw) * _mesa_get_format_bytes(format);
+
+   std::vector<uint8_t> blocks(*src_stride * DIV_ROUND_UP(height, bh));
+   for (uint8_t &b : blocks)
+      b = rng() & 0xff;
+   return blocks;
+}
+
+static void
+check_unpack(mesa_format format, bool bgra)
+{
+   unsigned src_stride;
+   std::vector<uint8_t> src = random_blocks(format, &src_stride);
+   /* Enough for any of the uncompressed layouts. */
+   const unsigned dst_stride = width * 8;
+   std::vector<uint8_t> banded(dst_stride * height);
+   std::vector<uint8_t> whole(dst_stride * height);
+
+   _mesa_unpack_compressed_image(banded.data(), dst_stride,
+                                 src.data(), src_stride,
+                                 width, height, format, bgra);
+
+   if (format == MESA_FORMAT_ETC1_RGB8)
+      _mesa_etc1_unpack_rgba8888(whole.data(), dst_stride,
+                                 src.data(), src_stride, width, height);
+   else if (_mesa_is_format_etc2(format))
+      _mesa_unpack_etc2_format(whole.data(), dst_stride,
+                               src.data(), src_stride, width, height,
+                               format, bgra);
+   else
+      _mesa_unpack_astc_2d_ldr(whole.data(), dst_stride,
+                               src.data(), src_stride, width, height,
+                               format);
+
+   EXPECT_EQ(0, memcmp(banded.data(), whole.data(), banded.size()))
+      << _mesa_get_format_name(format);
+}
+
+/* Filled when the first context is created, which these tests don't do. */
+extern "C" GLfloat _mesa_ubyte_to_float_color_tab[256];
+
+static void
+check_decompress(mesa_format format)
+{
+   unsigned src_stride;
+   std::vector<uint8_t> src = random_blocks(format, &src_stride);
+   std::vector<float> banded(width * height * 4);
+   std::vector<float> whole(width * height * 4);
+   compressed_fetch_func fetch = _mesa_get_compressed_fetch_func(format);
+   unsigned bw, bh;
+
+   _mesa_decompress_image(format, width, height, src.data(), src_stride,
+                          banded.data());
+
+   /* The fetch functions take the row stride in texels. */
+   _mesa_get_format_block_size(format, &bw, &bh);
+   const GLint fetch_stride = src_stride * bh / _mesa_get_format_bytes(format);
+   float *dst = whole.data();
+   for (unsigned j = 0; j < height; j++) {
+      for (unsigned i = 0; i < width; i++) {
+         fetch(src.data(), fetch_stride, i, j, dst);
+         dst += 4;
+      }
+   }
+
+   EXPECT_EQ(0, memcmp(banded.data(), whole.data(),
+                       banded.size() * sizeof(float)))
+      << _mesa_get_format_name(format);
+}
+
+TEST(TexcompressBands, ETC)
+{
+   check_unpack(MESA_FORMAT_ETC1_RGB8, false);
+   check_unpack(MESA_FORMAT_ETC2_RGB8, false);
+   check_unpack(MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC, true);
+   check_unpack(MESA_FORMAT_ETC2_RG11_EAC, false);
+}
+
+TEST(TexcompressBands, ASTC)
+{
+   check_unpack(MESA_FORMAT_RGBA_ASTC_4x4, false);
+   check_unpack(MESA_FORMAT_RGBA_ASTC_5x4, false);
+   check_unpack(MESA_FORMAT_SRGB8_ALPHA8_ASTC_12x12, false);
+}
+
+TEST(TexcompressBands, BPTC)
+{
+   for (unsigned i = 0; i < 256; i++)
+      _mesa_ubyte_to_float_color_tab[i] = (float) i / 255.0F;
+
+   check_decompress(MESA_FORMAT_BPTC_RGBA_UNORM);
+   check_decompress(MESA_FORMAT_BPTC_RGB_UNSIGNED_FLOAT);
+}
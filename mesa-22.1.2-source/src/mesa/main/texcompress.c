@@ -37,11 +37,13 @@
 #include "mtypes.h"
 #include "context.h"
 #include "texcompress.h"
+#include "texcompress_astc.h"
 #include "texcompress_fxt1.h"
 #include "texcompress_rgtc.h"
 #include "texcompress_s3tc.h"
 #include "texcompress_etc.h"
 #include "texcompress_bptc.h"
+#include "util/u_parallel.h"
 
 
 /**
@@ -896,6 +898,123 @@ _mesa_get_compressed_fetch_func(mesa_format format)
 }
 
 
+/**
+ * Large images are decoded in bands of whole block rows, which are run in
+ * parallel with util_parallel_for().
+ */
+#define DECOMPRESS_BLOCKS_PER_BAND 1024
+
+struct decompress_job {
+   /** Decodes texel rows [y, y + height), y being a multiple of block_h. */
+   void (*decode)(const struct decompress_job *job,
+                  unsigned y, unsigned height);
+
+   mesa_format format;
+   unsigned width, height;
+   unsigned block_w, block_h;
+
+   const GLubyte *src;
+   unsigned src_stride;
+   GLubyte *dst;
+   unsigned dst_stride;
+
+   compressed_fetch_func fetch;
+   bool bgra;
+
+   unsigned band_height;
+};
+
+static void
+decompress_band(void *data, unsigned band)
+{
+   const struct decompress_job *job = (const struct decompress_job *)data;
+   unsigned y = band * job->band_height;
+
+   job->decode(job, y, MIN2(job->band_height, job->height - y));
+}
+
+static void
+decompress_run(struct decompress_job *job)
+{
+   if (job->width == 0 || job->height == 0)
+      return;
+
+   unsigned blocks_x = DIV_ROUND_UP(job->width, job->block_w);
+   unsigned blocks_y = DIV_ROUND_UP(job->height, job->block_h);
+   unsigned band_rows = DIV_ROUND_UP(DECOMPRESS_BLOCKS_PER_BAND, blocks_x);
+
+   job->band_height = band_rows * job->block_h;
+
+   util_parallel_for(DIV_ROUND_UP(blocks_y, band_rows), decompress_band, job);
+}
+
+
+static void
+unpack_image_rows(const struct decompress_job *job, unsigned y, unsigned height)
+{
+   const GLubyte *src = job->src + y / job->block_h * job->src_stride;
+   GLubyte *dst = job->dst + y * job->dst_stride;
+
+   if (job->format == MESA_FORMAT_ETC1_RGB8) {
+      _mesa_etc1_unpack_rgba8888(dst, job->dst_stride, src, job->src_stride,
+                                 job->width, height);
+   } else if (_mesa_is_format_etc2(job->format)) {
+      _mesa_unpack_etc2_format(dst, job->dst_stride, src, job->src_stride,
+                               job->width, height, job->format, job->bgra);
+   } else {
+      _mesa_unpack_astc_2d_ldr(dst, job->dst_stride, src, job->src_stride,
+                               job->width, height, job->format);
+   }
+}
+
+
+/**
+ * Decompress an ETC1, ETC2 or 2D ASTC image to the uncompressed layout
+ * used when the driver doesn't support the format: RGBA8888 for ETC1 and
+ * ASTC, and whatever _mesa_unpack_etc2_format() writes for ETC2.
+ * \param src_stride  stride in bytes between rows of blocks.
+ * \param bgra  swap red and blue for the sRGB ETC2 formats.
+ */
+void
+_mesa_unpack_compressed_image(uint8_t *dst_row, unsigned dst_stride,
+                              const uint8_t *src_row, unsigned src_stride,
+                              unsigned width, unsigned height,
+                              mesa_format format, bool bgra)
+{
+   struct decompress_job job = {
+      .decode = unpack_image_rows,
+      .format = format,
+      .width = width,
+      .height = height,
+      .src = src_row,
+      .src_stride = src_stride,
+      .dst = dst_row,
+      .dst_stride = dst_stride,
+      .bgra = bgra,
+   };
+
+   assert(format == MESA_FORMAT_ETC1_RGB8 || _mesa_is_format_etc2(format) ||
+          _mesa_is_format_astc_2d(format));
+
+   _mesa_get_format_block_size(format, &job.block_w, &job.block_h);
+   decompress_run(&job);
+}
+
+
+static void
+fetch_image_rows(const struct decompress_job *job, unsigned y, unsigned height)
+{
+   GLfloat *dest = (GLfloat *)(job->dst + y * job->dst_stride);
+
+   for (unsigned j = y; j < y + height; j++) {
+      for (unsigned i = 0; i < job->width; i++) {
+         job->fetch(job->src, job->src_stride, i, j, dest);
+         dest += 4;
+      }
+   }
+}
+
+
 /**
  * Decompress a compressed texture image, returning a GL_RGBA/GL_FLOAT image.
  * \param srcRowStride  stride in bytes between rows of blocks in the
@@ -906,26 +1025,24 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
                        GLfloat *dest)
 {
-   compressed_fetch_func fetch;
-   GLuint i, j;
-   GLuint bytes, bw, bh;
-   GLint stride;
-
-   bytes = _mesa_get_format_bytes(format);
-   _mesa_get_format_block_size(format, &bw, &bh);
+   struct decompress_job job = {
+      .decode = fetch_image_rows,
+      .format = format,
+      .width = width,
+      .height = height,
+      .src = src,
+      .dst = (GLubyte *)dest,
+      .dst_stride = width * 4 * sizeof(GLfloat),
+   };
 
-   fetch = _mesa_get_compressed_fetch_func(format);
-   if (!fetch) {
+   job.fetch = _mesa_get_compressed_fetch_func(format);
+   if (!job.fetch) {
       _mesa_problem(NULL, "Unexpected format in _mesa_decompress_image()");
       return;
    }
 
-   stride = srcRowStride * bh / bytes;
+   _mesa_get_format_block_size(format, &job.block_w, &job.block_h);
+   job.src_stride = srcRowStride * job.block_h / _mesa_get_format_bytes(format);
 
-   for (j = 0; j < height; j++) {
-      for (i = 0; i < width; i++) {
-         fetch(src, stride, i, j, dest);
-         dest += 4;
-      }
-   }
+   decompress_run(&job);
 }
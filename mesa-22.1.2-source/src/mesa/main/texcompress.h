@@ -28,6 +28,10 @@
 #include "formats.h"
 #include "glheader.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 
 extern GLenum
@@ -58,9 +62,19 @@ extern compressed_fetch_func
 _mesa_get_compressed_fetch_func(mesa_format format);
 
 
+extern void
+_mesa_unpack_compressed_image(uint8_t *dst_row, unsigned dst_stride,
+                              const uint8_t *src_row, unsigned src_stride,
+                              unsigned width, unsigned height,
+                              mesa_format format, bool bgra);
+
 extern void
 _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
                        GLfloat *dest);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* TEXCOMPRESS_H */
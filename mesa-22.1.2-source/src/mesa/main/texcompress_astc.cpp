@@ -35,17 +35,31 @@
 
 #include "texcompress_astc.h"
 #include "macros.h"
+#include "util/bitscan.h"
 #include "util/half_float.h"
 #include <stdio.h>
 #include <cstdlib>  // for abort() on windows
+#include <cstring>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || \
+    (defined(_M_X64) && !defined(_M_ARM64EC))
+#include <emmintrin.h>
+#define ASTC_SSE2 1
+#endif
 
 static bool VERBOSE_DECODE = false;
 static bool VERBOSE_WRITE = false;
 
+/* Same as _mesa_half_to_unorm8(_mesa_uint16_div_64k_to_half(v)), without
+ * the round trip through FP16: the conversion to FP16 keeps the 11 most
+ * significant bits of v, and the conversion to unorm8 rounds v * 255 / 64k
+ * to nearest.
+ */
 static inline uint8_t
 uint16_div_64k_to_half_to_unorm8(uint16_t v)
 {
-   return _mesa_half_to_unorm8(_mesa_uint16_div_64k_to_half(v));
+   unsigned drop = MAX2(util_last_bit(v), 11) - 11;
+   return ((v >> drop << drop) * 255 + 32768) >> 16;
 }
 
 class decode_error
@@ -1606,6 +1620,72 @@ decode_error::type Block::decode(const Decoder &decoder, InputBitVector in)
    return decode_error::ok;
 }
 
+/**
+ * Interpolate the endpoints of one texel and convert the result to unorm8.
+ *
+ * The endpoints are expanded to UNORM16 as e * 257, or e * 256 + 128 for
+ * sRGB, so the weighted sum can be taken on the 8-bit endpoints, where it
+ * fits in 16 bits, and scaled up afterwards.
+ */
+static inline void
+interpolate_unorm8(uint8x4_t e0, uint8x4_t e1, const int w[4], bool srgb,
+                   uint16_t *output)
+{
+#ifdef ASTC_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   uint32_t e0_bits, e1_bits;
+
+   memcpy(&e0_bits, e0.v, 4);
+   memcpy(&e1_bits, e1.v, 4);
+
+   /* (e0, e1) and (64 - w, w) pairs for each channel. */
+   __m128i e = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(e0_bits),
+                                                   _mm_cvtsi32_si128(e1_bits)),
+                                 zero);
+   __m128i wv = _mm_setr_epi16(64 - w[0], w[0], 64 - w[1], w[1],
+                               64 - w[2], w[2], 64 - w[3], w[3]);
+   __m128i sum = _mm_madd_epi16(e, wv);
+   __m128i c;
+
+   if (srgb) {
+      c = _mm_srli_epi32(_mm_add_epi32(_mm_slli_epi32(sum, 8),
+                                       _mm_set1_epi32(128 * 64 + 32)), 6);
+   } else {
+      c = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(sum, 8), sum),
+                                       _mm_set1_epi32(32)), 6);
+   }
+
+   /* uint16_div_64k_to_half_to_unorm8(): masking the float mantissa keeps
+    * the 11 most significant bits, and the rest is exact in float.
+    */
+   __m128 f = _mm_castsi128_ps(_mm_and_si128(_mm_castps_si128(_mm_cvtepi32_ps(c)),
+                                             _mm_set1_epi32(~0x1fff)));
+   f = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f)),
+                             _mm_set1_ps(32768.0f)),
+                  _mm_set1_ps(1.0f / 65536.0f));
+   __m128i unorm = _mm_cvttps_epi32(f);
+
+   if (srgb) {
+      const __m128i alpha = _mm_setr_epi32(0, 0, 0, -1);
+      unorm = _mm_or_si128(_mm_and_si128(alpha, unorm),
+                           _mm_andnot_si128(alpha, _mm_srli_epi32(c, 8)));
+   }
+
+   _mm_storel_epi64((__m128i *)output, _mm_packs_epi32(unorm, zero));
+#else
+   for (int i = 0; i < 4; i++) {
+      int sum = e0.v[i] * (64 - w[i]) + e1.v[i] * w[i];
+      uint16_t c = srgb ? (sum * 256 + 128 * 64 + 32) >> 6
+                        : (sum * 257 + 32) >> 6;
+
+      if (srgb && i < 3)
+         output[i] = c >> 8;
+      else
+         output[i] = uint16_div_64k_to_half_to_unorm8(c);
+   }
+#endif
+}
+
 void Block::write_decoded(const Decoder &decoder, uint16_t *output)
 {
    /* sRGB can only be stored as unorm8. */
@@ -1654,30 +1734,6 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
 
             uint8x4_t e0 = endpoints_decoded[0][partition];
             uint8x4_t e1 = endpoints_decoded[1][partition];
-            uint16_t c0[4], c1[4];
-
-            /* Expand to 16 bits. */
-            if (decoder.srgb) {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | 0x80);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | 0x80);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | 0x80);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | 0x80);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | 0x80);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | 0x80);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | 0x80);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | 0x80);
-            } else {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | e0.v[0]);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | e0.v[1]);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | e0.v[2]);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | e0.v[3]);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | e1.v[0]);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | e1.v[1]);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | e1.v[2]);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | e1.v[3]);
-            }
 
             int w[4];
             if (dual_plane) {
@@ -1690,6 +1746,19 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
                w[0] = w[1] = w[2] = w[3] = w0;
             }
 
+            if (decoder.output_unorm8) {
+               interpolate_unorm8(e0, e1, w, decoder.srgb, &output[idx*4]);
+               idx++;
+               continue;
+            }
+
+            /* Expand to 16 bits. */
+            uint16_t c0[4], c1[4];
+            for (int i = 0; i < 4; i++) {
+               c0[i] = (uint16_t)((e0.v[i] << 8) | e0.v[i]);
+               c1[i] = (uint16_t)((e1.v[i] << 8) | e1.v[i]);
+            }
+
             /* Interpolate to produce UNORM16, applying weights. */
             uint16_t c[4] = {
                (uint16_t)((c0[0] * (64 - w[0]) + c1[0] * w[0] + 32) >> 6),
@@ -1698,24 +1767,11 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
                (uint16_t)((c0[3] * (64 - w[3]) + c1[3] * w[3] + 32) >> 6),
             };
 
-            if (decoder.output_unorm8) {
-               if (decoder.srgb) {
-                  output[idx*4+0] = c[0] >> 8;
-                  output[idx*4+1] = c[1] >> 8;
-                  output[idx*4+2] = c[2] >> 8;
-               } else {
-                  output[idx*4+0] = c[0] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[0]);
-                  output[idx*4+1] = c[1] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[1]);
-                  output[idx*4+2] = c[2] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[2]);
-               }
-               output[idx*4+3] = c[3] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[3]);
-            } else {
-               /* Store the color as FP16. */
-               output[idx*4+0] = c[0] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[0]);
-               output[idx*4+1] = c[1] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[1]);
-               output[idx*4+2] = c[2] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[2]);
-               output[idx*4+3] = c[3] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[3]);
-            }
+            /* Store the color as FP16. */
+            output[idx*4+0] = c[0] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[0]);
+            output[idx*4+1] = c[1] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[1]);
+            output[idx*4+2] = c[2] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[2]);
+            output[idx*4+3] = c[3] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[3]);
 
             idx++;
          }
@@ -3847,6 +3847,42 @@ _mesa_TexSubImage2D( GLenum target, GLint level,
 }
 
 
+/**
+ * glTexSubImage2D with the client pixels staged by glthread in one of its
+ * upload buffers.  The upload buffer is used as the pixel unpack buffer
+ * for the duration of the call.
+ */
+void GLAPIENTRY
+_mesa_InternalTexSubImage2DUploadMESA(GLintptr srcBuffer, GLuint srcOffset,
+                                      GLenum target, GLint level,
+                                      GLint xoffset, GLint yoffset,
+                                      GLsizei width, GLsizei height,
+                                      GLenum format, GLenum type)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *src = (struct gl_buffer_object *)srcBuffer;
+   struct gl_buffer_object *unpack_buffer = ctx->Unpack.BufferObj;
+
+   ctx->Unpack.BufferObj = src;
+   if (_mesa_is_no_error_enabled(ctx)) {
+      texsubimage(ctx, 2, target, level,
+                  xoffset, yoffset, 0,
+                  width, height, 1,
+                  format, type, (const GLvoid *)(uintptr_t)srcOffset);
+   } else {
+      texsubimage_err(ctx, 2, target, level,
+                      xoffset, yoffset, 0,
+                      width, height, 1,
+                      format, type, (const GLvoid *)(uintptr_t)srcOffset,
+                      "glTexSubImage2D");
+   }
+   ctx->Unpack.BufferObj = unpack_buffer;
+
+   /* The caller passes the reference to this function, so unreference it. */
+   _mesa_reference_buffer_object(ctx, &src, NULL);
+}
+
+
 void GLAPIENTRY
 _mesa_TexSubImage3D_no_error(GLenum target, GLint level,
                              GLint xoffset, GLint yoffset, GLint zoffset,
@@ -432,7 +432,17 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    st_validate_state(st, ST_PIPELINE_UPDATE_FRAMEBUFFER);
    st_flush_bitmap_cache(st);
 
-   if (!st->prefer_blit_based_texture_transfer) {
+   /* Without blit-based transfers (llvmpipe, softpipe), _mesa_readpixels()
+    * maps the renderbuffer itself and converts straight into the user
+    * memory, so a staging copy would only add a pass.  Readbacks into a
+    * PBO still take the shader-based download below on drivers which
+    * prefer it (llvmpipe): it is queued behind the rendering like any other
+    * draw, while mapping the renderbuffer would wait for the rendering to
+    * finish.
+    */
+   if (!st->prefer_blit_based_texture_transfer &&
+       !(st->prefer_pbo_download_draw && st->pbo.download_enabled &&
+         pack->BufferObj)) {
       goto fallback;
    }
 
@@ -491,6 +501,10 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
          return;
    }
 
+   if (!st->prefer_blit_based_texture_transfer) {
+      goto fallback;
+   }
+
    if (needs_integer_signed_unsigned_conversion(ctx, format, type)) {
       goto fallback;
    }
@@ -387,6 +387,9 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    st_invalidate_readpix_cache(st);
    util_throttle_deinit(st->screen, &st->throttle);
 
+   if (util_queue_is_initialized(&st->link_queue))
+      util_queue_destroy(&st->link_queue);
+
    cso_destroy_context(st->cso_context);
 
    if (st->pipe && destroy_pipe)
@@ -525,6 +528,8 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
       st->prefer_blit_based_texture_transfer = (val & PIPE_TEXTURE_TRANSFER_BLIT) != 0;
       st->allow_compute_based_texture_transfer = (val & PIPE_TEXTURE_TRANSFER_COMPUTE) != 0;
    }
+   st->prefer_pbo_download_draw =
+      screen->get_param(screen, PIPE_CAP_PREFER_PBO_DOWNLOAD_DRAW);
    st_init_pbo_helpers(st);
 
    /* Choose texture target for glDrawPixels, glBitmap, renderbuffers */
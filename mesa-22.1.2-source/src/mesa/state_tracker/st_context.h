@@ -35,6 +35,7 @@
 #include "state_tracker/st_atom.h"
 #include "util/u_helpers.h"
 #include "util/u_inlines.h"
+#include "util/u_queue.h"
 #include "util/list.h"
 #include "vbo/vbo.h"
 #include "util/list.h"
@@ -145,6 +146,7 @@ struct st_context
    boolean has_astc_5x5_ldr;
    boolean prefer_blit_based_texture_transfer;
    boolean allow_compute_based_texture_transfer;
+   boolean prefer_pbo_download_draw;
    boolean force_persample_in_shader;
    boolean has_shareable_shaders;
    boolean has_half_float_packing;
@@ -382,6 +384,11 @@ struct st_context
       struct st_zombie_shader_node list;
       simple_mtx_t mutex;
    } zombie_shaders;
+
+   /* Worker threads for the stage-local parts of st_link_nir(), created
+    * on first use.
+    */
+   struct util_queue link_queue;
 };
 
 
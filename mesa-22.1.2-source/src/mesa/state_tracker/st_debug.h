@@ -32,6 +32,10 @@
 #include "pipe/p_compiler.h"
 #include "util/u_debug.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct st_context;
 
 #define DEBUG_MESA            BITFIELD_BIT(0)
@@ -41,6 +45,7 @@ struct st_context;
 #define DEBUG_WIREFRAME       BITFIELD_BIT(4)
 #define DEBUG_GREMEDY         BITFIELD_BIT(5)
 #define DEBUG_NOREADPIXCACHE  BITFIELD_BIT(6)
+#define DEBUG_SERIAL_LINK     BITFIELD_BIT(7)
 
 extern int ST_DEBUG;
 
@@ -59,5 +64,8 @@ ST_DBG( unsigned flag, const char *fmt, ... )
     }
 }
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* ST_DEBUG_H */
@@ -39,6 +39,7 @@
 
 #include "main/shaderobj.h"
 #include "st_context.h"
+#include "st_debug.h"
 #include "st_program.h"
 #include "st_shader_cache.h"
 
@@ -53,6 +54,8 @@
 #include "compiler/glsl/ir_optimization.h"
 #include "compiler/glsl/linker_util.h"
 #include "compiler/glsl/string_to_uint_map.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 
 static int
 type_size(const struct glsl_type *type)
@@ -305,8 +308,12 @@ shared_type_info(const struct glsl_type *type, unsigned *size, unsigned *align)
 /* First third of converting glsl_to_nir.. this leaves things in a pre-
  * nir_lower_io state, so that shader variants can more easily insert/
  * replace variables, etc.
+ *
+ * This may run on a link thread, so it only touches the program being
+ * converted. Returns true if the shader needs the fp64 software library,
+ * which the caller has to build on the context's thread.
  */
-static void
+static bool
 st_nir_preprocess(struct st_context *st, struct gl_program *prog,
                   struct gl_shader_program *shader_program,
                   gl_shader_stage stage)
@@ -333,16 +340,9 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
    }
 
    nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
-   if (!st->ctx->SoftFP64 && ((nir->info.bit_sizes_int | nir->info.bit_sizes_float) & 64) &&
-       (options->lower_doubles_options & nir_lower_fp64_full_software) != 0) {
-
-      /* It's not possible to use float64 on GLSL ES, so don't bother trying to
-       * build the support code.  The support code depends on higher versions of
-       * desktop GLSL, so it will fail to compile (below) anyway.
-       */
-      if (_mesa_is_desktop_gl(st->ctx) && st->ctx->Const.GLSLVersion >= 400)
-         st->ctx->SoftFP64 = glsl_float64_funcs_to_nir(st->ctx, options);
-   }
+   bool needs_soft_fp64 =
+      ((nir->info.bit_sizes_int | nir->info.bit_sizes_float) & 64) &&
+      (options->lower_doubles_options & nir_lower_fp64_full_software) != 0;
 
    prog->skip_pointsize_xfb = !(nir->info.outputs_written & VARYING_BIT_PSIZ);
    if (st->lower_point_size && prog->skip_pointsize_xfb &&
@@ -397,6 +397,8 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
 
    /* Do a round of constant folding to clean up address calculations */
    NIR_PASS_V(nir, nir_opt_constant_folding);
+
+   return needs_soft_fp64;
 }
 
 static bool
@@ -436,15 +438,16 @@ filter_64_bit_instr(const nir_instr *const_instr, UNUSED const void *data)
    return lower;
 }
 
-/* Second third of converting glsl_to_nir. This creates uniforms, gathers
- * info on varyings, etc after NIR link time opts have been applied.
+/* Adds the state references of built-in uniforms and attaches the uniform
+ * storage of the program. The uniform storage is shared by all stages of
+ * the shader program, so this has to run on the context's thread.
  */
-static char *
-st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
-                         struct gl_shader_program *shader_program)
+static void
+st_glsl_to_nir_associate_uniforms(struct st_context *st,
+                                  struct gl_program *prog,
+                                  struct gl_shader_program *shader_program)
 {
    nir_shader *nir = prog->nir;
-   struct pipe_screen *screen = st->screen;
 
    /* Make a pass over the IR to add state references for any built-in
     * uniforms that are used.  This has to be done now (during linking).
@@ -484,6 +487,17 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
    _mesa_ensure_and_associate_uniform_storage(st->ctx, shader_program, prog, 16);
 
    st_set_prog_affected_state_flags(prog);
+}
+
+/* Second third of converting glsl_to_nir. This creates uniforms, gathers
+ * info on varyings, etc after NIR link time opts have been applied.
+ */
+static char *
+st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
+                         struct gl_shader_program *shader_program)
+{
+   nir_shader *nir = prog->nir;
+   struct pipe_screen *screen = st->screen;
 
    /* None of the builtins being lowered here can be produced by SPIR-V.  See
     * _mesa_builtin_uniform_desc. Also drivers that support packed uniform
@@ -547,15 +561,6 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
    if (st->allow_st_finalize_nir_twice)
       msg = st_finalize_nir(st, prog, shader_program, nir, true, true);
 
-   if (st->ctx->_Shader->Flags & GLSL_DUMP) {
-      _mesa_log("\n");
-      _mesa_log("NIR IR for linked %s program %d:\n",
-             _mesa_shader_stage_to_string(prog->info.stage),
-             shader_program->Name);
-      nir_print_shader(nir, _mesa_get_log_file());
-      _mesa_log("\n\n");
-   }
-
    return msg;
 }
 
@@ -648,6 +653,181 @@ st_lower_patch_vertices_in(struct gl_shader_program *shader_prog)
    }
 }
 
+/* The parts of st_link_nir() that only touch a single stage and don't call
+ * into the driver's compiler are run as one job per stage, so that they can
+ * be spread over the link queue. The steps that look at several stages
+ * (varying linking, uniform storage, etc.) and the finalisation stay on the
+ * context's thread.
+ */
+struct st_link_stage_job {
+   struct st_context *st;
+   struct gl_shader_program *shader_program;
+   struct gl_linked_shader *shader;
+   struct util_queue_fence fence;
+
+   /* Results handed back to st_link_nir(). */
+   bool needs_soft_fp64;
+   char *msg;
+};
+
+static struct util_queue *
+st_get_link_queue(struct st_context *st)
+{
+   if ((ST_DEBUG & DEBUG_SERIAL_LINK) ||
+       st->ctx->Hint.MaxShaderCompilerThreads == 0 ||
+       util_get_cpu_caps()->nr_cpus < 2)
+      return NULL;
+
+   if (!util_queue_is_initialized(&st->link_queue)) {
+      /* The calling thread always runs one of the stages itself, and a
+       * program never has more than the five graphics stages.
+       */
+      unsigned num_threads = MIN2(util_get_cpu_caps()->nr_cpus - 1,
+                                  MESA_SHADER_FRAGMENT);
+
+      if (!util_queue_init(&st->link_queue, "gllink", MESA_SHADER_STAGES,
+                           num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL,
+                           NULL))
+         return NULL;
+   }
+
+   return &st->link_queue;
+}
+
+/* Run \p execute for every stage and wait for all of them to finish. */
+static void
+st_link_run_stages(struct st_context *st, struct st_link_stage_job *jobs,
+                   unsigned num_jobs, util_queue_execute_func execute)
+{
+   struct util_queue *queue = num_jobs > 1 ? st_get_link_queue(st) : NULL;
+
+   if (!queue) {
+      for (unsigned i = 0; i < num_jobs; i++)
+         execute(&jobs[i], NULL, 0);
+      return;
+   }
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(queue, &jobs[i], &jobs[i].fence, execute, NULL, 0);
+   }
+
+   execute(&jobs[0], NULL, 0);
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
+/* Convert a stage to NIR and optimize it on its own. Linking the stages
+ * optimizes them again, but most of the work is done here, including for
+ * separate shaders, compute shaders and shaders with a fixed-func VS or FS
+ * that don't need linking.
+ */
+static void
+st_link_stage_to_nir(void *data, void *gdata, int thread_index)
+{
+   struct st_link_stage_job *job = (struct st_link_stage_job *)data;
+   struct st_context *st = job->st;
+   struct gl_shader_program *shader_program = job->shader_program;
+   struct gl_linked_shader *shader = job->shader;
+   const nir_shader_compiler_options *options =
+      st->ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions;
+   struct gl_program *prog = shader->Program;
+
+   if (shader_program->data->spirv)
+      prog->nir = _mesa_spirv_to_nir(st->ctx, shader_program, shader->Stage, options);
+   else
+      prog->nir = glsl_to_nir(&st->ctx->Const, shader_program, shader->Stage, options);
+
+   memcpy(prog->nir->info.source_sha1, shader->linked_source_sha1,
+          SHA1_DIGEST_LENGTH);
+   job->needs_soft_fp64 =
+      st_nir_preprocess(st, prog, shader_program, shader->Stage);
+
+   if (options->lower_to_scalar) {
+      NIR_PASS_V(prog->nir, nir_lower_load_const_to_scalar);
+   }
+
+   gl_nir_opts(prog->nir);
+}
+
+/* Per-stage lowering after the GLSL linker has run, up to the point where
+ * the varyings of neighbouring stages get compacted.
+ */
+static void
+st_link_stage_lower(void *data, void *gdata, int thread_index)
+{
+   struct st_link_stage_job *job = (struct st_link_stage_job *)data;
+   struct st_context *st = job->st;
+   struct gl_shader_program *shader_program = job->shader_program;
+   struct gl_linked_shader *shader = job->shader;
+   nir_shader *nir = shader->Program->nir;
+   const struct gl_shader_compiler_options *options =
+         &st->ctx->Const.ShaderCompilerOptions[shader->Stage];
+
+   /* If there are forms of indirect addressing that the driver
+    * cannot handle, perform the lowering pass.
+    */
+   if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
+       options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
+      nir_variable_mode mode = options->EmitNoIndirectInput ?
+         nir_var_shader_in : (nir_variable_mode)0;
+      mode |= options->EmitNoIndirectOutput ?
+         nir_var_shader_out : (nir_variable_mode)0;
+      mode |= options->EmitNoIndirectTemp ?
+         nir_var_function_temp : (nir_variable_mode)0;
+      mode |= options->EmitNoIndirectUniform ?
+         nir_var_uniform | nir_var_mem_ubo | nir_var_mem_ssbo :
+         (nir_variable_mode)0;
+
+      nir_lower_indirect_derefs(nir, mode, UINT32_MAX);
+   }
+
+   /* don't infer ACCESS_NON_READABLE so that Program->sh.ImageAccess is
+    * correct: https://gitlab.freedesktop.org/mesa/mesa/-/issues/3278
+    */
+   nir_opt_access_options opt_access_options;
+   opt_access_options.is_vulkan = false;
+   opt_access_options.infer_non_readable = false;
+   NIR_PASS_V(nir, nir_opt_access, &opt_access_options);
+
+   /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
+    * that the buffer indices are constants in nir where they where
+    * constants in GLSL. */
+   NIR_PASS_V(nir, gl_nir_lower_buffers, shader_program);
+
+   /* Remap the locations to slots so those requiring two slots will occupy
+    * two locations. For instance, if we have in the IR code a dvec3 attr0 in
+    * location 0 and vec4 attr1 in location 1, in NIR attr0 will use
+    * locations/slots 0 and 1, and attr1 will use location/slot 2
+    */
+   if (nir->info.stage == MESA_SHADER_VERTEX && !shader_program->data->spirv)
+      nir_remap_dual_slot_attributes(nir, &shader->Program->DualSlotInputs);
+
+   NIR_PASS_V(nir, st_nir_lower_wpos_ytransform, shader->Program,
+              st->screen);
+
+   NIR_PASS_V(nir, nir_lower_system_values);
+   NIR_PASS_V(nir, nir_lower_compute_system_values, NULL);
+
+   if (!st->screen->get_param(st->screen, PIPE_CAP_CULL_DISTANCE_NOCOMBINE))
+      NIR_PASS_V(nir, nir_lower_clip_cull_distance_arrays);
+
+   /* The info is gathered before the varyings get compacted. */
+   st_shader_gather_info(nir, shader->Program);
+   if (shader->Stage == MESA_SHADER_VERTEX) {
+      /* NIR expands dual-slot inputs out to two locations.  We need to
+       * compact things back down GL-style single-slot inputs to avoid
+       * confusing the state tracker.
+       */
+      shader->Program->info.inputs_read =
+         nir_get_single_slot_attribs_mask(nir->info.inputs_read,
+                                          shader->Program->DualSlotInputs);
+   }
+}
+
 extern "C" {
 
 void
@@ -698,6 +878,7 @@ st_link_nir(struct gl_context *ctx,
 {
    struct st_context *st = st_context(ctx);
    struct gl_linked_shader *linked_shader[MESA_SHADER_STAGES];
+   struct st_link_stage_job jobs[MESA_SHADER_STAGES] = {};
    unsigned num_shaders = 0;
 
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
@@ -707,8 +888,6 @@ st_link_nir(struct gl_context *ctx,
 
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
-      const nir_shader_compiler_options *options =
-         st->ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions;
       struct gl_program *prog = shader->Program;
 
       _mesa_copy_linked_program_data(shader_program, shader);
@@ -720,9 +899,7 @@ st_link_nir(struct gl_context *ctx,
       /* Parameters will be filled during NIR linking. */
       prog->Parameters = _mesa_new_parameter_list();
 
-      if (shader_program->data->spirv) {
-         prog->nir = _mesa_spirv_to_nir(ctx, shader_program, shader->Stage, options);
-      } else {
+      if (!shader_program->data->spirv) {
          validate_ir_tree(shader->ir);
 
          if (ctx->_Shader->Flags & GLSL_DUMP) {
@@ -733,17 +910,26 @@ st_link_nir(struct gl_context *ctx,
             _mesa_print_ir(_mesa_get_log_file(), shader->ir, NULL);
             _mesa_log("\n\n");
          }
-
-         prog->nir = glsl_to_nir(&st->ctx->Const, shader_program, shader->Stage, options);
       }
 
-      memcpy(prog->nir->info.source_sha1, shader->linked_source_sha1,
-             SHA1_DIGEST_LENGTH);
-      st_nir_preprocess(st, prog, shader_program, shader->Stage);
+      jobs[i].st = st;
+      jobs[i].shader_program = shader_program;
+      jobs[i].shader = shader;
+   }
 
-      if (options->lower_to_scalar) {
-         NIR_PASS_V(shader->Program->nir, nir_lower_load_const_to_scalar);
-      }
+   st_link_run_stages(st, jobs, num_shaders, st_link_stage_to_nir);
+
+   for (unsigned i = 0; i < num_shaders; i++) {
+      const nir_shader_compiler_options *options =
+         ctx->Const.ShaderCompilerOptions[linked_shader[i]->Stage].NirOptions;
+
+      /* It's not possible to use float64 on GLSL ES, so don't bother trying to
+       * build the support code.  The support code depends on higher versions of
+       * desktop GLSL, so it will fail to compile (below) anyway.
+       */
+      if (jobs[i].needs_soft_fp64 && !ctx->SoftFP64 &&
+          _mesa_is_desktop_gl(ctx) && ctx->Const.GLSLVersion >= 400)
+         ctx->SoftFP64 = glsl_float64_funcs_to_nir(ctx, options);
    }
 
    st_lower_patch_vertices_in(shader_program);
@@ -757,12 +943,6 @@ st_link_nir(struct gl_context *ctx,
       st_nir_link_shaders(linked_shader[i]->Program->nir,
                           linked_shader[i + 1]->Program->nir);
    }
-   /* Linking shaders also optimizes them. Separate shaders, compute shaders
-    * and shaders with a fixed-func VS or FS that don't need linking are
-    * optimized here.
-    */
-   if (num_shaders == 1)
-      gl_nir_opts(linked_shader[0]->Program->nir);
 
    if (shader_program->data->spirv) {
       static const gl_nir_linker_options opts = {
@@ -785,87 +965,37 @@ st_link_nir(struct gl_context *ctx,
    nir_build_program_resource_list(&ctx->Const, shader_program,
                                    shader_program->data->spirv);
 
-   for (unsigned i = 0; i < num_shaders; i++) {
+   st_link_run_stages(st, jobs, num_shaders, st_link_stage_lower);
+
+   for (unsigned i = 1; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
       nir_shader *nir = shader->Program->nir;
-      gl_shader_stage stage = shader->Stage;
-      const struct gl_shader_compiler_options *options =
-            &ctx->Const.ShaderCompilerOptions[stage];
+      struct gl_program *prev_shader = linked_shader[i - 1]->Program;
 
-      /* If there are forms of indirect addressing that the driver
-       * cannot handle, perform the lowering pass.
+      /* We can't use nir_compact_varyings with transform feedback, since
+       * the pipe_stream_output->output_register field is based on the
+       * pre-compacted driver_locations.
        */
-      if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
-          options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
-         nir_variable_mode mode = options->EmitNoIndirectInput ?
-            nir_var_shader_in : (nir_variable_mode)0;
-         mode |= options->EmitNoIndirectOutput ?
-            nir_var_shader_out : (nir_variable_mode)0;
-         mode |= options->EmitNoIndirectTemp ?
-            nir_var_function_temp : (nir_variable_mode)0;
-         mode |= options->EmitNoIndirectUniform ?
-            nir_var_uniform | nir_var_mem_ubo | nir_var_mem_ssbo :
-            (nir_variable_mode)0;
-
-         nir_lower_indirect_derefs(nir, mode, UINT32_MAX);
-      }
-
-      /* don't infer ACCESS_NON_READABLE so that Program->sh.ImageAccess is
-       * correct: https://gitlab.freedesktop.org/mesa/mesa/-/issues/3278
-       */
-      nir_opt_access_options opt_access_options;
-      opt_access_options.is_vulkan = false;
-      opt_access_options.infer_non_readable = false;
-      NIR_PASS_V(nir, nir_opt_access, &opt_access_options);
-
-      /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
-       * that the buffer indices are constants in nir where they where
-       * constants in GLSL. */
-      NIR_PASS_V(nir, gl_nir_lower_buffers, shader_program);
-
-      /* Remap the locations to slots so those requiring two slots will occupy
-       * two locations. For instance, if we have in the IR code a dvec3 attr0 in
-       * location 0 and vec4 attr1 in location 1, in NIR attr0 will use
-       * locations/slots 0 and 1, and attr1 will use location/slot 2
-       */
-      if (nir->info.stage == MESA_SHADER_VERTEX && !shader_program->data->spirv)
-         nir_remap_dual_slot_attributes(nir, &shader->Program->DualSlotInputs);
-
-      NIR_PASS_V(nir, st_nir_lower_wpos_ytransform, shader->Program,
-                 st->screen);
+      if (!(prev_shader->sh.LinkedTransformFeedback &&
+            prev_shader->sh.LinkedTransformFeedback->NumVarying > 0))
+         nir_compact_varyings(prev_shader->nir,
+                              nir, ctx->API != API_OPENGL_COMPAT);
 
-      NIR_PASS_V(nir, nir_lower_system_values);
-      NIR_PASS_V(nir, nir_lower_compute_system_values, NULL);
-
-      if (!st->screen->get_param(st->screen, PIPE_CAP_CULL_DISTANCE_NOCOMBINE))
-         NIR_PASS_V(nir, nir_lower_clip_cull_distance_arrays);
-
-      st_shader_gather_info(nir, shader->Program);
-      if (shader->Stage == MESA_SHADER_VERTEX) {
-         /* NIR expands dual-slot inputs out to two locations.  We need to
-          * compact things back down GL-style single-slot inputs to avoid
-          * confusing the state tracker.
-          */
-         shader->Program->info.inputs_read =
-            nir_get_single_slot_attribs_mask(nir->info.inputs_read,
-                                             shader->Program->DualSlotInputs);
-      }
-
-      if (i >= 1) {
-         struct gl_program *prev_shader = linked_shader[i - 1]->Program;
+      if (ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions->vectorize_io)
+         st_nir_vectorize_io(prev_shader->nir, nir);
+   }
 
-         /* We can't use nir_compact_varyings with transform feedback, since
-          * the pipe_stream_output->output_register field is based on the
-          * pre-compacted driver_locations.
-          */
-         if (!(prev_shader->sh.LinkedTransformFeedback &&
-               prev_shader->sh.LinkedTransformFeedback->NumVarying > 0))
-            nir_compact_varyings(prev_shader->nir,
-                                 nir, ctx->API != API_OPENGL_COMPAT);
+   for (unsigned i = 0; i < num_shaders; i++) {
+      st_glsl_to_nir_associate_uniforms(st, linked_shader[i]->Program,
+                                        shader_program);
+   }
 
-         if (ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions->vectorize_io)
-            st_nir_vectorize_io(prev_shader->nir, nir);
-      }
+   /* This ends in pipe_screen::finalize_nir, which drivers don't have to
+    * make thread-safe, so it stays on the calling thread.
+    */
+   for (unsigned i = 0; i < num_shaders; i++) {
+      jobs[i].msg = st_glsl_to_nir_post_opts(st, linked_shader[i]->Program,
+                                             shader_program);
    }
 
    struct shader_info *prev_info = NULL;
@@ -874,9 +1004,17 @@ st_link_nir(struct gl_context *ctx,
       struct gl_linked_shader *shader = linked_shader[i];
       struct shader_info *info = &shader->Program->nir->info;
 
-      char *msg = st_glsl_to_nir_post_opts(st, shader->Program, shader_program);
-      if (msg) {
-         linker_error(shader_program, msg);
+      if (ctx->_Shader->Flags & GLSL_DUMP) {
+         _mesa_log("\n");
+         _mesa_log("NIR IR for linked %s program %d:\n",
+                   _mesa_shader_stage_to_string(shader->Stage),
+                   shader_program->Name);
+         nir_print_shader(shader->Program->nir, _mesa_get_log_file());
+         _mesa_log("\n\n");
+      }
+
+      if (jobs[i].msg) {
+         linker_error(shader_program, jobs[i].msg);
          break;
       }
 
@@ -176,6 +176,26 @@ struct vbo_save_context {
    GLboolean dangling_attr_ref;
    GLboolean out_of_memory;  /**< True if last VBO allocation failed */
    bool no_current_update;
+
+   /**
+    * Draws of consecutive display list nodes using the same vertex buffers,
+    * issued as one multi-draw by vbo_save_flush_merged_draws().
+    */
+   struct {
+      const struct vbo_save_vertex_list *node; /**< first merged node */
+      gl_vertex_processing_mode vp_mode;
+      bool vertex_state;   /**< drawn with node->state[vp_mode] */
+      struct pipe_draw_vertex_state_info info;
+      unsigned num_draws;
+      unsigned max_draws;
+      struct pipe_draw_start_count_bias *draws;
+      uint8_t *modes;
+
+      /** Merged nodes whose copy to the current attribs is pending. */
+      unsigned num_copy_nodes;
+      unsigned max_copy_nodes;
+      const struct vbo_save_vertex_list **copy_nodes;
+   } merged;
 };
 
 GLboolean
@@ -218,6 +238,10 @@ vbo_save_EndList(struct gl_context *ctx);
 void
 vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj);
 
+void
+vbo_minmax_cache_invalidate(struct gl_buffer_object *bufferObj,
+                            GLintptr offset, GLsizeiptr size);
+
 void
 vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             unsigned restartIndex, bool restart,
@@ -30,12 +30,20 @@
 #include "main/context.h"
 #include "main/varray.h"
 #include "main/macros.h"
-#include "main/sse_minmax.h"
-#include "x86/common_x86_asm.h"
+#include "util/bitset.h"
 #include "util/hash_table.h"
+#include "util/u_index_minmax.h"
 #include "util/u_memory.h"
+#include "util/u_parallel.h"
 #include "pipe/p_state.h"
 
+/* Size of the blocks of index buffers that the min/max is kept for. */
+#define VBO_MINMAX_BLOCK_SIZE 4096
+
+/* Blocks per scanning task, and invalid blocks to scan in parallel. */
+#define VBO_MINMAX_TASK_BLOCKS 64
+#define VBO_MINMAX_PARALLEL_BLOCKS 256
+
 struct minmax_cache_key {
    GLintptr offset;
    GLuint count;
@@ -50,6 +58,33 @@ struct minmax_cache_entry {
 };
 
 
+/**
+ * Min/max of every VBO_MINMAX_BLOCK_SIZE block of a buffer, for one index
+ * size and restart index.  Unlike the cache of draw ranges, writing to the
+ * buffer only invalidates the blocks that are written, so that ranges of
+ * several blocks only scan these again.
+ */
+struct vbo_minmax_blocks {
+   unsigned index_size;
+   bool restart;
+   unsigned restart_index;
+   unsigned num_blocks;
+   BITSET_WORD *valid;
+   struct {
+      GLuint min;
+      GLuint max;
+   } *range;
+};
+
+
+struct minmax_blocks_job {
+   struct vbo_minmax_blocks *blocks;
+   const char *indices;          /**< start of the first block */
+   unsigned first_block;
+   unsigned num_blocks;
+};
+
+
 static uint32_t
 vbo_minmax_cache_hash(const struct minmax_cache_key *key)
 {
@@ -93,11 +128,76 @@ vbo_use_minmax_cache(struct gl_buffer_object *bufferObj)
 }
 
 
+static void
+vbo_minmax_blocks_destroy(struct vbo_minmax_blocks *blocks)
+{
+   if (blocks) {
+      free(blocks->valid);
+      free(blocks->range);
+      free(blocks);
+   }
+}
+
+
 void
 vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj)
 {
    _mesa_hash_table_destroy(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
    bufferObj->MinMaxCache = NULL;
+   vbo_minmax_blocks_destroy(bufferObj->MinMaxBlocks);
+   bufferObj->MinMaxBlocks = NULL;
+}
+
+
+/**
+ * Called when [offset, offset + size) of the buffer is written.
+ */
+void
+vbo_minmax_cache_invalidate(struct gl_buffer_object *bufferObj,
+                            GLintptr offset, GLsizeiptr size)
+{
+   struct vbo_minmax_blocks *blocks;
+
+   bufferObj->MinMaxCacheDirty = true;
+
+   if (size <= 0)
+      return;
+
+   simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
+
+   blocks = bufferObj->MinMaxBlocks;
+   if (blocks) {
+      const GLintptr first = offset / VBO_MINMAX_BLOCK_SIZE;
+      const GLintptr end = MIN2(DIV_ROUND_UP(offset + size, VBO_MINMAX_BLOCK_SIZE),
+                                blocks->num_blocks);
+
+      for (GLintptr b = first; b < end; b++)
+         BITSET_CLEAR(blocks->valid, b);
+   }
+
+   simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+}
+
+
+/**
+ * Account for the indices of a draw range that were found in the caches and
+ * the ones that had to be scanned.  Called with the cache mutex held.
+ */
+static void
+vbo_minmax_cache_count(struct gl_buffer_object *bufferObj,
+                       unsigned hits, unsigned misses)
+{
+   /* The hit counter saturates so that we don't accidently disable the
+    * cache in a long-running program.
+    */
+   unsigned new_hit_count = bufferObj->MinMaxCacheHitIndices + hits;
+
+   if (new_hit_count >= bufferObj->MinMaxCacheHitIndices)
+      bufferObj->MinMaxCacheHitIndices = new_hit_count;
+   else
+      bufferObj->MinMaxCacheHitIndices = ~(unsigned)0;
+
+   bufferObj->MinMaxCacheMissIndices += misses;
 }
 
 
@@ -152,19 +252,11 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
    }
 
 out_invalidate:
-   if (found) {
-      /* The hit counter saturates so that we don't accidently disable the
-       * cache in a long-running program.
-       */
-      unsigned new_hit_count = bufferObj->MinMaxCacheHitIndices + count;
-
-      if (new_hit_count >= bufferObj->MinMaxCacheHitIndices)
-         bufferObj->MinMaxCacheHitIndices = new_hit_count;
-      else
-         bufferObj->MinMaxCacheHitIndices = ~(unsigned)0;
-   } else {
-      bufferObj->MinMaxCacheMissIndices += count;
-   }
+   /* Misses are counted once the range was computed, see
+    * vbo_minmax_cache_store().
+    */
+   if (found)
+      vbo_minmax_cache_count(bufferObj, count, 0);
 
 out_disable:
    simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
@@ -172,11 +264,15 @@ out_disable:
 }
 
 
+/**
+ * Store the min/max of a draw range that missed the cache.  \p block_hits
+ * of its indices were in blocks of the block summary that were still valid.
+ */
 static void
 vbo_minmax_cache_store(struct gl_context *ctx,
                        struct gl_buffer_object *bufferObj,
                        unsigned index_size, GLintptr offset, GLuint count,
-                       GLuint min, GLuint max)
+                       GLuint min, GLuint max, unsigned block_hits)
 {
    struct minmax_cache_entry *entry;
    struct hash_entry *table_entry;
@@ -187,6 +283,12 @@ vbo_minmax_cache_store(struct gl_context *ctx,
 
    simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
 
+   /* Indices that the block summary had without scanning them are hits, so
+    * that a buffer streamed with small glBufferSubData() calls doesn't look
+    * like a miss on every draw and get both caches disabled.
+    */
+   vbo_minmax_cache_count(bufferObj, block_hits, count - block_hits);
+
    if (!bufferObj->MinMaxCache) {
       bufferObj->MinMaxCache =
          _mesa_hash_table_create(NULL,
@@ -234,82 +336,159 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             const void *indices,
                             unsigned *min_index, unsigned *max_index)
 {
-   switch (index_size) {
-   case 4: {
-      const GLuint *ui_indices = (const GLuint *)indices;
-      GLuint max_ui = 0;
-      GLuint min_ui = ~0U;
-      if (restart) {
-         for (unsigned i = 0; i < count; i++) {
-            if (ui_indices[i] != restartIndex) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
-         }
-      }
-      else {
-#if defined(USE_SSE41)
-         if (cpu_has_sse4_1) {
-            _mesa_uint_array_min_max(ui_indices, &min_ui, &max_ui, count);
-         }
-         else
-#endif
-            for (unsigned i = 0; i < count; i++) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
-      }
-      *min_index = min_ui;
-      *max_index = max_ui;
-      break;
+   util_index_minmax(indices, index_size, count, restart, restartIndex,
+                     min_index, max_index);
+}
+
+
+/**
+ * Return the block summary of the buffer for the index size and restart
+ * index, replacing the one for other ones.  Called with the cache mutex
+ * held.
+ */
+static struct vbo_minmax_blocks *
+vbo_minmax_blocks_get(struct gl_buffer_object *bufferObj, unsigned index_size,
+                      bool restart, unsigned restart_index)
+{
+   const unsigned num_blocks = DIV_ROUND_UP(bufferObj->Size,
+                                            VBO_MINMAX_BLOCK_SIZE);
+   struct vbo_minmax_blocks *blocks = bufferObj->MinMaxBlocks;
+
+   if (blocks && blocks->num_blocks == num_blocks &&
+       blocks->index_size == index_size && blocks->restart == restart &&
+       (!restart || blocks->restart_index == restart_index))
+      return blocks;
+
+   vbo_minmax_blocks_destroy(blocks);
+   bufferObj->MinMaxBlocks = NULL;
+
+   blocks = CALLOC_STRUCT(vbo_minmax_blocks);
+   if (!blocks)
+      return NULL;
+
+   blocks->index_size = index_size;
+   blocks->restart = restart;
+   blocks->restart_index = restart_index;
+   blocks->num_blocks = num_blocks;
+   blocks->valid = calloc(BITSET_WORDS(num_blocks), sizeof(BITSET_WORD));
+   blocks->range = malloc(num_blocks * sizeof(*blocks->range));
+   if (!blocks->valid || !blocks->range) {
+      vbo_minmax_blocks_destroy(blocks);
+      return NULL;
    }
-   case 2: {
-      const GLushort *us_indices = (const GLushort *)indices;
-      GLuint max_us = 0;
-      GLuint min_us = ~0U;
-      if (restart) {
-         for (unsigned i = 0; i < count; i++) {
-            if (us_indices[i] != restartIndex) {
-               if (us_indices[i] > max_us) max_us = us_indices[i];
-               if (us_indices[i] < min_us) min_us = us_indices[i];
-            }
-         }
-      }
-      else {
-         for (unsigned i = 0; i < count; i++) {
-            if (us_indices[i] > max_us) max_us = us_indices[i];
-            if (us_indices[i] < min_us) min_us = us_indices[i];
-         }
-      }
-      *min_index = min_us;
-      *max_index = max_us;
-      break;
+
+   bufferObj->MinMaxBlocks = blocks;
+   return blocks;
+}
+
+
+static void
+vbo_minmax_scan_blocks(void *data, unsigned task)
+{
+   const struct minmax_blocks_job *job = data;
+   struct vbo_minmax_blocks *blocks = job->blocks;
+   const unsigned start = task * VBO_MINMAX_TASK_BLOCKS;
+   const unsigned end = MIN2(start + VBO_MINMAX_TASK_BLOCKS, job->num_blocks);
+
+   for (unsigned i = start; i < end; i++) {
+      const unsigned b = job->first_block + i;
+
+      if (BITSET_TEST(blocks->valid, b))
+         continue;
+
+      util_index_minmax(job->indices + i * VBO_MINMAX_BLOCK_SIZE,
+                        blocks->index_size,
+                        VBO_MINMAX_BLOCK_SIZE / blocks->index_size,
+                        blocks->restart, blocks->restart_index,
+                        &blocks->range[b].min, &blocks->range[b].max);
    }
-   case 1: {
-      const GLubyte *ub_indices = (const GLubyte *)indices;
-      GLuint max_ub = 0;
-      GLuint min_ub = ~0U;
-      if (restart) {
-         for (unsigned i = 0; i < count; i++) {
-            if (ub_indices[i] != restartIndex) {
-               if (ub_indices[i] > max_ub) max_ub = ub_indices[i];
-               if (ub_indices[i] < min_ub) min_ub = ub_indices[i];
-            }
-         }
-      }
-      else {
-         for (unsigned i = 0; i < count; i++) {
-            if (ub_indices[i] > max_ub) max_ub = ub_indices[i];
-            if (ub_indices[i] < min_ub) min_ub = ub_indices[i];
-         }
+}
+
+
+/**
+ * Compute the min/max of indices from the block summary of the buffer,
+ * scanning the blocks that were written since they were last scanned, and
+ * the partial blocks at the ends of the range.  \p block_hits is set to the
+ * number of indices in blocks that didn't need to be scanned.
+ * \return false if the range has no whole block.
+ */
+static bool
+vbo_get_minmax_blocks(struct gl_buffer_object *bufferObj, const char *indices,
+                      GLintptr offset, unsigned count, unsigned index_size,
+                      bool restart, unsigned restart_index,
+                      GLuint *min_index, GLuint *max_index,
+                      unsigned *block_hits)
+{
+   const GLintptr end = offset + (GLintptr)count * index_size;
+   const GLintptr first = ALIGN_POT(offset, VBO_MINMAX_BLOCK_SIZE);
+   const GLintptr last = end & ~(GLintptr)(VBO_MINMAX_BLOCK_SIZE - 1);
+   struct vbo_minmax_blocks *blocks;
+   struct minmax_blocks_job job;
+   unsigned invalid = 0, i;
+   GLuint tmp_min, tmp_max;
+
+   if (offset % index_size || last <= first || end > bufferObj->Size ||
+       !vbo_use_minmax_cache(bufferObj))
+      return false;
+
+   simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
+
+   blocks = vbo_minmax_blocks_get(bufferObj, index_size, restart,
+                                  restart_index);
+   if (!blocks) {
+      simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+      return false;
+   }
+
+   job.blocks = blocks;
+   job.indices = indices + (first - offset);
+   job.first_block = first / VBO_MINMAX_BLOCK_SIZE;
+   job.num_blocks = (last - first) / VBO_MINMAX_BLOCK_SIZE;
+
+   for (i = 0; i < job.num_blocks; i++) {
+      if (!BITSET_TEST(blocks->valid, job.first_block + i))
+         invalid++;
+   }
+
+   if (invalid) {
+      const unsigned num_tasks = DIV_ROUND_UP(job.num_blocks,
+                                              VBO_MINMAX_TASK_BLOCKS);
+
+      if (invalid >= VBO_MINMAX_PARALLEL_BLOCKS) {
+         util_parallel_for(num_tasks, vbo_minmax_scan_blocks, &job);
+      } else {
+         for (i = 0; i < num_tasks; i++)
+            vbo_minmax_scan_blocks(&job, i);
       }
-      *min_index = min_ub;
-      *max_index = max_ub;
-      break;
+
+      BITSET_SET_RANGE(blocks->valid, job.first_block,
+                       job.first_block + job.num_blocks - 1);
    }
-   default:
-      unreachable("not reached");
+
+   *block_hits = (job.num_blocks - invalid) *
+                 (VBO_MINMAX_BLOCK_SIZE / index_size);
+
+   *min_index = ~0;
+   *max_index = 0;
+   for (i = job.first_block; i < job.first_block + job.num_blocks; i++) {
+      *min_index = MIN2(*min_index, blocks->range[i].min);
+      *max_index = MAX2(*max_index, blocks->range[i].max);
    }
+
+   simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+
+   util_index_minmax(indices, index_size, (first - offset) / index_size,
+                     restart, restart_index, &tmp_min, &tmp_max);
+   *min_index = MIN2(*min_index, tmp_min);
+   *max_index = MAX2(*max_index, tmp_max);
+
+   util_index_minmax(indices + (last - offset), index_size,
+                     (end - last) / index_size,
+                     restart, restart_index, &tmp_min, &tmp_max);
+   *min_index = MIN2(*min_index, tmp_min);
+   *max_index = MAX2(*max_index, tmp_max);
+
+   return true;
 }
 
 
@@ -327,6 +506,7 @@ vbo_get_minmax_index(struct gl_context *ctx, struct gl_buffer_object *obj,
                      GLuint *max_index)
 {
    const char *indices;
+   unsigned block_hits = 0;
 
    if (!obj) {
       indices = (const char *)ptr + offset;
@@ -341,13 +521,18 @@ vbo_get_minmax_index(struct gl_context *ctx, struct gl_buffer_object *obj,
                                           obj, MAP_INTERNAL);
    }
 
-   vbo_get_minmax_index_mapped(count, index_size, restart_index,
-                               primitive_restart, indices,
-                               min_index, max_index);
+   if (!obj || !vbo_get_minmax_blocks(obj, indices, offset, count,
+                                      index_size, primitive_restart,
+                                      restart_index, min_index, max_index,
+                                      &block_hits)) {
+      vbo_get_minmax_index_mapped(count, index_size, restart_index,
+                                  primitive_restart, indices,
+                                  min_index, max_index);
+   }
 
    if (obj) {
       vbo_minmax_cache_store(ctx, obj, index_size, offset, count, *min_index,
-                             *max_index);
+                             *max_index, block_hits);
       _mesa_bufferobj_unmap(ctx, obj, MAP_INTERNAL);
    }
 }
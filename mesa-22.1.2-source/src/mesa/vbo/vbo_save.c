@@ -75,5 +75,9 @@ void vbo_save_destroy( struct gl_context *ctx )
    if (save->copied.buffer)
       free(save->copied.buffer);
 
+   free(save->merged.draws);
+   free(save->merged.modes);
+   free(save->merged.copy_nodes);
+
    _mesa_reference_buffer_object(ctx, &save->current_bo, NULL);
 }
@@ -144,6 +144,9 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data, bool copy_to_c
 void
 vbo_save_playback_vertex_list_loopback(struct gl_context *ctx, void *data);
 
+void
+vbo_save_flush_merged_draws(struct gl_context *ctx);
+
 void
 vbo_save_api_init(struct vbo_save_context *save);
 
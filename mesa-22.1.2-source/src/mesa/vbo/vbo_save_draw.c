@@ -184,6 +184,213 @@ enum vbo_save_status {
    USE_SLOW_PATH,
 };
 
+
+/**
+ * Whether playback_copy_to_current() of the node can be done after the
+ * merged draws.  This is the case when it only sets current attribs, which
+ * merged draws don't read because all vertex program inputs are enabled
+ * arrays.  Materials, ColorMaterial and a primitive left open change the
+ * state of the following draws.
+ */
+static bool
+can_defer_copy_to_current(struct gl_context *ctx,
+                          const struct vbo_save_vertex_list *node)
+{
+   if (!node->cold->current_data)
+      return true;
+
+   if (node->cold->VAO[VP_MODE_FF]->Enabled & VERT_BIT_MAT_ALL)
+      return false;
+
+   if (ctx->Light.ColorMaterialEnabled &&
+       node->cold->VAO[VP_MODE_SHADER]->Enabled & VERT_BIT_COLOR0)
+      return false;
+
+   return !node->cold->prim_count ||
+          node->cold->prims[node->cold->prim_count - 1].end;
+}
+
+
+/**
+ * Remember to copy the current attribs of the node after the merged draws.
+ */
+static bool
+defer_copy_to_current(struct vbo_save_context *save,
+                      const struct vbo_save_vertex_list *node)
+{
+   if (save->merged.num_copy_nodes == save->merged.max_copy_nodes) {
+      const unsigned max_nodes = MAX2(2 * save->merged.max_copy_nodes, 16);
+      const struct vbo_save_vertex_list **nodes =
+         realloc(save->merged.copy_nodes, max_nodes * sizeof(*nodes));
+      if (!nodes)
+         return false;
+      save->merged.copy_nodes = nodes;
+      save->merged.max_copy_nodes = max_nodes;
+   }
+
+   save->merged.copy_nodes[save->merged.num_copy_nodes++] = node;
+   return true;
+}
+
+
+/**
+ * Add the draws of the node to the merged draws.
+ */
+static bool
+merge_draws(struct vbo_save_context *save,
+            const struct vbo_save_vertex_list *node,
+            bool copy_to_current)
+{
+   const unsigned num_draws = save->merged.num_draws + node->num_draws;
+
+   if (num_draws > save->merged.max_draws) {
+      const unsigned max_draws = MAX3(num_draws, 2 * save->merged.max_draws, 64);
+      struct pipe_draw_start_count_bias *draws =
+         realloc(save->merged.draws, max_draws * sizeof(*draws));
+      if (!draws)
+         return false;
+      save->merged.draws = draws;
+
+      uint8_t *modes = realloc(save->merged.modes, max_draws);
+      if (!modes)
+         return false;
+      save->merged.modes = modes;
+
+      save->merged.max_draws = max_draws;
+   }
+
+   if (copy_to_current && !defer_copy_to_current(save, node))
+      return false;
+
+   if (node->num_draws == 1) {
+      save->merged.draws[save->merged.num_draws] = node->start_count;
+      save->merged.modes[save->merged.num_draws] =
+         node->modes ? node->modes[0] : node->cold->info.mode;
+   } else {
+      memcpy(&save->merged.draws[save->merged.num_draws], node->start_counts,
+             node->num_draws * sizeof(*node->start_counts));
+      if (node->modes) {
+         memcpy(&save->merged.modes[save->merged.num_draws], node->modes,
+                node->num_draws);
+      } else {
+         memset(&save->merged.modes[save->merged.num_draws],
+                node->cold->info.mode, node->num_draws);
+      }
+   }
+
+   save->merged.num_draws = num_draws;
+   return true;
+}
+
+
+/**
+ * Try to add the draws of the node to the draws of the previous nodes.
+ * This is possible when they use the same vertex buffers and the state
+ * hasn't changed since.  The previous nodes copy to the current attribs
+ * only after the merged draws.
+ */
+static bool
+merge_with_previous_nodes(struct gl_context *ctx,
+                          const struct vbo_save_vertex_list *node,
+                          bool copy_to_current)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   const struct vbo_save_vertex_list *first = save->merged.node;
+   const gl_vertex_processing_mode mode = ctx->VertexProgram._VPMode;
+
+   if (!save->merged.num_draws ||
+       ctx->NewState ||
+       (copy_to_current && !can_defer_copy_to_current(ctx, node)) ||
+       mode != save->merged.vp_mode ||
+       node->enabled_attribs[mode] != first->enabled_attribs[mode] ||
+       ctx->VertexProgram._Current->info.inputs_read & ~node->enabled_attribs[mode])
+      return false;
+
+   if (save->merged.vertex_state) {
+      if (node->state[mode] != first->state[mode])
+         return false;
+   } else {
+      if (node->cold->VAO[mode] != first->cold->VAO[mode] ||
+          node->cold->info.index.gl_bo != first->cold->info.index.gl_bo)
+         return false;
+   }
+
+   return merge_draws(save, node, copy_to_current);
+}
+
+
+/**
+ * Start merging draws with the draws of the node, instead of drawing it.
+ * All vertex program inputs must be enabled arrays of the node.
+ */
+static bool
+start_merged_draws(struct gl_context *ctx,
+                   const struct vbo_save_vertex_list *node,
+                   bool copy_to_current, bool vertex_state,
+                   const struct pipe_draw_vertex_state_info *info)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+
+   assert(!save->merged.num_draws && !save->merged.num_copy_nodes);
+
+   if (!node->num_draws ||
+       (copy_to_current && !can_defer_copy_to_current(ctx, node)))
+      return false;
+
+   if (!merge_draws(save, node, copy_to_current))
+      return false;
+
+   save->merged.node = node;
+   save->merged.vp_mode = ctx->VertexProgram._VPMode;
+   save->merged.vertex_state = vertex_state;
+   if (info)
+      save->merged.info = *info;
+   return true;
+}
+
+
+/**
+ * Draw the merged draws of the previous nodes.  This must be called before
+ * anything else than playing back display list nodes changes the state.
+ */
+void
+vbo_save_flush_merged_draws(struct gl_context *ctx)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   const struct vbo_save_vertex_list *node = save->merged.node;
+   const unsigned num_draws = save->merged.num_draws;
+
+   if (!num_draws) {
+      assert(!save->merged.num_copy_nodes);
+      return;
+   }
+
+   save->merged.num_draws = 0;
+   save->merged.node = NULL;
+
+   if (save->merged.vertex_state) {
+      const gl_vertex_processing_mode mode = save->merged.vp_mode;
+
+      ctx->Driver.DrawGalliumVertexState(ctx, node->state[mode],
+                                         save->merged.info,
+                                         save->merged.draws,
+                                         save->merged.modes, num_draws,
+                                         node->enabled_attribs[mode] &
+                                         VERT_ATTRIB_EDGEFLAG);
+   } else {
+      struct pipe_draw_info *info = (struct pipe_draw_info *) &node->cold->info;
+      void *gl_bo = info->index.gl_bo;
+
+      ctx->Driver.DrawGalliumMultiMode(ctx, info, save->merged.draws,
+                                       save->merged.modes, num_draws);
+      info->index.gl_bo = gl_bo;
+   }
+
+   for (unsigned i = 0; i < save->merged.num_copy_nodes; i++)
+      playback_copy_to_current(ctx, save->merged.copy_nodes[i]);
+   save->merged.num_copy_nodes = 0;
+}
+
 static enum vbo_save_status
 vbo_save_playback_vertex_list_gallium(struct gl_context *ctx,
                                       const struct vbo_save_vertex_list *node,
@@ -272,6 +479,11 @@ vbo_save_playback_vertex_list_gallium(struct gl_context *ctx,
    }
 
    /* Fast path using a pre-built gallium vertex buffer state. */
+   if (start_merged_draws(ctx, node, copy_to_current, true, &info)) {
+      /* drawn and copied by vbo_save_flush_merged_draws() */
+      return DONE;
+   }
+
    if (node->modes || node->num_draws > 1) {
       ctx->Driver.DrawGalliumVertexState(ctx, state, info,
                                          node->start_counts,
@@ -312,6 +524,11 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data, bool copy_to_c
       return;
    }
 
+   if (merge_with_previous_nodes(ctx, node, copy_to_current))
+      return;
+
+   vbo_save_flush_merged_draws(ctx);
+
    if (vbo_save_playback_vertex_list_gallium(ctx, node, copy_to_current) == DONE)
       return;
 
@@ -329,6 +546,18 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data, bool copy_to_c
 
    assert(ctx->NewState == 0);
 
+   /* Inputs that aren't enabled arrays are read from the current attribs,
+    * which the following nodes can change.
+    */
+   const gl_vertex_processing_mode mode = ctx->VertexProgram._VPMode;
+
+   if (!(ctx->VertexProgram._Current->info.inputs_read &
+         ~node->enabled_attribs[mode]) &&
+       start_merged_draws(ctx, node, copy_to_current, false, NULL)) {
+      /* drawn and copied by vbo_save_flush_merged_draws() */
+      return;
+   }
+
    struct pipe_draw_info *info = (struct pipe_draw_info *) &node->cold->info;
    void *gl_bo = info->index.gl_bo;
    if (node->modes) {
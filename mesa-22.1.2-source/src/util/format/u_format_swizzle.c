@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "c11/threads.h"
+#include "pipe/p_defines.h"
+#include "util/format/format_utils.h"
+#include "util/format/u_format_swizzle.h"
+#include "util/u_cpu_detect.h"
+
+static struct util_format_swizzle_funcs swizzle_funcs;
+
+static void
+util_format_swizzle_init(void)
+{
+   util_cpu_detect();
+
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+   util_format_swizzle_funcs_x86(&swizzle_funcs);
+#elif (defined(PIPE_ARCH_AARCH64) || defined(PIPE_ARCH_ARM)) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
+   util_format_swizzle_funcs_neon(&swizzle_funcs);
+#endif
+}
+
+static const struct util_format_swizzle_funcs *
+util_format_swizzle_get_funcs(void)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, util_format_swizzle_init);
+
+   return &swizzle_funcs;
+}
+
+/* The kernels only handle what the generic conversions handle the same way
+ * for every pixel: swizzles reading a channel that the source doesn't have
+ * read stale data there.
+ */
+static bool
+swizzle_is_supported(unsigned dst_chans, unsigned src_chans,
+                     const uint8_t swizzle[4])
+{
+   if (dst_chans < 1 || dst_chans > 4 || src_chans < 1 || src_chans > 4)
+      return false;
+
+   for (unsigned c = 0; c < dst_chans; c++) {
+      if (swizzle[c] <= PIPE_SWIZZLE_W && swizzle[c] >= src_chans)
+         return false;
+      if (swizzle[c] > PIPE_SWIZZLE_NONE)
+         return false;
+   }
+
+   return true;
+}
+
+bool
+util_format_swizzle_8bit(uint8_t *dst, unsigned dst_chans,
+                         const uint8_t *src, unsigned src_chans,
+                         const uint8_t swizzle[4], uint8_t one,
+                         unsigned count)
+{
+   const struct util_format_swizzle_funcs *funcs = util_format_swizzle_get_funcs();
+
+   if (!funcs->swizzle_8bit || !swizzle_is_supported(dst_chans, src_chans, swizzle))
+      return false;
+
+   unsigned done = funcs->swizzle_8bit(dst, dst_chans, src, src_chans,
+                                       swizzle, one, count);
+
+   for (unsigned i = done; i < count; i++) {
+      uint8_t tmp[7] = { 0, 0, 0, 0, 0, one, 0 };
+
+      for (unsigned c = 0; c < src_chans; c++)
+         tmp[c] = src[i * src_chans + c];
+      for (unsigned c = 0; c < dst_chans; c++)
+         dst[i * dst_chans + c] = tmp[swizzle[c]];
+   }
+
+   return true;
+}
+
+bool
+util_format_unorm8_to_float(float *dst, unsigned dst_chans,
+                            const uint8_t *src, unsigned src_chans,
+                            const uint8_t swizzle[4], unsigned count)
+{
+   const struct util_format_swizzle_funcs *funcs = util_format_swizzle_get_funcs();
+
+   if (!funcs->unorm8_to_float || dst_chans != 4 ||
+       !swizzle_is_supported(dst_chans, src_chans, swizzle))
+      return false;
+
+   unsigned done = funcs->unorm8_to_float(dst, src, src_chans, swizzle, count);
+
+   for (unsigned i = done; i < count; i++) {
+      float tmp[7] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+      for (unsigned c = 0; c < src_chans; c++)
+         tmp[c] = _mesa_unorm_to_float(src[i * src_chans + c], 8);
+      for (unsigned c = 0; c < 4; c++)
+         dst[i * 4 + c] = tmp[swizzle[c]];
+   }
+
+   return true;
+}
+
+bool
+util_format_float_to_unorm8(uint8_t *dst, unsigned dst_chans,
+                            const float *src, unsigned src_chans,
+                            const uint8_t swizzle[4], unsigned count)
+{
+   const struct util_format_swizzle_funcs *funcs = util_format_swizzle_get_funcs();
+
+   if (!funcs->float_to_unorm8 || src_chans != 4 ||
+       !swizzle_is_supported(dst_chans, src_chans, swizzle))
+      return false;
+
+   unsigned done = funcs->float_to_unorm8(dst, dst_chans, src, swizzle, count);
+
+   for (unsigned i = done; i < count; i++) {
+      uint8_t tmp[7] = { 0, 0, 0, 0, 0, 0xff, 0 };
+
+      for (unsigned c = 0; c < 4; c++)
+         tmp[c] = _mesa_float_to_unorm(src[i * 4 + c], 8);
+      for (unsigned c = 0; c < dst_chans; c++)
+         dst[i * dst_chans + c] = tmp[swizzle[c]];
+   }
+
+   return true;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * SIMD kernels for the most common array format conversions: shuffling
+ * 8-bit channels around (RGB -> RGBA expansion, BGRA swizzles, dropping
+ * alpha), and 8-bit unorm <-> float normalization.
+ *
+ * Swizzles are in the _mesa_swizzle_and_convert() sense: dst channel i is
+ * taken from src channel swizzle[i], or is PIPE_SWIZZLE_0/PIPE_SWIZZLE_1.
+ * The kernels are picked at runtime with util_cpu_detect().  Each function
+ * returns false without touching dst if there is no SIMD kernel for the
+ * given conversion on this CPU, so that callers fall back to their generic
+ * code.  The results are identical to the generic conversions.
+ */
+
+#ifndef U_FORMAT_SWIZZLE_H
+#define U_FORMAT_SWIZZLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shuffle 8-bit channels.  PIPE_SWIZZLE_1 is written as "one", which is
+ * 0xff for unorm data.  Works in place if dst_chans == src_chans.
+ */
+bool
+util_format_swizzle_8bit(uint8_t *dst, unsigned dst_chans,
+                         const uint8_t *src, unsigned src_chans,
+                         const uint8_t swizzle[4], uint8_t one,
+                         unsigned count);
+
+/* Convert 8-bit unorm channels to 4-channel float. */
+bool
+util_format_unorm8_to_float(float *dst, unsigned dst_chans,
+                            const uint8_t *src, unsigned src_chans,
+                            const uint8_t swizzle[4], unsigned count);
+
+/* Convert 4-channel float to 8-bit unorm channels, clamping to [0, 1]. */
+bool
+util_format_float_to_unorm8(uint8_t *dst, unsigned dst_chans,
+                            const float *src, unsigned src_chans,
+                            const uint8_t swizzle[4], unsigned count);
+
+/**
+ * Row kernels of one instruction set.  Each converts as many whole SIMD
+ * chunks of the row as it can without reading or writing past the end of
+ * src or dst, and returns the number of pixels it converted; the rest of
+ * the row is done by generic code.
+ */
+struct util_format_swizzle_funcs {
+   unsigned (*swizzle_8bit)(uint8_t *dst, unsigned dst_chans,
+                            const uint8_t *src, unsigned src_chans,
+                            const uint8_t swizzle[4], uint8_t one,
+                            unsigned count);
+   unsigned (*unorm8_to_float)(float *dst, const uint8_t *src,
+                               unsigned src_chans, const uint8_t swizzle[4],
+                               unsigned count);
+   unsigned (*float_to_unorm8)(uint8_t *dst, unsigned dst_chans,
+                               const float *src, const uint8_t swizzle[4],
+                               unsigned count);
+};
+
+void
+util_format_swizzle_funcs_x86(struct util_format_swizzle_funcs *funcs);
+
+void
+util_format_swizzle_funcs_neon(struct util_format_swizzle_funcs *funcs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_SWIZZLE_H */
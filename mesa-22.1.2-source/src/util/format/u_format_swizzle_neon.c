@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pipe/p_config.h"
+
+#if (defined(PIPE_ARCH_AARCH64) || defined(PIPE_ARCH_ARM)) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
+
+/* armhf builds default to vfp, not neon, and refuses to compile neon intrinsics
+ * unless you tell it "no really".
+ */
+#ifdef PIPE_ARCH_ARM
+#pragma GCC target ("fpu=neon")
+#endif
+
+#include <arm_neon.h>
+
+#include "pipe/p_defines.h"
+#include "util/format/u_format_swizzle.h"
+#include "util/u_cpu_detect.h"
+
+/* The kernels work on 16 pixels at a time, with the structure loads and
+ * stores splitting them into one vector per channel.
+ */
+static inline uint8x16x4_t
+load_8bit(const uint8_t *src, unsigned chans)
+{
+   uint8x16x4_t v;
+
+   v.val[0] = v.val[1] = v.val[2] = v.val[3] = vdupq_n_u8(0);
+
+   switch (chans) {
+   case 1:
+      v.val[0] = vld1q_u8(src);
+      break;
+   case 2: {
+      uint8x16x2_t l = vld2q_u8(src);
+      v.val[0] = l.val[0];
+      v.val[1] = l.val[1];
+      break;
+   }
+   case 3: {
+      uint8x16x3_t l = vld3q_u8(src);
+      v.val[0] = l.val[0];
+      v.val[1] = l.val[1];
+      v.val[2] = l.val[2];
+      break;
+   }
+   default:
+      v = vld4q_u8(src);
+      break;
+   }
+
+   return v;
+}
+
+static inline void
+store_8bit(uint8_t *dst, unsigned chans, uint8x16x4_t v)
+{
+   switch (chans) {
+   case 1:
+      vst1q_u8(dst, v.val[0]);
+      break;
+   case 2: {
+      uint8x16x2_t s = { .val = { v.val[0], v.val[1] } };
+      vst2q_u8(dst, s);
+      break;
+   }
+   case 3: {
+      uint8x16x3_t s = { .val = { v.val[0], v.val[1], v.val[2] } };
+      vst3q_u8(dst, s);
+      break;
+   }
+   default:
+      vst4q_u8(dst, v);
+      break;
+   }
+}
+
+static inline uint8x16x4_t
+swizzle_8bit(uint8x16x4_t v, unsigned dst_chans, const uint8_t swizzle[4],
+             uint8_t one)
+{
+   uint8x16x4_t s;
+
+   for (unsigned c = 0; c < 4; c++) {
+      if (c < dst_chans && swizzle[c] <= PIPE_SWIZZLE_W)
+         s.val[c] = v.val[swizzle[c]];
+      else if (c < dst_chans && swizzle[c] == PIPE_SWIZZLE_1)
+         s.val[c] = vdupq_n_u8(one);
+      else
+         s.val[c] = vdupq_n_u8(0);
+   }
+
+   return s;
+}
+
+static unsigned
+swizzle_8bit_neon(uint8_t *dst, unsigned dst_chans,
+                  const uint8_t *src, unsigned src_chans,
+                  const uint8_t swizzle[4], uint8_t one, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i + 16 <= count; i += 16) {
+      uint8x16x4_t v = load_8bit(src + i * src_chans, src_chans);
+      store_8bit(dst + i * dst_chans, dst_chans,
+                 swizzle_8bit(v, dst_chans, swizzle, one));
+   }
+
+   return i;
+}
+
+static inline float32x4_t
+unorm8_to_float(uint16x4_t x)
+{
+   return vmulq_f32(vcvtq_f32_u32(vmovl_u16(x)), vdupq_n_f32(1.0f / 255.0f));
+}
+
+static unsigned
+unorm8_to_float_neon(float *dst, const uint8_t *src, unsigned src_chans,
+                     const uint8_t swizzle[4], unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i + 16 <= count; i += 16) {
+      uint8x16x4_t v = swizzle_8bit(load_8bit(src + i * src_chans, src_chans),
+                                    4, swizzle, 0xff);
+      float32x4x4_t f[4];
+
+      for (unsigned c = 0; c < 4; c++) {
+         uint16x8_t lo = vmovl_u8(vget_low_u8(v.val[c]));
+         uint16x8_t hi = vmovl_u8(vget_high_u8(v.val[c]));
+
+         f[0].val[c] = unorm8_to_float(vget_low_u16(lo));
+         f[1].val[c] = unorm8_to_float(vget_high_u16(lo));
+         f[2].val[c] = unorm8_to_float(vget_low_u16(hi));
+         f[3].val[c] = unorm8_to_float(vget_high_u16(hi));
+      }
+
+      for (unsigned p = 0; p < 4; p++)
+         vst4q_f32(dst + (i + 4 * p) * 4, f[p]);
+   }
+
+   return i;
+}
+
+#ifdef PIPE_ARCH_AARCH64
+
+/* Same as _mesa_float_to_unorm(x, 8): NaN stays NaN through the clamp, and
+ * FCVTNU turns it into 0.  ARMv7 has no round-to-nearest-even conversion,
+ * so this one is AArch64 only.
+ */
+static inline uint16x4_t
+float_to_unorm8(float32x4_t x)
+{
+   x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+   return vmovn_u32(vcvtnq_u32_f32(vmulq_n_f32(x, 255.0f)));
+}
+
+static unsigned
+float_to_unorm8_neon(uint8_t *dst, unsigned dst_chans, const float *src,
+                     const uint8_t swizzle[4], unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i + 16 <= count; i += 16) {
+      float32x4x4_t f[4];
+      uint8x16x4_t v;
+
+      for (unsigned p = 0; p < 4; p++)
+         f[p] = vld4q_f32(src + (i + 4 * p) * 4);
+
+      for (unsigned c = 0; c < 4; c++) {
+         uint16x8_t lo = vcombine_u16(float_to_unorm8(f[0].val[c]),
+                                      float_to_unorm8(f[1].val[c]));
+         uint16x8_t hi = vcombine_u16(float_to_unorm8(f[2].val[c]),
+                                      float_to_unorm8(f[3].val[c]));
+         v.val[c] = vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+      }
+
+      store_8bit(dst + i * dst_chans, dst_chans,
+                 swizzle_8bit(v, dst_chans, swizzle, 0xff));
+   }
+
+   return i;
+}
+
+#endif /* PIPE_ARCH_AARCH64 */
+
+void
+util_format_swizzle_funcs_neon(struct util_format_swizzle_funcs *funcs)
+{
+   /* CPU detect for NEON support.  On arm64, it's implied. */
+#ifdef PIPE_ARCH_ARM
+   if (!util_get_cpu_caps()->has_neon)
+      return;
+#endif
+
+   funcs->swizzle_8bit = swizzle_8bit_neon;
+   funcs->unorm8_to_float = unorm8_to_float_neon;
+#ifdef PIPE_ARCH_AARCH64
+   funcs->float_to_unorm8 = float_to_unorm8_neon;
+#endif
+}
+
+#endif /* PIPE_ARCH_AARCH64 | PIPE_ARCH_ARM */
@@ -0,0 +1,264 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+
+#include <immintrin.h>
+
+#include "pipe/p_defines.h"
+#include "util/format/u_format_swizzle.h"
+#include "util/macros.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+/* The kernels are built for the baseline target and only run on CPUs that
+ * have the instructions, so they are compiled for them one by one.
+ */
+#if defined(__GNUC__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+/**
+ * PSHUFB control moving the 8-bit channels of as many pixels as fit in 16
+ * bytes from the source to the destination layout.
+ */
+struct byte_shuffle {
+   /* Number of pixels converted per 16 bytes. */
+   unsigned pixels;
+   /* Minimum number of pixels left in the row for 16-byte loads and stores
+    * to stay inside of it.
+    */
+   unsigned span;
+   uint8_t index[16];
+   /* Bytes ORed in after the shuffle, for PIPE_SWIZZLE_1. */
+   uint8_t fill[16];
+};
+
+static void
+build_byte_shuffle(struct byte_shuffle *shuf,
+                   unsigned dst_chans, unsigned src_chans,
+                   const uint8_t swizzle[4], uint8_t one)
+{
+   shuf->pixels = 16 / MAX2(dst_chans, src_chans);
+   shuf->span = DIV_ROUND_UP(16, MIN2(dst_chans, src_chans));
+
+   for (unsigned b = 0; b < 16; b++) {
+      unsigned p = b / dst_chans, c = b % dst_chans;
+
+      shuf->fill[b] = 0;
+      if (p >= shuf->pixels) {
+         /* The store covers some bytes of the next pixels, which are either
+          * written again by the next chunk or, for in-place conversions
+          * (same channel count), must come out unchanged.
+          */
+         shuf->index[b] = src_chans == dst_chans ? b : 0x80;
+      } else if (swizzle[c] <= PIPE_SWIZZLE_W) {
+         shuf->index[b] = p * src_chans + swizzle[c];
+      } else {
+         shuf->index[b] = 0x80;
+         if (swizzle[c] == PIPE_SWIZZLE_1)
+            shuf->fill[b] = one;
+      }
+   }
+}
+
+static unsigned TARGET("ssse3")
+swizzle_8bit_ssse3(uint8_t *dst, unsigned dst_chans,
+                   const uint8_t *src, unsigned src_chans,
+                   const uint8_t swizzle[4], uint8_t one, unsigned count)
+{
+   struct byte_shuffle shuf;
+   unsigned i;
+
+   build_byte_shuffle(&shuf, dst_chans, src_chans, swizzle, one);
+
+   const __m128i index = _mm_loadu_si128((const __m128i *)shuf.index);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)shuf.fill);
+
+   for (i = 0; i + shuf.span <= count; i += shuf.pixels) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * src_chans));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, index), fill);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_chans), v);
+   }
+
+   return i;
+}
+
+static unsigned TARGET("sse4.1")
+unorm8_to_float_sse41(float *dst, const uint8_t *src, unsigned src_chans,
+                      const uint8_t swizzle[4], unsigned count)
+{
+   struct byte_shuffle shuf;
+   unsigned i;
+
+   build_byte_shuffle(&shuf, 4, src_chans, swizzle, 0xff);
+   assert(shuf.pixels == 4);
+
+   const __m128i index = _mm_loadu_si128((const __m128i *)shuf.index);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)shuf.fill);
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+#define CONVERT_PIXEL(v, p) \
+   _mm_storeu_ps(dst + (i + p) * 4, \
+                 _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4 * p))), scale))
+
+   for (i = 0; i + shuf.span <= count; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * src_chans));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, index), fill);
+      CONVERT_PIXEL(v, 0);
+      CONVERT_PIXEL(v, 1);
+      CONVERT_PIXEL(v, 2);
+      CONVERT_PIXEL(v, 3);
+   }
+
+#undef CONVERT_PIXEL
+
+   return i;
+}
+
+static unsigned TARGET("avx2")
+unorm8_to_float_avx2(float *dst, const uint8_t *src, unsigned src_chans,
+                     const uint8_t swizzle[4], unsigned count)
+{
+   struct byte_shuffle shuf;
+   unsigned i;
+
+   build_byte_shuffle(&shuf, 4, src_chans, swizzle, 0xff);
+   assert(shuf.pixels == 4);
+
+   const __m128i index = _mm_loadu_si128((const __m128i *)shuf.index);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)shuf.fill);
+   const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+
+   for (i = 0; i + shuf.span <= count; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * src_chans));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, index), fill);
+
+      __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+      __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+      _mm256_storeu_ps(dst + i * 4, _mm256_mul_ps(lo, scale));
+      _mm256_storeu_ps(dst + i * 4 + 8, _mm256_mul_ps(hi, scale));
+   }
+
+   return i;
+}
+
+/* Same as _mesa_float_to_unorm(x, 8), including NaN going to 0: MAXPS
+ * returns its second operand if either is NaN.
+ */
+static inline __m128i TARGET("sse4.1")
+unorm8_from_float_sse41(__m128 x)
+{
+   x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+   return _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(255.0f)));
+}
+
+static unsigned TARGET("sse4.1")
+float_to_unorm8_sse41(uint8_t *dst, unsigned dst_chans, const float *src,
+                      const uint8_t swizzle[4], unsigned count)
+{
+   struct byte_shuffle shuf;
+   unsigned i;
+
+   build_byte_shuffle(&shuf, dst_chans, 4, swizzle, 0xff);
+   assert(shuf.pixels == 4);
+
+   const __m128i index = _mm_loadu_si128((const __m128i *)shuf.index);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)shuf.fill);
+
+   for (i = 0; i + shuf.span <= count; i += 4) {
+      const float *s = src + i * 4;
+      __m128i p0 = unorm8_from_float_sse41(_mm_loadu_ps(s));
+      __m128i p1 = unorm8_from_float_sse41(_mm_loadu_ps(s + 4));
+      __m128i p2 = unorm8_from_float_sse41(_mm_loadu_ps(s + 8));
+      __m128i p3 = unorm8_from_float_sse41(_mm_loadu_ps(s + 12));
+      __m128i v = _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+                                   _mm_packs_epi32(p2, p3));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, index), fill);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_chans), v);
+   }
+
+   return i;
+}
+
+static inline __m256i TARGET("avx2")
+unorm8_from_float_avx2(__m256 x)
+{
+   x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+   return _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(255.0f)));
+}
+
+static unsigned TARGET("avx2")
+float_to_unorm8_avx2(uint8_t *dst, unsigned dst_chans, const float *src,
+                     const uint8_t swizzle[4], unsigned count)
+{
+   struct byte_shuffle shuf;
+   unsigned i;
+
+   build_byte_shuffle(&shuf, dst_chans, 4, swizzle, 0xff);
+   assert(shuf.pixels == 4);
+
+   const __m128i index = _mm_loadu_si128((const __m128i *)shuf.index);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)shuf.fill);
+
+   for (i = 0; i + shuf.span <= count; i += 4) {
+      const float *s = src + i * 4;
+      __m256i p01 = unorm8_from_float_avx2(_mm256_loadu_ps(s));
+      __m256i p23 = unorm8_from_float_avx2(_mm256_loadu_ps(s + 8));
+
+      /* The packs work within 128-bit lanes: the low lane ends up with
+       * pixels 0 and 2, the high lane with pixels 1 and 3.
+       */
+      __m256i b = _mm256_packus_epi16(_mm256_packs_epi32(p01, p23),
+                                      _mm256_setzero_si256());
+      __m128i v = _mm_unpacklo_epi32(_mm256_castsi256_si128(b),
+                                     _mm256_extracti128_si256(b, 1));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, index), fill);
+      _mm_storeu_si128((__m128i *)(dst + i * dst_chans), v);
+   }
+
+   return i;
+}
+
+void
+util_format_swizzle_funcs_x86(struct util_format_swizzle_funcs *funcs)
+{
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+
+   if (caps->has_ssse3)
+      funcs->swizzle_8bit = swizzle_8bit_ssse3;
+
+   if (caps->has_avx2) {
+      funcs->unorm8_to_float = unorm8_to_float_avx2;
+      funcs->float_to_unorm8 = float_to_unorm8_avx2;
+   } else if (caps->has_sse4_1) {
+      funcs->unorm8_to_float = unorm8_to_float_sse41;
+      funcs->float_to_unorm8 = float_to_unorm8_sse41;
+   }
+}
+
+#endif /* PIPE_ARCH_X86 || PIPE_ARCH_X86_64 */
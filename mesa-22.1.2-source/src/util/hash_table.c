@@ -33,9 +33,10 @@
  */
 
 /**
- * Implements an open-addressing, linear-reprobing hash table.
+ * Implements an open-addressing hash table with a Swiss table layout, see
+ * hash_table_ctrl.h.
  *
- * For more information, see:
+ * For more information on the original design, see:
  *
  * http://cgit.freedesktop.org/~anholt/hash_table/tree/README
  */
@@ -45,10 +46,10 @@
 #include <assert.h>
 
 #include "hash_table.h"
+#include "hash_table_ctrl.h"
 #include "ralloc.h"
 #include "macros.h"
 #include "u_memory.h"
-#include "fast_urem_by_const.h"
 #include "util/u_memory.h"
 
 #define XXH_INLINE_ALL
@@ -75,52 +76,6 @@ uint_key(unsigned id)
 
 static const uint32_t deleted_key_value;
 
-/**
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
- */
-static const struct {
-   uint32_t max_entries, size, rehash;
-   uint64_t size_magic, rehash_magic;
-} hash_sizes[] = {
-#define ENTRY(max_entries, size, rehash) \
-   { max_entries, size, rehash, \
-      REMAINDER_MAGIC(size), REMAINDER_MAGIC(rehash) }
-
-   ENTRY(2,            5,            3            ),
-   ENTRY(4,            7,            5            ),
-   ENTRY(8,            13,           11           ),
-   ENTRY(16,           19,           17           ),
-   ENTRY(32,           43,           41           ),
-   ENTRY(64,           73,           71           ),
-   ENTRY(128,          151,          149          ),
-   ENTRY(256,          283,          281          ),
-   ENTRY(512,          571,          569          ),
-   ENTRY(1024,         1153,         1151         ),
-   ENTRY(2048,         2269,         2267         ),
-   ENTRY(4096,         4519,         4517         ),
-   ENTRY(8192,         9013,         9011         ),
-   ENTRY(16384,        18043,        18041        ),
-   ENTRY(32768,        36109,        36107        ),
-   ENTRY(65536,        72091,        72089        ),
-   ENTRY(131072,       144409,       144407       ),
-   ENTRY(262144,       288361,       288359       ),
-   ENTRY(524288,       576883,       576881       ),
-   ENTRY(1048576,      1153459,      1153457      ),
-   ENTRY(2097152,      2307163,      2307161      ),
-   ENTRY(4194304,      4613893,      4613891      ),
-   ENTRY(8388608,      9227641,      9227639      ),
-   ENTRY(16777216,     18455029,     18455027     ),
-   ENTRY(33554432,     36911011,     36911009     ),
-   ENTRY(67108864,     73819861,     73819859     ),
-   ENTRY(134217728,    147639589,    147639587    ),
-   ENTRY(268435456,    295279081,    295279079    ),
-   ENTRY(536870912,    590559793,    590559791    ),
-   ENTRY(1073741824,   1181116273,   1181116271   ),
-   ENTRY(2147483648ul, 2362232233ul, 2362232231ul )
-};
-
 ASSERTED static inline bool
 key_pointer_is_reserved(const struct hash_table *ht, const void *key)
 {
@@ -128,21 +83,38 @@ key_pointer_is_reserved(const struct hash_table *ht, const void *key)
 }
 
 static int
-entry_is_free(const struct hash_entry *entry)
+entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
 {
-   return entry->key == NULL;
+   return entry->key != NULL && entry->key != ht->deleted_key;
 }
 
-static int
-entry_is_deleted(const struct hash_table *ht, struct hash_entry *entry)
+/* Allocates the entries and the control bytes of a table in one block. */
+static struct hash_entry *
+hash_table_alloc(void *mem_ctx, uint32_t size, uint8_t **ctrl)
 {
-   return entry->key == ht->deleted_key;
+   size_t ctrl_size = hash_ctrl_num_bytes(size);
+   struct hash_entry *table;
+
+   if (size > (SIZE_MAX - ctrl_size) / sizeof(struct hash_entry))
+      return NULL;
+
+   table = ralloc_size(mem_ctx, size * sizeof(struct hash_entry) + ctrl_size);
+   if (table == NULL)
+      return NULL;
+
+   memset(table, 0, size * sizeof(struct hash_entry));
+   *ctrl = (uint8_t *)(table + size);
+   hash_ctrl_init(*ctrl, size);
+
+   return table;
 }
 
-static int
-entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
+static void
+hash_table_set_size(struct hash_table *ht, uint32_t size_index)
 {
-   return entry->key != NULL && entry->key != ht->deleted_key;
+   ht->size_index = size_index;
+   ht->size = hash_ctrl_size(size_index);
+   ht->max_entries = hash_ctrl_max_entries(ht->size);
 }
 
 bool
@@ -152,15 +124,10 @@ _mesa_hash_table_init(struct hash_table *ht,
                       bool (*key_equals_function)(const void *a,
                                                   const void *b))
 {
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->size_magic = hash_sizes[ht->size_index].size_magic;
-   ht->rehash_magic = hash_sizes[ht->size_index].rehash_magic;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   hash_table_set_size(ht, HASH_CTRL_MIN_SIZE_INDEX);
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(mem_ctx, struct hash_entry, ht->size);
+   ht->table = hash_table_alloc(mem_ctx, ht->size, &ht->ctrl);
    ht->entries = 0;
    ht->deleted_entries = 0;
    ht->deleted_key = &deleted_key_value;
@@ -222,13 +189,17 @@ _mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
 
    memcpy(ht, src, sizeof(struct hash_table));
 
-   ht->table = ralloc_array(ht, struct hash_entry, ht->size);
+   size_t table_size = ht->size * sizeof(struct hash_entry) +
+                       hash_ctrl_num_bytes(ht->size);
+
+   ht->table = ralloc_size(ht, table_size);
    if (ht->table == NULL) {
       ralloc_free(ht);
       return NULL;
    }
 
-   memcpy(ht->table, src->table, ht->size * sizeof(struct hash_entry));
+   memcpy(ht->table, src->table, table_size);
+   ht->ctrl = (uint8_t *)(ht->table + ht->size);
 
    return ht;
 }
@@ -257,7 +228,8 @@ _mesa_hash_table_destroy(struct hash_table *ht,
 static void
 hash_table_clear_fast(struct hash_table *ht)
 {
-   memset(ht->table, 0, sizeof(struct hash_entry) * hash_sizes[ht->size_index].size);
+   memset(ht->table, 0, sizeof(struct hash_entry) * ht->size);
+   hash_ctrl_init(ht->ctrl, ht->size);
    ht->entries = ht->deleted_entries = 0;
 }
 
@@ -283,6 +255,7 @@ _mesa_hash_table_clear(struct hash_table *ht,
 
          entry->key = NULL;
       }
+      hash_ctrl_init(ht->ctrl, ht->size);
       ht->entries = 0;
       ht->deleted_entries = 0;
    } else
@@ -310,27 +283,27 @@ hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
    assert(!key_pointer_is_reserved(ht, key));
 
-   uint32_t size = ht->size;
-   uint32_t start_hash_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = 1 + util_fast_urem32(hash, ht->rehash,
-                                               ht->rehash_magic);
-   uint32_t hash_address = start_hash_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   uint8_t h2 = hash_ctrl_h2(mix);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
 
    do {
-      struct hash_entry *entry = ht->table + hash_address;
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      const uint8_t *group = ht->ctrl + offset;
+      hash_ctrl_mask match = hash_ctrl_match(group, h2);
 
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(ht, entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+      while (match) {
+         struct hash_entry *entry =
+            ht->table + offset + hash_ctrl_mask_next(&match);
+
+         if (entry->hash == hash && entry_is_present(ht, entry) &&
+             ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
-      hash_address += double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (hash_address != start_hash_address);
+      if (hash_ctrl_has_empty(group))
+         return NULL;
+   } while (hash_ctrl_probe_next(&probe));
 
    return NULL;
 }
@@ -364,25 +337,27 @@ static void
 hash_table_insert_rehash(struct hash_table *ht, uint32_t hash,
                          const void *key, void *data)
 {
-   uint32_t size = ht->size;
-   uint32_t start_hash_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = 1 + util_fast_urem32(hash, ht->rehash,
-                                               ht->rehash_magic);
-   uint32_t hash_address = start_hash_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
+
    do {
-      struct hash_entry *entry = ht->table + hash_address;
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      hash_ctrl_mask available = hash_ctrl_match(ht->ctrl + offset,
+                                                 HASH_CTRL_EMPTY);
+
+      if (likely(available)) {
+         uint32_t index = offset + hash_ctrl_mask_next(&available);
+         struct hash_entry *entry = ht->table + index;
 
-      if (likely(entry->key == NULL)) {
+         ht->ctrl[index] = hash_ctrl_h2(mix);
          entry->hash = hash;
          entry->key = key;
          entry->data = data;
          return;
       }
+   } while (hash_ctrl_probe_next(&probe));
 
-      hash_address += double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (true);
+   unreachable("rehashed table is full");
 }
 
 static void
@@ -390,6 +365,7 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
 {
    struct hash_table old_ht;
    struct hash_entry *table;
+   uint8_t *ctrl;
 
    if (ht->size_index == new_size_index && ht->deleted_entries == ht->max_entries) {
       hash_table_clear_fast(ht);
@@ -397,23 +373,19 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
       return;
    }
 
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
+   if (new_size_index > HASH_CTRL_MAX_SIZE_INDEX)
       return;
 
-   table = rzalloc_array(ralloc_parent(ht->table), struct hash_entry,
-                         hash_sizes[new_size_index].size);
+   table = hash_table_alloc(ralloc_parent(ht->table),
+                            hash_ctrl_size(new_size_index), &ctrl);
    if (table == NULL)
       return;
 
    old_ht = *ht;
 
    ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->size_magic = hash_sizes[ht->size_index].size_magic;
-   ht->rehash_magic = hash_sizes[ht->size_index].rehash_magic;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->ctrl = ctrl;
+   hash_table_set_size(ht, new_size_index);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
@@ -430,7 +402,7 @@ static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data)
 {
-   struct hash_entry *available_entry = NULL;
+   uint32_t available_index = UINT32_MAX;
 
    assert(!key_pointer_is_reserved(ht, key));
 
@@ -440,21 +412,14 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
       _mesa_hash_table_rehash(ht, ht->size_index);
    }
 
-   uint32_t size = ht->size;
-   uint32_t start_hash_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = 1 + util_fast_urem32(hash, ht->rehash,
-                                               ht->rehash_magic);
-   uint32_t hash_address = start_hash_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   uint8_t h2 = hash_ctrl_h2(mix);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
+
    do {
-      struct hash_entry *entry = ht->table + hash_address;
-
-      if (!entry_is_present(ht, entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
-      }
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      const uint8_t *group = ht->ctrl + offset;
+      hash_ctrl_mask match = hash_ctrl_match(group, h2);
 
       /* Implement replacement when another insert happens
        * with a matching key.  This is a relatively common
@@ -467,22 +432,35 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
        * required to avoid memory leaks, perform a search
        * before inserting.
        */
-      if (!entry_is_deleted(ht, entry) &&
-          entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         entry->key = key;
-         entry->data = data;
-         return entry;
+      while (match) {
+         struct hash_entry *entry =
+            ht->table + offset + hash_ctrl_mask_next(&match);
+
+         if (entry->hash == hash && entry_is_present(ht, entry) &&
+             ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            entry->data = data;
+            return entry;
+         }
+      }
+
+      /* Stash the first available entry we find */
+      if (available_index == UINT32_MAX) {
+         hash_ctrl_mask available = hash_ctrl_match_available(group);
+         if (available)
+            available_index = offset + hash_ctrl_mask_next(&available);
       }
 
-      hash_address += double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (hash_address != start_hash_address);
+      if (hash_ctrl_has_empty(group))
+         break;
+   } while (hash_ctrl_probe_next(&probe));
+
+   if (available_index != UINT32_MAX) {
+      struct hash_entry *available_entry = ht->table + available_index;
 
-   if (available_entry) {
-      if (entry_is_deleted(ht, available_entry))
+      if (ht->ctrl[available_index] == HASH_CTRL_DELETED)
          ht->deleted_entries--;
+      ht->ctrl[available_index] = h2;
       available_entry->hash = hash;
       available_entry->key = key;
       available_entry->data = data;
@@ -517,6 +495,74 @@ _mesa_hash_table_insert_pre_hashed(struct hash_table *ht, uint32_t hash,
    return hash_table_insert(ht, hash, key, data);
 }
 
+/* How many keys ahead the bulk functions prefetch. */
+#define BULK_PREFETCH_DISTANCE 8
+
+static void
+hash_table_prefetch(struct hash_table *ht, uint32_t hash)
+{
+   struct hash_ctrl_probe probe =
+      hash_ctrl_probe_start(hash_ctrl_mix(hash), ht->size);
+   uint32_t offset = hash_ctrl_probe_offset(&probe);
+
+   hash_ctrl_prefetch(ht->ctrl + offset);
+   hash_ctrl_prefetch(ht->table + offset);
+}
+
+/**
+ * Looks up \p count keys with the given hashes, storing the entries found
+ * (or NULL) to \p entries.
+ *
+ * This is faster than searching the keys one by one because it fetches the
+ * memory of the next lookups while the current one is compared.
+ */
+void
+_mesa_hash_table_search_bulk_pre_hashed(struct hash_table *ht,
+                                        unsigned count,
+                                        const uint32_t *hashes,
+                                        const void *const *keys,
+                                        struct hash_entry **entries)
+{
+   for (unsigned i = 0; i < MIN2(count, BULK_PREFETCH_DISTANCE); i++)
+      hash_table_prefetch(ht, hashes[i]);
+
+   for (unsigned i = 0; i < count; i++) {
+      if (i + BULK_PREFETCH_DISTANCE < count)
+         hash_table_prefetch(ht, hashes[i + BULK_PREFETCH_DISTANCE]);
+
+      assert(ht->key_hash_function == NULL ||
+             hashes[i] == ht->key_hash_function(keys[i]));
+      entries[i] = hash_table_search(ht, hashes[i], keys[i]);
+   }
+}
+
+/**
+ * Inserts \p count keys with the given hashes and data.
+ *
+ * The table is grown once up front instead of as the keys are inserted.
+ */
+void
+_mesa_hash_table_insert_bulk_pre_hashed(struct hash_table *ht,
+                                        unsigned count,
+                                        const uint32_t *hashes,
+                                        const void *const *keys,
+                                        void *const *data)
+{
+   _mesa_hash_table_reserve(ht, ht->entries + count);
+
+   for (unsigned i = 0; i < MIN2(count, BULK_PREFETCH_DISTANCE); i++)
+      hash_table_prefetch(ht, hashes[i]);
+
+   for (unsigned i = 0; i < count; i++) {
+      if (i + BULK_PREFETCH_DISTANCE < count)
+         hash_table_prefetch(ht, hashes[i + BULK_PREFETCH_DISTANCE]);
+
+      assert(ht->key_hash_function == NULL ||
+             hashes[i] == ht->key_hash_function(keys[i]));
+      hash_table_insert(ht, hashes[i], keys[i], data[i]);
+   }
+}
+
 /**
  * This function deletes the given hash table entry.
  *
@@ -531,6 +577,7 @@ _mesa_hash_table_remove(struct hash_table *ht,
       return;
 
    entry->key = ht->deleted_key;
+   ht->ctrl[entry - ht->table] = HASH_CTRL_DELETED;
    ht->entries--;
    ht->deleted_entries++;
 }
@@ -733,12 +780,7 @@ _mesa_hash_table_reserve(struct hash_table *ht, unsigned size)
 {
    if (size < ht->max_entries)
       return true;
-   for (unsigned i = ht->size_index + 1; i < ARRAY_SIZE(hash_sizes); i++) {
-      if (hash_sizes[i].max_entries >= size) {
-         _mesa_hash_table_rehash(ht, i);
-         break;
-      }
-   }
+   _mesa_hash_table_rehash(ht, hash_ctrl_size_index_for(size));
    return ht->max_entries >= size;
 }
 
@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include "c99_compat.h"
 #include "macros.h"
+#include "hash_table_ctrl.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,13 +47,12 @@ struct hash_entry {
 
 struct hash_table {
    struct hash_entry *table;
+   /* One control byte per entry, allocated along with the table. */
+   uint8_t *ctrl;
    uint32_t (*key_hash_function)(const void *key);
    bool (*key_equals_function)(const void *a, const void *b);
    const void *deleted_key;
    uint32_t size;
-   uint32_t rehash;
-   uint64_t size_magic;
-   uint64_t rehash_magic;
    uint32_t max_entries;
    uint32_t size_index;
    uint32_t entries;
@@ -99,6 +99,18 @@ _mesa_hash_table_search(struct hash_table *ht, const void *key);
 struct hash_entry *
 _mesa_hash_table_search_pre_hashed(struct hash_table *ht, uint32_t hash,
                                   const void *key);
+void
+_mesa_hash_table_search_bulk_pre_hashed(struct hash_table *ht,
+                                        unsigned count,
+                                        const uint32_t *hashes,
+                                        const void *const *keys,
+                                        struct hash_entry **entries);
+void
+_mesa_hash_table_insert_bulk_pre_hashed(struct hash_table *ht,
+                                        unsigned count,
+                                        const uint32_t *hashes,
+                                        const void *const *keys,
+                                        void *const *data);
 void _mesa_hash_table_remove(struct hash_table *ht,
                              struct hash_entry *entry);
 void _mesa_hash_table_remove_key(struct hash_table *ht,
@@ -150,6 +162,7 @@ _mesa_hash_table_reserve(struct hash_table *ht, unsigned size);
    for (struct hash_entry *entry = _mesa_hash_table_next_entry_unsafe(ht, NULL);  \
         (ht)->entries;                                                     \
         entry->hash = 0, entry->key = (void*)NULL, entry->data = NULL,      \
+        (ht)->ctrl[entry - (ht)->table] = HASH_CTRL_EMPTY,                 \
         (ht)->entries--, entry = _mesa_hash_table_next_entry_unsafe(ht, entry))
 
 static inline void
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Control bytes shared by the hash table and set implementations.
+ *
+ * Both are "Swiss tables": next to the power-of-two sized entry array there
+ * is one control byte per entry, which is either empty, deleted, or holds 7
+ * bits of the entry's hash.  Probing looks at groups of 16 control bytes at
+ * once, so that most lookups only compare the keys of entries that are very
+ * likely to match, and stop at the first group with an empty slot.
+ *
+ * Tables smaller than a group still get a full group of control bytes; the
+ * bytes past the end of the table are sentinels that never match anything.
+ */
+
+#ifndef HASH_TABLE_CTRL_H
+#define HASH_TABLE_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bitscan.h"
+#include "macros.h"
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || \
+    (defined(_M_X64) && !defined(_M_ARM64EC))
+#include <emmintrin.h>
+#define HASH_CTRL_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HASH_CTRL_NEON 1
+#endif
+
+#define HASH_CTRL_EMPTY    0x80
+#define HASH_CTRL_DELETED  0xfe
+#define HASH_CTRL_SENTINEL 0xff
+
+#define HASH_CTRL_GROUP_SIZE 16
+#define HASH_CTRL_MIN_SIZE_INDEX 3
+#define HASH_CTRL_MAX_SIZE_INDEX 31
+
+/* Mask of the control bytes of a group matching some value.  On NEON there
+ * is no cheap movemask, so each byte gets a nibble instead of a bit.
+ */
+typedef uint64_t hash_ctrl_mask;
+
+#ifdef HASH_CTRL_NEON
+#define HASH_CTRL_MASK_SHIFT 2
+#else
+#define HASH_CTRL_MASK_SHIFT 0
+#endif
+
+static inline uint32_t
+hash_ctrl_size(uint32_t size_index)
+{
+   return 1u << size_index;
+}
+
+/* Maximum load factor of 7/8. */
+static inline uint32_t
+hash_ctrl_max_entries(uint32_t size)
+{
+   return size - size / 8;
+}
+
+static inline uint32_t
+hash_ctrl_num_bytes(uint32_t size)
+{
+   return MAX2(size, HASH_CTRL_GROUP_SIZE);
+}
+
+static inline uint32_t
+hash_ctrl_group_mask(uint32_t size)
+{
+   return hash_ctrl_num_bytes(size) / HASH_CTRL_GROUP_SIZE - 1;
+}
+
+/* Smallest size index whose table can hold the given number of entries. */
+static inline uint32_t
+hash_ctrl_size_index_for(uint32_t entries)
+{
+   uint32_t size_index = HASH_CTRL_MIN_SIZE_INDEX;
+
+   while (size_index < HASH_CTRL_MAX_SIZE_INDEX &&
+          hash_ctrl_max_entries(hash_ctrl_size(size_index)) < entries)
+      size_index++;
+
+   return size_index;
+}
+
+static inline void
+hash_ctrl_init(uint8_t *ctrl, uint32_t size)
+{
+   memset(ctrl, HASH_CTRL_EMPTY, size);
+   if (size < HASH_CTRL_GROUP_SIZE)
+      memset(ctrl + size, HASH_CTRL_SENTINEL, HASH_CTRL_GROUP_SIZE - size);
+}
+
+/* The user's hash functions aren't always good at spreading their bits (the
+ * pointer hash is just a few shifts), and power-of-two tables only look at
+ * some of them, so mix the hash before splitting it into the group index and
+ * the 7 bits stored in the control byte.
+ */
+static inline uint64_t
+hash_ctrl_mix(uint32_t hash)
+{
+   return (uint64_t)hash * 0x9e3779b97f4a7c15ull;
+}
+
+static inline uint32_t
+hash_ctrl_h1(uint64_t mix)
+{
+   return (uint32_t)(mix >> 32);
+}
+
+static inline uint8_t
+hash_ctrl_h2(uint64_t mix)
+{
+   return (uint8_t)(mix >> 57);
+}
+
+static inline hash_ctrl_mask
+hash_ctrl_match(const uint8_t *group, uint8_t value)
+{
+#if defined(HASH_CTRL_SSE2)
+   __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+   return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl,
+                                                     _mm_set1_epi8(value)));
+#elif defined(HASH_CTRL_NEON)
+   uint8x16_t eq = vceqq_u8(vld1q_u8(group), vdupq_n_u8(value));
+   uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+   return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) &
+          0x8888888888888888ull;
+#else
+   hash_ctrl_mask mask = 0;
+   for (unsigned i = 0; i < HASH_CTRL_GROUP_SIZE; i++)
+      mask |= (hash_ctrl_mask)(group[i] == value) << i;
+   return mask;
+#endif
+}
+
+static inline bool
+hash_ctrl_has_empty(const uint8_t *group)
+{
+   return hash_ctrl_match(group, HASH_CTRL_EMPTY) != 0;
+}
+
+/* Empty or deleted control bytes, which can take a new entry. */
+static inline hash_ctrl_mask
+hash_ctrl_match_available(const uint8_t *group)
+{
+   return hash_ctrl_match(group, HASH_CTRL_EMPTY) |
+          hash_ctrl_match(group, HASH_CTRL_DELETED);
+}
+
+/* Pop the lowest match off the mask and return its index in the group. */
+static inline unsigned
+hash_ctrl_mask_next(hash_ctrl_mask *mask)
+{
+   unsigned index = (ffsll(*mask) - 1) >> HASH_CTRL_MASK_SHIFT;
+   *mask &= *mask - 1;
+   return index;
+}
+
+static inline void
+hash_ctrl_prefetch(const void *ptr)
+{
+#if defined(__GNUC__)
+   __builtin_prefetch(ptr);
+#endif
+}
+
+/**
+ * Probe sequence over the groups of a table.  Groups are visited in
+ * triangular order, which covers every group of a power-of-two table once.
+ */
+struct hash_ctrl_probe {
+   uint32_t group;
+   uint32_t group_mask;
+   uint32_t step;
+};
+
+static inline struct hash_ctrl_probe
+hash_ctrl_probe_start(uint64_t mix, uint32_t size)
+{
+   struct hash_ctrl_probe probe;
+   probe.group_mask = hash_ctrl_group_mask(size);
+   probe.group = hash_ctrl_h1(mix) & probe.group_mask;
+   probe.step = 0;
+   return probe;
+}
+
+/* Move on to the next group, returning false once all have been visited. */
+static inline bool
+hash_ctrl_probe_next(struct hash_ctrl_probe *probe)
+{
+   if (probe->step == probe->group_mask)
+      return false;
+
+   probe->step++;
+   probe->group = (probe->group + probe->step) & probe->group_mask;
+   return true;
+}
+
+static inline uint32_t
+hash_ctrl_probe_offset(const struct hash_ctrl_probe *probe)
+{
+   return probe->group * HASH_CTRL_GROUP_SIZE;
+}
+
+#endif /* HASH_TABLE_CTRL_H */
@@ -29,6 +29,8 @@
 #include <stdint.h>
 
 #include "util/macros.h"
+#include "util/simple_mtx.h"
+#include "util/u_atomic.h"
 #include "util/u_math.h"
 #include "util/u_printf.h"
 
@@ -70,6 +72,11 @@ __declspec(align(16))
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The arena size class this block was carved out of, or NULL if the block
+    * was malloc'd on its own.
+    */
+   struct ralloc_pool *pool;
 };
 
 typedef struct ralloc_header ralloc_header;
@@ -107,25 +114,379 @@ ralloc_context(const void *ctx)
    return ralloc_size(ctx, 0);
 }
 
-void *
-ralloc_size(const void *ctx, size_t size)
-{
-   /* Some malloc allocation doesn't always align to 16 bytes even on 64 bits
-    * system, from Android bionic/tests/malloc_test.cpp:
-    *  - Allocations of a size that rounds up to a multiple of 16 bytes
-    *    must have at least 16 byte alignment.
-    *  - Allocations of a size that rounds up to a multiple of 8 bytes and
-    *    not 16 bytes, are only required to have at least 8 byte alignment.
+/***************************************************************************
+ * Arena contexts
+ ***************************************************************************
+ *
+ * A context created with ralloc_arena_context() carves all of its
+ * descendants out of large chunks instead of malloc'ing them one by one.
+ * Blocks are bump-allocated from the current chunk and rounded up to a
+ * size class; ralloc_free() of a single block puts it on its size class'
+ * free list for reuse.  Blocks too big for a size class get their own
+ * malloc, but are still tracked by the arena.
+ *
+ * Freeing the arena's root releases the chunks wholesale without visiting
+ * the tree, unless the tree has destructors to run or contains allocations
+ * that don't belong to the arena (see arena_edge()).
+ *
+ * Blocks stolen out of the arena can end up in trees used by other threads,
+ * so while there are any, the arena's state is only touched with its lock
+ * held.  Only the thread holding the arena's root can steal the first one,
+ * so an arena without escaped blocks belongs to that thread alone.
+ */
+
+#define ARENA_NUM_POOLS 28
+#define ARENA_MAX_BLOCK_SIZE 1024
+#define ARENA_MIN_CHUNK_SIZE (8 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (128 * 1024)
+
+struct ralloc_pool {
+   struct ralloc_arena *arena;
+   unsigned block_size;
+   ralloc_header *free_list;
+};
+
+struct arena_chunk {
+   struct arena_chunk *next;
+};
+
+struct arena_large {
+   struct arena_large *prev;
+   struct arena_large *next;
+   size_t size;
+};
+
+#define ARENA_CHUNK_OFFSET \
+   align64(sizeof(struct arena_chunk), alignof(ralloc_header))
+#define ARENA_LARGE_OFFSET \
+   align64(sizeof(struct arena_large), alignof(ralloc_header))
+
+struct ralloc_arena {
+   /* The root of the arena's tree, or NULL once it has been freed. */
+   ralloc_header *root;
+
+   /* Bump allocation range in the most recent chunk. */
+   char *cur;
+   char *end;
+   size_t next_chunk_size;
+   struct arena_chunk *chunks;
+
+   struct arena_large *large;
+
+   struct ralloc_pool pools[ARENA_NUM_POOLS];
+   struct ralloc_pool root_pool;
+   struct ralloc_pool large_pool;
+
+   /* One reference for the root, and one for each block of this arena
+    * (other than the root) whose parent is not in this arena.  Escaped
+    * blocks keep the arena alive after its root is freed.
     */
-   void *block = malloc(align64(size + sizeof(ralloc_header),
-                                alignof(ralloc_header)));
+   unsigned refs;
+
+   simple_mtx_t lock;
+
+   /* Children of the arena's blocks that belong to another arena or to no
+    * arena at all.
+    */
+   unsigned num_foreign_children;
+
+   unsigned num_destructors;
+
+   struct ralloc_arena_stats stats;
+};
+
+/* Lock the arena if blocks of it may be used by another thread.  The one
+ * thread that can use an arena with a single reference is the one that
+ * would take the next one.
+ */
+static inline bool
+arena_lock(struct ralloc_arena *arena)
+{
+   if (likely(p_atomic_read(&arena->refs) == 1))
+      return false;
+
+   simple_mtx_lock(&arena->lock);
+   return true;
+}
+
+static inline void
+arena_unlock(struct ralloc_arena *arena, bool locked)
+{
+   if (locked)
+      simple_mtx_unlock(&arena->lock);
+}
+
+static unsigned
+arena_pool_index(size_t block_size)
+{
+   if (block_size <= 256)
+      return (block_size - 1) / 16;
+   return 16 + (block_size - 257) / 64;
+}
+
+static unsigned
+arena_pool_block_size(unsigned index)
+{
+   if (index < 16)
+      return (index + 1) * 16;
+   return 256 + (index - 15) * 64;
+}
+
+static void
+arena_add_mem(struct ralloc_arena *arena, size_t size)
+{
+   arena->stats.mem_size += size;
+   arena->stats.peak_mem_size = MAX2(arena->stats.peak_mem_size,
+                                     arena->stats.mem_size);
+}
+
+static bool
+arena_add_chunk(struct ralloc_arena *arena)
+{
+   size_t size = arena->next_chunk_size;
+   struct arena_chunk *chunk = malloc(size);
+
+   if (unlikely(chunk == NULL))
+      return false;
+
+   chunk->next = arena->chunks;
+   arena->chunks = chunk;
+   arena->cur = (char *) chunk + ARENA_CHUNK_OFFSET;
+   arena->end = (char *) chunk + size;
+   arena->next_chunk_size = MIN2(size * 2, ARENA_MAX_CHUNK_SIZE);
+   arena_add_mem(arena, size);
+   return true;
+}
+
+static ralloc_header *
+arena_alloc_block(struct ralloc_arena *arena, size_t block_size)
+{
    ralloc_header *info;
-   ralloc_header *parent;
 
-   if (unlikely(block == NULL))
+   if (unlikely(block_size > ARENA_MAX_BLOCK_SIZE)) {
+      size_t size = ARENA_LARGE_OFFSET + block_size;
+      struct arena_large *large = malloc(size);
+
+      if (unlikely(large == NULL))
+         return NULL;
+
+      large->prev = NULL;
+      large->next = arena->large;
+      large->size = size;
+      if (arena->large != NULL)
+         arena->large->prev = large;
+      arena->large = large;
+
+      arena->stats.num_allocs++;
+      arena->stats.num_large_allocs++;
+      arena_add_mem(arena, size);
+
+      info = (ralloc_header *) ((char *) large + ARENA_LARGE_OFFSET);
+      info->pool = &arena->large_pool;
+      return info;
+   }
+
+   struct ralloc_pool *pool = &arena->pools[arena_pool_index(block_size)];
+
+   if (pool->free_list != NULL) {
+      info = pool->free_list;
+      pool->free_list = info->next;
+      arena->stats.num_reused++;
+   } else {
+      if ((size_t) (arena->end - arena->cur) < pool->block_size &&
+          !arena_add_chunk(arena))
+         return NULL;
+
+      info = (ralloc_header *) arena->cur;
+      arena->cur += pool->block_size;
+   }
+
+   arena->stats.num_allocs++;
+   info->pool = pool;
+   return info;
+}
+
+static struct arena_large *
+arena_large_from_header(ralloc_header *info)
+{
+   return (struct arena_large *) ((char *) info - ARENA_LARGE_OFFSET);
+}
+
+static void
+arena_destroy(struct ralloc_arena *arena)
+{
+   while (arena->chunks != NULL) {
+      struct arena_chunk *next = arena->chunks->next;
+      free(arena->chunks);
+      arena->chunks = next;
+   }
+
+   while (arena->large != NULL) {
+      struct arena_large *next = arena->large->next;
+      free(arena->large);
+      arena->large = next;
+   }
+
+   simple_mtx_destroy(&arena->lock);
+   free(arena);
+}
+
+static void
+arena_unref(struct ralloc_arena *arena)
+{
+   if (p_atomic_dec_zero(&arena->refs))
+      arena_destroy(arena);
+}
+
+/* Return the memory of a block to its arena.  This doesn't care about
+ * the block's links or destructor, nor about the root's reference.
+ */
+static void
+arena_release_block(ralloc_header *info)
+{
+   struct ralloc_pool *pool = info->pool;
+   struct ralloc_arena *arena = pool->arena;
+
+   if (pool == &arena->root_pool) {
+      free(info);
+      arena->root = NULL;
+   } else if (pool == &arena->large_pool) {
+      struct arena_large *large = arena_large_from_header(info);
+
+      if (large->prev != NULL)
+         large->prev->next = large->next;
+      else
+         arena->large = large->next;
+      if (large->next != NULL)
+         large->next->prev = large->prev;
+
+      arena->stats.mem_size -= large->size;
+      arena->stats.num_frees++;
+      free(large);
+   } else {
+      info->next = pool->free_list;
+      pool->free_list = info;
+      arena->stats.num_frees++;
+   }
+}
+
+static ralloc_header *
+arena_resize_block(ralloc_header *old, size_t block_size)
+{
+   struct ralloc_pool *pool = old->pool;
+   struct ralloc_arena *arena = pool->arena;
+   ralloc_header *info;
+
+   if (pool == &arena->root_pool) {
+      info = realloc(old, block_size);
+      if (info != NULL)
+         arena->root = info;
+      return info;
+   }
+
+   if (pool == &arena->large_pool) {
+      if (block_size > ARENA_MAX_BLOCK_SIZE) {
+         struct arena_large *large = arena_large_from_header(old);
+         size_t old_size = large->size;
+         size_t size = ARENA_LARGE_OFFSET + block_size;
+
+         large = realloc(large, size);
+         if (large == NULL)
+            return NULL;
+
+         if (large->prev != NULL)
+            large->prev->next = large;
+         else
+            arena->large = large;
+         if (large->next != NULL)
+            large->next->prev = large;
+
+         large->size = size;
+         arena->stats.mem_size -= old_size;
+         arena_add_mem(arena, size);
+         return (ralloc_header *) ((char *) large + ARENA_LARGE_OFFSET);
+      }
+   } else if (block_size <= pool->block_size) {
+      return old;
+   }
+
+   /* Move to another size class, or between a size class and a dedicated
+    * allocation.
+    */
+   size_t old_size = pool == &arena->large_pool ?
+      arena_large_from_header(old)->size - ARENA_LARGE_OFFSET :
+      pool->block_size;
+
+   info = arena_alloc_block(arena, block_size);
+   if (info == NULL)
       return NULL;
 
-   info = (ralloc_header *) block;
+   pool = info->pool;
+   memcpy(info, old, MIN2(old_size, block_size));
+   info->pool = pool;
+   arena_release_block(old);
+   return info;
+}
+
+/* Allocations can be moved between trees with ralloc_steal() and
+ * ralloc_adopt(), so an arena's tree can end up holding blocks that aren't
+ * its own, and its blocks can end up in other trees.  Every parent/child
+ * link crossing an arena boundary is counted on both sides: foreign children
+ * force freeing the root to walk the tree, and escaped blocks keep the
+ * arena's memory alive after the root is gone.
+ */
+struct arena_edge {
+   struct ralloc_arena *foreign;
+   struct ralloc_arena *escaped;
+};
+
+static inline struct arena_edge
+arena_edge(const ralloc_header *parent, const ralloc_header *info)
+{
+   struct arena_edge edge = { NULL, NULL };
+   struct ralloc_arena *parent_arena =
+      parent != NULL && parent->pool != NULL ? parent->pool->arena : NULL;
+   struct ralloc_arena *arena = info->pool != NULL ? info->pool->arena : NULL;
+
+   if (parent_arena != arena) {
+      edge.foreign = parent_arena;
+      if (arena != NULL && info->pool != &arena->root_pool)
+         edge.escaped = arena;
+   }
+
+   return edge;
+}
+
+static void
+arena_edge_add(struct arena_edge edge)
+{
+   if (edge.foreign != NULL) {
+      bool locked = arena_lock(edge.foreign);
+      edge.foreign->num_foreign_children++;
+      arena_unlock(edge.foreign, locked);
+   }
+
+   if (edge.escaped != NULL)
+      p_atomic_inc(&edge.escaped->refs);
+}
+
+static void
+arena_edge_remove(struct arena_edge edge)
+{
+   if (edge.foreign != NULL) {
+      bool locked = arena_lock(edge.foreign);
+      assert(edge.foreign->num_foreign_children > 0);
+      edge.foreign->num_foreign_children--;
+      arena_unlock(edge.foreign, locked);
+   }
+
+   if (edge.escaped != NULL)
+      arena_unref(edge.escaped);
+}
+
+static void *
+init_header(ralloc_header *parent, ralloc_header *info)
+{
    /* measurements have shown that calloc is slower (because of
     * the multiplication overflow checking?), so clear things
     * manually
@@ -136,8 +497,6 @@ ralloc_size(const void *ctx, size_t size)
    info->next = NULL;
    info->destructor = NULL;
 
-   parent = ctx != NULL ? get_header(ctx) : NULL;
-
    add_child(parent, info);
 
 #ifndef NDEBUG
@@ -147,6 +506,38 @@ ralloc_size(const void *ctx, size_t size)
    return PTR_FROM_HEADER(info);
 }
 
+void *
+ralloc_size(const void *ctx, size_t size)
+{
+   /* Some malloc allocation doesn't always align to 16 bytes even on 64 bits
+    * system, from Android bionic/tests/malloc_test.cpp:
+    *  - Allocations of a size that rounds up to a multiple of 16 bytes
+    *    must have at least 16 byte alignment.
+    *  - Allocations of a size that rounds up to a multiple of 8 bytes and
+    *    not 16 bytes, are only required to have at least 8 byte alignment.
+    */
+   size_t block_size = align64(size + sizeof(ralloc_header),
+                               alignof(ralloc_header));
+   ralloc_header *parent = ctx != NULL ? get_header(ctx) : NULL;
+   ralloc_header *info;
+
+   if (parent != NULL && parent->pool != NULL) {
+      struct ralloc_arena *arena = parent->pool->arena;
+      bool locked = arena_lock(arena);
+      info = arena_alloc_block(arena, block_size);
+      arena_unlock(arena, locked);
+   } else {
+      info = malloc(block_size);
+      if (likely(info != NULL))
+         info->pool = NULL;
+   }
+
+   if (unlikely(info == NULL))
+      return NULL;
+
+   return init_header(parent, info);
+}
+
 void *
 rzalloc_size(const void *ctx, size_t size)
 {
@@ -158,15 +549,89 @@ rzalloc_size(const void *ctx, size_t size)
    return ptr;
 }
 
+void *
+ralloc_arena_context(const void *ctx)
+{
+   return ralloc_arena_size(ctx, 0);
+}
+
+void *
+ralloc_arena_size(const void *ctx, size_t size)
+{
+   struct ralloc_arena *arena = calloc(1, sizeof(*arena));
+   ralloc_header *parent, *info;
+
+   if (unlikely(arena == NULL))
+      return NULL;
+
+   info = malloc(align64(size + sizeof(ralloc_header),
+                         alignof(ralloc_header)));
+   if (unlikely(info == NULL)) {
+      free(arena);
+      return NULL;
+   }
+
+   for (unsigned i = 0; i < ARENA_NUM_POOLS; i++) {
+      arena->pools[i].arena = arena;
+      arena->pools[i].block_size = arena_pool_block_size(i);
+   }
+   arena->root_pool.arena = arena;
+   arena->large_pool.arena = arena;
+   arena->next_chunk_size = ARENA_MIN_CHUNK_SIZE;
+   arena->root = info;
+   arena->refs = 1;
+   simple_mtx_init(&arena->lock, mtx_plain);
+
+   parent = ctx != NULL ? get_header(ctx) : NULL;
+   info->pool = &arena->root_pool;
+   void *ptr = init_header(parent, info);
+   arena_edge_add(arena_edge(parent, info));
+
+   return ptr;
+}
+
+void *
+rzalloc_arena_size(const void *ctx, size_t size)
+{
+   void *ptr = ralloc_arena_size(ctx, size);
+
+   if (likely(ptr))
+      memset(ptr, 0, size);
+
+   return ptr;
+}
+
+bool
+ralloc_arena_get_stats(const void *ptr, struct ralloc_arena_stats *stats)
+{
+   ralloc_header *info = get_header(ptr);
+
+   if (info->pool == NULL)
+      return false;
+
+   struct ralloc_arena *arena = info->pool->arena;
+   bool locked = arena_lock(arena);
+   *stats = arena->stats;
+   arena_unlock(arena, locked);
+   return true;
+}
+
 /* helper function - assumes ptr != NULL */
 static void *
 resize(void *ptr, size_t size)
 {
    ralloc_header *child, *old, *info;
+   size_t block_size = align64(size + sizeof(ralloc_header),
+                               alignof(ralloc_header));
 
    old = get_header(ptr);
-   info = realloc(old, align64(size + sizeof(ralloc_header),
-                               alignof(ralloc_header)));
+   if (old->pool != NULL) {
+      struct ralloc_arena *arena = old->pool->arena;
+      bool locked = arena_lock(arena);
+      info = arena_resize_block(old, block_size);
+      arena_unlock(arena, locked);
+   } else
+      info = realloc(old, block_size);
 
    if (info == NULL)
       return NULL;
@@ -261,8 +726,11 @@ ralloc_free(void *ptr)
       return;
 
    info = get_header(ptr);
+
+   struct arena_edge edge = arena_edge(info->parent, info);
    unlink_block(info);
    unsafe_free(info);
+   arena_edge_remove(edge);
 }
 
 static void
@@ -287,19 +755,54 @@ unlink_block(ralloc_header *info)
 static void
 unsafe_free(ralloc_header *info)
 {
+   struct ralloc_pool *pool = info->pool;
+
+   /* The whole tree of an arena root goes away with the arena's chunks,
+    * unless something in it needs to be visited.
+    */
+   if (pool != NULL && pool == &pool->arena->root_pool) {
+      struct ralloc_arena *arena = pool->arena;
+      bool locked = arena_lock(arena);
+      if (arena->num_foreign_children == 0 &&
+          arena->num_destructors == (info->destructor != NULL))
+         info->child = NULL;
+      arena_unlock(arena, locked);
+   }
+
    /* Recursively free any children...don't waste time unlinking them. */
    ralloc_header *temp;
    while (info->child != NULL) {
       temp = info->child;
       info->child = temp->next;
-      unsafe_free(temp);
+
+      if (unlikely(pool != NULL || temp->pool != NULL)) {
+         struct arena_edge edge = arena_edge(info, temp);
+         unsafe_free(temp);
+         arena_edge_remove(edge);
+      } else {
+         unsafe_free(temp);
+      }
    }
 
    /* Free the block itself.  Call the destructor first, if any. */
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   if (pool != NULL) {
+      struct ralloc_arena *arena = pool->arena;
+      bool is_root = pool == &arena->root_pool;
+      bool locked = arena_lock(arena);
+
+      if (info->destructor != NULL)
+         arena->num_destructors--;
+      arena_release_block(info);
+      arena_unlock(arena, locked);
+
+      if (is_root)
+         arena_unref(arena);
+   } else {
+      free(info);
+   }
 }
 
 void
@@ -313,9 +816,14 @@ ralloc_steal(const void *new_ctx, void *ptr)
    info = get_header(ptr);
    parent = new_ctx ? get_header(new_ctx) : NULL;
 
+   struct arena_edge old_edge = arena_edge(info->parent, info);
+
    unlink_block(info);
 
    add_child(parent, info);
+
+   arena_edge_add(arena_edge(parent, info));
+   arena_edge_remove(old_edge);
 }
 
 void
@@ -334,10 +842,17 @@ ralloc_adopt(const void *new_ctx, void *old_ctx)
       return;
 
    /* Set all the children's parent to new_ctx; get a pointer to the last child. */
-   for (child = old_info->child; child->next != NULL; child = child->next) {
+   for (child = old_info->child; ; child = child->next) {
+      if (unlikely(old_info->pool != NULL || new_info->pool != NULL ||
+                   child->pool != NULL)) {
+         arena_edge_add(arena_edge(new_info, child));
+         arena_edge_remove(arena_edge(old_info, child));
+      }
       child->parent = new_info;
+
+      if (child->next == NULL)
+         break;
    }
-   child->parent = new_info;
 
    /* Connect the two lists together; parent them to new_ctx; make old_ctx empty. */
    child->next = new_info->child;
@@ -363,6 +878,15 @@ void
 ralloc_set_destructor(const void *ptr, void(*destructor)(void *))
 {
    ralloc_header *info = get_header(ptr);
+
+   if (info->pool != NULL) {
+      struct ralloc_arena *arena = info->pool->arena;
+      bool locked = arena_lock(arena);
+      arena->num_destructors += (destructor != NULL) -
+                                (info->destructor != NULL);
+      arena_unlock(arena, locked);
+   }
+
    info->destructor = destructor;
 }
 
@@ -49,6 +49,7 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "macros.h"
 
@@ -107,6 +108,69 @@ void *ralloc_size(const void *ctx, size_t size) MALLOCLIKE;
  */
 void *rzalloc_size(const void *ctx, size_t size) MALLOCLIKE;
 
+/**
+ * Allocate a new ralloc context in arena mode.
+ *
+ * Every allocation made out of the returned context or any of its
+ * descendants is carved out of large chunks owned by the context instead of
+ * being malloc'd individually, and freeing the context releases the chunks
+ * at once.  This is meant for contexts holding large numbers of small,
+ * short-lived allocations, like a shader's IR.
+ *
+ * Arena allocations behave like any other ralloc allocation: they can be
+ * freed, resized, stolen into other contexts and given destructors.  Memory
+ * stolen out of the arena keeps the arena's chunks alive until it is freed.
+ *
+ * As with the rest of ralloc, a tree must only be used by one thread at a
+ * time, but memory stolen out of the arena may be used and freed by other
+ * threads than the one holding the context.
+ */
+void *ralloc_arena_context(const void *ctx);
+
+/**
+ * Like ralloc_arena_context(), but also allocates \p size bytes for the
+ * context itself, similar to ralloc_size().
+ */
+void *ralloc_arena_size(const void *ctx, size_t size) MALLOCLIKE;
+
+/**
+ * Same as ralloc_arena_size(), but zero-initializes the returned memory.
+ */
+void *rzalloc_arena_size(const void *ctx, size_t size) MALLOCLIKE;
+
+#define rzalloc_arena(ctx, type) \
+   ((type *) rzalloc_arena_size(ctx, sizeof(type)))
+
+/**
+ * Allocation statistics of an arena context.
+ */
+struct ralloc_arena_stats {
+   /** Number of allocations made out of the arena */
+   uint64_t num_allocs;
+
+   /** Number of allocations that were freed before the arena itself */
+   uint64_t num_frees;
+
+   /** Number of allocations that reused memory of a freed allocation */
+   uint64_t num_reused;
+
+   /** Number of allocations too big to be carved out of a chunk */
+   uint64_t num_large_allocs;
+
+   /** Memory currently held by the arena, in bytes */
+   size_t mem_size;
+
+   /** Highest value \c mem_size has reached */
+   size_t peak_mem_size;
+};
+
+/**
+ * Get the statistics of the arena \p ptr was allocated out of.
+ *
+ * Returns false if \p ptr doesn't belong to an arena.
+ */
+bool ralloc_arena_get_stats(const void *ptr, struct ralloc_arena_stats *stats);
+
 /**
  * Resize a piece of ralloc-managed memory, preserving data.
  *
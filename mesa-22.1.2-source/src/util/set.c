@@ -40,58 +40,16 @@
 #include "macros.h"
 #include "ralloc.h"
 #include "set.h"
-#include "fast_urem_by_const.h"
+#include "hash_table_ctrl.h"
 
 /*
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * The set uses the same Swiss table layout as the hash table, see
+ * hash_table_ctrl.h.
  */
 
 static const uint32_t deleted_key_value;
 static const void *deleted_key = &deleted_key_value;
 
-static const struct {
-   uint32_t max_entries, size, rehash;
-   uint64_t size_magic, rehash_magic;
-} hash_sizes[] = {
-#define ENTRY(max_entries, size, rehash) \
-   { max_entries, size, rehash, \
-      REMAINDER_MAGIC(size), REMAINDER_MAGIC(rehash) }
-
-   ENTRY(2,            5,            3            ),
-   ENTRY(4,            7,            5            ),
-   ENTRY(8,            13,           11           ),
-   ENTRY(16,           19,           17           ),
-   ENTRY(32,           43,           41           ),
-   ENTRY(64,           73,           71           ),
-   ENTRY(128,          151,          149          ),
-   ENTRY(256,          283,          281          ),
-   ENTRY(512,          571,          569          ),
-   ENTRY(1024,         1153,         1151         ),
-   ENTRY(2048,         2269,         2267         ),
-   ENTRY(4096,         4519,         4517         ),
-   ENTRY(8192,         9013,         9011         ),
-   ENTRY(16384,        18043,        18041        ),
-   ENTRY(32768,        36109,        36107        ),
-   ENTRY(65536,        72091,        72089        ),
-   ENTRY(131072,       144409,       144407       ),
-   ENTRY(262144,       288361,       288359       ),
-   ENTRY(524288,       576883,       576881       ),
-   ENTRY(1048576,      1153459,      1153457      ),
-   ENTRY(2097152,      2307163,      2307161      ),
-   ENTRY(4194304,      4613893,      4613891      ),
-   ENTRY(8388608,      9227641,      9227639      ),
-   ENTRY(16777216,     18455029,     18455027     ),
-   ENTRY(33554432,     36911011,     36911009     ),
-   ENTRY(67108864,     73819861,     73819859     ),
-   ENTRY(134217728,    147639589,    147639587    ),
-   ENTRY(268435456,    295279081,    295279079    ),
-   ENTRY(536870912,    590559793,    590559791    ),
-   ENTRY(1073741824,   1181116273,   1181116271   ),
-   ENTRY(2147483648ul, 2362232233ul, 2362232231ul )
-};
-
 ASSERTED static inline bool
 key_pointer_is_reserved(const void *key)
 {
@@ -99,21 +57,38 @@ key_pointer_is_reserved(const void *key)
 }
 
 static int
-entry_is_free(struct set_entry *entry)
+entry_is_present(struct set_entry *entry)
 {
-   return entry->key == NULL;
+   return entry->key != NULL && entry->key != deleted_key;
 }
 
-static int
-entry_is_deleted(struct set_entry *entry)
+/* Allocates the entries and the control bytes of a set in one block. */
+static struct set_entry *
+set_alloc(void *mem_ctx, uint32_t size, uint8_t **ctrl)
 {
-   return entry->key == deleted_key;
+   size_t ctrl_size = hash_ctrl_num_bytes(size);
+   struct set_entry *table;
+
+   if (size > (SIZE_MAX - ctrl_size) / sizeof(struct set_entry))
+      return NULL;
+
+   table = ralloc_size(mem_ctx, size * sizeof(struct set_entry) + ctrl_size);
+   if (table == NULL)
+      return NULL;
+
+   memset(table, 0, size * sizeof(struct set_entry));
+   *ctrl = (uint8_t *)(table + size);
+   hash_ctrl_init(*ctrl, size);
+
+   return table;
 }
 
-static int
-entry_is_present(struct set_entry *entry)
+static void
+set_set_size(struct set *ht, uint32_t size_index)
 {
-   return entry->key != NULL && entry->key != deleted_key;
+   ht->size_index = size_index;
+   ht->size = hash_ctrl_size(size_index);
+   ht->max_entries = hash_ctrl_max_entries(ht->size);
 }
 
 bool
@@ -122,15 +97,10 @@ _mesa_set_init(struct set *ht, void *mem_ctx,
                  bool (*key_equals_function)(const void *a,
                                              const void *b))
 {
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->size_magic = hash_sizes[ht->size_index].size_magic;
-   ht->rehash_magic = hash_sizes[ht->size_index].rehash_magic;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   set_set_size(ht, HASH_CTRL_MIN_SIZE_INDEX);
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(mem_ctx, struct set_entry, ht->size);
+   ht->table = set_alloc(mem_ctx, ht->size, &ht->ctrl);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
@@ -188,13 +158,17 @@ _mesa_set_clone(struct set *set, void *dst_mem_ctx)
 
    memcpy(clone, set, sizeof(struct set));
 
-   clone->table = ralloc_array(clone, struct set_entry, clone->size);
+   size_t table_size = clone->size * sizeof(struct set_entry) +
+                       hash_ctrl_num_bytes(clone->size);
+
+   clone->table = ralloc_size(clone, table_size);
    if (clone->table == NULL) {
       ralloc_free(clone);
       return NULL;
    }
 
-   memcpy(clone->table, set->table, clone->size * sizeof(struct set_entry));
+   memcpy(clone->table, set->table, table_size);
+   clone->ctrl = (uint8_t *)(clone->table + clone->size);
 
    return clone;
 }
@@ -224,7 +198,8 @@ _mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entr
 static void
 set_clear_fast(struct set *ht)
 {
-   memset(ht->table, 0, sizeof(struct set_entry) * hash_sizes[ht->size_index].size);
+   memset(ht->table, 0, sizeof(struct set_entry) * ht->size);
+   hash_ctrl_init(ht->ctrl, ht->size);
    ht->entries = ht->deleted_entries = 0;
 }
 
@@ -249,6 +224,7 @@ _mesa_set_clear(struct set *set, void (*delete_function)(struct set_entry *entry
 
          entry->key = NULL;
       }
+      hash_ctrl_init(set->ctrl, set->size);
       set->entries = 0;
       set->deleted_entries = 0;
    } else
@@ -265,26 +241,27 @@ set_search(const struct set *ht, uint32_t hash, const void *key)
 {
    assert(!key_pointer_is_reserved(key));
 
-   uint32_t size = ht->size;
-   uint32_t start_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = util_fast_urem32(hash, ht->rehash,
-                                           ht->rehash_magic) + 1;
-   uint32_t hash_address = start_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   uint8_t h2 = hash_ctrl_h2(mix);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
+
    do {
-      struct set_entry *entry = ht->table + hash_address;
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      const uint8_t *group = ht->ctrl + offset;
+      hash_ctrl_mask match = hash_ctrl_match(group, h2);
 
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+      while (match) {
+         struct set_entry *entry =
+            ht->table + offset + hash_ctrl_mask_next(&match);
+
+         if (entry->hash == hash && entry_is_present(entry) &&
+             ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
-      hash_address += double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (hash_address != start_address);
+      if (hash_ctrl_has_empty(group))
+         return NULL;
+   } while (hash_ctrl_probe_next(&probe));
 
    return NULL;
 }
@@ -308,23 +285,26 @@ _mesa_set_search_pre_hashed(const struct set *set, uint32_t hash,
 static void
 set_add_rehash(struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t size = ht->size;
-   uint32_t start_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = util_fast_urem32(hash, ht->rehash,
-                                           ht->rehash_magic) + 1;
-   uint32_t hash_address = start_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
+
    do {
-      struct set_entry *entry = ht->table + hash_address;
-      if (likely(entry->key == NULL)) {
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      hash_ctrl_mask available = hash_ctrl_match(ht->ctrl + offset,
+                                                 HASH_CTRL_EMPTY);
+
+      if (likely(available)) {
+         uint32_t index = offset + hash_ctrl_mask_next(&available);
+         struct set_entry *entry = ht->table + index;
+
+         ht->ctrl[index] = hash_ctrl_h2(mix);
          entry->hash = hash;
          entry->key = key;
          return;
       }
+   } while (hash_ctrl_probe_next(&probe));
 
-      hash_address = hash_address + double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (true);
+   unreachable("rehashed set is full");
 }
 
 static void
@@ -332,6 +312,7 @@ set_rehash(struct set *ht, unsigned new_size_index)
 {
    struct set old_ht;
    struct set_entry *table;
+   uint8_t *ctrl;
 
    if (ht->size_index == new_size_index && ht->deleted_entries == ht->max_entries) {
       set_clear_fast(ht);
@@ -339,23 +320,19 @@ set_rehash(struct set *ht, unsigned new_size_index)
       return;
    }
 
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
+   if (new_size_index > HASH_CTRL_MAX_SIZE_INDEX)
       return;
 
-   table = rzalloc_array(ralloc_parent(ht->table), struct set_entry,
-                         hash_sizes[new_size_index].size);
+   table = set_alloc(ralloc_parent(ht->table),
+                     hash_ctrl_size(new_size_index), &ctrl);
    if (table == NULL)
       return;
 
    old_ht = *ht;
 
    ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->size_magic = hash_sizes[ht->size_index].size_magic;
-   ht->rehash_magic = hash_sizes[ht->size_index].rehash_magic;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->ctrl = ctrl;
+   set_set_size(ht, new_size_index);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
@@ -375,11 +352,7 @@ _mesa_set_resize(struct set *set, uint32_t entries)
    if (set->entries > entries)
       entries = set->entries;
 
-   unsigned size_index = 0;
-   while (hash_sizes[size_index].max_entries < entries)
-      size_index++;
-
-   set_rehash(set, size_index);
+   set_rehash(set, hash_ctrl_size_index_for(entries));
 }
 
 /**
@@ -392,7 +365,7 @@ _mesa_set_resize(struct set *set, uint32_t entries)
 static struct set_entry *
 set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
 {
-   struct set_entry *available_entry = NULL;
+   uint32_t available_index = UINT32_MAX;
 
    assert(!key_pointer_is_reserved(key));
 
@@ -402,39 +375,45 @@ set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
       set_rehash(ht, ht->size_index);
    }
 
-   uint32_t size = ht->size;
-   uint32_t start_address = util_fast_urem32(hash, size, ht->size_magic);
-   uint32_t double_hash = util_fast_urem32(hash, ht->rehash,
-                                           ht->rehash_magic) + 1;
-   uint32_t hash_address = start_address;
+   uint64_t mix = hash_ctrl_mix(hash);
+   uint8_t h2 = hash_ctrl_h2(mix);
+   struct hash_ctrl_probe probe = hash_ctrl_probe_start(mix, ht->size);
+
    do {
-      struct set_entry *entry = ht->table + hash_address;
-
-      if (!entry_is_present(entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
+      uint32_t offset = hash_ctrl_probe_offset(&probe);
+      const uint8_t *group = ht->ctrl + offset;
+      hash_ctrl_mask match = hash_ctrl_match(group, h2);
+
+      while (match) {
+         struct set_entry *entry =
+            ht->table + offset + hash_ctrl_mask_next(&match);
+
+         if (entry->hash == hash && entry_is_present(entry) &&
+             ht->key_equals_function(key, entry->key)) {
+            if (found)
+               *found = true;
+            return entry;
+         }
       }
 
-      if (!entry_is_deleted(entry) &&
-          entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         if (found)
-            *found = true;
-         return entry;
+      /* Stash the first available entry we find */
+      if (available_index == UINT32_MAX) {
+         hash_ctrl_mask available = hash_ctrl_match_available(group);
+         if (available)
+            available_index = offset + hash_ctrl_mask_next(&available);
       }
 
-      hash_address = hash_address + double_hash;
-      if (hash_address >= size)
-         hash_address -= size;
-   } while (hash_address != start_address);
+      if (hash_ctrl_has_empty(group))
+         break;
+   } while (hash_ctrl_probe_next(&probe));
+
+   if (available_index != UINT32_MAX) {
+      struct set_entry *available_entry = ht->table + available_index;
 
-   if (available_entry) {
       /* There is no matching entry, create it. */
-      if (entry_is_deleted(available_entry))
+      if (ht->ctrl[available_index] == HASH_CTRL_DELETED)
          ht->deleted_entries--;
+      ht->ctrl[available_index] = h2;
       available_entry->hash = hash;
       available_entry->key = key;
       ht->entries++;
@@ -534,6 +513,72 @@ _mesa_set_search_or_add_pre_hashed(struct set *set, uint32_t hash,
    return set_search_or_add(set, hash, key, found);
 }
 
+/* How many keys ahead the bulk functions prefetch. */
+#define BULK_PREFETCH_DISTANCE 8
+
+static void
+set_prefetch(const struct set *ht, uint32_t hash)
+{
+   struct hash_ctrl_probe probe =
+      hash_ctrl_probe_start(hash_ctrl_mix(hash), ht->size);
+   uint32_t offset = hash_ctrl_probe_offset(&probe);
+
+   hash_ctrl_prefetch(ht->ctrl + offset);
+   hash_ctrl_prefetch(ht->table + offset);
+}
+
+/**
+ * Looks up \p count keys with the given hashes, storing the entries found
+ * (or NULL) to \p entries.
+ *
+ * This is faster than searching the keys one by one because it fetches the
+ * memory of the next lookups while the current one is compared.
+ */
+void
+_mesa_set_search_bulk_pre_hashed(const struct set *set, unsigned count,
+                                 const uint32_t *hashes,
+                                 const void *const *keys,
+                                 struct set_entry **entries)
+{
+   for (unsigned i = 0; i < MIN2(count, BULK_PREFETCH_DISTANCE); i++)
+      set_prefetch(set, hashes[i]);
+
+   for (unsigned i = 0; i < count; i++) {
+      if (i + BULK_PREFETCH_DISTANCE < count)
+         set_prefetch(set, hashes[i + BULK_PREFETCH_DISTANCE]);
+
+      assert(set->key_hash_function == NULL ||
+             hashes[i] == set->key_hash_function(keys[i]));
+      entries[i] = set_search(set, hashes[i], keys[i]);
+   }
+}
+
+/**
+ * Adds \p count keys with the given hashes.
+ *
+ * The set is grown once up front instead of as the keys are added.
+ */
+void
+_mesa_set_add_bulk_pre_hashed(struct set *set, unsigned count,
+                              const uint32_t *hashes,
+                              const void *const *keys)
+{
+   if (set->entries + count > set->max_entries)
+      _mesa_set_resize(set, set->entries + count);
+
+   for (unsigned i = 0; i < MIN2(count, BULK_PREFETCH_DISTANCE); i++)
+      set_prefetch(set, hashes[i]);
+
+   for (unsigned i = 0; i < count; i++) {
+      if (i + BULK_PREFETCH_DISTANCE < count)
+         set_prefetch(set, hashes[i + BULK_PREFETCH_DISTANCE]);
+
+      assert(set->key_hash_function == NULL ||
+             hashes[i] == set->key_hash_function(keys[i]));
+      set_add(set, hashes[i], keys[i]);
+   }
+}
+
 /**
  * This function deletes the given hash table entry.
  *
@@ -547,6 +592,7 @@ _mesa_set_remove(struct set *ht, struct set_entry *entry)
       return;
 
    entry->key = deleted_key;
+   ht->ctrl[entry - ht->table] = HASH_CTRL_DELETED;
    ht->entries--;
    ht->deleted_entries++;
 }
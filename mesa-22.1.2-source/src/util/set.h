@@ -30,6 +30,7 @@
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include "hash_table_ctrl.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,12 +44,11 @@ struct set_entry {
 struct set {
    void *mem_ctx;
    struct set_entry *table;
+   /* One control byte per entry, allocated along with the table. */
+   uint8_t *ctrl;
    uint32_t (*key_hash_function)(const void *key);
    bool (*key_equals_function)(const void *a, const void *b);
    uint32_t size;
-   uint32_t rehash;
-   uint64_t size_magic;
-   uint64_t rehash_magic;
    uint32_t max_entries;
    uint32_t size_index;
    uint32_t entries;
@@ -104,6 +104,16 @@ struct set_entry *
 _mesa_set_search_and_add_pre_hashed(struct set *set, uint32_t hash,
                                     const void *key, bool *replaced);
 
+void
+_mesa_set_search_bulk_pre_hashed(const struct set *set, unsigned count,
+                                 const uint32_t *hashes,
+                                 const void *const *keys,
+                                 struct set_entry **entries);
+void
+_mesa_set_add_bulk_pre_hashed(struct set *set, unsigned count,
+                              const uint32_t *hashes,
+                              const void *const *keys);
+
 void
 _mesa_set_remove(struct set *set, struct set_entry *entry);
 void
@@ -141,7 +151,9 @@ _mesa_set_intersects(struct set *a, struct set *b);
 #define set_foreach_remove(set, entry)                              \
    for (struct set_entry *entry = _mesa_set_next_entry_unsafe(set, NULL);  \
         (set)->entries;                                              \
-        entry->hash = 0, entry->key = (void*)NULL, (set)->entries--, entry = _mesa_set_next_entry_unsafe(set, entry))
+        entry->hash = 0, entry->key = (void*)NULL,                   \
+        (set)->ctrl[entry - (set)->table] = HASH_CTRL_EMPTY,         \
+        (set)->entries--, entry = _mesa_set_next_entry_unsafe(set, entry))
 
 #ifdef __cplusplus
 } /* extern C */
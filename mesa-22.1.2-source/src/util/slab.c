@@ -39,17 +39,19 @@
 #define CHECK_MAGIC(element, value)
 #endif
 
+/* Pages grow up to this many times the parent's num_elements. */
+#define SLAB_MAX_PAGE_SCALE 8
+
+/* Head of a migrated list whose child pool has been destroyed. */
+#define SLAB_ORPHANED ((struct slab_element_header *)(intptr_t)1)
+
 /* One array element within a big buffer. */
 struct slab_element_header {
    /* The next element in the free or migrated list. */
    struct slab_element_header *next;
 
-   /* This is either
-    * - a pointer to the child pool to which this element belongs, or
-    * - a pointer to the orphaned page of the element, with the least
-    *   significant bit set to 1.
-    */
-   intptr_t owner;
+   /* The page to which this element belongs. */
+   struct slab_page_header *page;
 
 #ifndef NDEBUG
    intptr_t magic;
@@ -58,18 +60,40 @@ struct slab_element_header {
 
 /* The page is an array of allocations in one block. */
 struct slab_page_header {
-   union {
-      /* Next page in the same child pool. */
-      struct slab_page_header *next;
+   /* Next page in the same child pool. */
+   struct slab_page_header *next;
+
+   /* The child pool to which this page belongs, or NULL if the pool has been
+    * destroyed (i.e. the page is orphaned).
+    */
+   struct slab_child_pool *owner;
+
+   /* The owner's migrated list. */
+   struct slab_migrated_list *migrated;
+
+   unsigned num_elements;
+
+   /* Number of remaining, non-freed elements (for orphaned pages). */
+   unsigned num_remaining;
 
-      /* Number of remaining, non-freed elements (for orphaned pages). */
-      unsigned num_remaining;
-   } u;
    /* Memory after the last member is dedicated to the page itself.
     * The allocated size is always larger than this structure.
     */
 };
 
+/* Elements freed through another child pool are pushed here without any
+ * locking; the owning pool takes the whole stack at once when it runs out of
+ * free elements, so there is no ABA problem.  When the owning pool is
+ * destroyed, the head is set to SLAB_ORPHANED and later frees go to the
+ * orphaned page directly.
+ */
+struct slab_migrated_list {
+   struct slab_element_header *head;
+
+   /* One reference for the child pool and one for each of its pages. */
+   unsigned refcount;
+};
+
 
 static struct slab_element_header *
 slab_get_element(struct slab_parent_pool *parent,
@@ -79,6 +103,29 @@ slab_get_element(struct slab_parent_pool *parent,
           ((uint8_t*)&page[1] + (parent->element_size * index));
 }
 
+/* Replace the whole stack, returning the old one. */
+static struct slab_element_header *
+slab_migrated_list_exchange(struct slab_migrated_list *list,
+                            struct slab_element_header *new_head)
+{
+   struct slab_element_header *head = p_atomic_read(&list->head);
+
+   for (;;) {
+      struct slab_element_header *old =
+         p_atomic_cmpxchg(&list->head, head, new_head);
+      if (old == head)
+         return head;
+      head = old;
+   }
+}
+
+static void
+slab_migrated_list_unref(struct slab_migrated_list *list)
+{
+   if (!p_atomic_dec_return(&list->refcount))
+      free(list);
+}
+
 /* The given object/element belongs to an orphaned page (i.e. the owning child
  * pool has been destroyed). Mark the element as freed and free the whole page
  * when no elements are left in it.
@@ -86,13 +133,15 @@ slab_get_element(struct slab_parent_pool *parent,
 static void
 slab_free_orphaned(struct slab_element_header *elt)
 {
-   struct slab_page_header *page;
+   struct slab_page_header *page = elt->page;
 
-   assert(elt->owner & 1);
+   assert(p_atomic_read(&page->owner) == NULL);
 
-   page = (struct slab_page_header *)(elt->owner & ~(intptr_t)1);
-   if (!p_atomic_dec_return(&page->u.num_remaining))
+   if (!p_atomic_dec_return(&page->num_remaining)) {
+      struct slab_migrated_list *list = page->migrated;
       free(page);
+      slab_migrated_list_unref(list);
+   }
 }
 
 /**
@@ -106,7 +155,6 @@ slab_create_parent(struct slab_parent_pool *parent,
                    unsigned item_size,
                    unsigned num_items)
 {
-   simple_mtx_init(&parent->mutex, mtx_plain);
    parent->element_size = ALIGN_POT(sizeof(struct slab_element_header) + item_size,
                                     sizeof(intptr_t));
    parent->num_elements = num_items;
@@ -116,7 +164,6 @@ slab_create_parent(struct slab_parent_pool *parent,
 void
 slab_destroy_parent(struct slab_parent_pool *parent)
 {
-   simple_mtx_destroy(&parent->mutex);
 }
 
 /**
@@ -129,6 +176,8 @@ void slab_create_child(struct slab_child_pool *pool,
    pool->pages = NULL;
    pool->free = NULL;
    pool->migrated = NULL;
+   pool->next_page_elements = parent->num_elements;
+   memset(&pool->stats, 0, sizeof(pool->stats));
 }
 
 /**
@@ -139,62 +188,87 @@ void slab_create_child(struct slab_child_pool *pool,
  */
 void slab_destroy_child(struct slab_child_pool *pool)
 {
+   struct slab_element_header *migrated = NULL;
+
    if (!pool->parent)
       return; /* the slab probably wasn't even created */
 
-   simple_mtx_lock(&pool->parent->mutex);
-
    while (pool->pages) {
       struct slab_page_header *page = pool->pages;
-      pool->pages = page->u.next;
-      p_atomic_set(&page->u.num_remaining, pool->parent->num_elements);
-
-      for (unsigned i = 0; i < pool->parent->num_elements; ++i) {
-         struct slab_element_header *elt = slab_get_element(pool->parent, page, i);
-         p_atomic_set(&elt->owner, (intptr_t)page | 1);
-      }
+      pool->pages = page->next;
+      p_atomic_set(&page->num_remaining, page->num_elements);
+      p_atomic_set(&page->owner, NULL);
    }
 
-   while (pool->migrated) {
-      struct slab_element_header *elt = pool->migrated;
-      pool->migrated = elt->next;
+   /* From here on, other threads free elements of our pages directly, and
+    * the pages may go away as soon as their last element is freed.
+    */
+   if (pool->migrated)
+      migrated = slab_migrated_list_exchange(pool->migrated, SLAB_ORPHANED);
+
+   while (migrated) {
+      struct slab_element_header *elt = migrated;
+      migrated = elt->next;
       slab_free_orphaned(elt);
    }
 
-   simple_mtx_unlock(&pool->parent->mutex);
-
    while (pool->free) {
       struct slab_element_header *elt = pool->free;
       pool->free = elt->next;
       slab_free_orphaned(elt);
    }
 
+   if (pool->migrated)
+      slab_migrated_list_unref(pool->migrated);
+
    /* Guard against use-after-free. */
    pool->parent = NULL;
+   pool->migrated = NULL;
 }
 
 static bool
 slab_add_new_page(struct slab_child_pool *pool)
 {
-   struct slab_page_header *page = malloc(sizeof(struct slab_page_header) +
-      pool->parent->num_elements * pool->parent->element_size);
+   unsigned num_elements = pool->next_page_elements;
+   struct slab_page_header *page;
 
+   if (!pool->migrated) {
+      pool->migrated = calloc(1, sizeof(*pool->migrated));
+      if (!pool->migrated)
+         return false;
+      pool->migrated->refcount = 1;
+   }
+
+   page = malloc(sizeof(struct slab_page_header) +
+                 num_elements * pool->parent->element_size);
    if (!page)
       return false;
 
-   for (unsigned i = 0; i < pool->parent->num_elements; ++i) {
+   page->owner = pool;
+   page->migrated = pool->migrated;
+   page->num_elements = num_elements;
+   page->num_remaining = 0;
+   p_atomic_inc(&pool->migrated->refcount);
+
+   for (unsigned i = 0; i < num_elements; ++i) {
       struct slab_element_header *elt = slab_get_element(pool->parent, page, i);
-      elt->owner = (intptr_t)pool;
-      assert(!(elt->owner & 1));
+      elt->page = page;
 
       elt->next = pool->free;
       pool->free = elt;
       SET_MAGIC(elt, SLAB_MAGIC_FREE);
    }
 
-   page->u.next = pool->pages;
+   page->next = pool->pages;
    pool->pages = page;
 
+   /* Pools that keep running dry get bigger pages, so that they fall back
+    * to malloc less often.
+    */
+   pool->next_page_elements =
+      MIN2(num_elements * 2, pool->parent->num_elements * SLAB_MAX_PAGE_SCALE);
+   pool->stats.num_pages++;
+
    return true;
 }
 
@@ -212,10 +286,8 @@ slab_alloc(struct slab_child_pool *pool)
       /* First, collect elements that belong to us but were freed from a
        * different child pool.
        */
-      simple_mtx_lock(&pool->parent->mutex);
-      pool->free = pool->migrated;
-      pool->migrated = NULL;
-      simple_mtx_unlock(&pool->parent->mutex);
+      if (pool->migrated && p_atomic_read(&pool->migrated->head))
+         pool->free = slab_migrated_list_exchange(pool->migrated, NULL);
 
       /* Now allocate a new page. */
       if (!pool->free && !slab_add_new_page(pool))
@@ -224,6 +296,7 @@ slab_alloc(struct slab_child_pool *pool)
 
    elt = pool->free;
    pool->free = elt->next;
+   pool->stats.num_allocs++;
 
    CHECK_MAGIC(elt, SLAB_MAGIC_FREE);
    SET_MAGIC(elt, SLAB_MAGIC_ALLOCATED);
@@ -255,12 +328,13 @@ slab_zalloc(struct slab_child_pool *pool)
 void slab_free(struct slab_child_pool *pool, void *ptr)
 {
    struct slab_element_header *elt = ((struct slab_element_header*)ptr - 1);
-   intptr_t owner_int;
+   struct slab_page_header *page = elt->page;
+   struct slab_element_header *head;
 
    CHECK_MAGIC(elt, SLAB_MAGIC_ALLOCATED);
    SET_MAGIC(elt, SLAB_MAGIC_FREE);
 
-   if (p_atomic_read(&elt->owner) == (intptr_t)pool) {
+   if (p_atomic_read(&page->owner) == pool) {
       /* This is the simple case: The caller guarantees that we can safely
        * access the free list.
        */
@@ -270,26 +344,23 @@ void slab_free(struct slab_child_pool *pool, void *ptr)
    }
 
    /* The slow case: migration or an orphaned page. */
-   if (pool->parent)
-      simple_mtx_lock(&pool->parent->mutex);
+   pool->stats.num_migrations++;
 
-   /* Note: we _must_ re-read elt->owner here because the owning child pool
-    * may have been destroyed by another thread in the meantime.
+   /* Note: the owning child pool may be destroyed by another thread at any
+    * time, which is why this must only look at the page's migrated list.
     */
-   owner_int = p_atomic_read(&elt->owner);
-
-   if (!(owner_int & 1)) {
-      struct slab_child_pool *owner = (struct slab_child_pool *)owner_int;
-      elt->next = owner->migrated;
-      owner->migrated = elt;
-      if (pool->parent)
-         simple_mtx_unlock(&pool->parent->mutex);
-   } else {
-      if (pool->parent)
-         simple_mtx_unlock(&pool->parent->mutex);
-
-      slab_free_orphaned(elt);
+   head = p_atomic_read(&page->migrated->head);
+   while (head != SLAB_ORPHANED) {
+      struct slab_element_header *old;
+
+      elt->next = head;
+      old = p_atomic_cmpxchg(&page->migrated->head, head, elt);
+      if (old == head)
+         return;
+      head = old;
    }
+
+   slab_free_orphaned(elt);
 }
 
 /**
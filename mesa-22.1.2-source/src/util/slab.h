@@ -33,7 +33,8 @@
  * Allocations obtained from one child pool should usually be freed in the
  * same child pool. Freeing an allocation in a different child pool associated
  * to the same parent is allowed (and requires no locking by the caller), but
- * it is discouraged because it implies a performance penalty.
+ * it is discouraged because it implies a performance penalty. Such frees are
+ * handed back to the owning pool through a lock-free list.
  *
  * For convenience and to ease the transition, there is also a set of wrapper
  * functions around a single parent-child pair.
@@ -42,6 +43,8 @@
 #ifndef SLAB_H
 #define SLAB_H
 
+#include <stdint.h>
+
 #include "simple_mtx.h"
 
 #ifdef __cplusplus
@@ -50,14 +53,27 @@ extern "C" {
 
 struct slab_element_header;
 struct slab_page_header;
+struct slab_migrated_list;
 
 struct slab_parent_pool {
-   simple_mtx_t mutex;
    unsigned element_size;
    unsigned num_elements;
    unsigned item_size;
 };
 
+struct slab_child_pool_stats {
+   /* Number of objects allocated from the pool. */
+   uint64_t num_allocs;
+
+   /* Number of objects freed through the pool that belonged to another
+    * pool.
+    */
+   uint64_t num_migrations;
+
+   /* Number of pages allocated by the pool. */
+   unsigned num_pages;
+};
+
 struct slab_child_pool {
    struct slab_parent_pool *parent;
 
@@ -69,9 +85,15 @@ struct slab_child_pool {
    /* Elements that are owned by this pool but were freed with a different
     * pool as the argument to slab_free.
     *
-    * This list is protected by the parent mutex.
+    * This is a lock-free stack that is shared with the pool's pages, as they
+    * can outlive the pool.
     */
-   struct slab_element_header *migrated;
+   struct slab_migrated_list *migrated;
+
+   /* Number of elements in the next page, which grows with each page. */
+   unsigned next_page_elements;
+
+   struct slab_child_pool_stats stats;
 };
 
 void slab_create_parent(struct slab_parent_pool *parent,
@@ -0,0 +1,314 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks the SIMD conversion kernels against per-pixel conversions for all
+ * channel counts, a set of swizzles and row widths around the SIMD chunk
+ * sizes, then prints the throughput of both for the common upload and
+ * readback conversions.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_defines.h"
+#include "util/format/format_utils.h"
+#include "util/format/u_format_swizzle.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+static const uint8_t swizzles[][4] = {
+   { 0, 1, 2, 3 },
+   { 2, 1, 0, 3 },
+   { 0, 1, 2, PIPE_SWIZZLE_1 },
+   { 2, 1, 0, PIPE_SWIZZLE_1 },
+   { 0, 0, 0, PIPE_SWIZZLE_1 },
+   { PIPE_SWIZZLE_0, PIPE_SWIZZLE_0, PIPE_SWIZZLE_0, 0 },
+   { 3, 0, 1, 2 },
+   { 1, 0, PIPE_SWIZZLE_0, PIPE_SWIZZLE_1 },
+};
+
+#define MAX_WIDTH 67
+
+/* Same as the SWIZZLE_CONVERT_LOOP of _mesa_swizzle_and_convert(). */
+static void
+ref_swizzle_8bit(uint8_t *dst, unsigned dst_chans,
+                 const uint8_t *src, unsigned src_chans,
+                 const uint8_t swizzle[4], uint8_t one, unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      uint8_t tmp[7] = { 0, 0, 0, 0, 0, one, 0 };
+      for (unsigned c = 0; c < src_chans; c++)
+         tmp[c] = src[i * src_chans + c];
+      for (unsigned c = 0; c < dst_chans; c++)
+         dst[i * dst_chans + c] = tmp[swizzle[c]];
+   }
+}
+
+static void
+ref_unorm8_to_float(float *dst, const uint8_t *src, unsigned src_chans,
+                    const uint8_t swizzle[4], unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      float tmp[7] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+      for (unsigned c = 0; c < src_chans; c++)
+         tmp[c] = _mesa_unorm_to_float(src[i * src_chans + c], 8);
+      for (unsigned c = 0; c < 4; c++)
+         dst[i * 4 + c] = tmp[swizzle[c]];
+   }
+}
+
+static void
+ref_float_to_unorm8(uint8_t *dst, unsigned dst_chans, const float *src,
+                    const uint8_t swizzle[4], unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      uint8_t tmp[7] = { 0, 0, 0, 0, 0, 0xff, 0 };
+      for (unsigned c = 0; c < 4; c++)
+         tmp[c] = _mesa_float_to_unorm(src[i * 4 + c], 8);
+      for (unsigned c = 0; c < dst_chans; c++)
+         dst[i * dst_chans + c] = tmp[swizzle[c]];
+   }
+}
+
+static bool
+swizzle_fits(const uint8_t swizzle[4], unsigned dst_chans, unsigned src_chans)
+{
+   for (unsigned c = 0; c < dst_chans; c++) {
+      if (swizzle[c] <= PIPE_SWIZZLE_W && swizzle[c] >= src_chans)
+         return false;
+   }
+   return true;
+}
+
+static bool
+test_swizzle_8bit(void)
+{
+   uint8_t src[MAX_WIDTH * 4], dst[MAX_WIDTH * 4 + 1], ref[MAX_WIDTH * 4 + 1];
+   bool pass = true;
+
+   for (unsigned i = 0; i < sizeof(src); i++)
+      src[i] = rand();
+
+   for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+      for (unsigned dst_chans = 1; dst_chans <= 4; dst_chans++) {
+         for (unsigned src_chans = 1; src_chans <= 4; src_chans++) {
+            if (!swizzle_fits(swizzles[s], dst_chans, src_chans))
+               continue;
+
+            for (unsigned width = 0; width <= MAX_WIDTH; width++) {
+               /* Catch writes past the end of the row. */
+               memset(dst, 0xcd, sizeof(dst));
+               memset(ref, 0xcd, sizeof(ref));
+
+               ref_swizzle_8bit(ref, dst_chans, src, src_chans,
+                                swizzles[s], 0xff, width);
+               if (!util_format_swizzle_8bit(dst, dst_chans, src, src_chans,
+                                             swizzles[s], 0xff, width))
+                  return true; /* no SIMD kernel on this CPU */
+
+               if (memcmp(dst, ref, sizeof(dst))) {
+                  fprintf(stderr, "swizzle_8bit %u -> %u, swizzle %u, width %u: FAIL\n",
+                          src_chans, dst_chans, s, width);
+                  pass = false;
+               }
+
+               /* In place */
+               if (dst_chans == src_chans) {
+                  memcpy(dst, src, width * src_chans);
+                  util_format_swizzle_8bit(dst, dst_chans, dst, src_chans,
+                                           swizzles[s], 0xff, width);
+                  if (memcmp(dst, ref, width * dst_chans)) {
+                     fprintf(stderr, "swizzle_8bit %u -> %u in place, swizzle %u, width %u: FAIL\n",
+                             src_chans, dst_chans, s, width);
+                     pass = false;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   return pass;
+}
+
+static bool
+test_unorm8_to_float(void)
+{
+   uint8_t src[MAX_WIDTH * 4];
+   float dst[MAX_WIDTH * 4 + 1], ref[MAX_WIDTH * 4 + 1];
+   bool pass = true;
+
+   for (unsigned i = 0; i < sizeof(src); i++)
+      src[i] = i < 256 ? i : rand();
+
+   for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+      for (unsigned src_chans = 1; src_chans <= 4; src_chans++) {
+         if (!swizzle_fits(swizzles[s], 4, src_chans))
+            continue;
+
+         for (unsigned width = 0; width <= MAX_WIDTH; width++) {
+            memset(dst, 0xcd, sizeof(dst));
+            memset(ref, 0xcd, sizeof(ref));
+
+            ref_unorm8_to_float(ref, src, src_chans, swizzles[s], width);
+            if (!util_format_unorm8_to_float(dst, 4, src, src_chans,
+                                             swizzles[s], width))
+               return true;
+
+            if (memcmp(dst, ref, sizeof(dst))) {
+               fprintf(stderr, "unorm8_to_float %u -> 4, swizzle %u, width %u: FAIL\n",
+                       src_chans, s, width);
+               pass = false;
+            }
+         }
+      }
+   }
+
+   return pass;
+}
+
+static bool
+test_float_to_unorm8(void)
+{
+   float src[MAX_WIDTH * 4];
+   uint8_t dst[MAX_WIDTH * 4 + 1], ref[MAX_WIDTH * 4 + 1];
+   bool pass = true;
+
+   /* Every value that rounds to a different byte, halfway cases, values out
+    * of range and NaN.
+    */
+   for (unsigned i = 0; i < ARRAY_SIZE(src); i++) {
+      switch (i % 8) {
+      case 0: src[i] = (i / 8 % 256) / 255.0f; break;
+      case 1: src[i] = (i / 8 % 255 + 0.5f) / 255.0f; break;
+      case 2: src[i] = -1.0f - i; break;
+      case 3: src[i] = 1.0f + i; break;
+      case 4: src[i] = NAN; break;
+      case 5: src[i] = -0.0f; break;
+      default: src[i] = rand() / (float)RAND_MAX; break;
+      }
+   }
+
+   for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+      for (unsigned dst_chans = 1; dst_chans <= 4; dst_chans++) {
+         for (unsigned width = 0; width <= MAX_WIDTH; width++) {
+            memset(dst, 0xcd, sizeof(dst));
+            memset(ref, 0xcd, sizeof(ref));
+
+            ref_float_to_unorm8(ref, dst_chans, src, swizzles[s], width);
+            if (!util_format_float_to_unorm8(dst, dst_chans, src, 4,
+                                             swizzles[s], width))
+               return true;
+
+            if (memcmp(dst, ref, sizeof(dst))) {
+               fprintf(stderr, "float_to_unorm8 4 -> %u, swizzle %u, width %u: FAIL\n",
+                       dst_chans, s, width);
+               pass = false;
+            }
+         }
+      }
+   }
+
+   return pass;
+}
+
+#define BENCH_WIDTH 1024
+#define BENCH_ROWS 1024
+
+/* Runs one conversion per row of a BENCH_WIDTH x BENCH_ROWS image and
+ * prints the source megapixels per second.
+ */
+#define BENCH(name, stmt)                                               \
+   do {                                                                 \
+      int64_t start = os_time_get_nano();                               \
+      for (unsigned row = 0; row < BENCH_ROWS; row++) {                 \
+         stmt;                                                          \
+      }                                                                 \
+      int64_t ns = os_time_get_nano() - start;                          \
+      printf("%-32s %8.1f Mpix/s\n", name,                              \
+             BENCH_WIDTH * (double)BENCH_ROWS / (ns / 1000.0));         \
+   } while (0)
+
+static void
+bench(void)
+{
+   static const uint8_t rgb1[4] = { 0, 1, 2, PIPE_SWIZZLE_1 };
+   static const uint8_t bgra[4] = { 2, 1, 0, 3 };
+   static const uint8_t rgba[4] = { 0, 1, 2, 3 };
+   uint8_t *src8 = malloc(BENCH_WIDTH * BENCH_ROWS * 4);
+   uint8_t *dst8 = malloc(BENCH_WIDTH * BENCH_ROWS * 4);
+   float *srcf = malloc(BENCH_WIDTH * BENCH_ROWS * 4 * sizeof(float));
+   float *dstf = malloc(BENCH_WIDTH * BENCH_ROWS * 4 * sizeof(float));
+   const size_t row8 = BENCH_WIDTH * 4, rowf = BENCH_WIDTH * 4;
+
+   for (unsigned i = 0; i < BENCH_WIDTH * BENCH_ROWS * 4; i++) {
+      src8[i] = rand();
+      srcf[i] = rand() / (float)RAND_MAX;
+   }
+
+   BENCH("RGB8 -> RGBA8 (generic)",
+         ref_swizzle_8bit(dst8 + row * row8, 4, src8 + row * BENCH_WIDTH * 3, 3,
+                          rgb1, 0xff, BENCH_WIDTH));
+   BENCH("RGB8 -> RGBA8 (simd)",
+         util_format_swizzle_8bit(dst8 + row * row8, 4, src8 + row * BENCH_WIDTH * 3, 3,
+                                  rgb1, 0xff, BENCH_WIDTH));
+   BENCH("BGRA8 -> RGBA8 (generic)",
+         ref_swizzle_8bit(dst8 + row * row8, 4, src8 + row * row8, 4,
+                          bgra, 0xff, BENCH_WIDTH));
+   BENCH("BGRA8 -> RGBA8 (simd)",
+         util_format_swizzle_8bit(dst8 + row * row8, 4, src8 + row * row8, 4,
+                                  bgra, 0xff, BENCH_WIDTH));
+   BENCH("RGBA8 -> RGBA32F (generic)",
+         ref_unorm8_to_float(dstf + row * rowf, src8 + row * row8, 4,
+                             rgba, BENCH_WIDTH));
+   BENCH("RGBA8 -> RGBA32F (simd)",
+         util_format_unorm8_to_float(dstf + row * rowf, 4, src8 + row * row8, 4,
+                                     rgba, BENCH_WIDTH));
+   BENCH("RGBA32F -> BGRA8 (generic)",
+         ref_float_to_unorm8(dst8 + row * row8, 4, srcf + row * rowf,
+                             bgra, BENCH_WIDTH));
+   BENCH("RGBA32F -> BGRA8 (simd)",
+         util_format_float_to_unorm8(dst8 + row * row8, 4, srcf + row * rowf, 4,
+                                     bgra, BENCH_WIDTH));
+
+   free(src8);
+   free(dst8);
+   free(srcf);
+   free(dstf);
+}
+
+int main(void)
+{
+   bool pass = true;
+
+   pass &= test_swizzle_8bit();
+   pass &= test_unorm8_to_float();
+   pass &= test_float_to_unorm8();
+
+   if (pass)
+      bench();
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
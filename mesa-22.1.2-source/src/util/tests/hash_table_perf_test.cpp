@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Throughput of the hash table and set.  Besides checking the results,
+ * each test prints nanoseconds per operation.  There is no baseline to
+ * compare against, so the numbers only mean something next to those of
+ * another run on the same machine.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "util/hash_table.h"
+#include "util/set.h"
+
+static const unsigned num_keys = 200000;
+
+class hash_table_perf : public ::testing::Test {
+protected:
+   void SetUp() override
+   {
+      objects.resize(2 * num_keys);
+      for (unsigned i = 0; i < 2 * num_keys; i++) {
+         const void *key = &objects[i];
+         (i < num_keys ? keys : misses).push_back(key);
+      }
+
+      /* Look keys up in a different order than they were inserted in, like
+       * passes looking up SSA defs as they come across them.
+       */
+      std::mt19937 rng(42);
+      std::shuffle(keys.begin(), keys.end(), rng);
+      std::shuffle(misses.begin(), misses.end(), rng);
+
+      for (const void *key : keys)
+         hashes.push_back(_mesa_hash_pointer(key));
+   }
+
+   /* Runs f and prints the time per key it took. */
+   template <typename F>
+   static void measure(const char *name, unsigned count, F f)
+   {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto elapsed = std::chrono::duration<double, std::nano>(
+         std::chrono::steady_clock::now() - start).count();
+      printf("%-24s %6.2f ns/op\n", name, elapsed / count);
+   }
+
+   /* Keys are pointers to small heap objects, as in NIR. */
+   std::vector<uint64_t> objects;
+   std::vector<const void *> keys;
+   std::vector<const void *> misses;
+   std::vector<uint32_t> hashes;
+};
+
+TEST_F(hash_table_perf, hash_table)
+{
+   struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+   std::vector<struct hash_entry *> entries(num_keys);
+   unsigned found = 0;
+
+   measure("insert", num_keys, [&]() {
+      for (const void *key : keys)
+         _mesa_hash_table_insert(ht, key, (void *) key);
+   });
+   ASSERT_EQ(_mesa_hash_table_num_entries(ht), num_keys);
+
+   measure("search hit", num_keys, [&]() {
+      for (const void *key : keys)
+         found += _mesa_hash_table_search(ht, key)->data == key;
+   });
+   EXPECT_EQ(found, num_keys);
+
+   measure("search miss", num_keys, [&]() {
+      for (const void *key : misses)
+         found += _mesa_hash_table_search(ht, key) != NULL;
+   });
+   EXPECT_EQ(found, num_keys);
+
+   measure("search bulk", num_keys, [&]() {
+      _mesa_hash_table_search_bulk_pre_hashed(ht, num_keys, hashes.data(),
+                                              keys.data(), entries.data());
+   });
+   for (unsigned i = 0; i < num_keys; i++)
+      ASSERT_EQ(entries[i]->key, keys[i]);
+
+   measure("iterate", num_keys, [&]() {
+      hash_table_foreach(ht, entry)
+         found -= entry->key == entry->data;
+   });
+   EXPECT_EQ(found, 0u);
+
+   measure("remove", num_keys / 2, [&]() {
+      for (unsigned i = 0; i < num_keys; i += 2)
+         _mesa_hash_table_remove_key(ht, keys[i]);
+   });
+   EXPECT_EQ(_mesa_hash_table_num_entries(ht), num_keys / 2);
+   EXPECT_EQ(_mesa_hash_table_search(ht, keys[0]), nullptr);
+   EXPECT_NE(_mesa_hash_table_search(ht, keys[1]), nullptr);
+
+   _mesa_hash_table_destroy(ht, NULL);
+
+   ht = _mesa_pointer_hash_table_create(NULL);
+   measure("insert bulk", num_keys, [&]() {
+      _mesa_hash_table_insert_bulk_pre_hashed(ht, num_keys, hashes.data(),
+                                              keys.data(),
+                                              (void *const *) keys.data());
+   });
+   ASSERT_EQ(_mesa_hash_table_num_entries(ht), num_keys);
+   for (unsigned i = 0; i < num_keys; i++)
+      ASSERT_EQ(_mesa_hash_table_search(ht, keys[i])->data, keys[i]);
+   _mesa_hash_table_destroy(ht, NULL);
+}
+
+TEST_F(hash_table_perf, set)
+{
+   struct set *set = _mesa_pointer_set_create(NULL);
+   std::vector<struct set_entry *> entries(num_keys);
+   unsigned found = 0;
+
+   measure("set add", num_keys, [&]() {
+      for (const void *key : keys)
+         _mesa_set_add(set, key);
+   });
+   ASSERT_EQ(set->entries, num_keys);
+
+   measure("set search hit", num_keys, [&]() {
+      for (const void *key : keys)
+         found += _mesa_set_search(set, key) != NULL;
+   });
+   EXPECT_EQ(found, num_keys);
+
+   measure("set search miss", num_keys, [&]() {
+      for (const void *key : misses)
+         found += _mesa_set_search(set, key) != NULL;
+   });
+   EXPECT_EQ(found, num_keys);
+
+   measure("set search bulk", num_keys, [&]() {
+      _mesa_set_search_bulk_pre_hashed(set, num_keys, hashes.data(),
+                                       keys.data(), entries.data());
+   });
+   for (unsigned i = 0; i < num_keys; i++)
+      ASSERT_EQ(entries[i]->key, keys[i]);
+
+   measure("set iterate", num_keys, [&]() {
+      set_foreach(set, entry)
+         found--;
+   });
+   EXPECT_EQ(found, 0u);
+
+   _mesa_set_destroy(set, NULL);
+
+   set = _mesa_pointer_set_create(NULL);
+   measure("set add bulk", num_keys, [&]() {
+      _mesa_set_add_bulk_pre_hashed(set, num_keys, hashes.data(),
+                                    keys.data());
+   });
+   ASSERT_EQ(set->entries, num_keys);
+   for (unsigned i = 0; i < num_keys; i++)
+      ASSERT_NE(_mesa_set_search(set, keys[i]), nullptr);
+   _mesa_set_destroy(set, NULL);
+}
+
+/* Small tables are the common case in NIR. */
+TEST_F(hash_table_perf, small_sets)
+{
+   measure("small set create/fill", num_keys, [&]() {
+      for (unsigned i = 0; i < num_keys; i += 8) {
+         struct set *set = _mesa_pointer_set_create(NULL);
+         for (unsigned j = 0; j < 8; j++)
+            _mesa_set_add(set, keys[i + j]);
+         ASSERT_EQ(set->entries, 8u);
+         ASSERT_NE(_mesa_set_search(set, keys[i + 7]), nullptr);
+         _mesa_set_destroy(set, NULL);
+      }
+   });
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "util/ralloc.h"
+
+static void
+count_destructor(void *ptr)
+{
+   unsigned **counter = (unsigned **) ptr;
+   (**counter)++;
+}
+
+static unsigned *
+alloc_counted(const void *ctx, unsigned *counter)
+{
+   unsigned **ptr = ralloc(ctx, unsigned *);
+   *ptr = counter;
+   ralloc_set_destructor(ptr, count_destructor);
+   return (unsigned *) ptr;
+}
+
+TEST(ralloc_arena, alloc_and_free)
+{
+   void *arena = ralloc_arena_context(NULL);
+   struct ralloc_arena_stats stats;
+
+   char *small[64];
+   for (unsigned i = 0; i < 64; i++) {
+      small[i] = (char *) ralloc_size(arena, i * 13 + 1);
+      memset(small[i], i, i * 13 + 1);
+   }
+   char *large = (char *) ralloc_size(small[3], 100000);
+   memset(large, 0xff, 100000);
+
+   for (unsigned i = 0; i < 64; i++) {
+      EXPECT_EQ(ralloc_parent(small[i]), arena);
+      EXPECT_EQ(small[i][i * 13], (char) i);
+   }
+
+   ASSERT_TRUE(ralloc_arena_get_stats(large, &stats));
+   EXPECT_EQ(stats.num_allocs, 65u);
+   EXPECT_EQ(stats.num_large_allocs, 1u);
+   EXPECT_GE(stats.mem_size, 100000u);
+
+   /* Freed blocks are reused for allocations of the same size class. */
+   ralloc_free(small[10]);
+   char *again = (char *) ralloc_size(arena, 10 * 13 + 1);
+   EXPECT_EQ(again, small[10]);
+
+   ASSERT_TRUE(ralloc_arena_get_stats(arena, &stats));
+   EXPECT_EQ(stats.num_frees, 1u);
+   EXPECT_EQ(stats.num_reused, 1u);
+
+   ralloc_free(small[3]);
+   ASSERT_TRUE(ralloc_arena_get_stats(arena, &stats));
+   EXPECT_LT(stats.mem_size, 100000u);
+   EXPECT_GE(stats.peak_mem_size, 100000u);
+
+   void *plain = ralloc_context(NULL);
+   EXPECT_FALSE(ralloc_arena_get_stats(plain, &stats));
+   ralloc_free(plain);
+
+   ralloc_free(arena);
+}
+
+TEST(ralloc_arena, resize)
+{
+   void *arena = ralloc_arena_context(NULL);
+
+   char *str = ralloc_strdup(arena, "a");
+   void *child = ralloc_context(str);
+   for (unsigned i = 0; i < 2000; i++)
+      ASSERT_TRUE(ralloc_strcat(&str, "b"));
+
+   EXPECT_EQ(strlen(str), 2001u);
+   EXPECT_EQ(str[0], 'a');
+   EXPECT_EQ(str[2000], 'b');
+   EXPECT_EQ(ralloc_parent(child), str);
+   EXPECT_EQ(ralloc_parent(str), arena);
+
+   /* Shrink back into a size class. */
+   str = reralloc(arena, str, char, 8);
+   EXPECT_EQ(str[0], 'a');
+   EXPECT_EQ(ralloc_parent(child), str);
+
+   /* The root itself can be resized too. */
+   arena = reralloc_size(NULL, arena, 4096);
+   EXPECT_EQ(ralloc_parent(str), arena);
+
+   ralloc_free(arena);
+}
+
+TEST(ralloc_arena, destructors)
+{
+   unsigned count = 0;
+   void *arena = ralloc_arena_context(NULL);
+
+   void *ctx = ralloc_context(arena);
+   alloc_counted(ctx, &count);
+   alloc_counted(arena, &count);
+   unsigned *removed = alloc_counted(arena, &count);
+   ralloc_set_destructor(removed, NULL);
+
+   ralloc_free(arena);
+   EXPECT_EQ(count, 2u);
+}
+
+TEST(ralloc_arena, steal_in)
+{
+   unsigned count = 0;
+   void *arena = ralloc_arena_context(NULL);
+   void *plain = ralloc_context(NULL);
+
+   /* A non-arena allocation inside the arena must still be freed with it. */
+   void *foreign = ralloc_context(plain);
+   alloc_counted(foreign, &count);
+   ralloc_steal(ralloc_context(arena), foreign);
+
+   /* So must a nested arena. */
+   void *nested = ralloc_arena_context(arena);
+   alloc_counted(ralloc_size(nested, 16), &count);
+
+   ralloc_free(arena);
+   EXPECT_EQ(count, 2u);
+   ralloc_free(plain);
+}
+
+TEST(ralloc_arena, steal_out)
+{
+   unsigned count = 0;
+   void *arena = ralloc_arena_context(NULL);
+   void *plain = ralloc_context(NULL);
+
+   char *str = ralloc_strdup(arena, "escaped");
+   char *orphan = ralloc_strdup(arena, "orphan");
+   unsigned *counted = alloc_counted(arena, &count);
+   ralloc_steal(plain, str);
+   ralloc_steal(plain, counted);
+   ralloc_steal(NULL, orphan);
+
+   /* Blocks stolen out of the arena outlive its root... */
+   ralloc_free(arena);
+   EXPECT_STREQ(str, "escaped");
+   EXPECT_STREQ(orphan, "orphan");
+   EXPECT_EQ(count, 0u);
+
+   /* ...and can still be used as contexts and resized. */
+   ASSERT_TRUE(ralloc_strcat(&str, " and grown"));
+   EXPECT_STREQ(ralloc_strdup(str, "child"), "child");
+   EXPECT_STREQ(str, "escaped and grown");
+
+   ralloc_free(orphan);
+   ralloc_free(plain);
+   EXPECT_EQ(count, 1u);
+}
+
+TEST(ralloc_arena, adopt)
+{
+   void *arena = ralloc_arena_context(NULL);
+   void *other = ralloc_arena_context(NULL);
+   void *plain = ralloc_context(NULL);
+
+   char *a = ralloc_strdup(arena, "a");
+   char *b = ralloc_strdup(arena, "b");
+   ralloc_strdup(plain, "c");
+
+   /* The nir_sweep() pattern: move everything out, then steal back what's
+    * still live.
+    */
+   ralloc_adopt(plain, arena);
+   ralloc_steal(arena, a);
+   EXPECT_EQ(ralloc_parent(b), plain);
+
+   /* Moving everything between two arenas, like nir_shader_replace(). */
+   ralloc_adopt(other, arena);
+   EXPECT_EQ(ralloc_parent(a), other);
+   ralloc_free(arena);
+   EXPECT_STREQ(a, "a");
+
+   ralloc_free(plain);
+   ralloc_free(other);
+}
+
+/* Blocks stolen out of the arena, like a compile's results, get freed by
+ * other threads while the arena is still allocating and after its root is
+ * gone.
+ */
+TEST(ralloc_arena, escaped_across_threads)
+{
+   void *arena = ralloc_arena_context(NULL);
+   std::vector<char *> results[4];
+
+   for (unsigned i = 0; i < 4000; i++) {
+      char *str = ralloc_asprintf(arena, "result %u", i);
+      ralloc_steal(NULL, str);
+      results[i % 4].push_back(str);
+   }
+
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < 4; t++) {
+      threads.emplace_back([&results, t] {
+         for (char *str : results[t]) {
+            ASSERT_TRUE(ralloc_strcat(&str, " freed"));
+            ralloc_free(str);
+         }
+      });
+   }
+
+   for (unsigned i = 0; i < 20000; i++) {
+      void *node = ralloc_size(arena, 24 + (i * 7) % 150);
+      if (i % 3 == 0)
+         ralloc_free(node);
+   }
+   ralloc_free(arena);
+
+   for (std::thread &thread : threads)
+      thread.join();
+}
+
+/* Build and tear down a tree shaped roughly like shader IR: lots of small
+ * nodes, a few of them freed early.
+ */
+static void
+build_tree(void *ctx)
+{
+   void *parents[16];
+
+   for (unsigned i = 0; i < 16; i++)
+      parents[i] = ralloc_context(ctx);
+
+   for (unsigned i = 0; i < 20000; i++) {
+      void *node = ralloc_size(parents[i % 16], 24 + (i * 7) % 150);
+      if (i % 5 == 0)
+         ralloc_free(node);
+      else if (i % 7 == 0)
+         ralloc_strdup(node, "ssa_value_name");
+   }
+}
+
+TEST(ralloc_arena, tree)
+{
+   void *plain = ralloc_context(NULL);
+   void *arena = ralloc_arena_context(NULL);
+   struct ralloc_arena_stats stats;
+
+   build_tree(plain);
+   build_tree(arena);
+
+   ASSERT_TRUE(ralloc_arena_get_stats(arena, &stats));
+   EXPECT_EQ(stats.num_allocs, 20000u + 20000u / 7 - 20000u / 35 + 16u);
+   EXPECT_GT(stats.num_reused, 0u);
+   EXPECT_LE(stats.peak_mem_size, 20000u * 256u);
+
+   ralloc_free(plain);
+   ralloc_free(arena);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "util/slab.h"
+
+struct item {
+   unsigned producer;
+   unsigned seq;
+};
+
+TEST(slab, single_pool)
+{
+   struct slab_mempool mempool;
+   std::vector<item *> items;
+
+   slab_create(&mempool, sizeof(item), 16);
+
+   for (unsigned i = 0; i < 1000; i++) {
+      item *it = (item *) slab_alloc_st(&mempool);
+      ASSERT_NE(it, nullptr);
+      it->seq = i;
+      items.push_back(it);
+   }
+
+   for (unsigned i = 0; i < 1000; i++)
+      EXPECT_EQ(items[i]->seq, i);
+
+   for (item *it : items)
+      slab_free_st(&mempool, it);
+
+   /* Pages grow as the pool keeps running dry. */
+   EXPECT_EQ(mempool.child.stats.num_allocs, 1000u);
+   EXPECT_LT(mempool.child.stats.num_pages, 1000u / 16);
+   EXPECT_EQ(mempool.child.stats.num_migrations, 0u);
+
+   /* Everything was returned, so this doesn't need new pages. */
+   unsigned num_pages = mempool.child.stats.num_pages;
+   for (unsigned i = 0; i < 1000; i++)
+      items[i] = (item *) slab_alloc_st(&mempool);
+   EXPECT_EQ(mempool.child.stats.num_pages, num_pages);
+
+   for (item *it : items)
+      slab_free_st(&mempool, it);
+
+   slab_destroy(&mempool);
+}
+
+TEST(slab, migration_and_orphans)
+{
+   struct slab_parent_pool parent;
+   struct slab_child_pool a, b;
+
+   slab_create_parent(&parent, sizeof(item), 8);
+   slab_create_child(&a, &parent);
+   slab_create_child(&b, &parent);
+
+   item *items[100];
+   for (unsigned i = 0; i < 100; i++)
+      items[i] = (item *) slab_zalloc(&a);
+
+   /* Freed through b, then reused by a. */
+   for (unsigned i = 0; i < 50; i++)
+      slab_free(&b, items[i]);
+   EXPECT_EQ(b.stats.num_migrations, 50u);
+
+   unsigned num_pages = a.stats.num_pages;
+   for (unsigned i = 0; i < 50; i++)
+      items[i] = (item *) slab_alloc(&a);
+   EXPECT_EQ(a.stats.num_pages, num_pages);
+
+   /* Objects outlive their pool. */
+   slab_destroy_child(&a);
+   for (unsigned i = 0; i < 100; i++)
+      slab_free(&b, items[i]);
+
+   slab_destroy_child(&b);
+   slab_destroy_parent(&parent);
+}
+
+/* Each thread allocates objects from its own child pool and hands them to
+ * the next thread, which frees them through its own pool, like transfers
+ * of a threaded context.  A thread destroys its pool as soon as it has
+ * received everything, while its neighbour may still be freeing its
+ * objects, so frees race with orphaning.
+ */
+TEST(slab, threads)
+{
+   static const unsigned num_threads = 4;
+   static const unsigned num_items = 100000;
+   static const unsigned ring_size = 256;
+
+   struct slab_parent_pool parent;
+   std::atomic<item *> rings[num_threads][ring_size];
+   std::vector<std::thread> threads;
+   std::atomic<unsigned> num_freed(0);
+   std::atomic<uint64_t> num_migrations(0);
+
+   slab_create_parent(&parent, sizeof(item), 64);
+   for (unsigned t = 0; t < num_threads; t++) {
+      for (unsigned i = 0; i < ring_size; i++)
+         rings[t][i] = nullptr;
+   }
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (unsigned t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+         struct slab_child_pool pool;
+         std::atomic<item *> *out = rings[(t + 1) % num_threads];
+         std::atomic<item *> *in = rings[t];
+         unsigned out_pos = 0, in_pos = 0, received = 0;
+
+         slab_create_child(&pool, &parent);
+
+         for (unsigned i = 0; i < num_items || received < num_items; ) {
+            bool progress = false;
+
+            if (i < num_items && out[out_pos % ring_size] == nullptr) {
+               item *it = (item *) slab_alloc(&pool);
+               it->producer = t;
+               it->seq = i++;
+               out[out_pos++ % ring_size] = it;
+               progress = true;
+            }
+
+            item *it = in[in_pos % ring_size].exchange(nullptr);
+            if (it) {
+               EXPECT_EQ(it->seq, received);
+               received++;
+               in_pos++;
+               slab_free(&pool, it);
+               num_freed++;
+               progress = true;
+            }
+
+            if (!progress)
+               std::this_thread::yield();
+         }
+
+         num_migrations += pool.stats.num_migrations;
+         slab_destroy_child(&pool);
+      });
+   }
+
+   for (std::thread &thread : threads)
+      thread.join();
+
+   auto elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+   EXPECT_EQ(num_freed, num_threads * num_items);
+   EXPECT_EQ(num_migrations, (uint64_t) num_threads * num_items);
+   printf("%u threads, %u objects: %.1f Mop/s\n", num_threads,
+          num_threads * num_items, num_threads * num_items / elapsed / 1e6);
+
+   slab_destroy_parent(&parent);
+}
@@ -0,0 +1,353 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Scalar emulation of the NEON intrinsics used by util/u_sse_neon.h and the
+ * llvmpipe coverage mask builders, following the Arm reference semantics,
+ * so that their AArch64 code can be checked on x86.  Only included by
+ * u_sse_ops_neon.c and llvmpipe's lp_test_rast_neon.c.
+ */
+
+#ifndef EMU_ARM_NEON_H
+#define EMU_ARM_NEON_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define EMU_VECTOR(elem, name, bytes) \
+   typedef elem name __attribute__((vector_size(bytes)));
+
+EMU_VECTOR(int8_t, int8x16_t, 16)
+EMU_VECTOR(uint8_t, uint8x16_t, 16)
+EMU_VECTOR(int16_t, int16x8_t, 16)
+EMU_VECTOR(uint16_t, uint16x8_t, 16)
+EMU_VECTOR(int32_t, int32x4_t, 16)
+EMU_VECTOR(uint32_t, uint32x4_t, 16)
+EMU_VECTOR(int64_t, int64x2_t, 16)
+EMU_VECTOR(uint64_t, uint64x2_t, 16)
+EMU_VECTOR(int8_t, int8x8_t, 8)
+EMU_VECTOR(uint8_t, uint8x8_t, 8)
+EMU_VECTOR(int16_t, int16x4_t, 8)
+EMU_VECTOR(uint16_t, uint16x4_t, 8)
+EMU_VECTOR(int32_t, int32x2_t, 8)
+EMU_VECTOR(uint32_t, uint32x2_t, 8)
+
+#define EMU_LANES(type, elem) ((int)(sizeof(type) / sizeof(elem)))
+
+#define EMU_REINTERPRET(type, x) \
+   ({ __typeof__(x) _x = (x); type _r; memcpy(&_r, &_x, sizeof _r); _r; })
+
+#define vreinterpretq_s8_s32(x)  EMU_REINTERPRET(int8x16_t, x)
+#define vreinterpretq_u8_s32(x)  EMU_REINTERPRET(uint8x16_t, x)
+#define vreinterpretq_s16_s32(x) EMU_REINTERPRET(int16x8_t, x)
+#define vreinterpretq_u16_s32(x) EMU_REINTERPRET(uint16x8_t, x)
+#define vreinterpretq_u32_s32(x) EMU_REINTERPRET(uint32x4_t, x)
+#define vreinterpretq_s64_s32(x) EMU_REINTERPRET(int64x2_t, x)
+#define vreinterpretq_u64_s32(x) EMU_REINTERPRET(uint64x2_t, x)
+#define vreinterpretq_s32_s8(x)  EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_u8(x)  EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_s16(x) EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_u16(x) EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_u32(x) EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_s64(x) EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_s32_u64(x) EMU_REINTERPRET(int32x4_t, x)
+#define vreinterpretq_u8_u32(x)  EMU_REINTERPRET(uint8x16_t, x)
+#define vreinterpretq_u8_u16(x)  EMU_REINTERPRET(uint8x16_t, x)
+
+#define EMU_DUP(name, type, elem) \
+   static inline type name(elem v) \
+   { \
+      type r; \
+      for (int i = 0; i < EMU_LANES(type, elem); i++) \
+         r[i] = v; \
+      return r; \
+   }
+
+EMU_DUP(vdupq_n_s32, int32x4_t, int32_t)
+EMU_DUP(vdupq_n_u32, uint32x4_t, uint32_t)
+EMU_DUP(vdupq_n_s16, int16x8_t, int16_t)
+EMU_DUP(vdupq_n_u16, uint16x8_t, uint16_t)
+EMU_DUP(vdupq_n_s64, int64x2_t, int64_t)
+EMU_DUP(vdup_n_s32, int32x2_t, int32_t)
+
+#define EMU_LOAD(name, type, elem) \
+   static inline type name(const elem *p) \
+   { \
+      type r; \
+      memcpy(&r, p, sizeof r); \
+      return r; \
+   }
+
+EMU_LOAD(vld1q_s32, int32x4_t, int32_t)
+EMU_LOAD(vld1q_s16, int16x8_t, int16_t)
+EMU_LOAD(vld1q_u32, uint32x4_t, uint32_t)
+EMU_LOAD(vld1q_u16, uint16x8_t, uint16_t)
+EMU_LOAD(vld1_s32, int32x2_t, int32_t)
+
+static inline void
+vst1q_s32(int32_t *p, int32x4_t a)
+{
+   memcpy(p, &a, sizeof a);
+}
+
+static inline int32x4_t
+vsetq_lane_s32(int32_t v, int32x4_t a, int lane)
+{
+   a[lane] = v;
+   return a;
+}
+
+static inline int32x4_t
+vcombine_s32(int32x2_t a, int32x2_t b)
+{
+   int32x4_t r = { a[0], a[1], b[0], b[1] };
+   return r;
+}
+
+static inline uint8x16_t
+vcombine_u8(uint8x8_t a, uint8x8_t b)
+{
+   uint8x16_t r;
+   for (int i = 0; i < 8; i++) {
+      r[i] = a[i];
+      r[i + 8] = b[i];
+   }
+   return r;
+}
+
+static inline int32x2_t
+vget_low_s32(int32x4_t a)
+{
+   int32x2_t r = { a[0], a[1] };
+   return r;
+}
+
+static inline int32x2_t
+vget_high_s32(int32x4_t a)
+{
+   int32x2_t r = { a[2], a[3] };
+   return r;
+}
+
+static inline int16x4_t
+vget_low_s16(int16x8_t a)
+{
+   int16x4_t r = { a[0], a[1], a[2], a[3] };
+   return r;
+}
+
+static inline int32x4_t vandq_s32(int32x4_t a, int32x4_t b) { return a & b; }
+static inline uint32x4_t vandq_u32(uint32x4_t a, uint32x4_t b) { return a & b; }
+static inline int32x4_t vorrq_s32(int32x4_t a, int32x4_t b) { return a | b; }
+static inline int32x4_t vbicq_s32(int32x4_t a, int32x4_t b) { return a & ~b; }
+
+/* Wrapping arithmetic is done on the unsigned types. */
+#define EMU_WRAP(name, type, utype, op) \
+   static inline type name(type a, type b) \
+   { \
+      return (type)((utype)a op (utype)b); \
+   }
+
+EMU_WRAP(vaddq_s8, int8x16_t, uint8x16_t, +)
+EMU_WRAP(vaddq_s16, int16x8_t, uint16x8_t, +)
+EMU_WRAP(vaddq_s32, int32x4_t, uint32x4_t, +)
+EMU_WRAP(vsubq_s16, int16x8_t, uint16x8_t, -)
+EMU_WRAP(vsubq_s64, int64x2_t, uint64x2_t, -)
+EMU_WRAP(vmulq_s16, int16x8_t, uint16x8_t, *)
+
+static inline int32x4_t
+vmull_s16(int16x4_t a, int16x4_t b)
+{
+   int32x4_t r;
+   for (int i = 0; i < 4; i++)
+      r[i] = (int32_t)a[i] * b[i];
+   return r;
+}
+
+static inline int32x4_t
+vmull_high_s16(int16x8_t a, int16x8_t b)
+{
+   int32x4_t r;
+   for (int i = 0; i < 4; i++)
+      r[i] = (int32_t)a[i + 4] * b[i + 4];
+   return r;
+}
+
+static inline int32x4_t
+vpaddq_s32(int32x4_t a, int32x4_t b)
+{
+   int32x4_t r = {
+      (int32_t)((uint32_t)a[0] + a[1]), (int32_t)((uint32_t)a[2] + a[3]),
+      (int32_t)((uint32_t)b[0] + b[1]), (int32_t)((uint32_t)b[2] + b[3]),
+   };
+   return r;
+}
+
+static inline uint32_t
+vaddvq_u32(uint32x4_t a)
+{
+   return a[0] + a[1] + a[2] + a[3];
+}
+
+static inline uint32x2_t
+vmovn_u64(uint64x2_t a)
+{
+   uint32x2_t r = { (uint32_t)a[0], (uint32_t)a[1] };
+   return r;
+}
+
+static inline uint64x2_t
+vmull_u32(uint32x2_t a, uint32x2_t b)
+{
+   uint64x2_t r = { (uint64_t)a[0] * b[0], (uint64_t)a[1] * b[1] };
+   return r;
+}
+
+static inline int16x8_t
+vminq_s16(int16x8_t a, int16x8_t b)
+{
+   int16x8_t r;
+   for (int i = 0; i < 8; i++)
+      r[i] = a[i] < b[i] ? a[i] : b[i];
+   return r;
+}
+
+static inline int16x8_t
+vmaxq_s16(int16x8_t a, int16x8_t b)
+{
+   int16x8_t r;
+   for (int i = 0; i < 8; i++)
+      r[i] = a[i] > b[i] ? a[i] : b[i];
+   return r;
+}
+
+static inline uint32x4_t
+vceqq_s32(int32x4_t a, int32x4_t b)
+{
+   uint32x4_t r;
+   for (int i = 0; i < 4; i++)
+      r[i] = a[i] == b[i] ? ~0u : 0;
+   return r;
+}
+
+/*
+ * SSHL/USHL: shift each lane left by the signed low byte of the count,
+ * right if negative.  Counts of the element size or more shift everything
+ * out (all sign bits for signed right shifts).
+ */
+#define EMU_SHL(name, type, stype, elem, bits, is_signed) \
+   static inline type name(type a, stype s) \
+   { \
+      type r; \
+      for (int i = 0; i < EMU_LANES(type, elem); i++) { \
+         int c = (int8_t)s[i]; \
+         elem v = a[i]; \
+         if (c >= 0) \
+            r[i] = c >= bits ? 0 : (elem)((uint64_t)v << c); \
+         else if (-c >= bits) \
+            r[i] = is_signed && (int64_t)v < 0 ? (elem)-1 : 0; \
+         else \
+            r[i] = (elem)(v >> -c); \
+      } \
+      return r; \
+   }
+
+EMU_SHL(vshlq_s32, int32x4_t, int32x4_t, int32_t, 32, 1)
+EMU_SHL(vshlq_u32, uint32x4_t, int32x4_t, uint32_t, 32, 0)
+EMU_SHL(vshlq_s16, int16x8_t, int16x8_t, int16_t, 16, 1)
+EMU_SHL(vshlq_u16, uint16x8_t, int16x8_t, uint16_t, 16, 0)
+EMU_SHL(vshlq_u64, uint64x2_t, int64x2_t, uint64_t, 64, 0)
+
+static inline int32x4_t
+vmlaq_n_s32(int32x4_t a, int32x4_t b, int32_t c)
+{
+   return (int32x4_t)((uint32x4_t)a + (uint32x4_t)b * (uint32_t)c);
+}
+
+static inline uint32x4_t
+vmlaq_n_u32(uint32x4_t a, uint32x4_t b, uint32_t c)
+{
+   return a + b * c;
+}
+
+static inline uint16x8_t
+vmlaq_n_u16(uint16x8_t a, uint16x8_t b, uint16_t c)
+{
+   return a + b * c;
+}
+
+static inline uint8x16_t
+vqtbl1q_u8(uint8x16_t t, uint8x16_t idx)
+{
+   uint8x16_t r;
+   for (int i = 0; i < 16; i++)
+      r[i] = idx[i] < 16 ? t[idx[i]] : 0;
+   return r;
+}
+
+static inline int8x16_t
+vzip1q_s8(int8x16_t a, int8x16_t b)
+{
+   int8x16_t r;
+   for (int i = 0; i < 8; i++) {
+      r[2 * i] = a[i];
+      r[2 * i + 1] = b[i];
+   }
+   return r;
+}
+
+static inline int8x16_t
+vzip2q_s8(int8x16_t a, int8x16_t b)
+{
+   int8x16_t r;
+   for (int i = 0; i < 8; i++) {
+      r[2 * i] = a[i + 8];
+      r[2 * i + 1] = b[i + 8];
+   }
+   return r;
+}
+
+static inline int32x4_t
+vzip1q_s32(int32x4_t a, int32x4_t b)
+{
+   int32x4_t r = { a[0], b[0], a[1], b[1] };
+   return r;
+}
+
+static inline int32x4_t
+vzip2q_s32(int32x4_t a, int32x4_t b)
+{
+   int32x4_t r = { a[2], b[2], a[3], b[3] };
+   return r;
+}
+
+static inline uint8x8_t
+vqmovun_s16(int16x8_t a)
+{
+   uint8x8_t r;
+   for (int i = 0; i < 8; i++)
+      r[i] = a[i] < 0 ? 0 : a[i] > 255 ? 255 : a[i];
+   return r;
+}
+
+#endif /* EMU_ARM_NEON_H */
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that the NEON implementation of util/u_sse_neon.h used on AArch64
+ * gives bit for bit the same results as SSE2, by running both on random
+ * inputs.  The NEON side is built against a scalar emulation of the
+ * intrinsics, so this runs on x86.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "u_sse_ops.h"
+
+int
+main(int argc, char **argv)
+{
+   uint8_t in[3][16], sse[U_SSE_MAX_OPS][16], neon[U_SSE_MAX_OPS][16];
+   unsigned iter, i, j, failures = 0;
+
+   srand(1);
+
+   for (iter = 0; iter < 200000; iter++) {
+      unsigned num_sse, num_neon;
+
+      /* Saturated bytes and equal halves hit the edge cases. */
+      for (i = 0; i < 3; i++) {
+         for (j = 0; j < 16; j++) {
+            if (iter % 7 == 0)
+               in[i][j] = rand() & 1 ? 0 : 255;
+            else
+               in[i][j] = rand();
+         }
+      }
+      if (iter % 5 == 0)
+         memcpy(in[1], in[0], 8);
+
+      num_sse = u_sse_ops_sse(in, sse);
+      num_neon = u_sse_ops_neon(in, neon);
+      if (num_sse != num_neon || num_sse > U_SSE_MAX_OPS) {
+         printf("ran %u SSE2 ops but %u NEON ops\n", num_sse, num_neon);
+         return 1;
+      }
+
+      for (i = 0; i < num_sse; i++) {
+         if (memcmp(sse[i], neon[i], 16) == 0)
+            continue;
+
+         if (failures++ < 10) {
+            printf("op %u differs for inputs\n", i);
+            for (j = 0; j < 3; j++) {
+               printf("  ");
+               for (unsigned k = 0; k < 16; k++)
+                  printf("%02x", in[j][k]);
+               printf("\n");
+            }
+         }
+      }
+   }
+
+   if (failures) {
+      printf("%u failures\n", failures);
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Every SSE2 intrinsic and util_sse2_* helper of util/u_sse.h that
+ * util/u_sse_neon.h implements with NEON on AArch64, applied to the inputs.
+ * Included by u_sse_ops_sse.c and u_sse_ops_neon.c with U_SSE_OPS set to
+ * the name of the function to define, after including util/u_sse.h or
+ * util/u_sse_neon.h.
+ */
+
+#include <string.h>
+
+#define OUT(e) \
+   do { __m128i _v = (e); memcpy(out[n++], &_v, 16); } while (0)
+
+#define SHUFFLES(imm) \
+   OUT(_mm_shuffle_epi32(a, imm)); \
+   OUT(_mm_shufflelo_epi16(a, imm)); \
+   OUT(_mm_shufflehi_epi16(a, imm));
+
+unsigned
+U_SSE_OPS(const uint8_t in[3][16], uint8_t out[][16])
+{
+   const int32_t *in32[3] = {
+      (const int32_t *)in[0], (const int32_t *)in[1], (const int32_t *)in[2]
+   };
+   __m128i a, b, c, wl, wh;
+   unsigned n = 0;
+
+   memcpy(&a, in[0], 16);
+   memcpy(&b, in[1], 16);
+   memcpy(&c, in[2], 16);
+
+   OUT(_mm_setzero_si128());
+   OUT(_mm_set1_epi32(in32[0][0]));
+   OUT(_mm_set1_epi16(((const int16_t *)in[0])[0]));
+   OUT(_mm_set_epi32(1, 2, 3, 4));
+   OUT(_mm_setr_epi32(1, 2, 3, -4));
+   OUT(_mm_setr_epi16(1, 2, 3, 4, 5, 6, -7, 8));
+   OUT(_mm_cvtsi32_si128(in32[1][2]));
+   OUT(_mm_loadu_si128((const __m128i *)in[2]));
+   OUT(_mm_loadl_epi64((const __m128i *)in[2]));
+
+   OUT(_mm_and_si128(a, b));
+   OUT(_mm_or_si128(a, b));
+   OUT(_mm_andnot_si128(a, b));
+   OUT(_mm_add_epi8(a, b));
+   OUT(_mm_add_epi16(a, b));
+   OUT(_mm_add_epi32(a, b));
+   OUT(_mm_sub_epi16(a, b));
+   OUT(_mm_sub_epi64(a, b));
+   OUT(_mm_mullo_epi16(a, b));
+   OUT(_mm_madd_epi16(a, b));
+   OUT(_mm_mul_epu32(a, b));
+   OUT(_mm_min_epi16(a, b));
+   OUT(_mm_max_epi16(a, b));
+   OUT(_mm_cmpeq_epi32(a, b));
+   OUT(_mm_cmpeq_epi32(a, a));
+
+   OUT(_mm_slli_epi32(a, 7));
+   OUT(_mm_srli_epi32(a, 9));
+   OUT(_mm_srai_epi32(a, 31));
+   OUT(_mm_srai_epi32(a, 40));
+   OUT(_mm_srli_epi16(a, 8));
+   OUT(_mm_srai_epi16(a, 3));
+   OUT(_mm_slli_epi64(a, 32));
+   OUT(_mm_srli_epi64(a, 32));
+   OUT(_mm_slli_epi32(a, 32));
+   OUT(_mm_srli_epi32(a, 0));
+
+   SHUFFLES(0x00)
+   SHUFFLES(0x1b)
+   SHUFFLES(0xff)
+   SHUFFLES(0x4e)
+   SHUFFLES(_MM_SHUFFLE(2, 3, 0, 1))
+   SHUFFLES(0x93)
+
+   OUT(_mm_unpacklo_epi8(a, b));
+   OUT(_mm_unpackhi_epi8(a, b));
+   OUT(_mm_unpacklo_epi32(a, b));
+   OUT(_mm_unpackhi_epi32(a, b));
+   OUT(_mm_unpacklo_epi64(a, b));
+   OUT(_mm_unpackhi_epi64(a, b));
+   OUT(_mm_packus_epi16(a, b));
+
+   OUT(mm_mullo_epi32(a, b));
+   {
+      __m128i r13, r02 = mm_mullohi_epi32(a, b, &r13);
+      OUT(r02);
+      OUT(r13);
+   }
+
+   OUT(util_sse2_blend_premul_4(a, b));
+   OUT(util_sse2_blend_srcalpha_4(a, b));
+   OUT(util_sse2_blend_premul_src_4(a, b, in[2][0]));
+   OUT(util_sse2_lerp_epi8_fixed08(a, b, c));
+   OUT(util_sse2_lerp_unorm8(a, b, c));
+
+   wl = _mm_srli_epi16(c, 7);
+   wh = _mm_srli_epi16(a, 7);
+   OUT(util_sse2_lerp_epi8_fixed88(a, b, &wl, &wh));
+   OUT(util_sse2_lerp_2d_epi8_fixed88(a, b, &c, &a, &wl, &wh, &wh, &wl));
+
+   {
+      __m128i o, p, q, r;
+      transpose4_epi32(&a, &b, &c, &a, &o, &p, &q, &r);
+      OUT(o);
+      OUT(p);
+      OUT(q);
+      OUT(r);
+   }
+
+   {
+      uint32_t src[80];
+      __m128i dst[4];
+      int x;
+
+      for (int i = 0; i < 80; i++)
+         src[i] = ((const uint32_t *)in[i % 3])[i % 4] * (i + 1);
+
+      x = util_sse2_stretch_row_8unorm(dst, 16, src,
+                                       ((const uint16_t *)in[2])[0],
+                                       0x28000 + in[1][3] * 37);
+      for (int i = 0; i < 4; i++)
+         OUT(dst[i]);
+      OUT(_mm_set1_epi32(x));
+   }
+
+   return n;
+}
+
+#undef SHUFFLES
+#undef OUT
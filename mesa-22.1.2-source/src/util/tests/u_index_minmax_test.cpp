@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <vector>
+
+#include "util/macros.h"
+#include "util/u_index_minmax.h"
+
+template <typename T>
+static void
+reference_minmax(const std::vector<T> &indices, unsigned offset,
+                 unsigned count, bool restart, unsigned restart_index,
+                 unsigned *min_index, unsigned *max_index)
+{
+   *min_index = ~0u;
+   *max_index = 0;
+   for (unsigned i = offset; i < offset + count; i++) {
+      if (restart && indices[i] == restart_index)
+         continue;
+      *min_index = MIN2(*min_index, (unsigned)indices[i]);
+      *max_index = MAX2(*max_index, (unsigned)indices[i]);
+   }
+}
+
+/* Compare against a scalar scan, for every alignment and length around the
+ * vector sizes, with the extremes and the restart index in the vector
+ * bodies and in the tails.
+ */
+template <typename T>
+static void
+check_minmax(bool restart)
+{
+   const unsigned type_max = (T)~0u;
+   const unsigned restart_indices[] = { 0, 7, type_max, ~0u };
+   std::vector<T> indices(160);
+   uint32_t seed = 1;
+
+   for (unsigned restart_index : restart_indices) {
+      for (unsigned pass = 0; pass < 16; pass++) {
+         for (auto &i : indices) {
+            seed = seed * 1103515245 + 12345;
+            i = (seed >> 8) % 5 == 0 ? (T)restart_index : (T)(seed >> 4);
+         }
+         if (pass & 1)
+            indices[37] = 0;
+         if (pass & 2)
+            indices[71] = type_max;
+
+         for (unsigned offset = 0; offset < 8; offset++) {
+            for (unsigned count = 0; count + offset <= indices.size();
+                 count += 1 + count / 16) {
+               unsigned min, max, ref_min, ref_max;
+
+               util_index_minmax(indices.data() + offset, sizeof(T), count,
+                                 restart, restart_index, &min, &max);
+               reference_minmax(indices, offset, count, restart,
+                                restart_index, &ref_min, &ref_max);
+               ASSERT_EQ(min, ref_min) << "offset " << offset
+                                       << " count " << count;
+               ASSERT_EQ(max, ref_max) << "offset " << offset
+                                       << " count " << count;
+            }
+         }
+      }
+   }
+}
+
+TEST(u_index_minmax, ubyte)
+{
+   check_minmax<uint8_t>(false);
+}
+
+TEST(u_index_minmax, ubyte_restart)
+{
+   check_minmax<uint8_t>(true);
+}
+
+TEST(u_index_minmax, ushort)
+{
+   check_minmax<uint16_t>(false);
+}
+
+TEST(u_index_minmax, ushort_restart)
+{
+   check_minmax<uint16_t>(true);
+}
+
+TEST(u_index_minmax, uint)
+{
+   check_minmax<uint32_t>(false);
+}
+
+TEST(u_index_minmax, uint_restart)
+{
+   check_minmax<uint32_t>(true);
+}
+
+/* All indices being the restart index leaves an empty range. */
+TEST(u_index_minmax, all_restart)
+{
+   std::vector<uint16_t> indices(100, 0xffff);
+   unsigned min, max;
+
+   util_index_minmax(indices.data(), 2, indices.size(), true, 0xffff,
+                     &min, &max);
+   EXPECT_EQ(min, ~0u);
+   EXPECT_EQ(max, 0u);
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "c11/threads.h"
+#include "pipe/p_config.h"
+#include "util/u_cpu_detect.h"
+#include "util/macros.h"
+#include "util/u_index_minmax.h"
+#include "util/u_math.h"
+
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+#include <immintrin.h>
+#elif defined(PIPE_ARCH_AARCH64)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Scan the first whole SIMD vectors of count indices, returning how many
+ * indices were scanned.  Indices equal to restart_index, if restart, are
+ * made ~0 for the minimum and 0 for the maximum.
+ */
+typedef unsigned (*minmax_func)(const void *indices, unsigned count,
+                                bool restart, unsigned restart_index,
+                                unsigned *min_index, unsigned *max_index);
+
+/* Indexed by util_logbase2(index_size). */
+static minmax_func minmax_funcs[3];
+
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+
+/* The kernels are built for the baseline target and only run on CPUs that
+ * have the instructions, so they are compiled for them one by one.
+ */
+#if defined(__GNUC__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+#define DEFINE_MINMAX(isa, name, bits, vec, width, load, set1, cmpeq,      \
+                      vmin, vmax, vor, vandnot, store)                     \
+static unsigned TARGET(isa)                                                \
+name(const void *indices, unsigned count, bool restart,                    \
+     unsigned restart_index, unsigned *min_index, unsigned *max_index)     \
+{                                                                          \
+   const uint##bits##_t *idx = indices;                                    \
+   const unsigned n = width / sizeof(*idx);                                \
+   const vec r = set1(restart_index);                                      \
+   vec lo = set1(-1), hi = set1(0);                                        \
+   uint##bits##_t lo_arr[width / sizeof(*idx)];                            \
+   uint##bits##_t hi_arr[width / sizeof(*idx)];                            \
+   unsigned i;                                                             \
+                                                                           \
+   if (restart) {                                                          \
+      for (i = 0; i + n <= count; i += n) {                                \
+         vec v = load((const vec *)(idx + i));                             \
+         vec m = cmpeq(v, r);                                              \
+         lo = vmin(lo, vor(v, m));                                         \
+         hi = vmax(hi, vandnot(m, v));                                     \
+      }                                                                    \
+   } else {                                                                \
+      for (i = 0; i + n <= count; i += n) {                                \
+         vec v = load((const vec *)(idx + i));                             \
+         lo = vmin(lo, v);                                                 \
+         hi = vmax(hi, v);                                                 \
+      }                                                                    \
+   }                                                                       \
+                                                                           \
+   store((vec *)lo_arr, lo);                                               \
+   store((vec *)hi_arr, hi);                                               \
+   *min_index = lo_arr[0];                                                 \
+   *max_index = hi_arr[0];                                                 \
+   for (unsigned j = 1; j < n; j++) {                                      \
+      *min_index = MIN2(*min_index, lo_arr[j]);                            \
+      *max_index = MAX2(*max_index, hi_arr[j]);                            \
+   }                                                                       \
+   return i;                                                               \
+}
+
+DEFINE_MINMAX("sse4.1", minmax_u8_sse41, 8, __m128i, 16, _mm_loadu_si128,
+              _mm_set1_epi8, _mm_cmpeq_epi8, _mm_min_epu8, _mm_max_epu8,
+              _mm_or_si128, _mm_andnot_si128, _mm_storeu_si128)
+DEFINE_MINMAX("sse4.1", minmax_u16_sse41, 16, __m128i, 16, _mm_loadu_si128,
+              _mm_set1_epi16, _mm_cmpeq_epi16, _mm_min_epu16, _mm_max_epu16,
+              _mm_or_si128, _mm_andnot_si128, _mm_storeu_si128)
+DEFINE_MINMAX("sse4.1", minmax_u32_sse41, 32, __m128i, 16, _mm_loadu_si128,
+              _mm_set1_epi32, _mm_cmpeq_epi32, _mm_min_epu32, _mm_max_epu32,
+              _mm_or_si128, _mm_andnot_si128, _mm_storeu_si128)
+
+DEFINE_MINMAX("avx2", minmax_u8_avx2, 8, __m256i, 32, _mm256_loadu_si256,
+              _mm256_set1_epi8, _mm256_cmpeq_epi8, _mm256_min_epu8,
+              _mm256_max_epu8, _mm256_or_si256, _mm256_andnot_si256,
+              _mm256_storeu_si256)
+DEFINE_MINMAX("avx2", minmax_u16_avx2, 16, __m256i, 32, _mm256_loadu_si256,
+              _mm256_set1_epi16, _mm256_cmpeq_epi16, _mm256_min_epu16,
+              _mm256_max_epu16, _mm256_or_si256, _mm256_andnot_si256,
+              _mm256_storeu_si256)
+DEFINE_MINMAX("avx2", minmax_u32_avx2, 32, __m256i, 32, _mm256_loadu_si256,
+              _mm256_set1_epi32, _mm256_cmpeq_epi32, _mm256_min_epu32,
+              _mm256_max_epu32, _mm256_or_si256, _mm256_andnot_si256,
+              _mm256_storeu_si256)
+
+static void
+index_minmax_init(void)
+{
+   const struct util_cpu_caps_t *caps;
+
+   util_cpu_detect();
+   caps = util_get_cpu_caps();
+
+   if (caps->has_avx2) {
+      minmax_funcs[0] = minmax_u8_avx2;
+      minmax_funcs[1] = minmax_u16_avx2;
+      minmax_funcs[2] = minmax_u32_avx2;
+   } else if (caps->has_sse4_1) {
+      minmax_funcs[0] = minmax_u8_sse41;
+      minmax_funcs[1] = minmax_u16_sse41;
+      minmax_funcs[2] = minmax_u32_sse41;
+   }
+}
+
+#elif defined(PIPE_ARCH_AARCH64)
+
+/* VBICQ(a, m) is a & ~m, like ANDNOT with the operands swapped. */
+#define DEFINE_MINMAX_NEON(name, bits, lanes)                              \
+static unsigned                                                            \
+name(const void *indices, unsigned count, bool restart,                    \
+     unsigned restart_index, unsigned *min_index, unsigned *max_index)     \
+{                                                                          \
+   const uint##bits##_t *idx = indices;                                    \
+   const uint##bits##x##lanes##_t r =                                      \
+      vdupq_n_u##bits((uint##bits##_t)restart_index);                      \
+   uint##bits##x##lanes##_t lo = vdupq_n_u##bits((uint##bits##_t)~0u);     \
+   uint##bits##x##lanes##_t hi = vdupq_n_u##bits(0);                       \
+   unsigned i;                                                             \
+                                                                           \
+   if (restart) {                                                          \
+      for (i = 0; i + lanes <= count; i += lanes) {                        \
+         uint##bits##x##lanes##_t v = vld1q_u##bits(idx + i);              \
+         uint##bits##x##lanes##_t m = vceqq_u##bits(v, r);                 \
+         lo = vminq_u##bits(lo, vorrq_u##bits(v, m));                      \
+         hi = vmaxq_u##bits(hi, vbicq_u##bits(v, m));                      \
+      }                                                                    \
+   } else {                                                                \
+      for (i = 0; i + lanes <= count; i += lanes) {                        \
+         uint##bits##x##lanes##_t v = vld1q_u##bits(idx + i);              \
+         lo = vminq_u##bits(lo, v);                                        \
+         hi = vmaxq_u##bits(hi, v);                                        \
+      }                                                                    \
+   }                                                                       \
+                                                                           \
+   *min_index = vminvq_u##bits(lo);                                        \
+   *max_index = vmaxvq_u##bits(hi);                                        \
+   return i;                                                               \
+}
+
+DEFINE_MINMAX_NEON(minmax_u8_neon, 8, 16)
+DEFINE_MINMAX_NEON(minmax_u16_neon, 16, 8)
+DEFINE_MINMAX_NEON(minmax_u32_neon, 32, 4)
+
+static void
+index_minmax_init(void)
+{
+   minmax_funcs[0] = minmax_u8_neon;
+   minmax_funcs[1] = minmax_u16_neon;
+   minmax_funcs[2] = minmax_u32_neon;
+}
+
+#else
+
+static void
+index_minmax_init(void)
+{
+}
+
+#endif
+
+#define MINMAX_TAIL(type)                                                  \
+   do {                                                                    \
+      const type *idx = indices;                                           \
+      for (unsigned i = done; i < count; i++) {                            \
+         if (restart && idx[i] == restart_index)                           \
+            continue;                                                      \
+         min = MIN2(min, idx[i]);                                          \
+         max = MAX2(max, idx[i]);                                          \
+      }                                                                    \
+   } while (0)
+
+void
+util_index_minmax(const void *indices, unsigned index_size, unsigned count,
+                  bool restart, unsigned restart_index,
+                  unsigned *min_index, unsigned *max_index)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   const unsigned type_max = u_uintN_max(index_size * 8);
+   unsigned min = ~0u, max = 0, done = 0;
+   minmax_func func;
+
+   call_once(&flag, index_minmax_init);
+
+   /* A restart index that doesn't fit never matches. */
+   if (restart_index > type_max)
+      restart = false;
+
+   func = minmax_funcs[util_logbase2(index_size)];
+   if (func && count) {
+      done = func(indices, count, restart, restart_index, &min, &max);
+
+      /* The restart indices were made type_max for the minimum, so only
+       * type_max and 0 means that none was found.
+       */
+      if (min == type_max && max == 0)
+         min = ~0u;
+   }
+
+   switch (index_size) {
+   case 4:
+      MINMAX_TAIL(uint32_t);
+      break;
+   case 2:
+      MINMAX_TAIL(uint16_t);
+      break;
+   default:
+      MINMAX_TAIL(uint8_t);
+      break;
+   }
+
+   *min_index = min;
+   *max_index = max;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "c11/threads.h"
+#include "util/macros.h"
+#include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_parallel.h"
+#include "util/u_queue.h"
+
+#define PARALLEL_MAX_THREADS 16
+
+struct parallel_job {
+   util_parallel_func func;
+   void *data;
+   unsigned num_tasks;
+   /** Next task to run, taken atomically by every thread. */
+   unsigned next_task;
+};
+
+static struct util_queue parallel_queue;
+static unsigned parallel_num_threads;
+
+static void
+parallel_queue_destroy(void)
+{
+   parallel_num_threads = 0;
+   util_queue_destroy(&parallel_queue);
+}
+
+static void
+parallel_queue_init(void)
+{
+   util_cpu_detect();
+
+   unsigned num_threads = MIN2(util_get_cpu_caps()->nr_cpus - 1,
+                               PARALLEL_MAX_THREADS);
+
+   if (num_threads &&
+       util_queue_init(&parallel_queue, "parallel", PARALLEL_MAX_THREADS,
+                       num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL)) {
+      parallel_num_threads = num_threads;
+      /* Registered after util_queue's own handler, so this runs first. */
+      atexit(parallel_queue_destroy);
+   }
+}
+
+static void
+parallel_run_tasks(void *data, void *gdata, int thread_index)
+{
+   struct parallel_job *job = (struct parallel_job *)data;
+   unsigned task;
+
+   while ((task = p_atomic_inc_return(&job->next_task) - 1) < job->num_tasks)
+      job->func(job->data, task);
+}
+
+void
+util_parallel_for(unsigned num_tasks, util_parallel_func func, void *data)
+{
+   static once_flag queue_once = ONCE_FLAG_INIT;
+   struct util_queue_fence fences[PARALLEL_MAX_THREADS];
+   struct parallel_job job = {
+      .func = func,
+      .data = data,
+      .num_tasks = num_tasks,
+   };
+   unsigned num_helpers = 0;
+
+   if (num_tasks > 1) {
+      call_once(&queue_once, parallel_queue_init);
+      num_helpers = MIN2(num_tasks - 1, parallel_num_threads);
+   }
+
+   for (unsigned i = 0; i < num_helpers; i++) {
+      util_queue_fence_init(&fences[i]);
+      util_queue_add_job(&parallel_queue, &job, &fences[i],
+                         parallel_run_tasks, NULL, 0);
+   }
+
+   parallel_run_tasks(&job, NULL, 0);
+
+   for (unsigned i = 0; i < num_helpers; i++) {
+      util_queue_fence_wait(&fences[i]);
+      util_queue_fence_destroy(&fences[i]);
+   }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Splitting CPU-bound work, like converting a large image, into independent
+ * tasks that run on the calling thread and on a pool of helper threads
+ * shared by the whole process.
+ *
+ * The pool is created the first time there is more than one task to run
+ * and destroyed when the process exits.
+ * The calling thread always takes part, so everything still gets done,
+ * only serially, if it has no helper threads, e.g. on single-CPU systems.
+ */
+
+#ifndef U_PARALLEL_H
+#define U_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*util_parallel_func)(void *data, unsigned task);
+
+/**
+ * Run func(data, task) for every task in [0, num_tasks), in no particular
+ * order, and return once they are all done.
+ */
+void
+util_parallel_for(unsigned num_tasks, util_parallel_func func, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_PARALLEL_H */